@@ -1,29 +1,64 @@
 // glb_tree_viewer.cpp
-// This code does: loads a real tree from tree.glb and renders its triangle mesh on screen.
+// This code does: loads a real tree from tree.glb and renders every mesh of its scenes on screen,
+// packed into shared vertex/index arenas and drawn as a sorted list of indexed draws.
+// Press B for billboard mode: a whole forest of instanced impostor quads.
+// Press L for the LOD forest: each tree picks mesh, MSFT_lod level or billboard by screen size.
+// The model is parsed on a loader thread and its geometry streamed to the GPU a few MiB per frame.
+// H toggles an overlay with per-stage CPU/GPU times; --csv logs them per frame.
+// --bench replays a camera path offscreen (EGL/OSMesa) and writes a JSON report.
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cfloat>
+#include <cstddef>
 #include <cstdint>
 #include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <deque>
 #include <iostream>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 #include <limits>
 
+// SSE is baseline on x86-64; the culler falls back to scalar code elsewhere
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <xmmintrin.h>
+#define VIEWER_HAS_SSE 1
+#else
+#define VIEWER_HAS_SSE 0
+#endif
+
 // ---- tinygltf ----
 #define TINYGLTF_IMPLEMENTATION
 #define STB_IMAGE_IMPLEMENTATION
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include "tinygltf-release/tiny_gltf.h"
 
+// ---- Dear ImGui (profiling overlay) ----
+#include "imgui.h"
+
 // ------------------ SHADERS ------------------
+// Meshes: Model places the primitive, then an optional per-instance offset/scale
+// (location 1) moves whole trees around for the LOD forest. Plain mesh mode leaves
+// location 1 disabled, so it reads the default (0, 0, 0, 1) and changes nothing.
+// aPos may be KHR_mesh_quantization integers: the attribute fetch converts them
+// to float (normalizing if flagged) and Model applies the dequantization scale.
 static const char *vsSrc = R"glsl(
 #version 330 core
 layout (location = 0) in vec3 aPos;
-uniform mat4 MVP;
+layout (location = 1) in vec4 iPosScale;
+uniform mat4 VP;
+uniform mat4 Model;
 void main() {
-    gl_Position = MVP * vec4(aPos, 1.0);
+    vec3 p = (Model * vec4(aPos, 1.0)).xyz;
+    gl_Position = VP * vec4(iPosScale.xyz + p * iPosScale.w, 1.0);
 }
 )glsl";
 
@@ -35,6 +70,72 @@ void main() {
 }
 )glsl";
 
+// Billboards: one camera- or axis-aligned quad per instance, expanded from gl_VertexID.
+// Per-instance position/scale and atlas cell come from an instance VBO (divisor 1).
+static const char *billboardVsSrc = R"glsl(
+#version 330 core
+layout (location = 1) in vec4 iPosScale;
+layout (location = 2) in uint iCell;
+uniform mat4 VP;
+uniform vec3 uRight;
+uniform vec3 uUp;
+uniform vec2 uQuadSize;
+uniform ivec2 uAtlasGrid;
+out vec2 vUV;
+void main() {
+    // triangle strip corners: (0,0) (1,0) (0,1) (1,1)
+    vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+    vec3 offset = uRight * ((corner.x - 0.5) * uQuadSize.x) + uUp * (corner.y * uQuadSize.y);
+    gl_Position = VP * vec4(iPosScale.xyz + offset * iPosScale.w, 1.0);
+
+    // atlas cells are counted row by row from the top-left of the image
+    int cell = int(iCell) % (uAtlasGrid.x * uAtlasGrid.y);
+    vec2 cellSize = 1.0 / vec2(uAtlasGrid);
+    vec2 origin = vec2(cell % uAtlasGrid.x, cell / uAtlasGrid.x) * cellSize;
+    vUV = origin + vec2(corner.x, 1.0 - corner.y) * cellSize;
+}
+)glsl";
+
+static const char *billboardFsSrc = R"glsl(
+#version 330 core
+in vec2 vUV;
+uniform sampler2D uAtlas;
+out vec4 FragColor;
+void main() {
+    vec4 c = texture(uAtlas, vUV);
+    if (c.a < 0.5)
+        discard; // alpha test keeps the forest order-independent (no sorting)
+    FragColor = vec4(c.rgb, 1.0);
+}
+)glsl";
+
+// Profiling overlay: ImGui vertices are already in pixels, uProj maps them to clip space.
+static const char *hudVsSrc = R"glsl(
+#version 330 core
+layout (location = 0) in vec2 aPos;
+layout (location = 1) in vec2 aUV;
+layout (location = 2) in vec4 aColor;
+uniform mat4 uProj;
+out vec2 vUV;
+out vec4 vColor;
+void main() {
+    vUV = aUV;
+    vColor = aColor;
+    gl_Position = uProj * vec4(aPos, 0.0, 1.0);
+}
+)glsl";
+
+static const char *hudFsSrc = R"glsl(
+#version 330 core
+in vec2 vUV;
+in vec4 vColor;
+uniform sampler2D uFont;
+out vec4 FragColor;
+void main() {
+    FragColor = vColor * texture(uFont, vUV);
+}
+)glsl";
+
 // ------------------ GL UTILS ------------------
 static GLuint compileShader(GLenum type, const char *src)
 {
@@ -58,10 +159,10 @@ static GLuint compileShader(GLenum type, const char *src)
     return s;
 }
 
-static GLuint makeProgram()
+static GLuint makeProgram(const char *vsText, const char *fsText)
 {
-    GLuint vs = compileShader(GL_VERTEX_SHADER, vsSrc);
-    GLuint fs = compileShader(GL_FRAGMENT_SHADER, fsSrc);
+    GLuint vs = compileShader(GL_VERTEX_SHADER, vsText);
+    GLuint fs = compileShader(GL_FRAGMENT_SHADER, fsText);
     if (!vs || !fs)
         return 0;
 
@@ -89,6 +190,33 @@ static GLuint makeProgram()
     return p;
 }
 
+// GL_ARB_pipeline_statistics_query is not part of the generated glad loader
+#ifndef GL_VERTEX_SHADER_INVOCATIONS_ARB
+#define GL_VERTEX_SHADER_INVOCATIONS_ARB 0x82F0
+#endif
+#ifndef GL_PRIMITIVES_SUBMITTED_ARB
+#define GL_PRIMITIVES_SUBMITTED_ARB 0x82EF
+#endif
+#ifndef GL_FRAGMENT_SHADER_INVOCATIONS_ARB
+#define GL_FRAGMENT_SHADER_INVOCATIONS_ARB 0x82F4
+#endif
+#ifndef GL_CLIPPING_OUTPUT_PRIMITIVES_ARB
+#define GL_CLIPPING_OUTPUT_PRIMITIVES_ARB 0x82F7
+#endif
+
+static bool hasExtension(const char *name)
+{
+    GLint n = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &n);
+    for (GLint i = 0; i < n; i++)
+    {
+        const char *ext = reinterpret_cast<const char *>(glGetStringi(GL_EXTENSIONS, (GLuint)i));
+        if (ext && std::strcmp(ext, name) == 0)
+            return true;
+    }
+    return false;
+}
+
 // ------------------ SIMPLE MATH ------------------
 struct Mat4
 {
@@ -141,307 +269,2846 @@ static Mat4 mul(const Mat4 &a, const Mat4 &b)
     return r;
 }
 
+static Mat4 fromTRS(const std::vector<double> &t, const std::vector<double> &r, const std::vector<double> &s)
+{
+    // glTF stores rotation as a unit quaternion (x, y, z, w)
+    float qx = r.size() == 4 ? (float)r[0] : 0.0f;
+    float qy = r.size() == 4 ? (float)r[1] : 0.0f;
+    float qz = r.size() == 4 ? (float)r[2] : 0.0f;
+    float qw = r.size() == 4 ? (float)r[3] : 1.0f;
+    float sx = s.size() == 3 ? (float)s[0] : 1.0f;
+    float sy = s.size() == 3 ? (float)s[1] : 1.0f;
+    float sz = s.size() == 3 ? (float)s[2] : 1.0f;
+
+    Mat4 m = identity();
+    m.m[0] = (1.0f - 2.0f * (qy * qy + qz * qz)) * sx;
+    m.m[1] = (2.0f * (qx * qy + qz * qw)) * sx;
+    m.m[2] = (2.0f * (qx * qz - qy * qw)) * sx;
+    m.m[4] = (2.0f * (qx * qy - qz * qw)) * sy;
+    m.m[5] = (1.0f - 2.0f * (qx * qx + qz * qz)) * sy;
+    m.m[6] = (2.0f * (qy * qz + qx * qw)) * sy;
+    m.m[8] = (2.0f * (qx * qz + qy * qw)) * sz;
+    m.m[9] = (2.0f * (qy * qz - qx * qw)) * sz;
+    m.m[10] = (1.0f - 2.0f * (qx * qx + qy * qy)) * sz;
+    if (t.size() == 3)
+    {
+        m.m[12] = (float)t[0];
+        m.m[13] = (float)t[1];
+        m.m[14] = (float)t[2];
+    }
+    return m;
+}
+
+static Mat4 nodeLocalMatrix(const tinygltf::Node &node)
+{
+    if (node.matrix.size() == 16)
+    {
+        Mat4 m;
+        for (int i = 0; i < 16; i++)
+            m.m[i] = (float)node.matrix[i];
+        return m;
+    }
+    return fromTRS(node.translation, node.rotation, node.scale);
+}
+
+static void transformPoint(const Mat4 &m, const float p[3], float out[3])
+{
+    for (int r = 0; r < 3; r++)
+        out[r] = m.m[0 * 4 + r] * p[0] + m.m[1 * 4 + r] * p[1] + m.m[2 * 4 + r] * p[2] + m.m[3 * 4 + r];
+}
+
+struct Vec3
+{
+    float x, y, z;
+};
+
+static Vec3 sub(const Vec3 &a, const Vec3 &b) { return Vec3{a.x - b.x, a.y - b.y, a.z - b.z}; }
+static float dot(const Vec3 &a, const Vec3 &b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+static Vec3 cross(const Vec3 &a, const Vec3 &b)
+{
+    return Vec3{a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};
+}
+static Vec3 normalize(const Vec3 &a)
+{
+    float l = std::sqrt(dot(a, a));
+    return l > 0.0f ? Vec3{a.x / l, a.y / l, a.z / l} : a;
+}
+
+// Right-handed view matrix; also hands back the camera basis for billboards.
+static Mat4 lookAt(const Vec3 &eye, const Vec3 &center, const Vec3 &worldUp, Vec3 *right, Vec3 *up)
+{
+    Vec3 f = normalize(sub(center, eye));
+    Vec3 s = normalize(cross(f, worldUp));
+    Vec3 u = cross(s, f);
+
+    Mat4 m = identity();
+    m.m[0] = s.x;
+    m.m[4] = s.y;
+    m.m[8] = s.z;
+    m.m[1] = u.x;
+    m.m[5] = u.y;
+    m.m[9] = u.z;
+    m.m[2] = -f.x;
+    m.m[6] = -f.y;
+    m.m[10] = -f.z;
+    m.m[12] = -dot(s, eye);
+    m.m[13] = -dot(u, eye);
+    m.m[14] = dot(f, eye);
+    if (right)
+        *right = s;
+    if (up)
+        *up = u;
+    return m;
+}
+
+// Orbit camera driven by the arrow keys (yaw/pitch) and W/S (distance)
+struct OrbitCamera
+{
+    Vec3 target{0.0f, 0.0f, 0.0f};
+    float yaw = 0.0f;
+    float pitch = 0.0f;
+    float dist = 1.0f;
+
+    Vec3 eye() const
+    {
+        return Vec3{target.x + dist * std::cos(pitch) * std::sin(yaw),
+                    target.y + dist * std::sin(pitch),
+                    target.z + dist * std::cos(pitch) * std::cos(yaw)};
+    }
+};
+
+static void updateCamera(GLFWwindow *win, OrbitCamera &cam, float dt)
+{
+    const float turn = 1.5f * dt;
+    if (glfwGetKey(win, GLFW_KEY_LEFT) == GLFW_PRESS)
+        cam.yaw -= turn;
+    if (glfwGetKey(win, GLFW_KEY_RIGHT) == GLFW_PRESS)
+        cam.yaw += turn;
+    if (glfwGetKey(win, GLFW_KEY_UP) == GLFW_PRESS)
+        cam.pitch = std::min(cam.pitch + turn, 1.5f);
+    if (glfwGetKey(win, GLFW_KEY_DOWN) == GLFW_PRESS)
+        cam.pitch = std::max(cam.pitch - turn, -1.5f);
+    if (glfwGetKey(win, GLFW_KEY_W) == GLFW_PRESS)
+        cam.dist *= 1.0f - std::min(dt, 0.5f);
+    if (glfwGetKey(win, GLFW_KEY_S) == GLFW_PRESS)
+        cam.dist *= 1.0f + std::min(dt, 0.5f);
+}
+
 // ------------------ tinygltf helpers ------------------
-static const unsigned char *accessorDataPtr(
-    const tinygltf::Model &model,
-    const tinygltf::Accessor &acc)
+// Vertex attribute component types: float, or the integer encodings of KHR_mesh_quantization
+static GLenum attribTypeToGL(int componentType)
 {
-    const tinygltf::BufferView &view = model.bufferViews[acc.bufferView];
-    const tinygltf::Buffer &buf = model.buffers[view.buffer];
-    return buf.data.data() + view.byteOffset + acc.byteOffset;
+    switch (componentType)
+    {
+    case TINYGLTF_COMPONENT_TYPE_BYTE:
+        return GL_BYTE;
+    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+        return GL_UNSIGNED_BYTE;
+    case TINYGLTF_COMPONENT_TYPE_SHORT:
+        return GL_SHORT;
+    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+        return GL_UNSIGNED_SHORT;
+    default:
+        return GL_FLOAT;
+    }
 }
 
-static int componentCount(int type)
+static GLenum indexTypeToGL(int componentType)
 {
-    // POSITION is usually VEC3
-    switch (type)
+    switch (componentType)
     {
-    case TINYGLTF_TYPE_SCALAR:
-        return 1;
-    case TINYGLTF_TYPE_VEC2:
-        return 2;
-    case TINYGLTF_TYPE_VEC3:
-        return 3;
-    case TINYGLTF_TYPE_VEC4:
-        return 4;
+    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+        return GL_UNSIGNED_BYTE;
+    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+        return GL_UNSIGNED_SHORT;
+    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
+        return GL_UNSIGNED_INT;
     default:
         return 0;
     }
 }
 
+// Counts vertex-shader runs for an indexed draw through a FIFO post-transform cache.
+// Real GPUs differ in size and policy; this is only meant as a ballpark.
+static size_t simulateVertexCache(const std::vector<uint32_t> &indices, size_t cacheSize)
+{
+    std::vector<uint32_t> fifo(cacheSize, 0xffffffffu);
+    size_t head = 0;
+    size_t misses = 0;
+    for (uint32_t v : indices)
+    {
+        if (std::find(fifo.begin(), fifo.end(), v) != fifo.end())
+            continue;
+        fifo[head] = v;
+        head = (head + 1) % cacheSize;
+        misses++;
+    }
+    return misses;
+}
+
 struct Bounds
 {
     float minx, miny, minz;
     float maxx, maxy, maxz;
 };
 
-static Bounds computeBoundsFromPositions(const float *pos, size_t vertexCount, size_t strideFloats)
+// Bounds in the same units the vertex shader sees: quantized positions are
+// converted the way glVertexAttribPointer does, before the node transform.
+static Bounds computeBoundsFromPositions(const tinygltf::AccessorView<float> &pos)
 {
     Bounds b;
+    if (pos.ComponentType() == TINYGLTF_COMPONENT_TYPE_FLOAT && pos.Data() && !pos.IsSparse())
+    {
+        float mn[3], mx[3];
+        tinygltf::kernels::BoundsFloat3(pos.Data(), pos.ByteStride(), pos.size(), mn, mx);
+        b.minx = mn[0], b.miny = mn[1], b.minz = mn[2];
+        b.maxx = mx[0], b.maxy = mx[1], b.maxz = mx[2];
+        return b;
+    }
+
     b.minx = b.miny = b.minz = std::numeric_limits<float>::infinity();
     b.maxx = b.maxy = b.maxz = -std::numeric_limits<float>::infinity();
-
-    for (size_t i = 0; i < vertexCount; i++)
+    for (auto p : pos)
     {
-        const float *p = pos + i * strideFloats;
-        b.minx = std::min(b.minx, p[0]);
-        b.maxx = std::max(b.maxx, p[0]);
-        b.miny = std::min(b.miny, p[1]);
-        b.maxy = std::max(b.maxy, p[1]);
-        b.minz = std::min(b.minz, p[2]);
-        b.maxz = std::max(b.maxz, p[2]);
+        float x = p[0], y = p[1], z = p[2];
+        b.minx = std::min(b.minx, x);
+        b.maxx = std::max(b.maxx, x);
+        b.miny = std::min(b.miny, y);
+        b.maxy = std::max(b.maxy, y);
+        b.minz = std::min(b.minz, z);
+        b.maxz = std::max(b.maxz, z);
     }
     return b;
 }
 
-int main()
+static Bounds emptyBounds()
 {
-    // ---- GLFW / GL init ----
-    if (!glfwInit())
+    Bounds b;
+    b.minx = b.miny = b.minz = std::numeric_limits<float>::infinity();
+    b.maxx = b.maxy = b.maxz = -std::numeric_limits<float>::infinity();
+    return b;
+}
+
+// Grows `b` by the 8 corners of `local` transformed by `m`.
+static void expandBounds(Bounds &b, const Bounds &local, const Mat4 &m)
+{
+    for (int i = 0; i < 8; i++)
     {
-        std::cerr << "glfwInit failed\n";
-        return 1;
+        float c[3] = {(i & 1) ? local.maxx : local.minx,
+                      (i & 2) ? local.maxy : local.miny,
+                      (i & 4) ? local.maxz : local.minz};
+        float w[3];
+        transformPoint(m, c, w);
+        b.minx = std::min(b.minx, w[0]);
+        b.maxx = std::max(b.maxx, w[0]);
+        b.miny = std::min(b.miny, w[1]);
+        b.maxy = std::max(b.maxy, w[1]);
+        b.minz = std::min(b.minz, w[2]);
+        b.maxz = std::max(b.maxz, w[2]);
     }
+}
 
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+// ------------------ SCENE GEOMETRY ARENA ------------------
+// Every primitive of every mesh reachable from the scene is packed into one VBO/IBO
+// pair per vertex layout. A frame is then one VAO bind per layout plus a sorted list
+// of glDrawElementsBaseVertex calls.
 
-    const int W = 800, H = 600;
-    GLFWwindow *win = glfwCreateWindow(W, H, "GLB Tree", nullptr, nullptr);
-    if (!win)
-    {
-        std::cerr << "glfwCreateWindow failed\n";
-        glfwTerminate();
-        return 1;
-    }
-    glfwMakeContextCurrent(win);
+struct VertexLayout
+{
+    int componentType; // of POSITION
+    int type;
+    bool normalized;   // KHR_mesh_quantization integer positions may be normalized
 
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    bool operator==(const VertexLayout &o) const
     {
-        std::cerr << "gladLoadGLLoader failed\n";
-        glfwTerminate();
-        return 1;
+        return componentType == o.componentType && type == o.type && normalized == o.normalized;
     }
+};
 
-    glViewport(0, 0, W, H);
-    glEnable(GL_DEPTH_TEST);
-    glDisable(GL_CULL_FACE); // avoid winding/handedness surprises
-    // glPolygonMode(GL_FRONT_AND_BACK, GL_LINE); // uncomment to debug wireframe
+struct GeometryArena
+{
+    VertexLayout layout;
+    size_t vertexStride = 0; // bytes, packed to a 4-byte multiple
+    std::vector<unsigned char> vertices;
+    std::vector<unsigned char> indices;
+    GLuint vao = 0, vbo = 0, ebo = 0;
+    GLuint instancedVao = 0; // same buffers plus the LOD instance stream at location 1
+    int pendingUploads = 0;  // streamed copies still to finish; drawn once this is 0
+    bool resident = false;
+};
 
-    GLuint prog = makeProgram();
-    if (!prog)
-    {
-        glfwTerminate();
-        return 1;
-    }
+// Where one glTF primitive landed inside its arena
+struct PrimitiveRange
+{
+    int arena = -1;
+    GLenum indexType = 0;
+    size_t indexOffset = 0; // bytes into the arena IBO
+    GLsizei indexCount = 0;
+    GLint baseVertex = 0;
+    Bounds local;
+};
 
-    // ---- LOAD GLB ----
-    tinygltf::TinyGLTF loader;
-    tinygltf::Model model;
-    std::string err, warn;
+struct DrawCmd
+{
+    int arena;
+    GLenum indexType;
+    size_t indexOffset;
+    GLsizei indexCount;
+    GLint baseVertex;
+    Mat4 model;
+    Bounds local; // of the primitive, before `model`
+};
+
+struct SceneGeometry
+{
+    std::vector<GeometryArena> arenas;
+    std::vector<PrimitiveRange> ranges;
+    std::vector<DrawCmd> draws;
+    Bounds bounds;
+    std::vector<std::vector<int>> meshRanges; // per glTF mesh: index into ranges, -1 if skipped
 
-    if (!loader.LoadBinaryFromFile(&model, &err, &warn, "tree.glb"))
+    // First node carrying MSFT_lod, and the world matrix of its parent
+    int lodRoot = -1;
+    Mat4 lodParent = identity();
+
+    // Savings report: expanded triangle soup vs indexed
+    size_t soupBytes = 0;
+    size_t indexedBytes = 0;
+    size_t soupVS = 0;
+    size_t indexedVS = 0;
+
+    // Dense copies of sparse accessors, built once and shared by every primitive using them
+    tinygltf::SparseAccessorCache sparse;
+};
+
+static int findOrAddArena(SceneGeometry &geo, const VertexLayout &layout)
+{
+    for (size_t i = 0; i < geo.arenas.size(); i++)
     {
-        std::cerr << "Failed to load tree.glb\n";
-        if (!warn.empty())
-            std::cerr << "WARN: " << warn << "\n";
-        if (!err.empty())
-            std::cerr << "ERR : " << err << "\n";
-        glfwTerminate();
-        return 1;
+        if (geo.arenas[i].layout == layout)
+            return (int)i;
     }
-    if (!warn.empty())
-        std::cerr << "WARN: " << warn << "\n";
+    GeometryArena a;
+    a.layout = layout;
+    size_t elementSize = (size_t)(tinygltf::GetComponentSizeInBytes(layout.componentType) *
+                                  tinygltf::GetNumComponentsInType(layout.type));
+    a.vertexStride = (elementSize + 3) & ~(size_t)3; // short3 -> 8 bytes, byte3 -> 4
+    geo.arenas.push_back(a);
+    return (int)geo.arenas.size() - 1;
+}
 
-    if (model.meshes.empty())
+// Appends one primitive to its arena. Returns false (with a reason) for primitives
+// this viewer can't draw; those are skipped, not fatal.
+static bool appendPrimitive(const tinygltf::Model &model, const tinygltf::Primitive &prim,
+                            SceneGeometry &geo, PrimitiveRange &out, std::string &why)
+{
+    if (prim.mode != -1 && prim.mode != TINYGLTF_MODE_TRIANGLES)
     {
-        std::cerr << "No meshes in GLB\n";
-        glfwTerminate();
-        return 1;
+        why = "mode is not TRIANGLES";
+        return false;
     }
-
-    // We take the first primitive of the first mesh (good enough for a quick viewer)
-    const tinygltf::Mesh &mesh = model.meshes[0];
-    if (mesh.primitives.empty())
+    auto posIt = prim.attributes.find(tinygltf::AttributeSemantic::Position);
+    if (posIt == prim.attributes.end())
     {
-        std::cerr << "Mesh has no primitives\n";
-        glfwTerminate();
-        return 1;
+        why = "no POSITION";
+        return false;
+    }
+    const tinygltf::Accessor &posAcc = model.accessors[posIt->second];
+    if (!tinygltf::IsValidAttributeEncoding("POSITION", posAcc, /* quantized */ true))
+    {
+        why = "POSITION is not a float or KHR_mesh_quantization VEC3";
+        return false;
+    }
+    // Positions are uploaded as stored; sparse ones come from their dense copy in the cache
+    tinygltf::AccessorView<float> posView;
+    if (!posView.Init(model, posIt->second, &geo.sparse) || !posView.Data() || posView.size() == 0)
+    {
+        why = "POSITION has no data";
+        return false;
     }
-    const tinygltf::Primitive &prim = mesh.primitives[0];
 
-    if (prim.attributes.find("POSITION") == prim.attributes.end())
+    GLenum idxType = GL_UNSIGNED_INT;
+    size_t idxElemBytes = 4;
+    size_t idxCount = posAcc.count;
+    tinygltf::AccessorView<uint32_t> idxView;
+    std::vector<uint32_t> idx32;
+    if (prim.indices >= 0)
     {
-        std::cerr << "Primitive has no POSITION\n";
-        glfwTerminate();
-        return 1;
+        const tinygltf::Accessor &idxAcc = model.accessors[prim.indices];
+        idxType = indexTypeToGL(idxAcc.componentType);
+        idxElemBytes = (size_t)tinygltf::GetComponentSizeInBytes(idxAcc.componentType);
+        if (idxType == 0 || !idxView.Init(model, prim.indices) || !idxView.Data() || idxView.IsSparse() ||
+            idxView.ByteStride() != idxElemBytes)
+        {
+            why = "unsupported index accessor";
+            return false;
+        }
+        idxCount = idxView.size();
+
+        // Widened once (SIMD) for validation and the cache simulation; the GPU gets the stored width.
+        idx32.resize(idxCount);
+        idxView.CopyTo(idx32.data());
+
+        // The element buffer goes to the GPU untouched, so out-of-range ids must be caught here.
+        for (uint32_t v : idx32)
+        {
+            if (v >= posAcc.count)
+            {
+                why = "index out of range";
+                return false;
+            }
+        }
     }
-    if (prim.indices < 0)
+    if (idxCount == 0)
     {
-        std::cerr << "Primitive has no indices (not handled in this minimal viewer)\n";
-        glfwTerminate();
-        return 1;
+        why = "no indices";
+        return false;
     }
 
-    // ---- Positions accessor ----
-    const tinygltf::Accessor &posAcc = model.accessors[prim.attributes.at("POSITION")];
-    const tinygltf::BufferView &posView = model.bufferViews[posAcc.bufferView];
+    // Quantized positions are uploaded as stored; the GPU converts them when fetching
+    // and the node transform (KHR_mesh_quantization's dequantization) does the rest.
+    int arenaIdx = findOrAddArena(geo, VertexLayout{posAcc.componentType, posAcc.type, posAcc.normalized});
+    GeometryArena &arena = geo.arenas[arenaIdx];
 
-    if (posAcc.componentType != TINYGLTF_COMPONENT_TYPE_FLOAT)
+    out.arena = arenaIdx;
+    out.indexType = idxType;
+    out.indexCount = (GLsizei)idxCount;
+    out.baseVertex = (GLint)(arena.vertices.size() / arena.vertexStride);
+    out.local = computeBoundsFromPositions(posView);
+
+    // Vertices are repacked so every primitive in the arena shares one stride.
+    size_t elementSize = (size_t)tinygltf::GetComponentSizeInBytes(posAcc.componentType) * 3;
+    size_t vbase = arena.vertices.size();
+    arena.vertices.resize(vbase + posAcc.count * arena.vertexStride); // padding bytes stay zero
+    for (size_t i = 0; i < posAcc.count; i++)
+        std::memcpy(&arena.vertices[vbase + i * arena.vertexStride], posView.Data() + i * posView.ByteStride(),
+                    elementSize);
+
+    // Indices keep their stored width; offsets must be aligned to that width.
+    size_t ibase = (arena.indices.size() + 3) & ~(size_t)3;
+    arena.indices.resize(ibase + idxCount * idxElemBytes);
+    if (idxView.Valid())
     {
-        std::cerr << "POSITION is not float (unsupported in this minimal viewer)\n";
-        glfwTerminate();
-        return 1;
+        std::memcpy(&arena.indices[ibase], idxView.Data(), idxCount * idxElemBytes);
+        size_t vs = simulateVertexCache(idx32, 32);
+        geo.indexedVS += vs;
     }
-    if (posAcc.type != TINYGLTF_TYPE_VEC3)
+    else
     {
-        std::cerr << "POSITION is not VEC3 (unsupported)\n";
-        glfwTerminate();
-        return 1;
+        // Non-indexed primitive: synthesize 0..n-1 so it still fits the indexed batch
+        for (uint32_t i = 0; i < (uint32_t)idxCount; i++)
+            std::memcpy(&arena.indices[ibase + i * 4], &i, 4);
+        geo.indexedVS += idxCount;
     }
+    out.indexOffset = ibase;
 
-    const unsigned char *posBase = accessorDataPtr(model, posAcc);
+    geo.soupBytes += idxCount * sizeof(float) * 3;
+    geo.indexedBytes += posAcc.count * arena.vertexStride + idxCount * idxElemBytes;
+    geo.soupVS += idxCount;
+    return true;
+}
 
-    // Stride: if byteStride == 0 then tightly packed
-    size_t posStrideBytes = posView.byteStride ? posView.byteStride : sizeof(float) * 3;
-    size_t posStrideFloats = posStrideBytes / sizeof(float);
+static void collectNode(const tinygltf::Model &model, int nodeIdx, const Mat4 &parent,
+                        SceneGeometry &geo, std::vector<DrawCmd> &draws, Bounds &bounds,
+                        std::vector<int> &visiting)
+{
+    // Guard against malformed files where a node is its own ancestor
+    if (visiting[nodeIdx])
+        return;
+    visiting[nodeIdx] = 1;
 
-    // We'll copy positions into a tight array to keep it simple/robust.
-    std::vector<float> positions;
-    positions.resize(posAcc.count * 3);
+    const tinygltf::Node &node = model.nodes[nodeIdx];
+    Mat4 world = mul(parent, nodeLocalMatrix(node));
 
-    for (size_t i = 0; i < posAcc.count; i++)
+    // The first MSFT_lod node met is what the LOD selector swaps out per instance
+    if (!node.lods.empty() && geo.lodRoot < 0)
     {
-        const float *p = reinterpret_cast<const float *>(posBase + i * posStrideBytes);
-        positions[i * 3 + 0] = p[0];
-        positions[i * 3 + 1] = p[1];
-        positions[i * 3 + 2] = p[2];
+        geo.lodRoot = nodeIdx;
+        geo.lodParent = parent;
     }
 
-    // ---- Indices accessor (THIS WAS YOUR BUG) ----
-    const tinygltf::Accessor &idxAcc = model.accessors[prim.indices];
-    const tinygltf::BufferView &idxView = model.bufferViews[idxAcc.bufferView];
-    const unsigned char *idxBase = accessorDataPtr(model, idxAcc);
+    if (node.mesh >= 0 && node.mesh < (int)model.meshes.size())
+    {
+        const tinygltf::Mesh &mesh = model.meshes[node.mesh];
+        std::vector<int> &ranges = geo.meshRanges[node.mesh];
 
-    std::vector<uint32_t> indices;
-    indices.reserve(idxAcc.count);
+        // A mesh referenced by several nodes is uploaded once
+        if (ranges.empty())
+        {
+            ranges.assign(mesh.primitives.size(), -1);
+            for (size_t p = 0; p < mesh.primitives.size(); p++)
+            {
+                PrimitiveRange r;
+                std::string why;
+                if (appendPrimitive(model, mesh.primitives[p], geo, r, why))
+                {
+                    ranges[p] = (int)geo.ranges.size();
+                    geo.ranges.push_back(r);
+                }
+                else
+                {
+                    std::cerr << "Skipping mesh " << node.mesh << " primitive " << p << ": " << why << "\n";
+                }
+            }
+        }
 
-    if (idxAcc.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT)
-    {
-        const uint16_t *p = reinterpret_cast<const uint16_t *>(idxBase);
-        for (size_t i = 0; i < idxAcc.count; i++)
-            indices.push_back((uint32_t)p[i]);
+        for (int ri : ranges)
+        {
+            if (ri < 0)
+                continue;
+            const PrimitiveRange &r = geo.ranges[ri];
+            draws.push_back(DrawCmd{r.arena, r.indexType, r.indexOffset, r.indexCount, r.baseVertex, world, r.local});
+            expandBounds(bounds, r.local, world);
+        }
     }
-    else if (idxAcc.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT)
+
+    for (int child : node.children)
     {
-        const uint32_t *p = reinterpret_cast<const uint32_t *>(idxBase);
-        for (size_t i = 0; i < idxAcc.count; i++)
-            indices.push_back(p[i]);
+        if (child >= 0 && child < (int)model.nodes.size())
+            collectNode(model, child, world, geo, draws, bounds, visiting);
     }
-    else if (idxAcc.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE)
+    visiting[nodeIdx] = 0;
+}
+
+// Sorted so that draws sharing an arena are contiguous (one VAO bind each) and
+// walk the index buffer front to back.
+static void sortDraws(std::vector<DrawCmd> &draws)
+{
+    std::sort(draws.begin(), draws.end(), [](const DrawCmd &a, const DrawCmd &b)
+              {
+                  if (a.arena != b.arena)
+                      return a.arena < b.arena;
+                  return a.indexOffset < b.indexOffset;
+              });
+}
+
+static void buildSceneGeometry(const tinygltf::Model &model, SceneGeometry &geo)
+{
+    geo.bounds = emptyBounds();
+    geo.meshRanges.assign(model.meshes.size(), std::vector<int>());
+    std::vector<int> visiting(model.nodes.size(), 0);
+
+    std::vector<int> roots;
+    if (!model.scenes.empty())
     {
-        const uint8_t *p = reinterpret_cast<const uint8_t *>(idxBase);
-        for (size_t i = 0; i < idxAcc.count; i++)
-            indices.push_back((uint32_t)p[i]);
+        // Walk every scene, not just the default one
+        for (const tinygltf::Scene &scene : model.scenes)
+            roots.insert(roots.end(), scene.nodes.begin(), scene.nodes.end());
     }
     else
     {
-        std::cerr << "Unsupported index componentType: " << idxAcc.componentType << "\n";
-        glfwTerminate();
-        return 1;
+        // No scenes: every node without a parent is a root
+        std::vector<char> hasParent(model.nodes.size(), 0);
+        for (const tinygltf::Node &n : model.nodes)
+            for (int c : n.children)
+                if (c >= 0 && c < (int)model.nodes.size())
+                    hasParent[c] = 1;
+        for (size_t i = 0; i < model.nodes.size(); i++)
+            if (!hasParent[i])
+                roots.push_back((int)i);
     }
 
-    // ---- Build draw vertex array (expanded triangles) ----
-    // We expand indexed triangles into a flat position array to avoid EBO complexity.
-    // Each 3 floats = 1 vertex position. 3 vertices per triangle.
-    std::vector<float> drawVerts;
-    drawVerts.reserve(indices.size() * 3);
-
-    for (uint32_t id : indices)
+    for (int r : roots)
     {
-        if (id >= (uint32_t)posAcc.count)
-            continue; // safety
-        drawVerts.push_back(positions[id * 3 + 0]);
-        drawVerts.push_back(positions[id * 3 + 1]);
-        drawVerts.push_back(positions[id * 3 + 2]);
+        if (r >= 0 && r < (int)model.nodes.size())
+            collectNode(model, r, identity(), geo, geo.draws, geo.bounds, visiting);
     }
+    sortDraws(geo.draws);
+}
+
+// Allocates the arena's GPU buffers and VAOs. The contents arrive later through
+// the upload queue; the CPU copies are kept until then.
+static void createArenaBuffers(GeometryArena &a)
+{
+    glGenVertexArrays(1, &a.vao);
+    glGenBuffers(1, &a.vbo);
+    glGenBuffers(1, &a.ebo);
+
+    glBindVertexArray(a.vao);
+    glBindBuffer(GL_ARRAY_BUFFER, a.vbo);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)a.vertices.size(), nullptr, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, attribTypeToGL(a.layout.componentType), a.layout.normalized ? GL_TRUE : GL_FALSE,
+                          (GLsizei)a.vertexStride, (void *)0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, a.ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)a.indices.size(), nullptr, GL_STATIC_DRAW);
+
+    // Location 1 is pointed at the right slice of the instance stream per LOD level
+    glGenVertexArrays(1, &a.instancedVao);
+    glBindVertexArray(a.instancedVao);
+    glBindBuffer(GL_ARRAY_BUFFER, a.vbo);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, attribTypeToGL(a.layout.componentType), a.layout.normalized ? GL_TRUE : GL_FALSE,
+                          (GLsizei)a.vertexStride, (void *)0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribDivisor(1, 1);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, a.ebo);
+    glBindVertexArray(0);
+}
+
+// Draw calls and triangles submitted this frame, for the profiler.
+struct FrameCounters
+{
+    size_t drawCalls = 0;
+    size_t triangles = 0;
+};
 
-    if (drawVerts.empty())
+// One VAO bind per arena, then one glDrawElementsBaseVertex per draw. `order` lists
+// the draws to issue as ascending indices into geo.draws, which keeps the arena sort.
+// Expects `prog` bound with VP already set.
+static void drawSceneGeometry(const SceneGeometry &geo, const std::vector<uint32_t> &order, GLint uModel,
+                              FrameCounters &counters)
+{
+    int boundArena = -1;
+    for (uint32_t i : order)
     {
-        std::cerr << "No vertices to draw (check GLB)\n";
-        glfwTerminate();
-        return 1;
+        const DrawCmd &d = geo.draws[i];
+        if (!geo.arenas[d.arena].resident)
+            continue; // still streaming in
+        if (d.arena != boundArena)
+        {
+            glBindVertexArray(geo.arenas[d.arena].vao);
+            boundArena = d.arena;
+        }
+        glUniformMatrix4fv(uModel, 1, GL_FALSE, d.model.m);
+        glDrawElementsBaseVertex(GL_TRIANGLES, d.indexCount, d.indexType, (void *)d.indexOffset, d.baseVertex);
+        counters.drawCalls++;
+        counters.triangles += (size_t)d.indexCount / 3;
     }
+    glBindVertexArray(0);
+}
 
-    // ---- Auto-fit camera (prevents black screen from scale) ----
-    Bounds b = computeBoundsFromPositions(positions.data(), posAcc.count, 3);
-    float cx = 0.5f * (b.minx + b.maxx);
-    float cy = 0.5f * (b.miny + b.maxy);
-    float cz = 0.5f * (b.minz + b.maxz);
-    float dx = (b.maxx - b.minx);
-    float dy = (b.maxy - b.miny);
-    float dz = (b.maxz - b.minz);
-    float radius = 0.5f * std::sqrt(dx * dx + dy * dy + dz * dz);
-    if (radius < 1e-6f)
-        radius = 1.0f;
+static void destroyArena(GeometryArena &a)
+{
+    glDeleteBuffers(1, &a.ebo);
+    glDeleteBuffers(1, &a.vbo);
+    glDeleteVertexArrays(1, &a.instancedVao);
+    glDeleteVertexArrays(1, &a.vao);
+}
 
-    // Camera distance: a bit more than radius so it fits
-    float camDist = radius * 2.5f;
+// ------------------ STREAMED UPLOADS ------------------
+// Arena contents reach the GPU through a fixed-size staging ring. Each frame copies
+// at most `budget` bytes into free ring space (mapped unsynchronized), and
+// glCopyBufferSubData moves them into the arena buffers. Every copy is fenced, and
+// ring space is reused only once its fence has signalled, so neither side waits.
 
-    // ---- GPU upload ----
-    GLuint VAO = 0, VBO = 0;
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
+struct UploadJob
+{
+    int arena;
+    GLuint dst;
+    const unsigned char *src; // CPU copy in the arena, freed once the arena is resident
+    size_t size;
+    size_t done = 0;
+};
 
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(drawVerts.size() * sizeof(float)),
-                 drawVerts.data(), GL_STATIC_DRAW);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void *)0);
-    glBindVertexArray(0);
+// Arenas the loader thread has finished filling. The loader publishes them as
+// soon as their contents are final; pumpUploads creates their buffers and queues
+// their uploads while the loader is still building the rest of the scene.
+struct ArenaHandoff
+{
+    std::mutex mutex;
+    std::vector<int> ready; // arena indices, in publication order
+    size_t taken = 0;       // entries of `ready` already queued (render thread only)
+};
 
-    GLint uMVP = glGetUniformLocation(prog, "MVP");
+static void publishArenas(ArenaHandoff &h, size_t count)
+{
+    std::lock_guard<std::mutex> lock(h.mutex);
+    for (size_t i = 0; i < count; i++)
+        h.ready.push_back((int)i);
+}
 
-    // ---- Main loop ----
-    while (!glfwWindowShouldClose(win))
-    {
-        glfwPollEvents();
+struct StagingSpan
+{
+    size_t begin, end;
+    GLsync fence;
+};
 
-        glClearColor(0.05f, 0.05f, 0.10f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+struct UploadQueue
+{
+    GLuint ring = 0;
+    size_t ringSize = 0;
+    size_t head = 0;
+    std::deque<StagingSpan> inFlight; // oldest first
 
-        // projection
-        Mat4 P = perspective(60.0f * 3.1415926f / 180.0f, (float)W / (float)H, 0.01f, camDist * 20.0f);
+    std::vector<UploadJob> jobs;
+    size_t next = 0;    // first unfinished job
+    size_t budget = 0;  // bytes per frame
+    size_t totalBytes = 0, uploadedBytes = 0;
+    ArenaHandoff *handoff = nullptr; // arenas arriving from the loader thread
 
-        // "view": translate scene so center is at origin, then move camera back.
-        // We don't implement full lookAt here; just center + z translation.
-        Mat4 centerToOrigin = translate(-cx, -cy, -cz);
-        Mat4 cameraBack = translate(0.0f, 0.0f, -camDist);
-        Mat4 V = mul(cameraBack, centerToOrigin);
+    bool idle() const { return next == jobs.size(); }
+};
 
-        Mat4 MVP = mul(P, V);
+static UploadQueue createUploadQueue(size_t budget)
+{
+    UploadQueue q;
+    q.budget = std::max<size_t>(budget, 64 * 1024);
+    q.ringSize = 3 * q.budget; // a frame being written plus two the GPU may still read
+    glGenBuffers(1, &q.ring);
+    glBindBuffer(GL_COPY_READ_BUFFER, q.ring);
+    glBufferData(GL_COPY_READ_BUFFER, (GLsizeiptr)q.ringSize, nullptr, GL_STREAM_DRAW);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    return q;
+}
 
-        glUseProgram(prog);
-        glUniformMatrix4fv(uMVP, 1, GL_FALSE, MVP.m);
+static void queueArenaUpload(UploadQueue &q, SceneGeometry &geo, int arenaIdx)
+{
+    GeometryArena &a = geo.arenas[arenaIdx];
+    UploadJob v{arenaIdx, a.vbo, a.vertices.data(), a.vertices.size()};
+    UploadJob i{arenaIdx, a.ebo, a.indices.data(), a.indices.size()};
+    for (const UploadJob &j : {v, i})
+    {
+        q.jobs.push_back(j);
+        q.totalBytes += j.size;
+        a.pendingUploads++;
+    }
+}
 
-        glBindVertexArray(VAO);
-        glDrawArrays(GL_TRIANGLES, 0, (GLsizei)(drawVerts.size() / 3));
-        glBindVertexArray(0);
+// Creates the buffers of the arenas published since the last call and queues
+// their contents. The loader does not touch an arena once it is published.
+static void takePublishedArenas(UploadQueue &q, SceneGeometry &geo)
+{
+    if (!q.handoff)
+        return;
+    std::vector<int> arrived;
+    {
+        std::lock_guard<std::mutex> lock(q.handoff->mutex);
+        arrived.assign(q.handoff->ready.begin() + (std::ptrdiff_t)q.handoff->taken, q.handoff->ready.end());
+        q.handoff->taken = q.handoff->ready.size();
+    }
+    for (int i : arrived)
+    {
+        createArenaBuffers(geo.arenas[i]);
+        queueArenaUpload(q, geo, i);
+    }
+}
 
-        glfwSwapBuffers(win);
+// Largest run of ring bytes starting at `head` that the GPU is done with.
+static size_t contiguousRingSpace(UploadQueue &q)
+{
+    if (q.inFlight.empty())
+    {
+        q.head = 0;
+        return q.ringSize;
+    }
+    size_t tail = q.inFlight.front().begin;
+    if (q.head > tail)
+    {
+        if (q.head < q.ringSize)
+            return q.ringSize - q.head;
+        q.head = 0; // wrap
+    }
+    return tail - q.head; // 0 when head caught up with tail: ring full
+}
 
-        if (glfwGetKey(win, GLFW_KEY_ESCAPE) == GLFW_PRESS)
-        {
+// Called once per frame before drawing, also while the scene is still loading.
+static void pumpUploads(UploadQueue &q, SceneGeometry &geo)
+{
+    takePublishedArenas(q, geo);
+
+    // Reclaim ring space whose copies have executed
+    while (!q.inFlight.empty())
+    {
+        GLenum r = glClientWaitSync(q.inFlight.front().fence, 0, 0);
+        if (r != GL_ALREADY_SIGNALED && r != GL_CONDITION_SATISFIED)
+            break;
+        glDeleteSync(q.inFlight.front().fence);
+        q.inFlight.pop_front();
+    }
+
+    size_t frameBytes = 0;
+    glBindBuffer(GL_COPY_READ_BUFFER, q.ring);
+    while (!q.idle() && frameBytes < q.budget)
+    {
+        size_t space = contiguousRingSpace(q);
+        if (space == 0)
+            break; // the GPU is behind; try again next frame
+        UploadJob &j = q.jobs[q.next];
+        size_t n = std::min(std::min(space, j.size - j.done), q.budget - frameBytes);
+
+        void *dst = glMapBufferRange(GL_COPY_READ_BUFFER, (GLintptr)q.head, (GLsizeiptr)n,
+                                     GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+        if (!dst)
+            break;
+        std::memcpy(dst, j.src + j.done, n);
+        glUnmapBuffer(GL_COPY_READ_BUFFER);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, j.dst);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, (GLintptr)q.head, (GLintptr)j.done,
+                            (GLsizeiptr)n);
+        q.inFlight.push_back(StagingSpan{q.head, q.head + n, glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0)});
+
+        q.head += n;
+        j.done += n;
+        frameBytes += n;
+        q.uploadedBytes += n;
+        if (j.done < j.size)
+            continue;
+
+        q.next++;
+        GeometryArena &a = geo.arenas[j.arena];
+        if (--a.pendingUploads == 0)
+        {
+            // Draws issued from now on are ordered after the copies
+            a.resident = true;
+            std::vector<unsigned char>().swap(a.vertices);
+            std::vector<unsigned char>().swap(a.indices);
+        }
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+}
+
+static void destroyUploadQueue(UploadQueue &q)
+{
+    for (const StagingSpan &s : q.inFlight)
+        glDeleteSync(s.fence);
+    q.inFlight.clear();
+    glDeleteBuffers(1, &q.ring);
+}
+
+// ------------------ FRUSTUM CULLING ------------------
+// A 4-wide BVH over world-space boxes (scene draws, forest instances). Each node
+// keeps its four child boxes in SoA form so one SSE pass classifies all four
+// against a frustum plane; subtrees found fully inside are accepted without
+// testing their contents.
+
+struct Frustum
+{
+    // plane i: a*x + b*y + c*z + d >= 0 on the inside
+    float a[6], b[6], c[6], d[6];
+};
+
+// Gribb/Hartmann: the planes are sums/differences of the rows of the clip matrix.
+static Frustum frustumFromMatrix(const Mat4 &vp)
+{
+    Frustum f;
+    for (int i = 0; i < 6; i++)
+    {
+        int row = i / 2;
+        float sign = (i & 1) ? -1.0f : 1.0f; // left/right, bottom/top, near/far
+        f.a[i] = vp.m[3] + sign * vp.m[row];
+        f.b[i] = vp.m[7] + sign * vp.m[4 + row];
+        f.c[i] = vp.m[11] + sign * vp.m[8 + row];
+        f.d[i] = vp.m[15] + sign * vp.m[12 + row];
+    }
+    return f;
+}
+
+// Classifies four boxes (SoA, unaligned) against the frustum. Bit i of `outside`
+// is set when box i is entirely behind some plane, bit i of `inside` when it is in
+// front of all six.
+static void classifyBoxes4(const float *minx, const float *miny, const float *minz,
+                           const float *maxx, const float *maxy, const float *maxz,
+                           const Frustum &f, int &outside, int &inside)
+{
+#if VIEWER_HAS_SSE
+    __m128 x0 = _mm_loadu_ps(minx), y0 = _mm_loadu_ps(miny), z0 = _mm_loadu_ps(minz);
+    __m128 x1 = _mm_loadu_ps(maxx), y1 = _mm_loadu_ps(maxy), z1 = _mm_loadu_ps(maxz);
+    __m128 zero = _mm_setzero_ps();
+    __m128 out = zero;
+    __m128 in = _mm_cmpeq_ps(zero, zero);
+    for (int p = 0; p < 6; p++)
+    {
+        // The corner furthest along the plane normal decides "outside",
+        // the opposite corner decides "inside".
+        __m128 a = _mm_set1_ps(f.a[p]), b = _mm_set1_ps(f.b[p]), c = _mm_set1_ps(f.c[p]);
+        __m128 farDist = _mm_add_ps(_mm_mul_ps(a, f.a[p] >= 0.0f ? x1 : x0), _mm_set1_ps(f.d[p]));
+        farDist = _mm_add_ps(farDist, _mm_mul_ps(b, f.b[p] >= 0.0f ? y1 : y0));
+        farDist = _mm_add_ps(farDist, _mm_mul_ps(c, f.c[p] >= 0.0f ? z1 : z0));
+        __m128 nearDist = _mm_add_ps(_mm_mul_ps(a, f.a[p] >= 0.0f ? x0 : x1), _mm_set1_ps(f.d[p]));
+        nearDist = _mm_add_ps(nearDist, _mm_mul_ps(b, f.b[p] >= 0.0f ? y0 : y1));
+        nearDist = _mm_add_ps(nearDist, _mm_mul_ps(c, f.c[p] >= 0.0f ? z0 : z1));
+        out = _mm_or_ps(out, _mm_cmplt_ps(farDist, zero));
+        in = _mm_and_ps(in, _mm_cmpge_ps(nearDist, zero));
+    }
+    outside = _mm_movemask_ps(out);
+    inside = _mm_movemask_ps(in);
+#else
+    outside = 0;
+    inside = 0xF;
+    for (int i = 0; i < 4; i++)
+    {
+        for (int p = 0; p < 6; p++)
+        {
+            float farDist = f.a[p] * (f.a[p] >= 0.0f ? maxx[i] : minx[i]) + f.b[p] * (f.b[p] >= 0.0f ? maxy[i] : miny[i]) +
+                        f.c[p] * (f.c[p] >= 0.0f ? maxz[i] : minz[i]) + f.d[p];
+            float nearDist = f.a[p] * (f.a[p] >= 0.0f ? minx[i] : maxx[i]) + f.b[p] * (f.b[p] >= 0.0f ? miny[i] : maxy[i]) +
+                         f.c[p] * (f.c[p] >= 0.0f ? minz[i] : maxz[i]) + f.d[p];
+            if (farDist < 0.0f)
+                outside |= 1 << i;
+            if (nearDist < 0.0f)
+                inside &= ~(1 << i);
+        }
+    }
+#endif
+}
+
+struct CullNode
+{
+    float minx[4], miny[4], minz[4], maxx[4], maxy[4], maxz[4];
+    int32_t node[4];   // inner child node, or -1 for a leaf
+    uint32_t first[4]; // every subtree owns a contiguous run of CullBvh::items
+    uint32_t count[4]; // 0 marks an unused slot
+};
+
+struct CullBvh
+{
+    std::vector<CullNode> nodes; // nodes[0] is the root
+    std::vector<uint32_t> items; // caller's ids in leaf order
+    // Item boxes in leaf order, SoA, padded so 4-wide loads never run off the end
+    std::vector<float> minx, miny, minz, maxx, maxy, maxz;
+};
+
+struct CullStats
+{
+    size_t tested = 0; // boxes tested, nodes and items
+    size_t culled = 0;
+    size_t drawn = 0;
+};
+
+static const uint32_t kCullLeafSize = 8;
+
+// Twice the box center along `axis`; only ever compared, so the halving is skipped
+static float centroid2(const Bounds &b, int axis)
+{
+    return axis == 0 ? b.minx + b.maxx : axis == 1 ? b.miny + b.maxy : b.minz + b.maxz;
+}
+
+static void growBounds(Bounds &b, const Bounds &o)
+{
+    b.minx = std::min(b.minx, o.minx);
+    b.miny = std::min(b.miny, o.miny);
+    b.minz = std::min(b.minz, o.minz);
+    b.maxx = std::max(b.maxx, o.maxx);
+    b.maxy = std::max(b.maxy, o.maxy);
+    b.maxz = std::max(b.maxz, o.maxz);
+}
+
+static int buildCullNode(CullBvh &bvh, const std::vector<Bounds> &boxes, uint32_t begin, uint32_t end)
+{
+    int nodeIdx = (int)bvh.nodes.size();
+    bvh.nodes.push_back(CullNode{});
+
+    // Split along the widest axis of the centroids into four equal runs
+    Bounds cb = emptyBounds();
+    for (uint32_t i = begin; i < end; i++)
+    {
+        const Bounds &b = boxes[bvh.items[i]];
+        float cx = centroid2(b, 0), cy = centroid2(b, 1), cz = centroid2(b, 2);
+        growBounds(cb, Bounds{cx, cy, cz, cx, cy, cz});
+    }
+    float ext[3] = {cb.maxx - cb.minx, cb.maxy - cb.miny, cb.maxz - cb.minz};
+    int axis = ext[1] > ext[0] ? (ext[2] > ext[1] ? 2 : 1) : (ext[2] > ext[0] ? 2 : 0);
+    std::sort(bvh.items.begin() + begin, bvh.items.begin() + end, [&](uint32_t l, uint32_t r)
+              { return centroid2(boxes[l], axis) < centroid2(boxes[r], axis); });
+
+    uint32_t n = end - begin;
+    for (int s = 0; s < 4; s++)
+    {
+        uint32_t b0 = begin + n * s / 4, b1 = begin + n * (s + 1) / 4;
+        Bounds sb = emptyBounds();
+        for (uint32_t i = b0; i < b1; i++)
+            growBounds(sb, boxes[bvh.items[i]]);
+        int child = -1;
+        if (b1 - b0 > kCullLeafSize)
+            child = buildCullNode(bvh, boxes, b0, b1);
+
+        CullNode &node = bvh.nodes[nodeIdx]; // the recursion may have reallocated
+        node.minx[s] = sb.minx, node.miny[s] = sb.miny, node.minz[s] = sb.minz;
+        node.maxx[s] = sb.maxx, node.maxy[s] = sb.maxy, node.maxz[s] = sb.maxz;
+        node.node[s] = child;
+        node.first[s] = b0;
+        node.count[s] = b1 - b0;
+    }
+    return nodeIdx;
+}
+
+static CullBvh buildCullBvh(const std::vector<Bounds> &boxes)
+{
+    CullBvh bvh;
+    if (boxes.empty())
+        return bvh;
+    bvh.items.resize(boxes.size());
+    for (size_t i = 0; i < boxes.size(); i++)
+        bvh.items[i] = (uint32_t)i;
+    buildCullNode(bvh, boxes, 0, (uint32_t)boxes.size());
+
+    size_t padded = (boxes.size() + 3) & ~(size_t)3;
+    for (std::vector<float> *v : {&bvh.minx, &bvh.miny, &bvh.minz, &bvh.maxx, &bvh.maxy, &bvh.maxz})
+        v->assign(padded + 4, 0.0f);
+    for (size_t i = 0; i < boxes.size(); i++)
+    {
+        const Bounds &b = boxes[bvh.items[i]];
+        bvh.minx[i] = b.minx, bvh.miny[i] = b.miny, bvh.minz[i] = b.minz;
+        bvh.maxx[i] = b.maxx, bvh.maxy[i] = b.maxy, bvh.maxz[i] = b.maxz;
+    }
+    return bvh;
+}
+
+// Appends the ids of every item that may touch the frustum to `visible`.
+static void cullBvh(const CullBvh &bvh, const Frustum &f, std::vector<uint32_t> &visible,
+                    std::vector<int> &stack, CullStats &stats)
+{
+    visible.clear();
+    stats = CullStats();
+    if (bvh.nodes.empty())
+        return;
+
+    stack.clear();
+    stack.push_back(0);
+    while (!stack.empty())
+    {
+        const CullNode &node = bvh.nodes[stack.back()];
+        stack.pop_back();
+
+        int outside, inside;
+        classifyBoxes4(node.minx, node.miny, node.minz, node.maxx, node.maxy, node.maxz, f, outside, inside);
+        for (int s = 0; s < 4; s++)
+        {
+            if (node.count[s] == 0)
+                continue;
+            stats.tested++;
+            if (outside & (1 << s))
+                continue;
+            if (inside & (1 << s))
+            {
+                visible.insert(visible.end(), bvh.items.begin() + node.first[s],
+                               bvh.items.begin() + node.first[s] + node.count[s]);
+                continue;
+            }
+            if (node.node[s] >= 0)
+            {
+                stack.push_back(node.node[s]);
+                continue;
+            }
+
+            // Straddling leaf: test its items four at a time
+            for (uint32_t i = 0; i < node.count[s]; i += 4)
+            {
+                uint32_t k = node.first[s] + i;
+                uint32_t lanes = std::min<uint32_t>(4, node.count[s] - i);
+                int itemOutside, itemInside;
+                classifyBoxes4(&bvh.minx[k], &bvh.miny[k], &bvh.minz[k], &bvh.maxx[k], &bvh.maxy[k], &bvh.maxz[k],
+                               f, itemOutside, itemInside);
+                stats.tested += lanes;
+                for (uint32_t l = 0; l < lanes; l++)
+                    if (!(itemOutside & (1 << l)))
+                        visible.push_back(bvh.items[k + l]);
+            }
+        }
+    }
+    stats.drawn = visible.size();
+    stats.culled = bvh.items.size() - visible.size();
+}
+
+static std::string cullLabel(bool enabled, const CullStats &stats)
+{
+    if (!enabled)
+        return "culling off";
+    return "cull " + std::to_string(stats.tested) + " tested, " + std::to_string(stats.culled) + " culled, " +
+           std::to_string(stats.drawn) + " drawn";
+}
+
+// ------------------ BILLBOARD FOREST ------------------
+
+struct BillboardInstance
+{
+    float x, y, z;  // base of the trunk, world space
+    float scale;    // multiplies the quad size
+    uint32_t cell;  // impostor atlas cell
+};
+
+struct ImpostorAtlas
+{
+    GLuint tex = 0;
+    int cols = 1, rows = 1;
+};
+
+// Loads `path` as the impostor atlas. When it can't be read a small procedural
+// tree-silhouette atlas is generated instead, so billboard mode always works.
+static ImpostorAtlas loadImpostorAtlas(const std::string &path, int cols, int rows)
+{
+    ImpostorAtlas atlas;
+    atlas.cols = std::max(cols, 1);
+    atlas.rows = std::max(rows, 1);
+
+    int w = 0, h = 0, comp = 0;
+    std::vector<unsigned char> pixels;
+    unsigned char *data = path.empty() ? nullptr : stbi_load(path.c_str(), &w, &h, &comp, 4);
+    if (data)
+    {
+        pixels.assign(data, data + (size_t)w * h * 4);
+        stbi_image_free(data);
+    }
+    else
+    {
+        if (!path.empty())
+            std::cerr << "Could not read impostor atlas " << path << ", using a procedural one\n";
+        const int cw = 64, ch = 128;
+        w = cw * atlas.cols;
+        h = ch * atlas.rows;
+        pixels.assign((size_t)w * h * 4, 0);
+        for (int cell = 0; cell < atlas.cols * atlas.rows; cell++)
+        {
+            int ox = (cell % atlas.cols) * cw, oy = (cell / atlas.cols) * ch;
+            float tint = 0.6f + 0.4f * (float)cell / (float)(atlas.cols * atlas.rows);
+            for (int y = 0; y < ch; y++)
+            {
+                for (int x = 0; x < cw; x++)
+                {
+                    float u = (x + 0.5f) / cw - 0.5f; // -0.5..0.5
+                    float v = 1.0f - (y + 0.5f) / ch; // 0 at the bottom
+                    unsigned char *px = &pixels[((size_t)(oy + y) * w + (ox + x)) * 4];
+                    if (v < 0.25f && std::fabs(u) < 0.06f)
+                    {
+                        px[0] = 90, px[1] = 60, px[2] = 30, px[3] = 255; // trunk
+                    }
+                    else if (v >= 0.2f && std::fabs(u) < 0.45f * (1.0f - (v - 0.2f) / 0.8f))
+                    {
+                        px[0] = (unsigned char)(40 * tint);
+                        px[1] = (unsigned char)(170 * tint);
+                        px[2] = (unsigned char)(60 * tint);
+                        px[3] = 255; // crown
+                    }
+                }
+            }
+        }
+    }
+
+    glGenTextures(1, &atlas.tex);
+    glBindTexture(GL_TEXTURE_2D, atlas.tex);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    glGenerateMipmap(GL_TEXTURE_2D);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return atlas;
+}
+
+// Scatters `count` trees on a jittered square grid in the XZ plane around the origin.
+static std::vector<BillboardInstance> scatterForest(size_t count, float spacing, uint32_t cells)
+{
+    std::vector<BillboardInstance> trees(count);
+    size_t side = (size_t)std::ceil(std::sqrt((double)count));
+    float half = 0.5f * spacing * (float)side;
+    uint32_t rng = 0x9E3779B9u; // fixed seed: the same forest every run
+    auto next = [&rng]()
+    {
+        rng ^= rng << 13;
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+        return (float)(rng & 0xFFFFFF) / (float)0x1000000; // 0..1
+    };
+    for (size_t i = 0; i < count; i++)
+    {
+        BillboardInstance &t = trees[i];
+        t.x = (float)(i % side) * spacing - half + (next() - 0.5f) * spacing * 0.8f;
+        t.z = (float)(i / side) * spacing - half + (next() - 0.5f) * spacing * 0.8f;
+        t.y = 0.0f;
+        t.scale = 0.7f + 0.6f * next();
+        t.cell = (uint32_t)(next() * (float)cells) % std::max(cells, 1u);
+    }
+    return trees;
+}
+
+struct BillboardBatch
+{
+    GLuint vao = 0, instanceVbo = 0;
+    GLsizei count = 0;
+};
+
+static BillboardBatch uploadBillboards(const std::vector<BillboardInstance> &trees)
+{
+    BillboardBatch bb;
+    bb.count = (GLsizei)trees.size();
+    glGenVertexArrays(1, &bb.vao);
+    glGenBuffers(1, &bb.instanceVbo);
+
+    glBindVertexArray(bb.vao);
+    glBindBuffer(GL_ARRAY_BUFFER, bb.instanceVbo);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(trees.size() * sizeof(BillboardInstance)), trees.data(),
+                 GL_STATIC_DRAW);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(BillboardInstance), (void *)0);
+    glVertexAttribDivisor(1, 1);
+    glEnableVertexAttribArray(2);
+    glVertexAttribIPointer(2, 1, GL_UNSIGNED_INT, sizeof(BillboardInstance),
+                           (void *)offsetof(BillboardInstance, cell));
+    glVertexAttribDivisor(2, 1);
+    glBindVertexArray(0);
+    return bb;
+}
+
+// ------------------ LOD SELECTION ------------------
+// Every forest instance picks, each frame, one of: the full mesh, one of the
+// MSFT_lod simplified meshes, or the impostor billboard. The choice follows the
+// projected size of the tree's bounding sphere and a global triangle budget.
+
+struct LodLevel
+{
+    std::vector<DrawCmd> draws;
+    size_t triangles = 0;
+    float coverage = 0.0f; // lowest screen coverage (sphere diameter / viewport height) this level is used at
+    size_t source = 0;     // index in the MSFT_lod chain (0 = the node itself), which coverages are keyed by
+};
+
+struct LodSet
+{
+    std::vector<LodLevel> levels; // mesh levels, finest first; the billboard comes after the last one
+    Mat4 toInstance;              // moves the tree so its base sits at the instance origin
+    float radius = 1.0f;          // bounding sphere of the finest level
+    float centerHeight = 0.0f;    // sphere center above the instance origin
+};
+
+// Builds the mesh levels. With an MSFT_lod node the levels are that node followed
+// by its `lods`; without one the whole scene is the only mesh level. Thresholds
+// come from `--lod-coverage`, then the node's MSFT_screencoverage extras, then a
+// geometric default, all indexed by position in the MSFT_lod chain. Levels that
+// are missing or have no meshes are left out with a warning; the others keep
+// their chain index. Must run before the arenas are uploaded.
+static LodSet buildLodSet(const tinygltf::Model &model, SceneGeometry &geo, const std::vector<float> &coverageOverride)
+{
+    LodSet set;
+    Bounds fine = geo.bounds;
+
+    if (geo.lodRoot >= 0)
+    {
+        const tinygltf::Node &root = model.nodes[geo.lodRoot];
+        std::vector<int> nodes(1, geo.lodRoot);
+        nodes.insert(nodes.end(), root.lods.begin(), root.lods.end());
+
+        const tinygltf::Value &extras = root.extras;
+        const tinygltf::Value *cov = nullptr;
+        if (coverageOverride.empty() && extras.Has("MSFT_screencoverage") &&
+            extras.Get("MSFT_screencoverage").IsArray())
+            cov = &extras.Get("MSFT_screencoverage");
+
+        std::vector<int> visiting(model.nodes.size(), 0);
+        for (size_t i = 0; i < nodes.size(); i++)
+        {
+            if (nodes[i] < 0 || nodes[i] >= (int)model.nodes.size())
+            {
+                std::cerr << "MSFT_lod: node " << geo.lodRoot << " level " << i << " references missing node "
+                          << nodes[i] << "; level skipped\n";
+                continue;
+            }
+            LodLevel level;
+            level.source = i;
+            Bounds b = emptyBounds();
+            collectNode(model, nodes[i], geo.lodParent, geo, level.draws, b, visiting);
+            if (level.draws.empty())
+            {
+                std::cerr << "MSFT_lod: node " << geo.lodRoot << " level " << i << " (node " << nodes[i]
+                          << ") has no meshes; level skipped\n";
+                continue;
+            }
+            if (set.levels.empty())
+                fine = b; // the finest level that is drawn sizes the tree
+            if (cov && i < cov->ArrayLen() && cov->Get((int)i).IsNumber())
+                level.coverage = (float)cov->Get((int)i).GetNumberAsDouble();
+            sortDraws(level.draws);
+            set.levels.push_back(std::move(level));
+        }
+    }
+
+    if (set.levels.empty())
+    {
+        LodLevel level;
+        level.draws = geo.draws;
+        set.levels.push_back(std::move(level));
+    }
+
+    for (size_t i = 0; i < set.levels.size(); i++)
+    {
+        LodLevel &level = set.levels[i];
+        for (const DrawCmd &d : level.draws)
+            level.triangles += (size_t)d.indexCount / 3;
+
+        if (level.source < coverageOverride.size())
+            level.coverage = coverageOverride[level.source];
+        else if (level.coverage <= 0.0f)
+            level.coverage = 0.3f * std::pow(0.35f, (float)level.source);
+        // Thresholds must shrink with the level or some levels could never be picked
+        if (i > 0)
+            level.coverage = std::min(level.coverage, set.levels[i - 1].coverage);
+    }
+
+    float dx = fine.maxx - fine.minx, dy = fine.maxy - fine.miny, dz = fine.maxz - fine.minz;
+    set.radius = std::max(0.5f * std::sqrt(dx * dx + dy * dy + dz * dz), 1e-6f);
+    set.centerHeight = 0.5f * dy;
+    set.toInstance = translate(-0.5f * (fine.minx + fine.maxx), -fine.miny, -0.5f * (fine.minz + fine.maxz));
+    for (LodLevel &level : set.levels)
+        for (DrawCmd &d : level.draws)
+            d.model = mul(set.toInstance, d.model);
+    return set;
+}
+
+struct LodStats
+{
+    std::vector<size_t> perLevel; // instances drawn with each mesh level
+    size_t billboards = 0;
+    size_t demoted = 0;           // wanted a mesh level but the budget ran out
+    size_t triangles = 0;         // mesh triangles submitted this frame
+};
+
+// Sorts the visible instances into one bucket per mesh level plus a final billboard bucket.
+// Instances that want a mesh are served nearest-first (largest coverage), and each
+// falls back to coarser levels, then the billboard, once `triBudget` is spent.
+static void selectLods(const LodSet &set, const std::vector<BillboardInstance> &trees,
+                       const std::vector<uint32_t> &visible, const Vec3 &eye, float tanHalfFov, size_t triBudget, std::vector<std::vector<BillboardInstance>> &buckets,
+                       std::vector<std::pair<float, uint32_t>> &candidates, LodStats &stats)
+{
+    const size_t n = set.levels.size();
+    buckets.resize(n + 1);
+    for (std::vector<BillboardInstance> &b : buckets)
+        b.clear();
+    candidates.clear();
+    stats.perLevel.assign(n, 0);
+    stats.billboards = stats.demoted = stats.triangles = 0;
+
+    const float minCoverage = set.levels.back().coverage;
+    for (uint32_t i : visible)
+    {
+        const BillboardInstance &t = trees[i];
+        Vec3 c{t.x, t.y + set.centerHeight * t.scale, t.z};
+        Vec3 d = sub(c, eye);
+        float dist = std::max(std::sqrt(dot(d, d)), 1e-4f);
+        float coverage = set.radius * t.scale / (dist * tanHalfFov);
+        if (coverage >= minCoverage)
+            candidates.push_back(std::make_pair(coverage, i));
+        else
+            buckets[n].push_back(t);
+    }
+
+    std::sort(candidates.begin(), candidates.end(),
+              [](const std::pair<float, uint32_t> &a, const std::pair<float, uint32_t> &b)
+              { return a.first > b.first; });
+
+    size_t remaining = triBudget;
+    for (const std::pair<float, uint32_t> &c : candidates)
+    {
+        size_t want = 0;
+        while (want + 1 < n && c.first < set.levels[want].coverage)
+            want++;
+
+        size_t level = want;
+        while (level < n && set.levels[level].triangles > remaining)
+            level++;
+
+        if (level == n)
+            stats.demoted++;
+        else
+        {
+            remaining -= set.levels[level].triangles;
+            stats.triangles += set.levels[level].triangles;
+            stats.perLevel[level]++;
+        }
+        buckets[level].push_back(trees[c.second]);
+    }
+    stats.billboards = buckets[n].size();
+}
+
+static std::string lodLabel(const LodStats &stats)
+{
+    std::string s = "LOD";
+    for (size_t i = 0; i < stats.perLevel.size(); i++)
+        s += (i ? "/" : " ") + std::to_string(stats.perLevel[i]);
+    s += " + " + std::to_string(stats.billboards) + " bb";
+    if (stats.demoted)
+        s += " (" + std::to_string(stats.demoted) + " over budget)";
+    s += ", " + std::to_string(stats.triangles / 1000) + "k tris";
+    return s;
+}
+
+// Per-frame instance data for LOD mode: every bucket is streamed into one VBO,
+// mesh levels first, then the billboards.
+struct LodStream
+{
+    GLuint vbo = 0;
+    GLuint billboardVao = 0;
+    std::vector<BillboardInstance> packed;
+    std::vector<size_t> first; // first instance of each bucket in `packed`
+};
+
+static LodStream createLodStream()
+{
+    LodStream ls;
+    glGenBuffers(1, &ls.vbo);
+    glGenVertexArrays(1, &ls.billboardVao);
+    glBindVertexArray(ls.billboardVao);
+    glEnableVertexAttribArray(1);
+    glVertexAttribDivisor(1, 1);
+    glEnableVertexAttribArray(2);
+    glVertexAttribDivisor(2, 1);
+    glBindVertexArray(0);
+    return ls;
+}
+
+static void uploadLodStream(LodStream &ls, const std::vector<std::vector<BillboardInstance>> &buckets)
+{
+    ls.packed.clear();
+    ls.first.clear();
+    for (const std::vector<BillboardInstance> &b : buckets)
+    {
+        ls.first.push_back(ls.packed.size());
+        ls.packed.insert(ls.packed.end(), b.begin(), b.end());
+    }
+    GLsizeiptr bytes = (GLsizeiptr)(ls.packed.size() * sizeof(BillboardInstance));
+    glBindBuffer(GL_ARRAY_BUFFER, ls.vbo);
+    glBufferData(GL_ARRAY_BUFFER, bytes, nullptr, GL_STREAM_DRAW); // orphan last frame's storage
+    glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, ls.packed.data());
+}
+
+// Draws every mesh level with one instanced call per draw command. Expects `prog`
+// bound with VP already set.
+static void drawLodMeshes(const SceneGeometry &geo, const LodSet &set, const LodStream &ls,
+                          const std::vector<std::vector<BillboardInstance>> &buckets, GLint uModel,
+                          FrameCounters &counters)
+{
+    glBindBuffer(GL_ARRAY_BUFFER, ls.vbo);
+    for (size_t l = 0; l < set.levels.size(); l++)
+    {
+        GLsizei count = (GLsizei)buckets[l].size();
+        if (count == 0)
+            continue;
+        void *offset = (void *)(ls.first[l] * sizeof(BillboardInstance));
+        int boundArena = -1;
+        for (const DrawCmd &d : set.levels[l].draws)
+        {
+            if (!geo.arenas[d.arena].resident)
+                continue;
+            if (d.arena != boundArena)
+            {
+                glBindVertexArray(geo.arenas[d.arena].instancedVao);
+                glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(BillboardInstance), offset);
+                boundArena = d.arena;
+            }
+            glUniformMatrix4fv(uModel, 1, GL_FALSE, d.model.m);
+            glDrawElementsInstancedBaseVertex(GL_TRIANGLES, d.indexCount, d.indexType, (void *)d.indexOffset,
+                                              count, d.baseVertex);
+            counters.drawCalls++;
+            counters.triangles += (size_t)d.indexCount / 3 * (size_t)count;
+        }
+    }
+    glBindVertexArray(0);
+}
+
+// Points the billboard VAO at the billboard bucket of this frame's stream.
+static void bindLodBillboards(const LodStream &ls)
+{
+    size_t offset = ls.first.back() * sizeof(BillboardInstance);
+    glBindVertexArray(ls.billboardVao);
+    glBindBuffer(GL_ARRAY_BUFFER, ls.vbo);
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(BillboardInstance), (void *)offset);
+    glVertexAttribIPointer(2, 1, GL_UNSIGNED_INT, sizeof(BillboardInstance),
+                           (void *)(offset + offsetof(BillboardInstance, cell)));
+}
+
+// ------------------ FRAME TIMER ------------------
+// Averages CPU frame time over ~1 s windows and shows it in the window title.
+
+struct FrameTimer
+{
+    double windowStart = 0.0;
+    double last = 0.0;
+    double worst = 0.0;
+    int frames = 0;
+};
+
+// Returns the delta time of the frame that just finished.
+static float tickFrameTimer(FrameTimer &ft, GLFWwindow *win, const std::string &label)
+{
+    double now = glfwGetTime();
+    if (ft.frames == 0 && ft.windowStart == 0.0)
+        ft.windowStart = ft.last = now;
+    double dt = now - ft.last;
+    ft.last = now;
+    ft.worst = std::max(ft.worst, dt);
+    ft.frames++;
+
+    double elapsed = now - ft.windowStart;
+    if (elapsed >= 1.0)
+    {
+        double avgMs = 1000.0 * elapsed / ft.frames;
+        char title[256];
+        std::snprintf(title, sizeof(title), "GLB Tree | %s | %.2f ms avg, %.2f ms worst (%.0f fps)",
+                      label.c_str(), avgMs, 1000.0 * ft.worst, 1000.0 / avgMs);
+        glfwSetWindowTitle(win, title);
+        ft.windowStart = now;
+        ft.frames = 0;
+        ft.worst = 0.0;
+    }
+    return (float)dt;
+}
+
+// ------------------ FRAME PROFILER ------------------
+// CPU time per main-loop stage from scoped timers, GPU time per stage from
+// GL_TIME_ELAPSED queries. Queries are double-buffered: a frame's results are
+// read two frames later, and only once the driver reports them available, so
+// reading never stalls. When both query sets are still in flight the frame
+// goes untimed on the GPU side rather than waiting.
+
+enum CpuStage
+{
+    kCpuPoll,
+    kCpuUpload,
+    kCpuUpdate,
+    kCpuCull,
+    kCpuSubmit,
+    kCpuHud,
+    kCpuSwap,
+    kCpuStageCount
+};
+static const char *kCpuStageNames[kCpuStageCount] = {"poll", "upload", "update", "cull", "submit", "hud", "swap"};
+
+enum GpuStage
+{
+    kGpuUpload,
+    kGpuScene,
+    kGpuHud,
+    kGpuStageCount
+};
+static const char *kGpuStageNames[kGpuStageCount] = {"upload", "scene", "hud"};
+
+// GL_ARB_pipeline_statistics_query targets, collected around the scene stage
+enum PipelineStat
+{
+    kStatVertices,
+    kStatPrimitives,
+    kStatClipped,
+    kStatFragments,
+    kPipelineStatCount
+};
+static const GLenum kPipelineStatTargets[kPipelineStatCount] = {
+    GL_VERTEX_SHADER_INVOCATIONS_ARB, GL_PRIMITIVES_SUBMITTED_ARB, GL_CLIPPING_OUTPUT_PRIMITIVES_ARB,
+    GL_FRAGMENT_SHADER_INVOCATIONS_ARB};
+static const char *kPipelineStatNames[kPipelineStatCount] = {"VS invocations", "primitives submitted",
+                                                             "primitives after clip", "FS invocations"};
+
+struct FrameSample
+{
+    uint64_t frame = 0;
+    double cpuMs[kCpuStageCount] = {};
+    double gpuMs[kGpuStageCount] = {}; // -1 when the stage didn't run
+    GLuint64 pipeline[kPipelineStatCount] = {};
+    bool gpuValid = false;
+    FrameCounters counters;
+};
+
+struct FrameProfiler
+{
+    struct Slot
+    {
+        GLuint time[kGpuStageCount] = {};
+        GLuint stats[kPipelineStatCount] = {};
+        bool used[kGpuStageCount] = {};
+        bool statsUsed = false;
+        bool pending = false; // queries issued, results not read yet
+        FrameSample sample;
+    };
+    Slot slots[2];
+    int current = 0;
+    bool recording = false;  // current slot takes GPU queries this frame
+    bool pipelineStats = false;
+
+    FrameSample frame;       // being filled this frame
+    FrameSample lastCpu;     // previous frame, complete on the CPU side
+    FrameSample lastGpu;     // most recent frame with GPU results
+    std::vector<float> history; // CPU frame ms, for the HUD plot
+    std::FILE *csv = nullptr;
+    bool keepSamples = false;   // collect every finished frame, for --bench
+    std::vector<FrameSample> samples;
+};
+
+static void createProfiler(FrameProfiler &p, bool pipelineStats, const std::string &csvPath)
+{
+    p.pipelineStats = pipelineStats;
+    for (FrameProfiler::Slot &s : p.slots)
+    {
+        glGenQueries(kGpuStageCount, s.time);
+        if (pipelineStats)
+            glGenQueries(kPipelineStatCount, s.stats);
+    }
+    p.history.assign(120, 0.0f);
+
+    if (!csvPath.empty())
+    {
+        p.csv = std::fopen(csvPath.c_str(), "w");
+        if (!p.csv)
+        {
+            std::cerr << "Could not open " << csvPath << " for writing\n";
+            return;
+        }
+        // Rows are written when a frame's GPU results land, so they may arrive out of order
+        std::fprintf(p.csv, "frame");
+        for (const char *n : kCpuStageNames)
+            std::fprintf(p.csv, ",cpu_%s_ms", n);
+        for (const char *n : kGpuStageNames)
+            std::fprintf(p.csv, ",gpu_%s_ms", n);
+        std::fprintf(p.csv, ",draw_calls,triangles,vs_invocations,primitives,clipped_primitives,fs_invocations\n");
+    }
+}
+
+// Called once per frame when its results are final (GPU columns may be empty).
+static void finishSample(FrameProfiler &p, const FrameSample &s)
+{
+    if (p.keepSamples)
+        p.samples.push_back(s);
+    if (!p.csv)
+        return;
+    std::fprintf(p.csv, "%llu", (unsigned long long)s.frame);
+    for (double ms : s.cpuMs)
+        std::fprintf(p.csv, ",%.4f", ms);
+    for (double ms : s.gpuMs)
+    {
+        if (s.gpuValid && ms >= 0.0)
+            std::fprintf(p.csv, ",%.4f", ms);
+        else
+            std::fprintf(p.csv, ",");
+    }
+    std::fprintf(p.csv, ",%zu,%zu", s.counters.drawCalls, s.counters.triangles);
+    for (GLuint64 v : s.pipeline)
+    {
+        if (s.gpuValid && p.pipelineStats)
+            std::fprintf(p.csv, ",%llu", (unsigned long long)v);
+        else
+            std::fprintf(p.csv, ",");
+    }
+    std::fprintf(p.csv, "\n");
+}
+
+// Reads back a slot's queries if the GPU has finished them. Never blocks.
+static bool harvestSlot(FrameProfiler &p, FrameProfiler::Slot &s)
+{
+    if (!s.pending)
+        return true;
+    for (int i = 0; i < kGpuStageCount + kPipelineStatCount; i++)
+    {
+        bool isTime = i < kGpuStageCount;
+        if (isTime ? !s.used[i] : !s.statsUsed)
+            continue;
+        GLuint available = GL_FALSE;
+        glGetQueryObjectuiv(isTime ? s.time[i] : s.stats[i - kGpuStageCount], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+            return false;
+    }
+
+    for (int i = 0; i < kGpuStageCount; i++)
+    {
+        GLuint64 ns = 0;
+        if (s.used[i])
+            glGetQueryObjectui64v(s.time[i], GL_QUERY_RESULT, &ns);
+        s.sample.gpuMs[i] = s.used[i] ? (double)ns * 1e-6 : -1.0;
+    }
+    for (int i = 0; i < kPipelineStatCount; i++)
+    {
+        s.sample.pipeline[i] = 0;
+        if (s.statsUsed)
+            glGetQueryObjectui64v(s.stats[i], GL_QUERY_RESULT, &s.sample.pipeline[i]);
+    }
+    s.sample.gpuValid = true;
+    s.pending = false;
+    p.lastGpu = s.sample;
+    finishSample(p, s.sample);
+    return true;
+}
+
+static void beginProfilerFrame(FrameProfiler &p, uint64_t frame)
+{
+    p.current ^= 1;
+    FrameProfiler::Slot &s = p.slots[p.current];
+    p.recording = harvestSlot(p, s);
+    harvestSlot(p, p.slots[p.current ^ 1]); // pick the other one up early if it's ready
+
+    p.frame = FrameSample();
+    p.frame.frame = frame;
+    if (p.recording)
+    {
+        for (bool &u : s.used)
+            u = false;
+        s.statsUsed = false;
+    }
+}
+
+static void beginGpuStage(FrameProfiler &p, GpuStage stage)
+{
+    if (!p.recording)
+        return;
+    FrameProfiler::Slot &s = p.slots[p.current];
+    glBeginQuery(GL_TIME_ELAPSED, s.time[stage]);
+    s.used[stage] = true;
+}
+
+static void endGpuStage(FrameProfiler &p)
+{
+    if (p.recording)
+        glEndQuery(GL_TIME_ELAPSED);
+}
+
+static void beginPipelineStats(FrameProfiler &p)
+{
+    if (!p.recording || !p.pipelineStats)
+        return;
+    FrameProfiler::Slot &s = p.slots[p.current];
+    for (int i = 0; i < kPipelineStatCount; i++)
+        glBeginQuery(kPipelineStatTargets[i], s.stats[i]);
+    s.statsUsed = true;
+}
+
+static void endPipelineStats(FrameProfiler &p)
+{
+    if (!p.recording || !p.pipelineStats)
+        return;
+    for (int i = 0; i < kPipelineStatCount; i++)
+        glEndQuery(kPipelineStatTargets[i]);
+}
+
+static void endProfilerFrame(FrameProfiler &p)
+{
+    double total = 0.0;
+    for (double ms : p.frame.cpuMs)
+        total += ms;
+    p.history.erase(p.history.begin());
+    p.history.push_back((float)total);
+    p.lastCpu = p.frame;
+
+    if (p.recording)
+    {
+        FrameProfiler::Slot &s = p.slots[p.current];
+        s.sample = p.frame;
+        s.pending = true;
+    }
+    else
+    {
+        finishSample(p, p.frame); // GPU columns left empty
+    }
+}
+
+// Waits for every query still in flight; for the end of a run, where stalling is fine.
+static void flushProfiler(FrameProfiler &p)
+{
+    glFinish();
+    harvestSlot(p, p.slots[p.current ^ 1]);
+    harvestSlot(p, p.slots[p.current]);
+}
+
+static void destroyProfiler(FrameProfiler &p)
+{
+    for (FrameProfiler::Slot &s : p.slots)
+    {
+        glDeleteQueries(kGpuStageCount, s.time);
+        if (p.pipelineStats)
+            glDeleteQueries(kPipelineStatCount, s.stats);
+    }
+    if (p.csv)
+        std::fclose(p.csv);
+}
+
+// Adds the lifetime of the scope to one CPU stage of the current frame.
+struct CpuStageTimer
+{
+    FrameProfiler &p;
+    CpuStage stage;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    CpuStageTimer(FrameProfiler &prof, CpuStage s) : p(prof), stage(s) {}
+    ~CpuStageTimer()
+    {
+        p.frame.cpuMs[stage] +=
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+};
+
+// ------------------ HUD ------------------
+// Dear ImGui (examples/common/imgui) drawn with a small GL 3.3 core renderer:
+// the vendored backend targets the fixed-function pipeline.
+
+struct Hud
+{
+    GLuint prog = 0, vao = 0, vbo = 0, ebo = 0, font = 0;
+    GLint uProj = -1, uFont = -1;
+};
+
+static bool createHud(Hud &hud)
+{
+    hud.prog = makeProgram(hudVsSrc, hudFsSrc);
+    if (!hud.prog)
+        return false;
+    hud.uProj = glGetUniformLocation(hud.prog, "uProj");
+    hud.uFont = glGetUniformLocation(hud.prog, "uFont");
+
+    ImGui::CreateContext();
+    ImGuiIO &io = ImGui::GetIO();
+    io.IniFilename = nullptr; // the overlay has a fixed place, nothing to save
+
+    unsigned char *pixels = nullptr;
+    int w = 0, h = 0;
+    io.Fonts->GetTexDataAsRGBA32(&pixels, &w, &h);
+    glGenTextures(1, &hud.font);
+    glBindTexture(GL_TEXTURE_2D, hud.font);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    io.Fonts->TexID = (void *)(intptr_t)hud.font;
+
+    glGenVertexArrays(1, &hud.vao);
+    glGenBuffers(1, &hud.vbo);
+    glGenBuffers(1, &hud.ebo);
+    glBindVertexArray(hud.vao);
+    glBindBuffer(GL_ARRAY_BUFFER, hud.vbo);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, hud.ebo);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(ImDrawVert), (void *)offsetof(ImDrawVert, pos));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(ImDrawVert), (void *)offsetof(ImDrawVert, uv));
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(ImDrawVert), (void *)offsetof(ImDrawVert, col));
+    glBindVertexArray(0);
+    return true;
+}
+
+static void renderHud(const Hud &hud, ImDrawData *dd, int fbHeight)
+{
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glDisable(GL_DEPTH_TEST);
+    glEnable(GL_SCISSOR_TEST);
+
+    const ImGuiIO &io = ImGui::GetIO();
+    float L = 0.0f, R = io.DisplaySize.x, T = 0.0f, B = io.DisplaySize.y;
+    const float proj[16] = {2.0f / (R - L), 0, 0, 0, 0, 2.0f / (T - B), 0, 0, 0, 0, -1.0f, 0,
+                            (R + L) / (L - R), (T + B) / (B - T), 0, 1.0f};
+    glUseProgram(hud.prog);
+    glUniformMatrix4fv(hud.uProj, 1, GL_FALSE, proj);
+    glUniform1i(hud.uFont, 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindVertexArray(hud.vao);
+
+    for (int n = 0; n < dd->CmdListsCount; n++)
+    {
+        const ImDrawList *list = dd->CmdLists[n];
+        glBindBuffer(GL_ARRAY_BUFFER, hud.vbo);
+        glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)list->VtxBuffer.Size * sizeof(ImDrawVert), list->VtxBuffer.Data,
+                     GL_STREAM_DRAW);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)list->IdxBuffer.Size * sizeof(ImDrawIdx),
+                     list->IdxBuffer.Data, GL_STREAM_DRAW);
+
+        size_t offset = 0;
+        for (const ImDrawCmd &cmd : list->CmdBuffer)
+        {
+            if (cmd.UserCallback)
+                cmd.UserCallback(list, &cmd);
+            else
+            {
+                glBindTexture(GL_TEXTURE_2D, (GLuint)(intptr_t)cmd.TextureId);
+                glScissor((int)cmd.ClipRect.x, (int)(fbHeight - cmd.ClipRect.w),
+                          (int)(cmd.ClipRect.z - cmd.ClipRect.x), (int)(cmd.ClipRect.w - cmd.ClipRect.y));
+                glDrawElements(GL_TRIANGLES, (GLsizei)cmd.ElemCount,
+                               sizeof(ImDrawIdx) == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT, (void *)offset);
+            }
+            offset += cmd.ElemCount * sizeof(ImDrawIdx);
+        }
+    }
+    glBindVertexArray(0);
+    glDisable(GL_SCISSOR_TEST);
+    glDisable(GL_BLEND);
+    glEnable(GL_DEPTH_TEST);
+}
+
+// Lays out the overlay: per-stage CPU/GPU times, counters and pipeline statistics.
+static void buildHudWindow(const FrameProfiler &p, const std::string &sceneLabel)
+{
+    ImGui::SetNextWindowPos(ImVec2(8.0f, 8.0f));
+    ImGui::SetNextWindowBgAlpha(0.6f);
+    ImGui::Begin("Frame", nullptr,
+                 ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove |
+                     ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoSavedSettings |
+                     ImGuiWindowFlags_NoInputs);
+    ImGui::TextUnformatted(sceneLabel.c_str());
+    ImGui::Separator();
+
+    const FrameSample &cpu = p.lastCpu, &gpu = p.lastGpu;
+    double cpuTotal = 0.0, gpuTotal = 0.0;
+    ImGui::Text("%-8s %8s %8s", "stage", "CPU ms", "GPU ms");
+    for (int i = 0; i < kCpuStageCount; i++)
+    {
+        cpuTotal += cpu.cpuMs[i];
+        int g = i == kCpuUpload ? kGpuUpload : i == kCpuSubmit ? kGpuScene : i == kCpuHud ? kGpuHud : -1;
+        if (g >= 0 && gpu.gpuValid && gpu.gpuMs[g] >= 0.0)
+        {
+            gpuTotal += gpu.gpuMs[g];
+            ImGui::Text("%-8s %8.3f %8.3f", kCpuStageNames[i], cpu.cpuMs[i], gpu.gpuMs[g]);
+        }
+        else
+            ImGui::Text("%-8s %8.3f %8s", kCpuStageNames[i], cpu.cpuMs[i], "-");
+    }
+    ImGui::Text("%-8s %8.3f %8.3f", "total", cpuTotal, gpuTotal);
+    ImGui::PlotLines("##cpu", p.history.data(), (int)p.history.size(), 0, "CPU frame ms", 0.0f, FLT_MAX,
+                     ImVec2(220.0f, 40.0f));
+    ImGui::Separator();
+
+    ImGui::Text("draw calls  %zu", cpu.counters.drawCalls);
+    ImGui::Text("triangles   %zu", cpu.counters.triangles);
+    if (p.pipelineStats && gpu.gpuValid)
+    {
+        for (int i = 0; i < kPipelineStatCount; i++)
+            ImGui::Text("%-22s %llu", kPipelineStatNames[i], (unsigned long long)gpu.pipeline[i]);
+    }
+    else if (!p.pipelineStats)
+        ImGui::TextUnformatted("pipeline statistics n/a");
+    ImGui::End();
+}
+
+static void destroyHud(Hud &hud)
+{
+    ImGui::DestroyContext();
+    glDeleteTextures(1, &hud.font);
+    glDeleteBuffers(1, &hud.ebo);
+    glDeleteBuffers(1, &hud.vbo);
+    glDeleteVertexArrays(1, &hud.vao);
+    glDeleteProgram(hud.prog);
+}
+
+// ------------------ COMMAND LINE ------------------
+
+struct ViewerOptions
+{
+    std::string glbPath = "tree.glb";
+    size_t billboards = 100000;   // forest size for billboard mode
+    bool startInBillboards = false;
+    bool axisAligned = false;     // rotate around world Y only instead of facing the camera
+    std::string atlasPath;        // impostor atlas image; procedural when empty
+    int atlasCols = 4, atlasRows = 1;
+    bool vsync = true;
+    bool startInLod = false;
+    size_t triBudget = 2000000;   // mesh triangles per frame in LOD mode
+    std::vector<float> lodCoverage; // per MSFT_lod chain index; overrides MSFT_screencoverage
+    bool cull = true;             // BVH frustum culling, toggled with C
+    size_t uploadBudget = 4u << 20; // bytes of geometry streamed to the GPU per frame
+    bool hud = true;              // profiling overlay, toggled with H
+    std::string csvPath;          // per-frame CPU/GPU timings; off when empty
+    bool bench = false;           // headless camera-path replay with a JSON report
+    size_t benchFrames = 600;
+    std::string cameraPath;       // bench path; a built-in orbit when empty
+    std::string recordPath;       // writes the interactive camera as a bench path
+    std::string benchReport = "bench_report.json";
+    double benchMaxP99 = 0.0, benchMaxMean = 0.0; // ms; 0 disables the check
+};
+
+static void printUsage(const char *exe)
+{
+    std::cerr << "usage: " << exe << " [model.glb] [--billboards N] [--axis-aligned]\n"
+              << "       [--atlas image.png --atlas-grid COLSxROWS] [--no-vsync]\n"
+              << "       [--lod] [--tri-budget N] [--lod-coverage C0,C1,...] [--no-cull]\n"
+              << "       [--upload-budget MiB] [--no-hud] [--csv frames.csv] [--record-path cam.txt]\n"
+              << "       [--bench [--bench-frames N] [--camera-path cam.txt] [--bench-report out.json]\n"
+              << "        [--bench-max-p99 MS] [--bench-max-mean MS]]\n"
+              << "keys: B toggles mesh/billboard mode, L toggles LOD forest mode, C toggles culling,\n"
+              << "      H toggles the profiling overlay, arrows orbit, W/S zoom, Esc quits\n";
+}
+
+static bool parseOptions(int argc, char **argv, ViewerOptions &opt)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        std::string a = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (a == "--billboards" && hasValue)
+        {
+            opt.billboards = (size_t)std::strtoull(argv[++i], nullptr, 10);
+            opt.startInBillboards = true;
+        }
+        else if (a == "--axis-aligned")
+            opt.axisAligned = true;
+        else if (a == "--atlas" && hasValue)
+            opt.atlasPath = argv[++i];
+        else if (a == "--atlas-grid" && hasValue)
+        {
+            if (std::sscanf(argv[++i], "%dx%d", &opt.atlasCols, &opt.atlasRows) != 2)
+                return false;
+        }
+        else if (a == "--no-vsync")
+            opt.vsync = false;
+        else if (a == "--upload-budget" && hasValue)
+            opt.uploadBudget = (size_t)(std::strtod(argv[++i], nullptr) * 1024.0 * 1024.0);
+        else if (a == "--no-cull")
+            opt.cull = false;
+        else if (a == "--no-hud")
+            opt.hud = false;
+        else if (a == "--csv" && hasValue)
+            opt.csvPath = argv[++i];
+        else if (a == "--bench")
+            opt.bench = true;
+        else if (a == "--bench-frames" && hasValue)
+            opt.benchFrames = std::max<size_t>((size_t)std::strtoull(argv[++i], nullptr, 10), 1);
+        else if (a == "--camera-path" && hasValue)
+            opt.cameraPath = argv[++i];
+        else if (a == "--record-path" && hasValue)
+            opt.recordPath = argv[++i];
+        else if (a == "--bench-report" && hasValue)
+            opt.benchReport = argv[++i];
+        else if (a == "--bench-max-p99" && hasValue)
+            opt.benchMaxP99 = std::strtod(argv[++i], nullptr);
+        else if (a == "--bench-max-mean" && hasValue)
+            opt.benchMaxMean = std::strtod(argv[++i], nullptr);
+        else if (a == "--lod")
+            opt.startInLod = true;
+        else if (a == "--tri-budget" && hasValue)
+            opt.triBudget = (size_t)std::strtoull(argv[++i], nullptr, 10);
+        else if (a == "--lod-coverage" && hasValue)
+        {
+            std::string list = argv[++i];
+            opt.lodCoverage.clear();
+            for (size_t pos = 0; pos <= list.size();)
+            {
+                size_t comma = std::min(list.find(',', pos), list.size());
+                opt.lodCoverage.push_back(std::strtof(list.substr(pos, comma - pos).c_str(), nullptr));
+                pos = comma + 1;
+            }
+        }
+        else if (!a.empty() && a[0] != '-')
+            opt.glbPath = a;
+        else
+            return false;
+    }
+    return true;
+}
+
+// ------------------ BENCHMARK ------------------
+// --bench replays a camera path over a fixed number of frames with no window on
+// screen, then writes a JSON report. Paths are plain text, one key per line:
+//   <mesh|billboards|lod> yaw pitch distScale
+// where distScale is relative to the auto-fit distance of that mode, so a path
+// recorded on one model replays sensibly on another. --record-path writes one
+// key per frame from an interactive session.
+// The run exits with 2 when a threshold was exceeded and with 3 when the report
+// could not be written, so CI can tell a regression from an I/O error.
+
+struct CameraKey
+{
+    int mode = 0; // ViewMode index: mesh, billboards, lod
+    float yaw = 0.0f, pitch = 0.0f, distScale = 1.0f;
+};
+
+static const char *kModeNames[3] = {"mesh", "billboards", "lod"};
+
+static bool loadCameraPath(const std::string &path, std::vector<CameraKey> &keys)
+{
+    std::FILE *f = std::fopen(path.c_str(), "r");
+    if (!f)
+        return false;
+    char line[256];
+    while (std::fgets(line, sizeof(line), f))
+    {
+        char mode[32];
+        CameraKey k;
+        if (line[0] == '#' || std::sscanf(line, "%31s %f %f %f", mode, &k.yaw, &k.pitch, &k.distScale) != 4)
+            continue;
+        k.mode = -1;
+        for (int m = 0; m < 3; m++)
+            if (std::strcmp(mode, kModeNames[m]) == 0)
+                k.mode = m;
+        if (k.mode >= 0)
+            keys.push_back(k);
+    }
+    std::fclose(f);
+    return !keys.empty();
+}
+
+// One slow orbit with a dolly in and back out, for runs without a recorded path.
+static std::vector<CameraKey> defaultCameraPath(int mode)
+{
+    std::vector<CameraKey> keys(64);
+    for (size_t i = 0; i < keys.size(); i++)
+    {
+        float t = (float)i / (float)(keys.size() - 1);
+        keys[i].mode = mode;
+        keys[i].yaw = t * 2.0f * 3.1415926f;
+        keys[i].pitch = 0.35f;
+        keys[i].distScale = 1.0f - 0.5f * std::sin(t * 3.1415926f);
+    }
+    return keys;
+}
+
+// Frame `i` of `frames` maps linearly onto the path; the mode comes from the key below.
+static CameraKey sampleCameraPath(const std::vector<CameraKey> &keys, size_t i, size_t frames)
+{
+    if (keys.size() == 1 || frames <= 1)
+        return keys.front();
+    float t = (float)i * (float)(keys.size() - 1) / (float)(frames - 1);
+    size_t k = std::min((size_t)t, keys.size() - 2);
+    float f = t - (float)k;
+    const CameraKey &a = keys[k], &b = keys[k + 1];
+    CameraKey r;
+    r.mode = f < 1.0f ? a.mode : b.mode;
+    r.yaw = a.yaw + (b.yaw - a.yaw) * f;
+    r.pitch = a.pitch + (b.pitch - a.pitch) * f;
+    r.distScale = a.distScale + (b.distScale - a.distScale) * f;
+    return r;
+}
+
+// Offscreen render target. A surfaceless context has no default framebuffer, so
+// bench frames always go here.
+struct OffscreenTarget
+{
+    GLuint fbo = 0, color = 0, depth = 0;
+};
+
+static bool createOffscreenTarget(OffscreenTarget &t, int w, int h)
+{
+    glGenRenderbuffers(1, &t.color);
+    glBindRenderbuffer(GL_RENDERBUFFER, t.color);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, w, h);
+    glGenRenderbuffers(1, &t.depth);
+    glBindRenderbuffer(GL_RENDERBUFFER, t.depth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, w, h);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glGenFramebuffers(1, &t.fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, t.fbo);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, t.color);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, t.depth);
+    return glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+}
+
+static void destroyOffscreenTarget(OffscreenTarget &t)
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteFramebuffers(1, &t.fbo);
+    glDeleteRenderbuffers(1, &t.depth);
+    glDeleteRenderbuffers(1, &t.color);
+}
+
+// Hidden window whose context needs no display: EGL (surfaceless) first, then
+// OSMesa, both through GLFW's null platform (GLFW 3.4+). main() refuses --bench
+// without it rather than opening a window on a display server.
+#ifdef GLFW_PLATFORM_NULL
+static GLFWwindow *createHeadlessWindow(int w, int h)
+{
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    const int apis[] = {GLFW_EGL_CONTEXT_API, GLFW_OSMESA_CONTEXT_API};
+    for (int api : apis)
+    {
+        glfwWindowHint(GLFW_CONTEXT_CREATION_API, api);
+        GLFWwindow *win = glfwCreateWindow(w, h, "GLB Tree bench", nullptr, nullptr);
+        if (win)
+        {
+            std::cout << "Bench context: " << (api == GLFW_EGL_CONTEXT_API ? "EGL" : "OSMesa") << "\n";
+            return win;
+        }
+    }
+    std::cerr << "--bench: neither an EGL nor an OSMesa context could be created\n";
+    return nullptr;
+}
+#endif
+
+static std::string jsonEscape(const std::string &s)
+{
+    std::string out;
+    for (char c : s)
+    {
+        if (c == '"' || c == '\\')
+            out += '\\';
+        if ((unsigned char)c >= 0x20)
+            out += c;
+    }
+    return out;
+}
+
+struct SeriesStats
+{
+    double min = 0.0, mean = 0.0, p99 = 0.0, max = 0.0;
+    size_t count = 0;
+};
+
+static SeriesStats seriesStats(std::vector<double> v)
+{
+    SeriesStats s;
+    if (v.empty())
+        return s;
+    std::sort(v.begin(), v.end());
+    double sum = 0.0;
+    for (double x : v)
+        sum += x;
+    s.count = v.size();
+    s.min = v.front();
+    s.max = v.back();
+    s.mean = sum / (double)v.size();
+    // nearest-rank percentile
+    size_t rank = (size_t)std::ceil(0.99 * (double)v.size());
+    s.p99 = v[std::max<size_t>(rank, 1) - 1];
+    return s;
+}
+
+static void writeSeries(std::FILE *f, const char *name, const SeriesStats &s, bool last)
+{
+    if (s.count == 0)
+        std::fprintf(f, "  \"%s\": null%s\n", name, last ? "" : ",");
+    else
+        std::fprintf(f, "  \"%s\": {\"min\": %.4f, \"mean\": %.4f, \"p99\": %.4f, \"max\": %.4f, \"samples\": %zu}%s\n",
+                     name, s.min, s.mean, s.p99, s.max, s.count, last ? "" : ",");
+}
+
+// Exit codes of a --bench run
+enum BenchResult
+{
+    BenchPassed = 0,
+    BenchThresholdExceeded = 2,
+    BenchReportFailed = 3, // the report could not be written
+};
+
+// Summarizes the measured frames and writes the report. CPU frame time is the
+// sum of the profiled stages.
+static BenchResult writeBenchReport(const ViewerOptions &opt, const std::vector<FrameSample> &samples, uint64_t firstFrame)
+{
+    std::vector<double> cpu, gpu, draws, tris;
+    for (const FrameSample &s : samples)
+    {
+        if (s.frame < firstFrame)
+            continue; // warm-up
+        double c = 0.0, g = 0.0;
+        for (double ms : s.cpuMs)
+            c += ms;
+        cpu.push_back(c);
+        if (s.gpuValid)
+        {
+            for (double ms : s.gpuMs)
+                g += std::max(ms, 0.0);
+            gpu.push_back(g);
+        }
+        draws.push_back((double)s.counters.drawCalls);
+        tris.push_back((double)s.counters.triangles);
+    }
+    SeriesStats cpuStats = seriesStats(cpu), gpuStats = seriesStats(gpu);
+    SeriesStats drawStats = seriesStats(draws), triStats = seriesStats(tris);
+
+    std::vector<std::string> failures;
+    char msg[128];
+    if (opt.benchMaxP99 > 0.0 && cpuStats.p99 > opt.benchMaxP99)
+    {
+        std::snprintf(msg, sizeof(msg), "p99 frame time %.3f ms > %.3f ms", cpuStats.p99, opt.benchMaxP99);
+        failures.push_back(msg);
+    }
+    if (opt.benchMaxMean > 0.0 && cpuStats.mean > opt.benchMaxMean)
+    {
+        std::snprintf(msg, sizeof(msg), "mean frame time %.3f ms > %.3f ms", cpuStats.mean, opt.benchMaxMean);
+        failures.push_back(msg);
+    }
+
+    std::FILE *f = std::fopen(opt.benchReport.c_str(), "w");
+    if (!f)
+    {
+        std::cerr << "Could not open " << opt.benchReport << " for writing\n";
+        return BenchReportFailed;
+    }
+    std::fprintf(f, "{\n");
+    std::fprintf(f, "  \"model\": \"%s\",\n", jsonEscape(opt.glbPath).c_str());
+    std::fprintf(f, "  \"camera_path\": \"%s\",\n",
+                 opt.cameraPath.empty() ? "default" : jsonEscape(opt.cameraPath).c_str());
+    std::fprintf(f, "  \"frames\": %zu,\n", cpu.size());
+    const GLubyte *renderer = glGetString(GL_RENDERER);
+    std::fprintf(f, "  \"gl_renderer\": \"%s\",\n",
+                 renderer ? jsonEscape((const char *)renderer).c_str() : "unknown");
+    writeSeries(f, "cpu_frame_ms", cpuStats, false);
+    writeSeries(f, "gpu_frame_ms", gpuStats, false);
+    writeSeries(f, "draw_calls", drawStats, false);
+    writeSeries(f, "triangles", triStats, false);
+    std::fprintf(f, "  \"thresholds\": {\"max_p99_ms\": %.4f, \"max_mean_ms\": %.4f},\n", opt.benchMaxP99,
+                 opt.benchMaxMean);
+    std::fprintf(f, "  \"failures\": [");
+    for (size_t i = 0; i < failures.size(); i++)
+        std::fprintf(f, "%s\"%s\"", i ? ", " : "", failures[i].c_str());
+    std::fprintf(f, "],\n  \"passed\": %s\n}\n", failures.empty() ? "true" : "false");
+    bool written = !std::ferror(f);
+    if (std::fclose(f) != 0 || !written)
+    {
+        std::cerr << "Could not write " << opt.benchReport << "\n";
+        return BenchReportFailed;
+    }
+
+    std::printf("Bench: %zu frames, CPU %.3f/%.3f/%.3f ms (min/mean/p99), %.0f draws, %.0f tris mean -> %s\n",
+                cpu.size(), cpuStats.min, cpuStats.mean, cpuStats.p99, drawStats.mean, triStats.mean,
+                opt.benchReport.c_str());
+    for (const std::string &m : failures)
+        std::cerr << "BENCH FAIL: " << m << "\n";
+    return failures.empty() ? BenchPassed : BenchThresholdExceeded;
+}
+
+// ------------------ BACKGROUND LOADING ------------------
+// Parsing, accessor conversion, LOD setup, forest scattering and the culling
+// hierarchies all run on a loader thread that never touches GL. The render
+// thread keeps presenting frames meanwhile. Arenas are final once the LOD levels
+// are built (those may add meshes to them), so they are published then and
+// stream to the GPU while the loader scatters the forest and builds the culling
+// hierarchies; the rest of the scene is taken once it is complete.
+
+struct LoadedScene
+{
+    bool ok = false;
+    std::string err, warn;
+    double seconds = 0.0;
+
+    SceneGeometry geo;
+    LodSet lods;
+    float treeWidth = 1.0f, treeHeight = 1.0f, spacing = 1.0f;
+    std::vector<BillboardInstance> trees;
+    CullBvh drawBvh, forestBvh;
+};
+
+static void loadScene(const ViewerOptions &opt, LoadedScene &out, ArenaHandoff &handoff)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    tinygltf::TinyGLTF loader;
+    tinygltf::Model model;
+    loader.SetMemoryMapBinary(true); // the BIN chunk is read in place, not copied
+    if (!loader.LoadBinaryFromFile(&model, &out.err, &out.warn, opt.glbPath))
+        return;
+
+    // ---- Pack the whole scene into per-layout arenas ----
+    SceneGeometry &geo = out.geo;
+    buildSceneGeometry(model, geo);
+    if (geo.draws.empty())
+    {
+        out.err = "No drawable primitives in GLB";
+        return;
+    }
+
+    // ---- LOD levels (MSFT_lod, if any); these may add meshes to the arenas ----
+    out.lods = buildLodSet(model, geo, opt.lodCoverage);
+    geo.sparse.Clear(); // the arenas hold their own copies now
+    publishArenas(handoff, geo.arenas.size());
+
+    // ---- Billboard forest ----
+    // The quad matches the tree's bounds; instances stand on y = 0 in a grid
+    // whose spacing follows the tree's footprint.
+    const Bounds &b = geo.bounds;
+    out.treeWidth = std::max(std::max(b.maxx - b.minx, b.maxz - b.minz), 1e-3f);
+    out.treeHeight = std::max(b.maxy - b.miny, 1e-3f);
+    out.spacing = out.treeWidth * 1.5f;
+    uint32_t cells = (uint32_t)(std::max(opt.atlasCols, 1) * std::max(opt.atlasRows, 1));
+    out.trees = scatterForest(opt.billboards, out.spacing, cells);
+
+    // ---- Culling hierarchies over the scene draws and the forest instances ----
+    std::vector<Bounds> drawBoxes(geo.draws.size(), emptyBounds());
+    for (size_t i = 0; i < geo.draws.size(); i++)
+        expandBounds(drawBoxes[i], geo.draws[i].local, geo.draws[i].model);
+    out.drawBvh = buildCullBvh(drawBoxes);
+
+    // An instance box must hold any mesh level as well as a camera-facing
+    // billboard, which leans toward the camera by up to its height.
+    float treeHalf = std::max(0.5f * out.treeWidth + (opt.axisAligned ? 0.0f : out.treeHeight), out.lods.radius);
+    float treeTop = std::max(out.treeHeight, 2.0f * out.lods.centerHeight);
+    std::vector<Bounds> treeBoxes(out.trees.size());
+    for (size_t i = 0; i < out.trees.size(); i++)
+    {
+        const BillboardInstance &t = out.trees[i];
+        float h = treeHalf * t.scale;
+        treeBoxes[i] = Bounds{t.x - h, t.y, t.z - h, t.x + h, t.y + treeTop * t.scale, t.z + h};
+    }
+    out.forestBvh = buildCullBvh(treeBoxes);
+
+    out.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    out.ok = true;
+}
+
+struct AsyncSceneLoad
+{
+    std::thread worker;
+    std::atomic<bool> finished{false};
+    LoadedScene scene;    // only read once `finished` is set, except published arenas
+    ArenaHandoff arenas;
+};
+
+static void startSceneLoad(AsyncSceneLoad &load, const ViewerOptions &opt)
+{
+    load.worker = std::thread([&load, opt]()
+                              {
+                                  loadScene(opt, load.scene, load.arenas);
+                                  load.finished.store(true, std::memory_order_release);
+                              });
+}
+
+int main(int argc, char **argv)
+{
+    ViewerOptions opt;
+    if (!parseOptions(argc, argv, opt))
+    {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    // ---- GLFW / GL init ----
+#ifdef GLFW_PLATFORM_NULL
+    if (opt.bench)
+        glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL); // no display server needed
+#else
+    if (opt.bench)
+    {
+        std::cerr << "--bench needs GLFW 3.4 or later (null platform); this build uses GLFW "
+                  << GLFW_VERSION_MAJOR << "." << GLFW_VERSION_MINOR << "\n";
+        return 1;
+    }
+#endif
+    if (!glfwInit())
+    {
+        std::cerr << "glfwInit failed\n";
+        return 1;
+    }
+#ifdef GLFW_PLATFORM_NULL
+    if (opt.bench && glfwGetPlatform() != GLFW_PLATFORM_NULL)
+    {
+        std::cerr << "--bench: the GLFW library has no null platform (needs GLFW 3.4 or later)\n";
+        glfwTerminate();
+        return 1;
+    }
+#endif
+
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+    const int W = 800, H = 600;
+#ifdef GLFW_PLATFORM_NULL
+    GLFWwindow *win = opt.bench ? createHeadlessWindow(W, H) : glfwCreateWindow(W, H, "GLB Tree", nullptr, nullptr);
+#else
+    GLFWwindow *win = glfwCreateWindow(W, H, "GLB Tree", nullptr, nullptr);
+#endif
+    if (!win)
+    {
+        std::cerr << "glfwCreateWindow failed\n";
+        glfwTerminate();
+        return 1;
+    }
+    glfwMakeContextCurrent(win);
+    glfwSwapInterval(opt.vsync && !opt.bench ? 1 : 0); // vsync would cap the frame timer at the refresh rate
+
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cerr << "gladLoadGLLoader failed\n";
+        glfwTerminate();
+        return 1;
+    }
+
+    OffscreenTarget offscreen;
+    if (opt.bench && !createOffscreenTarget(offscreen, W, H))
+    {
+        std::cerr << "Bench framebuffer incomplete\n";
+        glfwTerminate();
+        return 1;
+    }
+
+    glViewport(0, 0, W, H);
+    glEnable(GL_DEPTH_TEST);
+    glDisable(GL_CULL_FACE); // avoid winding/handedness surprises
+    // glPolygonMode(GL_FRONT_AND_BACK, GL_LINE); // uncomment to debug wireframe
+
+    GLuint prog = makeProgram(vsSrc, fsSrc);
+    GLuint billboardProg = makeProgram(billboardVsSrc, billboardFsSrc);
+    if (!prog || !billboardProg)
+    {
+        glfwTerminate();
+        return 1;
+    }
+
+    // ---- LOAD GLB (loader thread) ----
+    // The window keeps presenting frames while the model is parsed and converted.
+    AsyncSceneLoad load;
+    startSceneLoad(load, opt);
+    ImpostorAtlas atlas = loadImpostorAtlas(opt.atlasPath, opt.atlasCols, opt.atlasRows);
+
+    // GPU upload: arena storage and contents are streamed as the loader publishes them
+    UploadQueue uploads = createUploadQueue(opt.uploadBudget);
+    uploads.handoff = &load.arenas;
+
+    double loadStart = glfwGetTime(), lastTitle = 0.0;
+    while (!load.finished.load(std::memory_order_acquire) && !glfwWindowShouldClose(win))
+    {
+        glfwPollEvents();
+        pumpUploads(uploads, load.scene.geo);
+        glClearColor(0.05f, 0.05f, 0.10f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        glfwSwapBuffers(win);
+
+        double now = glfwGetTime();
+        if (now - lastTitle > 0.25)
+        {
+            char title[256];
+            std::snprintf(title, sizeof(title), "GLB Tree | loading %s (%.1f s)", opt.glbPath.c_str(),
+                          now - loadStart);
+            glfwSetWindowTitle(win, title);
+            lastTitle = now;
+        }
+        if (glfwGetKey(win, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+            glfwSetWindowShouldClose(win, 1);
+    }
+    load.worker.join(); // tinygltf can't be interrupted; an early Esc waits for it here
+
+    LoadedScene &scene = load.scene;
+    if (!scene.warn.empty())
+        std::cerr << "WARN: " << scene.warn << "\n";
+    if (!scene.ok || glfwWindowShouldClose(win))
+    {
+        bool failed = !scene.ok;
+        if (failed)
+            std::cerr << "Failed to load " << opt.glbPath << "\n"
+                      << (scene.err.empty() ? "" : "ERR : " + scene.err + "\n");
+        destroyUploadQueue(uploads);
+        glDeleteTextures(1, &atlas.tex);
+        glDeleteProgram(billboardProg);
+        glDeleteProgram(prog);
+        glfwTerminate();
+        return failed ? 1 : 0;
+    }
+    std::cout << "Loaded " << opt.glbPath << " in " << (int)(1000.0 * scene.seconds)
+              << " ms on the loader thread\n";
+
+    SceneGeometry &geo = scene.geo;
+    takePublishedArenas(uploads, geo); // those the loading frames have not taken yet
+    const LodSet &lods = scene.lods;
+    const std::vector<BillboardInstance> &trees = scene.trees;
+    std::cout << "LOD levels: " << lods.levels.size() << " mesh + billboard (tris";
+    for (const LodLevel &l : lods.levels)
+        std::cout << " " << l.triangles << "@" << l.coverage;
+    std::cout << "), budget " << opt.triBudget << " tris/frame\n";
+
+    size_t arenaBytes = uploads.totalBytes; // CPU copies of uploaded arenas are already freed
+    std::cout << "Primitives: " << geo.ranges.size() << "  draws: " << geo.draws.size()
+              << "  arenas: " << geo.arenas.size() << " (" << arenaBytes / 1024 << " KiB)\n";
+    std::cout << "VRAM   expanded: " << geo.soupBytes / 1024 << " KiB  indexed: " << geo.indexedBytes / 1024
+              << " KiB (" << (100.0 * (double)geo.indexedBytes / (double)geo.soupBytes) << "%)\n";
+    std::cout << "VS runs expanded: " << geo.soupVS << "  indexed (FIFO-32 estimate): " << geo.indexedVS
+              << " (ACMR " << (3.0 * (double)geo.indexedVS / (double)geo.soupVS) << ")\n";
+
+    // ---- Auto-fit camera (prevents black screen from scale) ----
+    const Bounds &b = geo.bounds;
+    float cx = 0.5f * (b.minx + b.maxx);
+    float cy = 0.5f * (b.miny + b.maxy);
+    float cz = 0.5f * (b.minz + b.maxz);
+    float dx = (b.maxx - b.minx);
+    float dy = (b.maxy - b.miny);
+    float dz = (b.maxz - b.minz);
+    float radius = 0.5f * std::sqrt(dx * dx + dy * dy + dz * dz);
+    if (radius < 1e-6f)
+        radius = 1.0f;
+
+    // Camera distance: a bit more than radius so it fits
+    float camDist = radius * 2.5f;
+
+    // ---- Billboard forest ----
+    float treeWidth = scene.treeWidth;
+    float treeHeight = scene.treeHeight;
+    BillboardBatch forest = uploadBillboards(trees);
+    float forestExtent = scene.spacing * std::sqrt((float)std::max<size_t>(opt.billboards, 1));
+    std::cout << "Billboards: " << forest.count << " instances, "
+              << (forest.count * sizeof(BillboardInstance)) / 1024 << " KiB instance data\n";
+
+    GLint bbVP = glGetUniformLocation(billboardProg, "VP");
+    GLint bbRight = glGetUniformLocation(billboardProg, "uRight");
+    GLint bbUp = glGetUniformLocation(billboardProg, "uUp");
+    GLint bbQuad = glGetUniformLocation(billboardProg, "uQuadSize");
+    GLint bbGrid = glGetUniformLocation(billboardProg, "uAtlasGrid");
+    GLint bbAtlas = glGetUniformLocation(billboardProg, "uAtlas");
+
+    enum class ViewMode
+    {
+        Mesh,
+        Billboards,
+        Lod
+    };
+    ViewMode mode = opt.startInLod ? ViewMode::Lod : opt.startInBillboards ? ViewMode::Billboards : ViewMode::Mesh;
+    bool bWasDown = false, lWasDown = false;
+    OrbitCamera meshCam;
+    meshCam.target = Vec3{cx, cy, cz};
+    meshCam.dist = camDist;
+    OrbitCamera forestCam;
+    forestCam.target = Vec3{0.0f, treeHeight * 0.5f, 0.0f};
+    forestCam.pitch = 0.35f;
+    forestCam.dist = std::max(forestExtent * 0.6f, camDist);
+    FrameTimer timer;
+    float frameDt = 0.0f;
+    const float meshHome = meshCam.dist, forestHome = forestCam.dist;
+
+    // ---- Bench camera path / recording ----
+    std::vector<CameraKey> cameraKeys;
+    if (opt.bench)
+    {
+        if (opt.cameraPath.empty())
+            cameraKeys = defaultCameraPath((int)mode);
+        else if (!loadCameraPath(opt.cameraPath, cameraKeys))
+        {
+            std::cerr << "Could not read camera path " << opt.cameraPath << "\n";
+            glfwTerminate();
+            return 1;
+        }
+    }
+    std::FILE *recorder = opt.recordPath.empty() ? nullptr : std::fopen(opt.recordPath.c_str(), "w");
+    if (recorder)
+        std::fprintf(recorder, "# mode yaw pitch distScale\n");
+    const uint64_t benchWarmup = 10; // frames run before measuring, to settle driver caches
+
+    // ---- GPU upload: whatever the loading frames did not finish is streamed by the main loop ----
+    while (opt.bench && !uploads.idle())
+    {
+        // Benchmarks measure the resident scene, not the streaming
+        pumpUploads(uploads, geo);
+        glFinish();
+    }
+
+    // ---- Profiling: stage timers, pipeline statistics when the driver exposes them ----
+    bool pipelineStats = hasExtension("GL_ARB_pipeline_statistics_query");
+    if (!pipelineStats)
+        std::cout << "Pipeline statistics: n/a (GL_ARB_pipeline_statistics_query not supported)\n";
+    FrameProfiler profiler;
+    createProfiler(profiler, pipelineStats, opt.csvPath);
+    Hud hud;
+    bool hudReady = createHud(hud);
+    bool hudVisible = opt.hud && hudReady && !opt.bench, hWasDown = false;
+    uint64_t frameIndex = 0;
+    profiler.keepSamples = opt.bench;
+
+    GLint uVP = glGetUniformLocation(prog, "VP");
+    GLint uModel = glGetUniformLocation(prog, "Model");
+
+    LodStream lodStream = createLodStream();
+    std::vector<std::vector<BillboardInstance>> lodBuckets;
+    std::vector<std::pair<float, uint32_t>> lodCandidates;
+    LodStats lodStats;
+
+    const CullBvh &drawBvh = scene.drawBvh;
+    const CullBvh &forestBvh = scene.forestBvh;
+    std::cout << "Cull BVH: " << drawBvh.nodes.size() << " nodes over draws, " << forestBvh.nodes.size()
+              << " over instances" << (VIEWER_HAS_SSE ? " (SSE)" : " (scalar)") << "\n";
+
+    bool cullEnabled = opt.cull;
+    bool cWasDown = false;
+    std::vector<uint32_t> allDraws(geo.draws.size()), allTrees(trees.size()), visible;
+    for (size_t i = 0; i < allDraws.size(); i++)
+        allDraws[i] = (uint32_t)i;
+    for (size_t i = 0; i < allTrees.size(); i++)
+        allTrees[i] = (uint32_t)i;
+    std::vector<int> cullStack;
+    CullStats cullStats;
+
+    // ---- Main loop ----
+    const float fovY = 60.0f * 3.1415926f / 180.0f;
+    while (!glfwWindowShouldClose(win))
+    {
+        beginProfilerFrame(profiler, frameIndex++);
+        {
+            CpuStageTimer t(profiler, kCpuPoll);
+            glfwPollEvents();
+        }
+        if (!uploads.idle())
+        {
+            CpuStageTimer t(profiler, kCpuUpload);
+            beginGpuStage(profiler, kGpuUpload);
+            pumpUploads(uploads, geo);
+            endGpuStage(profiler);
+        }
+
+        bool forestMode;
+        OrbitCamera *cam;
+        Mat4 VP;
+        Vec3 camRight, camUp;
+        {
+            CpuStageTimer t(profiler, kCpuUpdate);
+            CameraKey key;
+            if (opt.bench)
+            {
+                size_t i = frameIndex > benchWarmup ? (size_t)(frameIndex - 1 - benchWarmup) : 0;
+                key = sampleCameraPath(cameraKeys, i, opt.benchFrames);
+                mode = (ViewMode)key.mode;
+            }
+            bool bDown = glfwGetKey(win, GLFW_KEY_B) == GLFW_PRESS;
+            if (bDown && !bWasDown)
+                mode = mode == ViewMode::Billboards ? ViewMode::Mesh : ViewMode::Billboards;
+            bWasDown = bDown;
+            bool lDown = glfwGetKey(win, GLFW_KEY_L) == GLFW_PRESS;
+            if (lDown && !lWasDown)
+                mode = mode == ViewMode::Lod ? ViewMode::Billboards : ViewMode::Lod;
+            lWasDown = lDown;
+            bool cDown = glfwGetKey(win, GLFW_KEY_C) == GLFW_PRESS;
+            if (cDown && !cWasDown)
+                cullEnabled = !cullEnabled;
+            cWasDown = cDown;
+            bool hDown = glfwGetKey(win, GLFW_KEY_H) == GLFW_PRESS;
+            if (hDown && !hWasDown)
+                hudVisible = !hudVisible && hudReady;
+            hWasDown = hDown;
+
+            forestMode = mode != ViewMode::Mesh;
+            cam = forestMode ? &forestCam : &meshCam;
+            float home = forestMode ? forestHome : meshHome;
+            if (opt.bench)
+            {
+                cam->yaw = key.yaw;
+                cam->pitch = key.pitch;
+                cam->dist = home * key.distScale;
+            }
+            else
+                updateCamera(win, *cam, frameDt);
+            if (recorder)
+                std::fprintf(recorder, "%s %.5f %.5f %.5f\n", kModeNames[(int)mode], cam->yaw, cam->pitch,
+                             cam->dist / home);
+
+            // projection
+            float farPlane = forestMode ? cam->dist + forestExtent : cam->dist * 20.0f;
+            Mat4 P = perspective(fovY, (float)W / (float)H, cam->dist * 0.001f, farPlane);
+            Mat4 V = lookAt(cam->eye(), cam->target, Vec3{0.0f, 1.0f, 0.0f}, &camRight, &camUp);
+            VP = mul(P, V);
+        }
+
+        // ---- cull (and pick LODs) before anything is submitted ----
+        const std::vector<uint32_t> &drawList = cullEnabled ? visible : forestMode ? allTrees : allDraws;
+        {
+            CpuStageTimer t(profiler, kCpuCull);
+            if (cullEnabled)
+            {
+                cullBvh(forestMode ? forestBvh : drawBvh, frustumFromMatrix(VP), visible, cullStack, cullStats);
+                if (!forestMode)
+                    std::sort(visible.begin(), visible.end()); // back to arena order
+            }
+            if (mode == ViewMode::Lod)
+                selectLods(lods, trees, drawList, cam->eye(), std::tan(0.5f * fovY), opt.triBudget, lodBuckets,
+                           lodCandidates, lodStats);
+        }
+
+        {
+            CpuStageTimer t(profiler, kCpuSubmit);
+            FrameCounters &counters = profiler.frame.counters;
+            beginGpuStage(profiler, kGpuScene);
+            beginPipelineStats(profiler);
+
+            glClearColor(0.05f, 0.05f, 0.10f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+            if (mode == ViewMode::Lod)
+            {
+                uploadLodStream(lodStream, lodBuckets);
+
+                glUseProgram(prog);
+                glUniformMatrix4fv(uVP, 1, GL_FALSE, VP.m);
+                drawLodMeshes(geo, lods, lodStream, lodBuckets, uModel, counters);
+            }
+            else if (mode == ViewMode::Billboards && cullEnabled)
+            {
+                // Only the survivors are streamed; unculled, the static batch is drawn
+                lodBuckets.resize(1);
+                lodBuckets[0].clear();
+                for (uint32_t i : drawList)
+                    lodBuckets[0].push_back(trees[i]);
+                uploadLodStream(lodStream, lodBuckets);
+            }
+
+            if (forestMode)
+            {
+                if (opt.axisAligned)
+                    camUp = Vec3{0.0f, 1.0f, 0.0f}; // camRight is already horizontal
+
+                glUseProgram(billboardProg);
+                glUniformMatrix4fv(bbVP, 1, GL_FALSE, VP.m);
+                glUniform3f(bbRight, camRight.x, camRight.y, camRight.z);
+                glUniform3f(bbUp, camUp.x, camUp.y, camUp.z);
+                glUniform2f(bbQuad, treeWidth, treeHeight);
+                glUniform2i(bbGrid, atlas.cols, atlas.rows);
+                glUniform1i(bbAtlas, 0);
+                glActiveTexture(GL_TEXTURE0);
+                glBindTexture(GL_TEXTURE_2D, atlas.tex);
+
+                GLsizei quads;
+                if (mode == ViewMode::Lod || cullEnabled)
+                {
+                    bindLodBillboards(lodStream);
+                    quads = (GLsizei)(lodStream.packed.size() - lodStream.first.back());
+                }
+                else
+                {
+                    glBindVertexArray(forest.vao);
+                    quads = forest.count;
+                }
+                glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, quads);
+                glBindVertexArray(0);
+                counters.drawCalls++;
+                counters.triangles += 2 * (size_t)quads;
+            }
+            else
+            {
+                glUseProgram(prog);
+                glUniformMatrix4fv(uVP, 1, GL_FALSE, VP.m);
+                drawSceneGeometry(geo, drawList, uModel, counters);
+            }
+
+            endPipelineStats(profiler);
+            endGpuStage(profiler);
+        }
+
+        std::string label = mode == ViewMode::Lod          ? lodLabel(lodStats)
+                            : mode == ViewMode::Billboards ? std::to_string(forest.count) + " billboards"
+                                                           : std::to_string(geo.draws.size()) + " mesh draws";
+        label += " | " + cullLabel(cullEnabled, cullStats);
+        if (!uploads.idle())
+            label += " | uploading " + std::to_string(uploads.uploadedBytes >> 20) + "/" +
+                     std::to_string(uploads.totalBytes >> 20) + " MiB";
+
+        if (hudVisible)
+        {
+            CpuStageTimer t(profiler, kCpuHud);
+            beginGpuStage(profiler, kGpuHud);
+            ImGuiIO &io = ImGui::GetIO();
+            io.DisplaySize = ImVec2((float)W, (float)H);
+            io.DeltaTime = std::max(frameDt, 1e-4f);
+            ImGui::NewFrame();
+            buildHudWindow(profiler, label);
+            ImGui::Render();
+            renderHud(hud, ImGui::GetDrawData(), H);
+            endGpuStage(profiler);
+        }
+
+        {
+            CpuStageTimer t(profiler, kCpuSwap);
+            glfwSwapBuffers(win);
+        }
+        endProfilerFrame(profiler);
+        frameDt = tickFrameTimer(timer, win, label);
+        if (opt.bench && frameIndex >= benchWarmup + opt.benchFrames)
+            glfwSetWindowShouldClose(win, 1);
+
+        if (glfwGetKey(win, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+        {
             glfwSetWindowShouldClose(win, 1);
         }
     }
 
-    glDeleteBuffers(1, &VBO);
-    glDeleteVertexArrays(1, &VAO);
+    BenchResult benchResult = BenchPassed;
+    if (opt.bench)
+    {
+        flushProfiler(profiler);
+        benchResult = writeBenchReport(opt, profiler.samples, benchWarmup);
+    }
+    if (recorder)
+        std::fclose(recorder);
+
+    destroyProfiler(profiler);
+    if (hudReady)
+        destroyHud(hud);
+    destroyUploadQueue(uploads);
+    for (GeometryArena &a : geo.arenas)
+        destroyArena(a);
+    glDeleteBuffers(1, &lodStream.vbo);
+    glDeleteVertexArrays(1, &lodStream.billboardVao);
+    glDeleteBuffers(1, &forest.instanceVbo);
+    glDeleteVertexArrays(1, &forest.vao);
+    glDeleteTextures(1, &atlas.tex);
+    glDeleteProgram(billboardProg);
     glDeleteProgram(prog);
+    if (opt.bench)
+        destroyOffscreenTarget(offscreen);
 
     glfwTerminate();
-    return 0;
+    return benchResult;
 }
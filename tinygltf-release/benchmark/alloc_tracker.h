@@ -0,0 +1,61 @@
+//
+// Heap accounting shared by the benchmarks: replaces the global operator
+// new/delete so that every allocation is counted and the heap in use and its
+// high-water mark are tracked.
+//
+// Include it from exactly one translation unit of a benchmark. To measure a
+// region, store g_in_use into g_peak first, then read g_peak afterwards:
+//
+//   const size_t base = g_in_use.load();
+//   g_peak.store(base);
+//   Run();
+//   size_t peak = g_peak.load() - base;
+//
+#ifndef TINYGLTF_BENCHMARK_ALLOC_TRACKER_H_
+#define TINYGLTF_BENCHMARK_ALLOC_TRACKER_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+// Heap in use and its high-water mark; each block carries its size.
+static std::atomic<size_t> g_in_use{0};
+static std::atomic<size_t> g_peak{0};
+// operator new calls and the bytes they asked for, never decremented.
+static std::atomic<size_t> g_allocs{0};
+static std::atomic<size_t> g_allocated_bytes{0};
+// Keeps the returned pointer aligned for any fundamental type.
+static const size_t kAllocHeader = 16;
+
+void *operator new(size_t size) {
+  unsigned char *p =
+      static_cast<unsigned char *>(std::malloc(size + kAllocHeader));
+  if (!p) throw std::bad_alloc();
+  std::memcpy(p, &size, sizeof(size));
+  g_allocs.fetch_add(1, std::memory_order_relaxed);
+  g_allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+  size_t now = g_in_use.fetch_add(size) + size;
+  size_t peak = g_peak.load();
+  while (now > peak && !g_peak.compare_exchange_weak(peak, now)) {
+  }
+  return p + kAllocHeader;
+}
+
+void operator delete(void *ptr) noexcept {
+  if (!ptr) return;
+  unsigned char *p = static_cast<unsigned char *>(ptr) - kAllocHeader;
+  size_t size;
+  std::memcpy(&size, p, sizeof(size));
+  g_in_use.fetch_sub(size);
+  std::free(p);
+}
+
+void operator delete(void *ptr, size_t) noexcept { operator delete(ptr); }
+
+static inline double MiB(size_t bytes) {
+  return double(bytes) / (1024.0 * 1024.0);
+}
+
+#endif  // TINYGLTF_BENCHMARK_ALLOC_TRACKER_H_
@@ -0,0 +1,165 @@
+//
+// Throughput of the tinygltf::kernels conversion and base64 kernels on
+// every instruction set the CPU supports, against their scalar loops. The
+// SSE2 tier runs base64 with SSSE3 when the CPU has it.
+//
+// usage: kernel_bench [elements] [repeats]
+//
+// GB/s counts bytes read plus bytes written. Each run's output is compared
+// with the scalar result; the exit code is 1 on any mismatch.
+//
+#define TINYGLTF_IMPLEMENTATION
+#define TINYGLTF_NO_STB_IMAGE
+#define TINYGLTF_NO_STB_IMAGE_WRITE
+#define TINYGLTF_NO_EXTERNAL_IMAGE
+#include "tiny_gltf.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+using tinygltf::kernels::Isa;
+
+struct Kernel {
+  const char *name;
+  size_t bytes;  // read + written per run
+  std::function<void()> run;
+  std::function<std::vector<unsigned char>()> output;
+};
+
+template <typename T>
+static std::vector<unsigned char> AsBytes(const std::vector<T> &v) {
+  const unsigned char *p = reinterpret_cast<const unsigned char *>(v.data());
+  return std::vector<unsigned char>(p, p + v.size() * sizeof(T));
+}
+
+static double BestSeconds(const std::function<void()> &run, int repeats) {
+  double best = 1e30;
+  for (int r = 0; r < repeats; ++r) {
+    auto t0 = std::chrono::steady_clock::now();
+    run();
+    auto t1 = std::chrono::steady_clock::now();
+    double s = std::chrono::duration<double>(t1 - t0).count();
+    if (s < best) best = s;
+  }
+  return best;
+}
+
+int main(int argc, char **argv) {
+  const size_t n = argc > 1 ? size_t(std::strtoull(argv[1], nullptr, 10))
+                            : size_t(1) << 23;
+  const int repeats = argc > 2 ? std::atoi(argv[2]) : 7;
+
+  // Random payloads; floats stay finite so every path takes the same branches
+  std::vector<unsigned char> bytes(n * 4);
+  std::vector<float> floats(n * 5);  // 20-byte stride: xyz + 8 bytes of uv
+  uint32_t rng = 1;
+  for (unsigned char &b : bytes) {
+    rng = rng * 1664525u + 1013904223u;
+    b = static_cast<unsigned char>(rng >> 24);
+  }
+  for (float &f : floats) {
+    rng = rng * 1664525u + 1013904223u;
+    f = float(int32_t(rng)) * (1.0f / 65536.0f);
+  }
+  const unsigned char *xyz =
+      reinterpret_cast<const unsigned char *>(floats.data());
+  const uint16_t *shorts = reinterpret_cast<const uint16_t *>(bytes.data());
+
+  std::vector<uint32_t> u32(n);
+  std::vector<float> f32(n * 3);
+  std::vector<uint16_t> f16(n * 3);
+  float bounds[6];
+
+  // base64 of the random bytes, and room for its encoding/decoding
+  const size_t b64Size = tinygltf::kernels::Base64EncodedSize(bytes.size());
+  std::string b64(b64Size, '\0');
+  tinygltf::kernels::Base64Encode(bytes.data(), bytes.size(), &b64[0]);
+  std::string b64Out(b64Size, '\0');
+  std::vector<unsigned char> decoded(bytes.size());
+
+  std::vector<Kernel> kernels = {
+      {"widen u8->u32", n * 5,
+       [&] { tinygltf::kernels::WidenU8ToU32(bytes.data(), n, u32.data()); },
+       [&] { return AsBytes(u32); }},
+      {"widen u16->u32", n * 6,
+       [&] { tinygltf::kernels::WidenU16ToU32(shorts, n, u32.data()); },
+       [&] { return AsBytes(u32); }},
+      {"gather float3 (stride 20)", n * 24,
+       [&] { tinygltf::kernels::GatherFloat3(xyz, 20, n, f32.data()); },
+       [&] { return AsBytes(f32); }},
+      {"bounds float3 (stride 20)", n * 12,
+       [&] {
+         tinygltf::kernels::BoundsFloat3(xyz, 20, n, bounds, bounds + 3);
+       },
+       [&] {
+         return std::vector<unsigned char>(
+             reinterpret_cast<unsigned char *>(bounds),
+             reinterpret_cast<unsigned char *>(bounds + 6));
+       }},
+      {"unorm8 -> float", n * 5,
+       [&] {
+         tinygltf::kernels::NormalizedToFloat(
+             bytes.data(), TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE, n,
+             f32.data());
+       },
+       [&] { return AsBytes(std::vector<float>(f32.begin(), f32.begin() + long(n))); }},
+      {"snorm16 -> float", n * 6,
+       [&] {
+         tinygltf::kernels::NormalizedToFloat(
+             bytes.data(), TINYGLTF_COMPONENT_TYPE_SHORT, n, f32.data());
+       },
+       [&] { return AsBytes(std::vector<float>(f32.begin(), f32.begin() + long(n))); }},
+      {"float -> half", n * 3 * 6,
+       [&] { tinygltf::kernels::FloatToHalf(floats.data(), n * 3, f16.data()); },
+       [&] { return AsBytes(f16); }},
+      {"base64 encode", bytes.size() + b64Size,
+       [&] {
+         tinygltf::kernels::Base64Encode(bytes.data(), bytes.size(),
+                                         &b64Out[0]);
+       },
+       [&] { return std::vector<unsigned char>(b64Out.begin(), b64Out.end()); }},
+      {"base64 size + decode", b64Size * 2 + bytes.size(),
+       [&] {
+         size_t digits = 0;
+         tinygltf::kernels::Base64DecodedSize(b64.data(), b64.size(), &digits);
+         tinygltf::kernels::Base64Decode(b64.data(), digits, decoded.data());
+       },
+       [&] { return decoded; }},
+  };
+
+  const Isa supported = tinygltf::kernels::SupportedIsa();
+  std::printf("%zu elements, best of %d, cpu supports %s\n\n", n, repeats,
+              tinygltf::kernels::IsaName(supported));
+  std::printf("%-28s %-7s %9s %8s\n", "kernel", "isa", "GB/s", "speedup");
+
+  bool ok = true;
+  for (const Kernel &k : kernels) {
+    double scalarSeconds = 0.0;
+    std::vector<unsigned char> reference;
+    for (Isa isa : {Isa::Scalar, Isa::SSE2, Isa::AVX2}) {
+      if (isa > supported) continue;
+      tinygltf::kernels::SetIsa(isa);
+      k.run();  // warm caches and page in the output
+      double s = BestSeconds(k.run, repeats);
+      std::vector<unsigned char> out = k.output();
+      if (isa == Isa::Scalar) {
+        scalarSeconds = s;
+        reference = out;
+      } else if (out != reference) {
+        std::printf("MISMATCH: %s on %s\n", k.name,
+                    tinygltf::kernels::IsaName(isa));
+        ok = false;
+      }
+      std::printf("%-28s %-7s %9.2f %7.2fx\n", k.name,
+                  tinygltf::kernels::IsaName(isa), double(k.bytes) / s / 1e9,
+                  scalarSeconds / s);
+    }
+  }
+  tinygltf::kernels::SetIsa(supported);
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,302 @@
+//
+// Heap traffic of the loader's data paths: bytes allocated per load of an
+// embedded (data URI) glTF and of a GLB, and each hot path against the
+// copy-based code it replaced.
+//
+// usage: load_bench [buffer MiB] [repeats]
+//
+// "alloc MiB" counts every operator new during one load; "payload MiB" is
+// what ends up in Buffer::data and Image::image. The difference is the
+// intermediate storage a load needs (JSON DOM, data URI strings, ...).
+// "copied MiB" counts the bytes moved from one buffer into another on top of
+// decoding them. For whole loads and DecodeDataURI() the library reports
+// them through its TINYGLTF_COUNT_COPY() hook; the replaced code below
+// counts its own (substrings, string growth, copies into the destination).
+//
+// The "substr+string+copy" row runs a copy of the decoder tinygltf used
+// before DecodeDataURI() decoded into the destination.
+//
+#include <atomic>
+#include <cstddef>
+
+// Bytes copied between buffers, by the library and by the replaced code.
+static std::atomic<size_t> g_copied_bytes{0};
+
+#define TINYGLTF_COUNT_COPY(n) (g_copied_bytes += (n))
+#define TINYGLTF_IMPLEMENTATION
+#define STB_IMAGE_IMPLEMENTATION
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "tiny_gltf.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "alloc_tracker.h"
+
+struct Traffic {
+  size_t allocations;
+  size_t bytes;
+  size_t copied;
+  double seconds;  // best of `repeats`
+};
+
+static Traffic Measure(const std::function<void()> &run, int repeats) {
+  Traffic t{0, 0, 0, 1e30};
+  for (int r = 0; r < repeats; ++r) {
+    size_t a0 = g_allocs.load(), b0 = g_allocated_bytes.load();
+    size_t c0 = g_copied_bytes.load();
+    auto t0 = std::chrono::steady_clock::now();
+    run();
+    auto t1 = std::chrono::steady_clock::now();
+    t.allocations = g_allocs.load() - a0;
+    t.bytes = g_allocated_bytes.load() - b0;
+    t.copied = g_copied_bytes.load() - c0;
+    t.seconds = std::min(t.seconds, std::chrono::duration<double>(t1 - t0).count());
+  }
+  return t;
+}
+
+// tinygltf's base64_decode() before DecodeDataURI() decoded in place (René
+// Nyffenegger's decoder), appending to a string one byte at a time. The
+// bytes moved when the string grows are added to g_copied_bytes.
+static inline bool BaselineIsBase64(unsigned char c) {
+  return (isalnum(c) || (c == '+') || (c == '/'));
+}
+
+static void BaselineAppend(std::string &ret, unsigned char c) {
+  if (ret.size() == ret.capacity()) g_copied_bytes += ret.size();
+  ret += static_cast<char>(c);
+}
+
+static std::string BaselineBase64Decode(std::string const &encoded_string) {
+  int in_len = static_cast<int>(encoded_string.size());
+  int i = 0;
+  int j = 0;
+  int in_ = 0;
+  unsigned char char_array_4[4], char_array_3[3];
+  std::string ret;
+
+  const std::string base64_chars =
+      "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+      "abcdefghijklmnopqrstuvwxyz"
+      "0123456789+/";
+
+  while (in_len-- && (encoded_string[in_] != '=') &&
+         BaselineIsBase64(static_cast<unsigned char>(encoded_string[in_]))) {
+    char_array_4[i++] = static_cast<unsigned char>(encoded_string[in_]);
+    in_++;
+    if (i == 4) {
+      for (i = 0; i < 4; i++)
+        char_array_4[i] = static_cast<unsigned char>(
+            base64_chars.find(static_cast<char>(char_array_4[i])));
+
+      char_array_3[0] = static_cast<unsigned char>(
+          (char_array_4[0] << 2) + ((char_array_4[1] & 0x30) >> 4));
+      char_array_3[1] = static_cast<unsigned char>(
+          ((char_array_4[1] & 0xf) << 4) + ((char_array_4[2] & 0x3c) >> 2));
+      char_array_3[2] = static_cast<unsigned char>(
+          ((char_array_4[2] & 0x3) << 6) + char_array_4[3]);
+
+      for (i = 0; (i < 3); i++) BaselineAppend(ret, char_array_3[i]);
+      i = 0;
+    }
+  }
+
+  if (i) {
+    for (j = i; j < 4; j++) char_array_4[j] = 0;
+
+    for (j = 0; j < 4; j++)
+      char_array_4[j] = static_cast<unsigned char>(
+          base64_chars.find(static_cast<char>(char_array_4[j])));
+
+    char_array_3[0] = static_cast<unsigned char>(
+        (char_array_4[0] << 2) + ((char_array_4[1] & 0x30) >> 4));
+    char_array_3[1] = static_cast<unsigned char>(
+        ((char_array_4[1] & 0xf) << 4) + ((char_array_4[2] & 0x3c) >> 2));
+    char_array_3[2] = static_cast<unsigned char>(
+        ((char_array_4[2] & 0x3) << 6) + char_array_4[3]);
+
+    for (j = 0; (j < i - 1); j++) BaselineAppend(ret, char_array_3[j]);
+  }
+
+  return ret;
+}
+
+static void AppendU32(std::vector<unsigned char> *out, uint32_t v) {
+  for (int i = 0; i < 4; ++i) out->push_back(static_cast<unsigned char>(v >> (8 * i)));
+}
+
+static void WriteToVector(void *context, void *data, int size) {
+  auto *out = static_cast<std::vector<unsigned char> *>(context);
+  const unsigned char *p = static_cast<const unsigned char *>(data);
+  out->insert(out->end(), p, p + size);
+}
+
+int main(int argc, char **argv) {
+  const size_t mib = argc > 1 ? size_t(std::strtoull(argv[1], nullptr, 10)) : 16;
+  const int repeats = argc > 2 ? std::atoi(argv[2]) : 5;
+
+  // Payloads: a pseudo-random buffer and a 1024x1024 RGBA PNG
+  std::vector<unsigned char> bin(mib << 20);
+  uint32_t rng = 1;
+  for (unsigned char &b : bin) {
+    rng = rng * 1664525u + 1013904223u;
+    b = static_cast<unsigned char>(rng >> 24);
+  }
+  const int w = 1024, h = 1024;
+  std::vector<unsigned char> pixels(size_t(w * h * 4));
+  for (size_t i = 0; i < pixels.size(); ++i) {
+    pixels[i] = static_cast<unsigned char>((i >> 2) ^ (i >> 12) ^ (i & 3) * 85);
+  }
+  std::vector<unsigned char> png;
+  stbi_write_png_to_func(WriteToVector, &png, w, h, 4, pixels.data(), w * 4);
+
+  const std::string bin64 =
+      tinygltf::base64_encode(bin.data(), static_cast<unsigned int>(bin.size()));
+  const std::string png64 =
+      tinygltf::base64_encode(png.data(), static_cast<unsigned int>(png.size()));
+
+  const std::string gltf =
+      "{\"asset\":{\"version\":\"2.0\"},\"buffers\":[{\"byteLength\":" +
+      std::to_string(bin.size()) +
+      ",\"uri\":\"data:application/octet-stream;base64," + bin64 +
+      "\"}],\"images\":[{\"uri\":\"data:image/png;base64," + png64 + "\"}]}";
+
+  // GLB: the BIN chunk holds the buffer followed by the PNG
+  std::vector<unsigned char> glb;
+  {
+    const size_t png_offset = bin.size();
+    const size_t bin_size = (png_offset + png.size() + 3) & ~size_t(3);
+    std::string json =
+        "{\"asset\":{\"version\":\"2.0\"},\"buffers\":[{\"byteLength\":" +
+        std::to_string(bin_size) +
+        "}],\"bufferViews\":[{\"buffer\":0,\"byteOffset\":" +
+        std::to_string(png_offset) +
+        ",\"byteLength\":" + std::to_string(png.size()) +
+        "}],\"images\":[{\"bufferView\":0,\"mimeType\":\"image/png\"}]}";
+    while (json.size() % 4) json += ' ';
+    AppendU32(&glb, 0x46546C67);  // "glTF"
+    AppendU32(&glb, 2);
+    AppendU32(&glb, uint32_t(12 + 8 + json.size() + 8 + bin_size));
+    AppendU32(&glb, uint32_t(json.size()));
+    AppendU32(&glb, 0x4E4F534A);  // "JSON"
+    glb.insert(glb.end(), json.begin(), json.end());
+    AppendU32(&glb, uint32_t(bin_size));
+    AppendU32(&glb, 0x004E4942);  // "BIN"
+    glb.insert(glb.end(), bin.begin(), bin.end());
+    glb.insert(glb.end(), png.begin(), png.end());
+    glb.resize(glb.size() + (bin_size - png_offset - png.size()));
+  }
+
+  std::printf("%zu MiB buffer, %dx%d PNG (%zu KiB), best of %d\n\n", mib, w, h,
+              png.size() >> 10, repeats);
+
+  bool ok = true;
+  std::printf("%-34s %8s %11s %11s %11s %9s\n", "load", "allocs",
+              "alloc MiB", "payload MiB", "copied MiB", "ms");
+  struct Load {
+    const char *name;
+    std::function<bool(tinygltf::TinyGLTF &, tinygltf::Model *)> run;
+  };
+  const Load loads[] = {
+      {"glTF, data URI buffer + image",
+       [&](tinygltf::TinyGLTF &ctx, tinygltf::Model *model) {
+         std::string err, warn;
+         return ctx.LoadASCIIFromString(model, &err, &warn, gltf.c_str(),
+                                        static_cast<unsigned int>(gltf.size()),
+                                        "");
+       }},
+      {"GLB, BIN chunk buffer + image",
+       [&](tinygltf::TinyGLTF &ctx, tinygltf::Model *model) {
+         std::string err, warn;
+         return ctx.LoadBinaryFromMemory(model, &err, &warn, glb.data(),
+                                         static_cast<unsigned int>(glb.size()),
+                                         "");
+       }},
+  };
+  for (const Load &load : loads) {
+    tinygltf::TinyGLTF ctx;
+    ctx.SetImageDecodeThreads(1);
+    size_t payload = 0;
+    Traffic t = Measure(
+        [&] {
+          tinygltf::Model model;
+          if (!load.run(ctx, &model) || model.images.empty() ||
+              model.images[0].image.size() != pixels.size() ||
+              !std::equal(pixels.begin(), pixels.end(),
+                          model.images[0].image.begin())) {
+            ok = false;
+          }
+          payload = model.images[0].image.size();
+          for (const tinygltf::Buffer &b : model.buffers) payload += b.data.size();
+        },
+        repeats);
+    std::printf("%-34s %8zu %11.2f %11.2f %11.2f %9.2f\n", load.name,
+                t.allocations, MiB(t.bytes), MiB(payload), MiB(t.copied),
+                t.seconds * 1e3);
+  }
+
+  // Each hot path against the code it replaced
+  std::printf("\n%-34s %8s %11s %11s %9s\n", "path", "allocs", "alloc MiB",
+              "copied MiB", "ms");
+  const std::string uri = "data:application/octet-stream;base64," + bin64;
+  const size_t header = uri.find(',') + 1;
+  std::vector<unsigned char> out;
+  struct Path {
+    const char *name;
+    std::function<void()> run;
+  };
+  const Path paths[] = {
+      {"data URI: substr+string+copy",
+       [&] {
+         const std::string payload = uri.substr(header);
+         g_copied_bytes += payload.size();
+         std::string data = BaselineBase64Decode(payload);
+         std::vector<unsigned char> v;
+         v.resize(data.size());
+         std::copy(data.begin(), data.end(), v.begin());
+         g_copied_bytes += data.size();
+         out.swap(v);
+       }},
+      {"data URI: DecodeDataURI",
+       [&] {
+         std::vector<unsigned char> v;
+         std::string mime_type;
+         tinygltf::DecodeDataURI(&v, mime_type, uri, bin.size(), true);
+         out.swap(v);
+       }},
+      {"GLB BIN: resize+memcpy",
+       [&] {
+         std::vector<unsigned char> v;
+         v.resize(bin.size());
+         memcpy(v.data(), bin.data(), bin.size());
+         g_copied_bytes += bin.size();
+         out.swap(v);
+       }},
+      {"GLB BIN: assign",
+       [&] {
+         std::vector<unsigned char> v;
+         v.assign(bin.data(), bin.data() + bin.size());
+         g_copied_bytes += bin.size();
+         out.swap(v);
+       }},
+  };
+  for (const Path &path : paths) {
+    Traffic t = Measure(path.run, repeats);
+    if (out != bin) {
+      std::printf("MISMATCH: %s\n", path.name);
+      ok = false;
+    }
+    std::printf("%-34s %8zu %11.2f %11.2f %9.2f\n", path.name, t.allocations,
+                MiB(t.bytes), MiB(t.copied), t.seconds * 1e3);
+  }
+  return ok ? 0 : 1;
+}
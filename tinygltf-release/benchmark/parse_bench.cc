@@ -0,0 +1,148 @@
+//
+// Peak heap use and time of loading a .gltf with the streaming (SAX) front
+// end against building the JSON DOM first, with and without a ModelArena.
+//
+// usage: parse_bench [file.gltf | elements] [repeats]
+//
+// Without a file, a synthetic glTF with `elements` (default 200000) nodes,
+// each with a small `extras` object, accessors, bufferViews and materials is
+// generated. "peak MiB" is the largest amount of heap in use during the
+// load, "model MiB" what is left allocated once the model has been filled,
+// "allocs" the operator new calls of one load and "free ms" the time to
+// destroy the model and its loader.
+// The arena row loads repeatedly into the same Model, reusing its storage.
+//
+#define TINYGLTF_IMPLEMENTATION
+#define TINYGLTF_ENABLE_STREAMING_PARSE
+#define TINYGLTF_ENABLE_MODEL_ARENA
+#define TINYGLTF_NO_STB_IMAGE
+#define TINYGLTF_NO_STB_IMAGE_WRITE
+#include "tiny_gltf.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <string>
+
+#include "alloc_tracker.h"
+
+static std::string Synthesize(size_t n) {
+  std::ostringstream ss;
+  ss << "{\"asset\":{\"version\":\"2.0\",\"generator\":\"parse_bench\"},";
+  ss << "\"buffers\":[{\"byteLength\":48,\"uri\":\"data:application/"
+        "octet-stream;base64,"
+     << std::string(64, 'A') << "\"}],";
+  ss << "\"bufferViews\":[";
+  for (size_t i = 0; i < n; ++i) {
+    ss << (i ? "," : "")
+       << "{\"buffer\":0,\"byteLength\":48,\"target\":34962}";
+  }
+  ss << "],\"accessors\":[";
+  for (size_t i = 0; i < n; ++i) {
+    ss << (i ? "," : "") << "{\"bufferView\":" << i
+       << ",\"componentType\":5126,\"count\":4,\"type\":\"VEC3\","
+          "\"min\":[-1.0,-1.0,-1.0],\"max\":[1.0,1.0,1.0]}";
+  }
+  ss << "],\"materials\":[";
+  for (size_t i = 0; i < n; ++i) {
+    ss << (i ? "," : "") << "{\"name\":\"material" << i
+       << "\",\"pbrMetallicRoughness\":{"
+          "\"baseColorFactor\":[0.5,0.5,0.5,1.0],"
+          "\"metallicFactor\":0.25,\"roughnessFactor\":0.75}}";
+  }
+  ss << "],\"nodes\":[";
+  for (size_t i = 0; i < n; ++i) {
+    ss << (i ? "," : "") << "{\"name\":\"node" << i
+       << "\",\"translation\":[" << i << ".5,2.25,-3.125],"
+          "\"rotation\":[0.0,0.0,0.0,1.0],\"scale\":[1.0,1.0,1.0],"
+          "\"extras\":{\"id\":"
+       << i
+       << ",\"layer\":\"props\",\"lod\":0.5,\"visible\":true,"
+          "\"tags\":[\"static\",\"shadow\"]}}";
+  }
+  ss << "],\"scenes\":[{\"nodes\":[";
+  for (size_t i = 0; i < n; ++i) ss << (i ? "," : "") << i;
+  ss << "]}],\"scene\":0}";
+  return ss.str();
+}
+
+int main(int argc, char **argv) {
+  std::string json, basedir;
+  size_t elements = 200000;
+  if (argc > 1 && std::strtoull(argv[1], nullptr, 10) == 0) {
+    std::ifstream f(argv[1], std::ios::binary);
+    if (!f) {
+      std::fprintf(stderr, "cannot read %s\n", argv[1]);
+      return 1;
+    }
+    json.assign(std::istreambuf_iterator<char>(f),
+                std::istreambuf_iterator<char>());
+    basedir = tinygltf::GetBaseDir(argv[1]);
+  } else {
+    if (argc > 1) elements = size_t(std::strtoull(argv[1], nullptr, 10));
+    json = Synthesize(elements);
+  }
+  const int repeats = argc > 2 ? std::atoi(argv[2]) : 3;
+
+  std::printf("%.2f MiB of JSON, best of %d\n\n", MiB(json.size()), repeats);
+  std::printf("%-10s %10s %10s %10s %9s %9s\n", "front end", "peak MiB",
+              "model MiB", "allocs", "ms", "free ms");
+
+  struct Config {
+    const char *name;
+    bool streaming;
+    bool arena;
+  };
+  const Config configs[] = {
+      {"DOM", false, false}, {"streaming", true, false}, {"arena", true, true}};
+  bool ok = true;
+  tinygltf::Model reference;
+  for (const Config &config : configs) {
+    std::unique_ptr<tinygltf::TinyGLTF> ctx(new tinygltf::TinyGLTF);
+    ctx->SetStreamingParse(config.streaming);
+    ctx->SetModelArena(config.arena);
+    std::unique_ptr<tinygltf::Model> model;
+    double best = 1e30;
+    size_t peak = 0, kept = 0, allocs = 0;
+    const size_t base = g_in_use.load();
+    for (int r = 0; r < repeats; ++r) {
+      if (!config.arena || !model) model.reset(new tinygltf::Model);
+      std::string err, warn;
+      g_peak.store(g_in_use.load());
+      const size_t allocs0 = g_allocs.load();
+      auto t0 = std::chrono::steady_clock::now();
+      if (!ctx->LoadASCIIFromString(model.get(), &err, &warn, json.c_str(),
+                                    static_cast<unsigned int>(json.size()),
+                                    basedir)) {
+        std::printf("load failed: %s\n", err.c_str());
+        return 1;
+      }
+      auto t1 = std::chrono::steady_clock::now();
+      best = std::min(best, std::chrono::duration<double>(t1 - t0).count());
+      allocs = g_allocs.load() - allocs0;
+      peak = g_peak.load() - base;
+      kept = g_in_use.load() - base;
+    }
+    if (&config == configs) {
+      reference = *model;
+    } else if (!(*model == reference)) {
+      std::printf("MISMATCH between the %s and DOM models\n", config.name);
+      ok = false;
+    }
+    auto t0 = std::chrono::steady_clock::now();
+    model.reset();
+    ctx.reset();
+    auto t1 = std::chrono::steady_clock::now();
+    std::printf("%-10s %10.2f %10.2f %10zu %9.2f %9.2f\n", config.name,
+                MiB(peak), MiB(kept), allocs, best * 1e3,
+                std::chrono::duration<double>(t1 - t0).count() * 1e3);
+  }
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,174 @@
+//
+// Time and peak memory of saving a model with an embedded buffer to a
+// stream: the writer that builds the whole JSON DOM and dumps it to a string
+// first against the one that writes the JSON as it walks the model.
+//
+// usage: save_bench [buffer MiB] [repeats] [dom | stream]
+//
+// The model has one embedded buffer of the given size (default 64) and a
+// few thousand small nodes, accessors and bufferViews. "peak MiB" is the
+// largest amount of heap in use during a save on top of the model, "max RSS"
+// the process high-water mark after the row, so run a single writer (third
+// argument) to see the RSS of each; `save_bench 1024 1 stream` saves a 1 GiB
+// buffer. The output is hashed and discarded; both writers must produce the
+// same bytes.
+//
+#define TINYGLTF_IMPLEMENTATION
+#define TINYGLTF_NO_STB_IMAGE
+#define TINYGLTF_NO_STB_IMAGE_WRITE
+#include "tiny_gltf.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <ostream>
+#include <streambuf>
+#include <string>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+#include "alloc_tracker.h"
+
+static double MaxRssMiB() {
+#ifndef _WIN32
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return double(usage.ru_maxrss) / 1024.0;  // KiB on Linux
+#else
+  return 0.0;
+#endif
+}
+
+// Counts and hashes (FNV-1a) what is written, without keeping it.
+class HashBuf : public std::streambuf {
+ public:
+  size_t size = 0;
+  uint64_t hash = 14695981039346656037ull;
+
+ protected:
+  std::streamsize xsputn(const char *s, std::streamsize n) override {
+    for (std::streamsize i = 0; i < n; ++i) Add(s[i]);
+    return n;
+  }
+  int_type overflow(int_type c) override {
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+      Add(traits_type::to_char_type(c));
+    }
+    return traits_type::not_eof(c);
+  }
+
+ private:
+  void Add(char c) {
+    hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+    ++size;
+  }
+};
+
+static void Synthesize(size_t mib, tinygltf::Model *model) {
+  model->asset.version = "2.0";
+  model->asset.generator = "save_bench";
+  tinygltf::Buffer buffer;
+  buffer.data.resize(mib * 1024 * 1024);
+  for (size_t i = 0; i < buffer.data.size(); ++i) {
+    buffer.data[i] = static_cast<unsigned char>(i * 2654435761u >> 13);
+  }
+  model->buffers.push_back(std::move(buffer));
+  const int n = 5000;
+  for (int i = 0; i < n; ++i) {
+    tinygltf::BufferView view;
+    view.buffer = 0;
+    view.byteOffset = size_t(i) * 48 % (mib * 1024 * 1024 + 1);
+    view.byteLength = 48;
+    model->bufferViews.push_back(view);
+    tinygltf::Accessor accessor;
+    accessor.bufferView = i;
+    accessor.componentType = TINYGLTF_COMPONENT_TYPE_FLOAT;
+    accessor.type = TINYGLTF_TYPE_VEC3;
+    accessor.count = 4;
+    accessor.minValues = {-1.0, -1.0, -1.0};
+    accessor.maxValues = {1.0, 1.0, 1.0};
+    model->accessors.push_back(accessor);
+    tinygltf::Node node;
+    node.name = "node" + std::to_string(i);
+    node.translation = {double(i), 0.0, 1.0};
+    model->nodes.push_back(node);
+  }
+}
+
+// The DOM writer: SerializeGltfDocument() dumped to a string and streamed.
+static bool SaveDom(const tinygltf::Model &model, std::ostream &stream,
+                    bool pretty) {
+  tinygltf::GltfPayloads payloads;
+  for (const tinygltf::Buffer &buffer : model.buffers) {
+    tinygltf::SerializeGltfBufferPayload(buffer, false, &payloads);
+  }
+  tinygltf::detail::JsonDocument output;
+  tinygltf::SerializeGltfDocument(model, payloads, output);
+  stream << tinygltf::detail::JsonToString(output, pretty ? 2 : -1)
+         << std::endl;
+  return stream.good();
+}
+
+int main(int argc, char **argv) {
+  const size_t mib = argc > 1 ? size_t(std::atoll(argv[1])) : 64;
+  const int repeats = argc > 2 ? std::max(1, std::atoi(argv[2])) : 3;
+  const std::string only = argc > 3 ? argv[3] : "";
+
+  tinygltf::Model model;
+  Synthesize(mib, &model);
+  std::printf("%zu MiB embedded buffer, %zu nodes, best of %d\n\n", mib,
+              model.nodes.size(), repeats);
+  std::printf("%-8s %-7s %10s %10s %10s %9s\n", "writer", "format",
+              "out MiB", "peak MiB", "max RSS", "ms");
+
+  bool ok = true;
+  for (int pretty = 0; pretty < 2; ++pretty) {
+    size_t expected_size = 0;
+    uint64_t expected_hash = 0;
+    for (int w = 0; w < 2; ++w) {
+      const bool dom = w == 1;
+      const char *name = dom ? "dom" : "stream";
+      if (!only.empty() && only != name) continue;
+      double best = 1e30;
+      size_t peak = 0;
+      HashBuf out;
+      for (int r = 0; r < repeats; ++r) {
+        out = HashBuf();
+        std::ostream stream(&out);
+        tinygltf::TinyGLTF ctx;
+        const size_t base = g_in_use.load();
+        g_peak.store(base);
+        auto t0 = std::chrono::steady_clock::now();
+        const bool saved =
+            dom ? SaveDom(model, stream, pretty != 0)
+                : ctx.WriteGltfSceneToStream(&model, stream, pretty != 0,
+                                             false);
+        auto t1 = std::chrono::steady_clock::now();
+        if (!saved) {
+          std::printf("save failed: %s\n", name);
+          return 1;
+        }
+        best = std::min(best, std::chrono::duration<double>(t1 - t0).count());
+        peak = g_peak.load() - base;
+      }
+      if (expected_size == 0) {
+        expected_size = out.size;
+        expected_hash = out.hash;
+      } else if (out.size != expected_size || out.hash != expected_hash) {
+        std::printf("MISMATCH between the stream and DOM writers\n");
+        ok = false;
+      }
+      std::printf("%-8s %-7s %10.2f %10.2f %10.2f %9.2f\n", name,
+                  pretty ? "pretty" : "compact", MiB(out.size), MiB(peak),
+                  MaxRssMiB(), best * 1e3);
+    }
+  }
+  return ok ? 0 : 1;
+}
@@ -62,9 +62,18 @@ typedef struct {
   std::vector<GLuint> diffuseTex;  // for each primitive in mesh
 } GLMeshState;
 
+// Vertex attributes DrawMesh binds, and their shader inputs. Primitives look
+// them up by interned semantic rather than by name.
+static const tinygltf::AttributeSemantic kBoundAttributes[] = {
+    tinygltf::AttributeSemantic::Position, tinygltf::AttributeSemantic::Normal,
+    tinygltf::AttributeSemantic::TexCoord0};
+static const size_t kNumBoundAttributes =
+    sizeof(kBoundAttributes) / sizeof(kBoundAttributes[0]);
+
 typedef struct {
   std::map<std::string, GLint> attribs;
   std::map<std::string, GLint> uniforms;
+  GLint boundAttribs[kNumBoundAttributes];  // attribs of kBoundAttributes
 } GLProgramState;
 
 typedef struct {
@@ -465,6 +474,10 @@ static void SetupMeshState(tinygltf::Model &model, GLuint progId) {
   gGLProgramState.attribs["POSITION"] = vtloc;
   gGLProgramState.attribs["NORMAL"] = nrmloc;
   gGLProgramState.attribs["TEXCOORD_0"] = uvloc;
+  for (size_t k = 0; k < kNumBoundAttributes; k++) {
+    gGLProgramState.boundAttribs[k] = gGLProgramState.attribs[
+        tinygltf::AttributeSemanticName(kBoundAttributes[k])];
+  }
   // gGLProgramState.uniforms["diffuseTex"] = diffuseTexLoc;
   gGLProgramState.uniforms["isCurvesLoc"] = isCurvesLoc;
 };
@@ -628,6 +641,10 @@ static void SetupCurvesState(tinygltf::Scene &scene, GLuint progId) {
 	gGLProgramState.attribs["POSITION"] = vtloc;
 	gGLProgramState.attribs["NORMAL"] = nrmloc;
 	gGLProgramState.attribs["TEXCOORD_0"] = uvloc;
+	for (size_t k = 0; k < kNumBoundAttributes; k++) {
+		gGLProgramState.boundAttribs[k] = gGLProgramState.attribs[
+			tinygltf::AttributeSemanticName(kBoundAttributes[k])];
+	}
 	gGLProgramState.uniforms["diffuseTex"] = diffuseTexLoc;
 	gGLProgramState.uniforms["uIsCurves"] = isCurvesLoc;
 };
@@ -655,11 +672,13 @@ static void DrawMesh(tinygltf::Model &model, const tinygltf::Mesh &mesh) {
     // Assume TEXTURE_2D target for the texture object.
     // glBindTexture(GL_TEXTURE_2D, gMeshState[mesh.name].diffuseTex[i]);
 
-    std::map<std::string, int>::const_iterator it(primitive.attributes.begin());
-    std::map<std::string, int>::const_iterator itEnd(
-        primitive.attributes.end());
-
-    for (; it != itEnd; it++) {
+    // Only POSITION, NORMAL and TEXCOORD_0 are bound; neither the
+    // primitive's attributes nor the shader inputs are looked up by name.
+    for (size_t k = 0; k < kNumBoundAttributes; k++) {
+      tinygltf::AttributeMap::const_iterator it =
+          primitive.attributes.find(kBoundAttributes[k]);
+      if (it == primitive.attributes.end()) continue;
+      const GLint location = gGLProgramState.boundAttribs[k];
       assert(it->second >= 0);
       const tinygltf::Accessor &accessor = model.accessors[it->second];
       glBindBuffer(GL_ARRAY_BUFFER, gBufferState[accessor.bufferView].vb);
@@ -676,23 +695,17 @@ static void DrawMesh(tinygltf::Model &model, const tinygltf::Mesh &mesh) {
       } else {
         assert(0);
       }
-      // it->first would be "POSITION", "NORMAL", "TEXCOORD_0", ...
-      if ((it->first.compare("POSITION") == 0) ||
-          (it->first.compare("NORMAL") == 0) ||
-          (it->first.compare("TEXCOORD_0") == 0)) {
-        if (gGLProgramState.attribs[it->first] >= 0) {
-          // Compute byteStride from Accessor + BufferView combination.
-          int byteStride =
-              accessor.ByteStride(model.bufferViews[accessor.bufferView]);
-          assert(byteStride != -1);
-          glVertexAttribPointer(gGLProgramState.attribs[it->first], size,
-                                accessor.componentType,
-                                accessor.normalized ? GL_TRUE : GL_FALSE,
-                                byteStride, BUFFER_OFFSET(accessor.byteOffset));
-          CheckErrors("vertex attrib pointer");
-          glEnableVertexAttribArray(gGLProgramState.attribs[it->first]);
-          CheckErrors("enable vertex attrib array");
-        }
+      if (location >= 0) {
+        // Compute byteStride from Accessor + BufferView combination.
+        int byteStride =
+            accessor.ByteStride(model.bufferViews[accessor.bufferView]);
+        assert(byteStride != -1);
+        glVertexAttribPointer(location, size, accessor.componentType,
+                              accessor.normalized ? GL_TRUE : GL_FALSE,
+                              byteStride, BUFFER_OFFSET(accessor.byteOffset));
+        CheckErrors("vertex attrib pointer");
+        glEnableVertexAttribArray(location);
+        CheckErrors("enable vertex attrib array");
       }
     }
 
@@ -721,20 +734,13 @@ static void DrawMesh(tinygltf::Model &model, const tinygltf::Mesh &mesh) {
                    BUFFER_OFFSET(indexAccessor.byteOffset));
     CheckErrors("draw elements");
 
-    {
-      std::map<std::string, int>::const_iterator it(
-          primitive.attributes.begin());
-      std::map<std::string, int>::const_iterator itEnd(
-          primitive.attributes.end());
-
-      for (; it != itEnd; it++) {
-        if ((it->first.compare("POSITION") == 0) ||
-            (it->first.compare("NORMAL") == 0) ||
-            (it->first.compare("TEXCOORD_0") == 0)) {
-          if (gGLProgramState.attribs[it->first] >= 0) {
-            glDisableVertexAttribArray(gGLProgramState.attribs[it->first]);
-          }
-        }
+    for (size_t k = 0; k < kNumBoundAttributes; k++) {
+      if (primitive.attributes.find(kBoundAttributes[k]) ==
+          primitive.attributes.end()) {
+        continue;
+      }
+      if (gGLProgramState.boundAttribs[k] >= 0) {
+        glDisableVertexAttribArray(gGLProgramState.boundAttribs[k]);
       }
     }
   }
@@ -0,0 +1,444 @@
+//
+// Headless impostor atlas baker.
+//
+// Loads a glTF/GLB through the raytrace example's loader, builds a nanosg
+// scene (nanort BVH per mesh) and renders the model from a grid of directions
+// laid out octahedrally (full sphere) or hemi-octahedrally (upper hemisphere)
+// with example::Renderer::Render. No GPU or display is needed.
+//
+// Outputs, for an output prefix `out`:
+//   out_color.png   RGBA8, color with anti-aliased coverage in alpha
+//   out_normal.png  RGBA8, object-space normal packed as 0.5 * N + 0.5
+//   out_depth.exr   float, depth in [0, 1] across the bounding sphere (1 = empty)
+//   out.json        atlas layout and the camera parameters used for baking
+//
+// Cells are stored row by row starting at the top-left of the image, which is
+// the convention the viewer's billboard shader uses.
+//
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "gltf-loader.h"
+#include "nanosg.h"
+#include "render.h"
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "stb_image_write.h"
+
+#define TINYEXR_IMPLEMENTATION
+#include "tinyexr.h"
+
+namespace {
+
+const float kPi = 3.14159265358979f;
+
+struct Options {
+  std::string input;
+  std::string output = "impostor";
+  int grid = 8;         // views per side, grid * grid views in total
+  int resolution = 128; // pixels per view (square)
+  int samples = 4;      // color samples per pixel
+  bool hemisphere = false;
+  float albedo[3] = {0.95f, 0.95f, 0.95f};
+  float fov = 5.0f;  // narrow, so views are close to orthographic
+};
+
+struct Vec {
+  float x, y, z;
+};
+
+Vec Normalize(Vec v) {
+  float l = std::sqrt(v.x * v.x + v.y * v.y + v.z * v.z);
+  return (l > 0.0f) ? Vec{v.x / l, v.y / l, v.z / l} : v;
+}
+
+Vec Cross(Vec a, Vec b) {
+  return Vec{a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z,
+             a.x * b.y - a.y * b.x};
+}
+
+// Cell center (s, t) in [0, 1]^2 -> unit view direction, Y up.
+Vec DecodeViewDirection(float s, float t, bool hemisphere) {
+  float px = 2.0f * s - 1.0f;
+  float pz = 2.0f * t - 1.0f;
+  if (hemisphere) {
+    // Rotate the square by 45 degrees so it covers the upper-hemisphere
+    // diamond |x| + |z| <= 1.
+    float x = 0.5f * (px + pz);
+    float z = 0.5f * (px - pz);
+    return Normalize(Vec{x, 1.0f - std::fabs(x) - std::fabs(z), z});
+  }
+  float y = 1.0f - std::fabs(px) - std::fabs(pz);
+  if (y < 0.0f) {
+    // Fold the lower hemisphere onto the outer triangles
+    float fx = (1.0f - std::fabs(pz)) * (px >= 0.0f ? 1.0f : -1.0f);
+    float fz = (1.0f - std::fabs(px)) * (pz >= 0.0f ? 1.0f : -1.0f);
+    px = fx;
+    pz = fz;
+  }
+  return Normalize(Vec{px, y, pz});
+}
+
+// Camera basis for a view from direction `d`: up follows world Y, except for
+// views straight along Y, which use -Z (top) or +Z (bottom).
+void ViewBasis(Vec d, Vec *right, Vec *up) {
+  Vec hint = Vec{0.0f, 1.0f, 0.0f};
+  if (std::fabs(d.y) > 0.999f) {
+    hint = Vec{0.0f, 0.0f, d.y > 0.0f ? -1.0f : 1.0f};
+  }
+  *right = Normalize(Cross(hint, d));
+  *up = Cross(d, *right);
+}
+
+// Rotation matrix with columns (right, up, d) -> quaternion (x, y, z, w).
+void BasisToQuat(Vec r, Vec u, Vec d, float q[4]) {
+  float m00 = r.x, m01 = u.x, m02 = d.x;
+  float m10 = r.y, m11 = u.y, m12 = d.y;
+  float m20 = r.z, m21 = u.z, m22 = d.z;
+  float trace = m00 + m11 + m22;
+  if (trace > 0.0f) {
+    float s = 2.0f * std::sqrt(trace + 1.0f);
+    q[3] = 0.25f * s;
+    q[0] = (m21 - m12) / s;
+    q[1] = (m02 - m20) / s;
+    q[2] = (m10 - m01) / s;
+  } else if (m00 > m11 && m00 > m22) {
+    float s = 2.0f * std::sqrt(1.0f + m00 - m11 - m22);
+    q[3] = (m21 - m12) / s;
+    q[0] = 0.25f * s;
+    q[1] = (m01 + m10) / s;
+    q[2] = (m02 + m20) / s;
+  } else if (m11 > m22) {
+    float s = 2.0f * std::sqrt(1.0f + m11 - m00 - m22);
+    q[3] = (m02 - m20) / s;
+    q[0] = (m01 + m10) / s;
+    q[1] = 0.25f * s;
+    q[2] = (m12 + m21) / s;
+  } else {
+    float s = 2.0f * std::sqrt(1.0f + m22 - m00 - m11);
+    q[3] = (m10 - m01) / s;
+    q[0] = (m02 + m20) / s;
+    q[1] = (m12 + m21) / s;
+    q[2] = 0.25f * s;
+  }
+}
+
+// `s` as a quoted JSON string. Paths are passed through byte for byte, so
+// UTF-8 names stay readable; only quotes, backslashes and controls are escaped.
+std::string JsonString(const std::string &s) {
+  std::string out = "\"";
+  for (char c : s) {
+    switch (c) {
+      case '"':
+        out += "\\\"";
+        break;
+      case '\\':
+        out += "\\\\";
+        break;
+      case '\b':
+        out += "\\b";
+        break;
+      case '\f':
+        out += "\\f";
+        break;
+      case '\n':
+        out += "\\n";
+        break;
+      case '\r':
+        out += "\\r";
+        break;
+      case '\t':
+        out += "\\t";
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          char buf[8];
+          std::snprintf(buf, sizeof(buf), "\\u%04x",
+                        static_cast<unsigned char>(c));
+          out += buf;
+        } else {
+          out += c;
+        }
+    }
+  }
+  return out + "\"";
+}
+
+bool ParseArgs(int argc, char **argv, Options *opt) {
+  for (int i = 1; i < argc; i++) {
+    std::string a = argv[i];
+    bool has_value = (i + 1) < argc;
+    if (a == "-o" && has_value) {
+      opt->output = argv[++i];
+    } else if (a == "--grid" && has_value) {
+      opt->grid = std::atoi(argv[++i]);
+    } else if (a == "--res" && has_value) {
+      opt->resolution = std::atoi(argv[++i]);
+    } else if (a == "--spp" && has_value) {
+      opt->samples = std::atoi(argv[++i]);
+    } else if (a == "--fov" && has_value) {
+      opt->fov = float(std::atof(argv[++i]));
+    } else if (a == "--hemi") {
+      opt->hemisphere = true;
+    } else if (a == "--albedo" && has_value) {
+      if (std::sscanf(argv[++i], "%f,%f,%f", &opt->albedo[0], &opt->albedo[1],
+                      &opt->albedo[2]) != 3) {
+        return false;
+      }
+    } else if (!a.empty() && a[0] != '-' && opt->input.empty()) {
+      opt->input = a;
+    } else {
+      return false;
+    }
+  }
+  return !opt->input.empty() && opt->grid > 0 && opt->resolution > 0 &&
+         opt->samples > 0 && opt->fov > 0.0f && opt->fov < 90.0f;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  Options opt;
+  if (!ParseArgs(argc, argv, &opt)) {
+    std::cerr << "usage: " << argv[0]
+              << " input.glb [-o prefix] [--grid N] [--res PIXELS] [--spp N]\n"
+                 "       [--hemi] [--fov DEGREES] [--albedo r,g,b]\n";
+    return EXIT_FAILURE;
+  }
+
+  // ---- load ----
+  std::vector<example::Mesh<float> > meshes;
+  std::vector<example::Material> materials;
+  std::vector<example::Texture> textures;
+
+  example::Material default_material;
+  for (int c = 0; c < 3; c++) {
+    default_material.diffuse[c] = opt.albedo[c];
+    default_material.specular[c] = 0.0f;
+  }
+  materials.push_back(default_material);
+
+  if (!example::LoadGLTF(opt.input, 1.0f, &meshes, &materials, &textures)) {
+    return EXIT_FAILURE;
+  }
+  if (meshes.empty()) {
+    std::cerr << "No triangle meshes in " << opt.input << "\n";
+    return EXIT_FAILURE;
+  }
+  // Same convention as the raytrace viewer: the first texture is the albedo.
+  if (!textures.empty()) {
+    materials[0].diffuse_texid = 0;
+  }
+
+  example::Asset asset;
+  asset.meshes = meshes;
+  asset.materials = materials;
+  asset.default_material = default_material;
+  asset.textures = textures;
+
+  // ---- scene, centered on the bounding box ----
+  // Renderer::Render orbits the camera around the world origin, so the model
+  // is moved there instead of aiming the camera at it.
+  float bmin[3] = {1e30f, 1e30f, 1e30f};
+  float bmax[3] = {-1e30f, -1e30f, -1e30f};
+  for (const example::Mesh<float> &m : asset.meshes) {
+    for (size_t v = 0; v < m.vertices.size() / 3; v++) {
+      for (int c = 0; c < 3; c++) {
+        float p = m.vertices[3 * v + c] + m.pivot_xform[3][c];
+        bmin[c] = std::min(bmin[c], p);
+        bmax[c] = std::max(bmax[c], p);
+      }
+    }
+  }
+  float center[3], radius = 0.0f;
+  for (int c = 0; c < 3; c++) {
+    center[c] = 0.5f * (bmin[c] + bmax[c]);
+    radius += (bmax[c] - bmin[c]) * (bmax[c] - bmin[c]);
+  }
+  radius = std::max(0.5f * std::sqrt(radius), 1e-6f);
+
+  nanosg::Scene<float, example::Mesh<float> > scene;
+  for (size_t n = 0; n < asset.meshes.size(); n++) {
+    nanosg::Node<float, example::Mesh<float> > node(&asset.meshes[n]);
+    float xform[4][4];
+    for (int i = 0; i < 4; i++) {
+      for (int j = 0; j < 4; j++) {
+        xform[i][j] = asset.meshes[n].pivot_xform[i][j];
+      }
+    }
+    for (int c = 0; c < 3; c++) {
+      xform[3][c] -= center[c];
+    }
+    node.SetName(asset.meshes[n].name.empty() ? "mesh_" + std::to_string(n)
+                                              : asset.meshes[n].name);
+    node.SetLocalXform(xform);
+    scene.AddNode(node);
+  }
+  if (!scene.Commit()) {
+    std::cerr << "Failed to commit the scene.\n";
+    return EXIT_FAILURE;
+  }
+
+  // ---- bake ----
+  const int res = opt.resolution;
+  const int atlas_size = res * opt.grid;
+  const float half_fov = 0.5f * opt.fov * kPi / 180.0f;
+  const float dist = radius / std::sin(half_fov);  // sphere just fits
+
+  std::vector<unsigned char> color(size_t(atlas_size) * atlas_size * 4, 0);
+  std::vector<unsigned char> normal(size_t(atlas_size) * atlas_size * 4, 0);
+  std::vector<float> depth(size_t(atlas_size) * atlas_size, 1.0f);
+
+  std::vector<float> rgba(size_t(res) * res * 4);
+  std::vector<float> aux(size_t(res) * res * 4);
+  std::vector<int> counts(size_t(res) * res);
+  std::vector<float> normal_image(size_t(res) * res * 4);
+  std::vector<float> position_image(size_t(res) * res * 4);
+  std::vector<float> depth_image(size_t(res) * res * 4);
+  std::vector<float> texcoord_image(size_t(res) * res * 4);
+  std::vector<float> varycoord_image(size_t(res) * res * 4);
+
+  example::RenderConfig config;
+  config.width = res;
+  config.height = res;
+  config.eye[0] = 0.0f;
+  config.eye[1] = 0.0f;
+  config.eye[2] = dist;
+  config.look_at[0] = config.look_at[1] = config.look_at[2] = 0.0f;
+  config.up[0] = 0.0f;
+  config.up[1] = 1.0f;
+  config.up[2] = 0.0f;
+  config.fov = opt.fov;
+  config.max_passes = opt.samples;
+  config.normalImage = normal_image.data();
+  config.positionImage = position_image.data();
+  config.depthImage = depth_image.data();
+  config.texcoordImage = texcoord_image.data();
+  config.varycoordImage = varycoord_image.data();
+  config.scene_scale = 1.0f;
+
+  std::atomic<bool> cancel(false);
+
+  std::cout << "Baking " << opt.grid * opt.grid << " views of " << res << "x"
+            << res << " (" << (opt.hemisphere ? "hemi-octahedral" : "octahedral")
+            << "), radius " << radius << "\n";
+
+  for (int row = 0; row < opt.grid; row++) {
+    for (int col = 0; col < opt.grid; col++) {
+      Vec d = DecodeViewDirection((col + 0.5f) / opt.grid,
+                                  (row + 0.5f) / opt.grid, opt.hemisphere);
+      Vec right, up;
+      ViewBasis(d, &right, &up);
+      // BuildCameraFrame puts the eye at R * (0, 0, dist) with pixel axes
+      // u = R * +X and v = R * -Y, R being build_rotmatrix(quat) applied to
+      // column vectors, and Render traces row y at height - 1 - y along v.
+      // With R = (right, up, d), x runs along right and rows go up along up.
+      float quat[4];
+      BasisToQuat(right, up, d, quat);
+
+      // Pass 0 samples pixel centers, which keeps normal and depth crisp.
+      int mode = SHOW_BUFFER_NORMAL;
+      config.pass = 0;
+      example::Renderer::Render(rgba.data(), aux.data(), counts.data(), quat,
+                                scene, asset, config, cancel, mode);
+      mode = SHOW_BUFFER_COLOR;
+      for (int pass = 1; pass < opt.samples; pass++) {
+        config.pass = pass;
+        example::Renderer::Render(rgba.data(), aux.data(), counts.data(), quat,
+                                  scene, asset, config, cancel, mode);
+      }
+
+      for (int y = 0; y < res; y++) {
+        for (int x = 0; x < res; x++) {
+          size_t src = size_t(y) * res + x;
+          // Atlas is stored top row first
+          int ax = col * res + x;
+          int ay = row * res + res - 1 - y;
+          size_t dst = size_t(ay) * atlas_size + ax;
+
+          float hits = rgba[4 * src + 3];
+          int n = std::max(counts[src], 1);
+          if (hits > 0.0f) {
+            for (int c = 0; c < 3; c++) {
+              float v = std::min(std::max(rgba[4 * src + c] / hits, 0.0f), 1.0f);
+              color[4 * dst + c] = (unsigned char)(v * 255.0f + 0.5f);
+            }
+            color[4 * dst + 3] =
+                (unsigned char)(std::min(hits / n, 1.0f) * 255.0f + 0.5f);
+          }
+          if (normal_image[4 * src + 3] > 0.0f) {
+            for (int c = 0; c < 3; c++) {
+              float v = std::min(std::max(normal_image[4 * src + c], 0.0f), 1.0f);
+              normal[4 * dst + c] = (unsigned char)(v * 255.0f + 0.5f);
+            }
+            normal[4 * dst + 3] = 255;
+            float t = depth_image[4 * src + 0];
+            depth[dst] = std::min(
+                std::max((t - (dist - radius)) / (2.0f * radius), 0.0f), 1.0f);
+          }
+        }
+      }
+    }
+    std::cout << "  row " << row + 1 << "/" << opt.grid << "\n";
+  }
+
+  // ---- write ----
+  const std::string color_path = opt.output + "_color.png";
+  const std::string normal_path = opt.output + "_normal.png";
+  const std::string depth_path = opt.output + "_depth.exr";
+  const std::string meta_path = opt.output + ".json";
+
+  if (!stbi_write_png(color_path.c_str(), atlas_size, atlas_size, 4,
+                      color.data(), atlas_size * 4) ||
+      !stbi_write_png(normal_path.c_str(), atlas_size, atlas_size, 4,
+                      normal.data(), atlas_size * 4)) {
+    std::cerr << "Failed to write PNG output\n";
+    return EXIT_FAILURE;
+  }
+  const char *exr_err = nullptr;
+  if (SaveEXR(depth.data(), atlas_size, atlas_size, 1, /* fp16 */ 0,
+              depth_path.c_str(), &exr_err) != TINYEXR_SUCCESS) {
+    std::cerr << "Failed to write " << depth_path << ": "
+              << (exr_err ? exr_err : "") << "\n";
+    FreeEXRErrorMessage(exr_err);
+    return EXIT_FAILURE;
+  }
+
+  std::ofstream meta(meta_path);
+  meta << "{\n"
+       << "  \"source\": " << JsonString(opt.input) << ",\n"
+       << "  \"layout\": \"" << (opt.hemisphere ? "hemi-octahedral" : "octahedral")
+       << "\",\n"
+       << "  \"grid\": [" << opt.grid << ", " << opt.grid << "],\n"
+       << "  \"cellSize\": " << res << ",\n"
+       << "  \"center\": [" << center[0] << ", " << center[1] << ", "
+       << center[2] << "],\n"
+       << "  \"radius\": " << radius << ",\n"
+       << "  \"boundsMin\": [" << bmin[0] << ", " << bmin[1] << ", " << bmin[2]
+       << "],\n"
+       << "  \"boundsMax\": [" << bmax[0] << ", " << bmax[1] << ", " << bmax[2]
+       << "],\n"
+       << "  \"fovDegrees\": " << opt.fov << ",\n"
+       << "  \"cameraDistance\": " << dist << ",\n"
+       << "  \"samples\": " << opt.samples << ",\n"
+       << "  \"color\": " << JsonString(color_path) << ",\n"
+       << "  \"normal\": " << JsonString(normal_path) << ",\n"
+       << "  \"depth\": " << JsonString(depth_path) << "\n"
+       << "}\n";
+  if (!meta) {
+    std::cerr << "Failed to write " << meta_path << "\n";
+    return EXIT_FAILURE;
+  }
+
+  std::cout << "Wrote " << color_path << ", " << normal_path << ", "
+            << depth_path << " and " << meta_path << "\n";
+  return EXIT_SUCCESS;
+}
@@ -82,357 +82,98 @@ bool LoadGLTF(const std::string &filename, float scale,
 
     // For each primitive
     for (const auto &meshPrimitive : gltfMesh.primitives) {
-      // Boolean used to check if we have converted the vertex buffer format
-      bool convertedToTriangleList = false;
-      // This permit to get a type agnostic way of reading the index buffer
-      std::unique_ptr<intArrayBase> indicesArrayPtr = nullptr;
-      {
-        const auto &indicesAccessor = model.accessors[meshPrimitive.indices];
-        const auto &bufferView = model.bufferViews[indicesAccessor.bufferView];
-        const auto &buffer = model.buffers[bufferView.buffer];
-        const auto dataAddress = buffer.data.data() + bufferView.byteOffset +
-                                 indicesAccessor.byteOffset;
-        const auto byteStride = indicesAccessor.ByteStride(bufferView);
-        const auto count = indicesAccessor.count;
-
-        // Allocate the index array in the pointer-to-base declared in the
-        // parent scope
-        switch (indicesAccessor.componentType) {
-          case TINYGLTF_COMPONENT_TYPE_BYTE:
-            indicesArrayPtr =
-                std::unique_ptr<intArray<char> >(new intArray<char>(
-                    arrayAdapter<char>(dataAddress, count, byteStride)));
-            break;
-
-          case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
-            indicesArrayPtr = std::unique_ptr<intArray<unsigned char> >(
-                new intArray<unsigned char>(arrayAdapter<unsigned char>(
-                    dataAddress, count, byteStride)));
-            break;
-
-          case TINYGLTF_COMPONENT_TYPE_SHORT:
-            indicesArrayPtr =
-                std::unique_ptr<intArray<short> >(new intArray<short>(
-                    arrayAdapter<short>(dataAddress, count, byteStride)));
-            break;
-
-          case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
-            indicesArrayPtr = std::unique_ptr<intArray<unsigned short> >(
-                new intArray<unsigned short>(arrayAdapter<unsigned short>(
-                    dataAddress, count, byteStride)));
-            break;
-
-          case TINYGLTF_COMPONENT_TYPE_INT:
-            indicesArrayPtr = std::unique_ptr<intArray<int> >(new intArray<int>(
-                arrayAdapter<int>(dataAddress, count, byteStride)));
-            break;
-
-          case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
-            indicesArrayPtr = std::unique_ptr<intArray<unsigned int> >(
-                new intArray<unsigned int>(arrayAdapter<unsigned int>(
-                    dataAddress, count, byteStride)));
-            break;
-          default:
-            break;
-        }
-      }
-      const auto &indices = *indicesArrayPtr;
-
-      if (indicesArrayPtr) {
-        std::cout << "indices: ";
-        for (size_t i(0); i < indicesArrayPtr->size(); ++i) {
-          std::cout << indices[i] << " ";
-          loadedMesh.faces.push_back(indices[i]);
-        }
-        std::cout << '\n';
+      // Indices are widened to unsigned int whatever their stored type
+      std::string viewErr;
+      tinygltf::AccessorView<unsigned int> indicesView;
+      if (!indicesView.Init(model, meshPrimitive.indices, &viewErr)) {
+        std::cerr << "primitive has no usable indices: " << viewErr;
+        continue;
       }
+      std::vector<unsigned int> indices(indicesView.size());
+      indicesView.CopyTo(indices.data());
 
+      // We re-arrange the indices so that they describe a simple list of
+      // triangles
       switch (meshPrimitive.mode) {
-        // We re-arrange the indices so that it describe a simple list of
-        // triangles
-        case TINYGLTF_MODE_TRIANGLE_FAN:
-          if (!convertedToTriangleList) {
-            std::cout << "TRIANGLE_FAN\n";
-            // This only has to be done once per primitive
-            convertedToTriangleList = true;
-
-            // We steal the guts of the vector
-            auto triangleFan = std::move(loadedMesh.faces);
-            loadedMesh.faces.clear();
-
-            // Push back the indices that describe just one triangle one by one
-            for (size_t i{2}; i < triangleFan.size(); ++i) {
-              loadedMesh.faces.push_back(triangleFan[0]);
-              loadedMesh.faces.push_back(triangleFan[i - 1]);
-              loadedMesh.faces.push_back(triangleFan[i]);
-            }
+        case TINYGLTF_MODE_TRIANGLE_FAN: {
+          std::cout << "TRIANGLE_FAN\n";
+          std::vector<unsigned int> triangleFan;
+          triangleFan.swap(indices);
+          for (size_t i{2}; i < triangleFan.size(); ++i) {
+            indices.push_back(triangleFan[0]);
+            indices.push_back(triangleFan[i - 1]);
+            indices.push_back(triangleFan[i]);
           }
-        case TINYGLTF_MODE_TRIANGLE_STRIP:
-          if (!convertedToTriangleList) {
-            std::cout << "TRIANGLE_STRIP\n";
-            // This only has to be done once per primitive
-            convertedToTriangleList = true;
-
-            auto triangleStrip = std::move(loadedMesh.faces);
-            loadedMesh.faces.clear();
-
-            for (size_t i{2}; i < triangleStrip.size(); ++i) {
-              loadedMesh.faces.push_back(triangleStrip[i - 2]);
-              loadedMesh.faces.push_back(triangleStrip[i - 1]);
-              loadedMesh.faces.push_back(triangleStrip[i]);
-            }
+        } break;
+        case TINYGLTF_MODE_TRIANGLE_STRIP: {
+          std::cout << "TRIANGLE_STRIP\n";
+          std::vector<unsigned int> triangleStrip;
+          triangleStrip.swap(indices);
+          for (size_t i{2}; i < triangleStrip.size(); ++i) {
+            indices.push_back(triangleStrip[i - 2]);
+            indices.push_back(triangleStrip[i - 1]);
+            indices.push_back(triangleStrip[i]);
           }
+        } break;
         case TINYGLTF_MODE_TRIANGLES:  // this is the simpliest case to handle
-
-        {
           std::cout << "TRIANGLES\n";
-
-          for (const auto &attribute : meshPrimitive.attributes) {
-            const auto attribAccessor = model.accessors[attribute.second];
-            const auto &bufferView =
-                model.bufferViews[attribAccessor.bufferView];
-            const auto &buffer = model.buffers[bufferView.buffer];
-            const auto dataPtr = buffer.data.data() + bufferView.byteOffset +
-                                 attribAccessor.byteOffset;
-            const auto byte_stride = attribAccessor.ByteStride(bufferView);
-            const auto count = attribAccessor.count;
-
-            std::cout << "current attribute has count " << count
-                      << " and stride " << byte_stride << " bytes\n";
-
-            std::cout << "attribute string is : " << attribute.first << '\n';
-            if (attribute.first == "POSITION") {
-              std::cout << "found position attribute\n";
-
-              // get the position min/max for computing the boundingbox
-              pMin.x = attribAccessor.minValues[0];
-              pMin.y = attribAccessor.minValues[1];
-              pMin.z = attribAccessor.minValues[2];
-              pMax.x = attribAccessor.maxValues[0];
-              pMax.y = attribAccessor.maxValues[1];
-              pMax.z = attribAccessor.maxValues[2];
-
-              switch (attribAccessor.type) {
-                case TINYGLTF_TYPE_VEC3: {
-                  switch (attribAccessor.componentType) {
-                    case TINYGLTF_COMPONENT_TYPE_FLOAT:
-                      std::cout << "Type is FLOAT\n";
-                      // 3D vector of float
-                      v3fArray positions(
-                          arrayAdapter<v3f>(dataPtr, count, byte_stride));
-
-                      std::cout << "positions's size : " << positions.size()
-                                << '\n';
-
-                      for (size_t i{0}; i < positions.size(); ++i) {
-                        const auto v = positions[i];
-                        std::cout << "positions[" << i << "]: (" << v.x << ", "
-                                  << v.y << ", " << v.z << ")\n";
-
-                        loadedMesh.vertices.push_back(v.x * scale);
-                        loadedMesh.vertices.push_back(v.y * scale);
-                        loadedMesh.vertices.push_back(v.z * scale);
-                      }
-                  }
-                  break;
-                  case TINYGLTF_COMPONENT_TYPE_DOUBLE: {
-                    std::cout << "Type is DOUBLE\n";
-                    switch (attribAccessor.type) {
-                      case TINYGLTF_TYPE_VEC3: {
-                        v3dArray positions(
-                            arrayAdapter<v3d>(dataPtr, count, byte_stride));
-                        for (size_t i{0}; i < positions.size(); ++i) {
-                          const auto v = positions[i];
-                          std::cout << "positions[" << i << "]: (" << v.x
-                                    << ", " << v.y << ", " << v.z << ")\n";
-
-                          loadedMesh.vertices.push_back(v.x * scale);
-                          loadedMesh.vertices.push_back(v.y * scale);
-                          loadedMesh.vertices.push_back(v.z * scale);
-                        }
-                      } break;
-                      default:
-                        // TODO Handle error
-                        break;
-                    }
-                    break;
-                    default:
-                      break;
-                  }
-                } break;
-              }
-            }
-
-            if (attribute.first == "NORMAL") {
-              std::cout << "found normal attribute\n";
-
-              switch (attribAccessor.type) {
-                case TINYGLTF_TYPE_VEC3: {
-                  std::cout << "Normal is VEC3\n";
-                  switch (attribAccessor.componentType) {
-                    case TINYGLTF_COMPONENT_TYPE_FLOAT: {
-                      std::cout << "Normal is FLOAT\n";
-                      v3fArray normals(
-                          arrayAdapter<v3f>(dataPtr, count, byte_stride));
-
-                      // IMPORTANT: We need to reorder normals (and texture
-                      // coordinates into "facevarying" order) for each face
-
-                      // For each triangle :
-                      for (size_t i{0}; i < indices.size() / 3; ++i) {
-                        // get the i'th triange's indexes
-                        auto f0 = indices[3 * i + 0];
-                        auto f1 = indices[3 * i + 1];
-                        auto f2 = indices[3 * i + 2];
-
-                        // get the 3 normal vectors for that face
-                        v3f n0, n1, n2;
-                        n0 = normals[f0];
-                        n1 = normals[f1];
-                        n2 = normals[f2];
-
-                        // Put them in the array in the correct order
-                        loadedMesh.facevarying_normals.push_back(n0.x);
-                        loadedMesh.facevarying_normals.push_back(n0.y);
-                        loadedMesh.facevarying_normals.push_back(n0.z);
-
-                        loadedMesh.facevarying_normals.push_back(n1.x);
-                        loadedMesh.facevarying_normals.push_back(n1.y);
-                        loadedMesh.facevarying_normals.push_back(n1.z);
-
-                        loadedMesh.facevarying_normals.push_back(n2.x);
-                        loadedMesh.facevarying_normals.push_back(n2.y);
-                        loadedMesh.facevarying_normals.push_back(n2.z);
-                      }
-                    } break;
-                    case TINYGLTF_COMPONENT_TYPE_DOUBLE: {
-                      std::cout << "Normal is DOUBLE\n";
-                      v3dArray normals(
-                          arrayAdapter<v3d>(dataPtr, count, byte_stride));
-
-                      // IMPORTANT: We need to reorder normals (and texture
-                      // coordinates into "facevarying" order) for each face
-
-                      // For each triangle :
-                      for (size_t i{0}; i < indices.size() / 3; ++i) {
-                        // get the i'th triange's indexes
-                        auto f0 = indices[3 * i + 0];
-                        auto f1 = indices[3 * i + 1];
-                        auto f2 = indices[3 * i + 2];
-
-                        // get the 3 normal vectors for that face
-                        v3d n0, n1, n2;
-                        n0 = normals[f0];
-                        n1 = normals[f1];
-                        n2 = normals[f2];
-
-                        // Put them in the array in the correct order
-                        loadedMesh.facevarying_normals.push_back(n0.x);
-                        loadedMesh.facevarying_normals.push_back(n0.y);
-                        loadedMesh.facevarying_normals.push_back(n0.z);
-
-                        loadedMesh.facevarying_normals.push_back(n1.x);
-                        loadedMesh.facevarying_normals.push_back(n1.y);
-                        loadedMesh.facevarying_normals.push_back(n1.z);
-
-                        loadedMesh.facevarying_normals.push_back(n2.x);
-                        loadedMesh.facevarying_normals.push_back(n2.y);
-                        loadedMesh.facevarying_normals.push_back(n2.z);
-                      }
-                    } break;
-                    default:
-                      std::cerr << "Unhandeled componant type for normal\n";
-                  }
-                } break;
-                default:
-                  std::cerr << "Unhandeled vector type for normal\n";
-              }
-
-              // Face varying comment on the normals is also true for the UVs
-              if (attribute.first == "TEXCOORD_0") {
-                std::cout << "Found texture coordinates\n";
-
-                switch (attribAccessor.type) {
-                  case TINYGLTF_TYPE_VEC2: {
-                    std::cout << "TEXTCOORD is VEC2\n";
-                    switch (attribAccessor.componentType) {
-                      case TINYGLTF_COMPONENT_TYPE_FLOAT: {
-                        std::cout << "TEXTCOORD is FLOAT\n";
-                        v2fArray uvs(
-                            arrayAdapter<v2f>(dataPtr, count, byte_stride));
-
-                        for (size_t i{0}; i < indices.size() / 3; ++i) {
-                          // get the i'th triange's indexes
-                          auto f0 = indices[3 * i + 0];
-                          auto f1 = indices[3 * i + 1];
-                          auto f2 = indices[3 * i + 2];
-
-                          // get the texture coordinates for each triangle's
-                          // vertices
-                          v2f uv0, uv1, uv2;
-                          uv0 = uvs[f0];
-                          uv1 = uvs[f1];
-                          uv2 = uvs[f2];
-
-                          // push them in order into the mesh data
-                          loadedMesh.facevarying_uvs.push_back(uv0.x);
-                          loadedMesh.facevarying_uvs.push_back(uv0.y);
-
-                          loadedMesh.facevarying_uvs.push_back(uv1.x);
-                          loadedMesh.facevarying_uvs.push_back(uv1.y);
-
-                          loadedMesh.facevarying_uvs.push_back(uv2.x);
-                          loadedMesh.facevarying_uvs.push_back(uv2.y);
-                        }
-
-                      } break;
-                      case TINYGLTF_COMPONENT_TYPE_DOUBLE: {
-                        std::cout << "TEXTCOORD is DOUBLE\n";
-                        v2dArray uvs(
-                            arrayAdapter<v2d>(dataPtr, count, byte_stride));
-
-                        for (size_t i{0}; i < indices.size() / 3; ++i) {
-                          // get the i'th triange's indexes
-                          auto f0 = indices[3 * i + 0];
-                          auto f1 = indices[3 * i + 1];
-                          auto f2 = indices[3 * i + 2];
-
-                          v2d uv0, uv1, uv2;
-                          uv0 = uvs[f0];
-                          uv1 = uvs[f1];
-                          uv2 = uvs[f2];
-
-                          loadedMesh.facevarying_uvs.push_back(uv0.x);
-                          loadedMesh.facevarying_uvs.push_back(uv0.y);
-
-                          loadedMesh.facevarying_uvs.push_back(uv1.x);
-                          loadedMesh.facevarying_uvs.push_back(uv1.y);
-
-                          loadedMesh.facevarying_uvs.push_back(uv2.x);
-                          loadedMesh.facevarying_uvs.push_back(uv2.y);
-                        }
-                      } break;
-                      default:
-                        std::cerr << "unrecognized vector type for UV";
-                    }
-                  } break;
-                  default:
-                    std::cerr << "unreconized componant type for UV";
-                }
-              }
-            }
-          }
           break;
+        // These aren't triangles:
+        case TINYGLTF_MODE_POINTS:
+        case TINYGLTF_MODE_LINE:
+        case TINYGLTF_MODE_LINE_LOOP:
+          std::cerr << "primitive is not triangle based, ignoring";
+          continue;
+        default:
+          std::cerr << "primitive mode not implemented";
+          continue;
+      }
+      loadedMesh.faces.insert(loadedMesh.faces.end(), indices.begin(),
+                              indices.end());
+
+      for (const auto &attribute : meshPrimitive.attributes) {
+        std::cout << "attribute string is : " << attribute.first << '\n';
+
+        // Any componentType (float, double, normalized integers) reads as
+        // float through the view
+        tinygltf::AccessorView<float> view;
+        if (!view.Init(model, attribute.second, &viewErr)) {
+          std::cerr << viewErr;
+          continue;
+        }
+        const auto &attribAccessor = model.accessors[attribute.second];
+
+        if (attribute.first == "POSITION" && view.NumComponents() == 3) {
+          // get the position min/max for computing the boundingbox
+          pMin.x = attribAccessor.minValues[0];
+          pMin.y = attribAccessor.minValues[1];
+          pMin.z = attribAccessor.minValues[2];
+          pMax.x = attribAccessor.maxValues[0];
+          pMax.y = attribAccessor.maxValues[1];
+          pMax.z = attribAccessor.maxValues[2];
+
+          size_t base = loadedMesh.vertices.size();
+          loadedMesh.vertices.resize(base + view.size() * 3);
+          view.CopyTo(&loadedMesh.vertices[base]);
+          for (size_t i = base; i < loadedMesh.vertices.size(); ++i) {
+            loadedMesh.vertices[i] *= scale;
+          }
+        }
 
-          default:
-            std::cerr << "primitive mode not implemented";
-            break;
-
-          // These aren't triangles:
-          case TINYGLTF_MODE_POINTS:
-          case TINYGLTF_MODE_LINE:
-          case TINYGLTF_MODE_LINE_LOOP:
-            std::cerr << "primitive is not triangle based, ignoring";
+        // IMPORTANT: We need to reorder normals (and texture coordinates)
+        // into "facevarying" order for each face
+        std::vector<float> *facevarying = nullptr;
+        if (attribute.first == "NORMAL" && view.NumComponents() == 3) {
+          facevarying = &loadedMesh.facevarying_normals;
+        } else if (attribute.first == "TEXCOORD_0" &&
+                   view.NumComponents() == 2) {
+          facevarying = &loadedMesh.facevarying_uvs;
+        }
+        if (facevarying) {
+          for (size_t i{0}; i < indices.size() / 3 * 3; ++i) {
+            const auto v = view[indices[i]];
+            for (int c = 0; c < v.size(); ++c) facevarying->push_back(v[c]);
+          }
         }
       }
 
@@ -0,0 +1,94 @@
+// Tests for TINYGLTF_ENABLE_MODEL_ARENA. The option changes the container
+// types of the public structs (ModelVector is no longer std::vector), so it
+// is built separately from tester.cc, which uses the default configuration.
+#define TINYGLTF_IMPLEMENTATION
+#define TINYGLTF_ENABLE_MODEL_ARENA
+#define STB_IMAGE_IMPLEMENTATION
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "tiny_gltf.h"
+
+#define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
+#include "catch.hpp"
+
+#include <cstdint>
+#include <string>
+
+TEST_CASE("model-arena", "[arena]") {
+  const char *file = "../models/Cube/Cube.gltf";
+  tinygltf::Model heap;
+  {
+    tinygltf::TinyGLTF ctx;
+    ctx.SetModelArena(false);
+    std::string err, warn;
+    REQUIRE(ctx.LoadASCIIFromFile(&heap, &err, &warn, file));
+    REQUIRE(heap.nodes.get_allocator().arena() == nullptr);
+  }
+
+  tinygltf::Model copy, moved;
+  {
+    tinygltf::TinyGLTF ctx;
+    REQUIRE(ctx.GetModelArena());
+    tinygltf::Model model;
+    std::string err, warn;
+    REQUIRE(ctx.LoadASCIIFromFile(&model, &err, &warn, file));
+    tinygltf::ModelArena *arena = model.nodes.get_allocator().arena();
+    REQUIRE(arena != nullptr);
+    REQUIRE(model.meshes[0].primitives[0].attributes.get_allocator().arena() ==
+            arena);
+    REQUIRE(arena->BytesUsed() > 0);
+    REQUIRE(model == heap);
+
+    // Loading into the same model again rewinds and refills the arena
+    const size_t reserved = arena->BytesReserved();
+    const size_t used = arena->BytesUsed();
+    REQUIRE(ctx.LoadASCIIFromFile(&model, &err, &warn, file));
+    REQUIRE(model.nodes.get_allocator().arena() == arena);
+    REQUIRE(arena->BytesReserved() == reserved);
+    REQUIRE(arena->BytesUsed() == used);
+    REQUIRE(model == heap);
+
+    // A model still in use keeps its arena; the next load gets a new one
+    tinygltf::Model other;
+    REQUIRE(ctx.LoadASCIIFromFile(&other, &err, &warn, file));
+    REQUIRE(other.nodes.get_allocator().arena() != arena);
+    REQUIRE(model.nodes.get_allocator().arena() == arena);
+
+    // Copies go to the heap; moves take the arena along
+    copy = model;
+    REQUIRE(copy.nodes.get_allocator().arena() == nullptr);
+    moved = std::move(model);
+    REQUIRE(moved.nodes.get_allocator().arena() == arena);
+  }
+  // The loader is gone; `moved` keeps the arena alive
+  REQUIRE(moved.nodes.get_allocator().arena()->UseCount() > 0);
+  REQUIRE(moved == heap);
+  REQUIRE(copy == heap);
+
+  SECTION("allocation") {
+    tinygltf::ModelAllocator<char> owner(new tinygltf::ModelArena(256));
+    tinygltf::ModelArena *arena = owner.arena();
+    REQUIRE(arena->UseCount() == 1);
+    void *a = arena->Allocate(3, 1);
+    void *b = arena->Allocate(8, 8);
+    REQUIRE(reinterpret_cast<uintptr_t>(b) % 8 == 0);
+    REQUIRE(reinterpret_cast<uintptr_t>(b) >=
+            reinterpret_cast<uintptr_t>(a) + 3);
+    void *big = arena->Allocate(1000, 16);  // gets a block of its own
+    REQUIRE(big != nullptr);
+    const size_t reserved = arena->BytesReserved();
+    REQUIRE(reserved >= 256 + 1000);
+    arena->Reset();
+    REQUIRE(arena->BytesUsed() == 0);
+    REQUIRE(arena->Allocate(3, 1) == a);
+    REQUIRE(arena->Allocate(1000, 16) == big);
+    REQUIRE(arena->BytesReserved() == reserved);
+    {
+      tinygltf::ModelArena::Scope scope(arena);
+      tinygltf::ModelVector<int> v(10, 1);
+      REQUIRE(v.get_allocator().arena() == arena);
+      REQUIRE(arena->UseCount() == 2);
+    }
+    REQUIRE(arena->UseCount() == 1);
+    REQUIRE(tinygltf::ModelArena::Current() == nullptr);
+  }
+}
@@ -9,12 +9,15 @@
 #define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
 #include "catch.hpp"
 
+#include <atomic>
+#include <chrono>
 #include <cstdio>
 #include <cstdlib>
 #include <cassert>
 #include <iostream>
 #include <sstream>
 #include <fstream>
+#include <thread>
 
 static tinygltf::detail::JsonDocument JsonConstruct(const char* str)
 {
@@ -1249,3 +1252,1473 @@ TEST_CASE("empty-images-not-written", "[issue-495]") {
   // WriteImageData should be invoked for both images
   CHECK(counter == 2);
 }
+
+TEST_CASE("memory-mapped-glb", "[mmap]") {
+  std::string err;
+  std::string warn;
+  tinygltf::Model source;
+  {
+    tinygltf::TinyGLTF ctx;
+    REQUIRE(ctx.LoadASCIIFromFile(&source, &err, &warn, "../models/Cube/Cube.gltf"));
+    source.buffers[0].uri.clear();  // store it in the BIN chunk
+    REQUIRE(ctx.WriteGltfSceneToFile(&source, "mmap-cube.glb", true, true, false, true));
+  }
+
+  tinygltf::Model copied;
+  {
+    tinygltf::TinyGLTF ctx;
+    REQUIRE(ctx.LoadBinaryFromFile(&copied, &err, &warn, "mmap-cube.glb"));
+  }
+  REQUIRE(copied.buffers.size() == 1);
+  CHECK(copied.buffers[0].mapped_data == nullptr);
+
+  tinygltf::Model mapped;
+  {
+    tinygltf::TinyGLTF ctx;
+    ctx.SetMemoryMapBinary(true);
+    REQUIRE(ctx.LoadBinaryFromFile(&mapped, &err, &warn, "mmap-cube.glb"));
+  }
+  // The loader is gone; the model keeps the mapping alive.
+  REQUIRE(mapped.buffers.size() == 1);
+  const tinygltf::Buffer &buffer = mapped.buffers[0];
+  CHECK(buffer.data.empty());
+  REQUIRE(buffer.mapped_data != nullptr);
+  CHECK(buffer.Size() == copied.buffers[0].Size());
+  CHECK(buffer == copied.buffers[0]);
+  CHECK(mapped == copied);
+
+  // Writing reads through Buffer::Data().
+  std::stringstream a, b;
+  tinygltf::TinyGLTF writer;
+  REQUIRE(writer.WriteGltfSceneToStream(&mapped, a, false, true));
+  REQUIRE(writer.WriteGltfSceneToStream(&copied, b, false, true));
+  CHECK(a.str() == b.str());
+}
+
+static std::string QuantizedTriangleGltf(bool declareExtension,
+                                         int normalComponentType) {
+  // 3 SHORT positions (18 bytes, padded to 20) and 3 normalized BYTE normals.
+  std::stringstream os;
+  os << "{\"asset\":{\"version\":\"2.0\"},";
+  if (declareExtension) {
+    os << "\"extensionsUsed\":[\"KHR_mesh_quantization\"],"
+       << "\"extensionsRequired\":[\"KHR_mesh_quantization\"],";
+  }
+  os << "\"buffers\":[{\"byteLength\":29,\"uri\":\"data:application/"
+        "octet-stream;base64,AAAAAAAAZAA4/ywB/38AgAUAAAB/gAAAAH8AfwA=\"}],"
+     << "\"bufferViews\":[{\"buffer\":0,\"byteOffset\":0,\"byteLength\":18},"
+     << "{\"buffer\":0,\"byteOffset\":20,\"byteLength\":9}],"
+     << "\"accessors\":[{\"bufferView\":0,\"componentType\":5122,\"count\":3,"
+     << "\"type\":\"VEC3\",\"min\":[0,-32768,0],\"max\":[32767,0,300]},"
+     << "{\"bufferView\":1,\"componentType\":" << normalComponentType
+     << ",\"normalized\":true,\"count\":3,\"type\":\"VEC3\"}],"
+     << "\"meshes\":[{\"primitives\":[{\"attributes\":{\"POSITION\":0,"
+        "\"NORMAL\":1}}]}]}";
+  return os.str();
+}
+
+TEST_CASE("mesh-quantization", "[KHR_mesh_quantization]") {
+  tinygltf::TinyGLTF ctx;
+
+  {
+    tinygltf::Model model;
+    std::string err, warn;
+    std::string gltf =
+        QuantizedTriangleGltf(true, TINYGLTF_COMPONENT_TYPE_BYTE);
+    REQUIRE(ctx.LoadASCIIFromString(&model, &err, &warn, gltf.c_str(),
+                                    static_cast<unsigned int>(gltf.size()),
+                                    ""));
+    REQUIRE(err.empty());
+    REQUIRE(warn.empty());
+
+    tinygltf::AccessorView<float> pos;
+    REQUIRE(pos.Init(model, 0, &err));
+    REQUIRE(pos.size() == 3);
+    REQUIRE(pos.ByteStride() == 6);
+    REQUIRE(pos.Get(1, 0) == 100.0f);
+    REQUIRE(pos.Get(1, 1) == -200.0f);
+    REQUIRE(pos.Get(2, 1) == -32768.0f);
+
+    tinygltf::AccessorView<float> nrm;
+    REQUIRE(nrm.Init(model, 1, &err));
+    REQUIRE(nrm.Get(0, 0) == 1.0f);
+    REQUIRE(nrm.Get(0, 1) == -1.0f);  // -128 clamps to -1
+    REQUIRE(nrm.Get(1, 2) == 1.0f);
+
+    // A count whose span wraps around to fit in the view is rejected
+    model.accessors[0].count = (size_t(1) << (sizeof(size_t) * 8 - 1)) + 1;
+    REQUIRE_FALSE(pos.Init(model, 0, &err));
+    REQUIRE(err.find("runs past the end") != std::string::npos);
+  }
+
+  {
+    // Quantized positions without the extension still load, with a warning.
+    tinygltf::Model model;
+    std::string err, warn;
+    std::string gltf =
+        QuantizedTriangleGltf(false, TINYGLTF_COMPONENT_TYPE_BYTE);
+    REQUIRE(ctx.LoadASCIIFromString(&model, &err, &warn, gltf.c_str(),
+                                    static_cast<unsigned int>(gltf.size()),
+                                    ""));
+    REQUIRE(warn.find("KHR_mesh_quantization") != std::string::npos);
+  }
+
+  {
+    // Unsigned normals are invalid even when quantized: a warning, or an
+    // error when asked for.
+    tinygltf::Model model;
+    std::string err, warn;
+    std::string gltf =
+        QuantizedTriangleGltf(true, TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE);
+    REQUIRE(ctx.LoadASCIIFromString(&model, &err, &warn, gltf.c_str(),
+                                    static_cast<unsigned int>(gltf.size()),
+                                    ""));
+    REQUIRE(warn.find("NORMAL") != std::string::npos);
+
+    ctx.SetStrictAttributeEncoding(true);
+    err.clear();
+    warn.clear();
+    REQUIRE_FALSE(ctx.LoadASCIIFromString(
+        &model, &err, &warn, gltf.c_str(),
+        static_cast<unsigned int>(gltf.size()), ""));
+    REQUIRE(err.find("NORMAL") != std::string::npos);
+  }
+}
+
+// Minimal EXT_meshopt_compression attribute encoder (vertex codec v0) for the
+// decoder tests: picks the smallest of the 0/2/4/8-bit encodings per group.
+static void MeshoptTestEncodeGroup(std::vector<unsigned char> &out,
+                                   const unsigned char *group, int bitslog2) {
+  if (bitslog2 == 0) return;
+  if (bitslog2 == 3) {
+    out.insert(out.end(), group, group + 16);
+    return;
+  }
+  int bits = bitslog2 == 1 ? 2 : 4;
+  unsigned sentinel = (1u << bits) - 1;
+  std::vector<unsigned char> packed(size_t(16 * bits / 8), 0), rest;
+  for (int i = 0; i < 16; ++i) {
+    unsigned enc = group[i] >= sentinel ? sentinel : group[i];
+    packed[size_t(i * bits / 8)] |=
+        static_cast<unsigned char>(enc << (8 - bits - (i * bits) % 8));
+    if (enc == sentinel) rest.push_back(group[i]);
+  }
+  out.insert(out.end(), packed.begin(), packed.end());
+  out.insert(out.end(), rest.begin(), rest.end());
+}
+
+static std::vector<unsigned char> MeshoptTestEncodeVertices(
+    const std::vector<unsigned char> &vertices, size_t vertex_size) {
+  size_t count = vertices.size() / vertex_size;
+  size_t block = std::min<size_t>((8192 / vertex_size) & ~size_t(15), 256);
+  std::vector<unsigned char> out(1, 0xa0);
+  std::vector<unsigned char> last(vertices.begin(),
+                                  vertices.begin() + long(vertex_size));
+
+  for (size_t begin = 0; begin < count; begin += block) {
+    size_t n = std::min(block, count - begin);
+    size_t aligned = (n + 15) & ~size_t(15);
+    for (size_t k = 0; k < vertex_size; ++k) {
+      std::vector<unsigned char> deltas(aligned, 0);
+      unsigned char p = last[k];
+      for (size_t i = 0; i < n; ++i) {
+        unsigned char v = vertices[(begin + i) * vertex_size + k];
+        unsigned char d = static_cast<unsigned char>(v - p);
+        deltas[i] = static_cast<unsigned char>(
+            (d << 1) ^ static_cast<unsigned char>(static_cast<signed char>(d) >> 7));
+        p = v;
+      }
+
+      std::vector<unsigned char> header((aligned / 16 + 3) / 4, 0), groups;
+      for (size_t g = 0; g < aligned / 16; ++g) {
+        const unsigned char *group = &deltas[g * 16];
+        size_t best = 16, over3 = 0, over15 = 0;
+        bool zero = true;
+        for (int i = 0; i < 16; ++i) {
+          zero = zero && group[i] == 0;
+          over3 += group[i] >= 3;
+          over15 += group[i] >= 15;
+        }
+        int bitslog2 = 3;
+        if (zero) {
+          bitslog2 = 0;
+        } else if (4 + over3 <= 8 + over15 && 4 + over3 < best) {
+          bitslog2 = 1;
+        } else if (8 + over15 < best) {
+          bitslog2 = 2;
+        }
+        header[g / 4] |= static_cast<unsigned char>(bitslog2 << ((g % 4) * 2));
+        MeshoptTestEncodeGroup(groups, group, bitslog2);
+      }
+      out.insert(out.end(), header.begin(), header.end());
+      out.insert(out.end(), groups.begin(), groups.end());
+    }
+    last.assign(vertices.begin() + long((begin + n - 1) * vertex_size),
+                vertices.begin() + long((begin + n) * vertex_size));
+  }
+
+  // Tail: padding, then the first vertex (the decoder's initial baseline)
+  size_t tail = std::max<size_t>(32, vertex_size);
+  out.insert(out.end(), tail - vertex_size, 0);
+  out.insert(out.end(), vertices.begin(), vertices.begin() + long(vertex_size));
+  return out;
+}
+
+TEST_CASE("meshopt-vertex-codec", "[EXT_meshopt_compression]") {
+  uint32_t rng = 12345;
+  auto next = [&rng]() {
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+  };
+
+  for (size_t vertex_size : {4u, 12u, 16u, 36u}) {
+    for (size_t count : {1u, 15u, 17u, 300u, 1000u}) {
+      // Constant, slowly varying and random channels, to hit every group width
+      std::vector<unsigned char> vertices(count * vertex_size);
+      for (size_t i = 0; i < count; ++i) {
+        for (size_t k = 0; k < vertex_size; ++k) {
+          unsigned char v = 0;
+          switch (k % 4) {
+            case 0: v = 7; break;
+            case 1: v = static_cast<unsigned char>(i / 3 + (next() & 1)); break;
+            case 2: v = static_cast<unsigned char>(i * 5 + (next() & 7)); break;
+            default: v = static_cast<unsigned char>(next()); break;
+          }
+          vertices[i * vertex_size + k] = v;
+        }
+      }
+      std::vector<unsigned char> encoded =
+          MeshoptTestEncodeVertices(vertices, vertex_size);
+
+      for (bool simd : {false, true}) {
+        std::vector<unsigned char> decoded(vertices.size(), 0xcd);
+        REQUIRE(tinygltf::detail::DecodeMeshoptVertexBuffer(
+            decoded.data(), count, vertex_size, encoded.data(), encoded.size(),
+            simd));
+        REQUIRE(decoded == vertices);
+      }
+
+      // Truncated streams are rejected, not overrun
+      std::vector<unsigned char> decoded(vertices.size());
+      REQUIRE_FALSE(tinygltf::detail::DecodeMeshoptVertexBuffer(
+          decoded.data(), count, vertex_size, encoded.data(),
+          encoded.size() - 1));
+    }
+  }
+}
+
+TEST_CASE("meshopt-index-codecs", "[EXT_meshopt_compression]") {
+  // TRIANGLES: a table-coded fresh triangle, one reusing its edge (0, 2) and
+  // one with three explicit delta-coded indices.
+  std::vector<unsigned char> triangles = {0xe1, 0xf0, 0x00, 0xff,
+                                          0xff, 0x0a, 0x02, 0x03};
+  const unsigned char codeaux[16] = {0x00, 0x76, 0x87, 0x56, 0x67, 0x78,
+                                     0xa9, 0x86, 0x65, 0x89, 0x68, 0x98,
+                                     0x01, 0x69, 0x00, 0x00};
+  triangles.insert(triangles.end(), codeaux, codeaux + 16);
+
+  std::vector<uint16_t> tri16(9);
+  REQUIRE(tinygltf::detail::DecodeMeshoptIndexBuffer(
+      reinterpret_cast<unsigned char *>(tri16.data()), 9, 2, triangles.data(),
+      triangles.size()));
+  REQUIRE(tri16 == std::vector<uint16_t>({0, 1, 2, 0, 2, 3, 5, 6, 4}));
+
+  std::vector<uint32_t> tri32(9);
+  REQUIRE(tinygltf::detail::DecodeMeshoptIndexBuffer(
+      reinterpret_cast<unsigned char *>(tri32.data()), 9, 4, triangles.data(),
+      triangles.size()));
+  REQUIRE(tri32 == std::vector<uint32_t>({0, 1, 2, 0, 2, 3, 5, 6, 4}));
+  REQUIRE_FALSE(tinygltf::detail::DecodeMeshoptIndexBuffer(
+      reinterpret_cast<unsigned char *>(tri32.data()), 9, 4, triangles.data(),
+      triangles.size() - 1));
+
+  // INDICES: 10, 12, 11, 300 against baseline 0 (zigzag delta << 1 | 0)
+  std::vector<unsigned char> sequence = {0xd1, 0x28, 0x08, 0x02,
+                                         0x84, 0x09, 0, 0, 0, 0};
+  std::vector<uint32_t> seq(4);
+  REQUIRE(tinygltf::detail::DecodeMeshoptIndexSequence(
+      reinterpret_cast<unsigned char *>(seq.data()), 4, 4, sequence.data(),
+      sequence.size()));
+  REQUIRE(seq == std::vector<uint32_t>({10, 12, 11, 300}));
+}
+
+TEST_CASE("meshopt-filters", "[EXT_meshopt_compression]") {
+  // Octahedral (x, y, scale, w): +Z and +X decode to unit vectors and the
+  // 4th component passes through
+  std::vector<int8_t> oct8 = {0, 0, 127, 42, 127, 0, 127, -1};
+  REQUIRE(tinygltf::detail::ApplyMeshoptFilter(
+      "OCTAHEDRAL", reinterpret_cast<unsigned char *>(oct8.data()), 2, 4));
+  REQUIRE(oct8 == std::vector<int8_t>({0, 0, 127, 42, 127, 0, 0, -1}));
+
+  // Lower hemisphere: meshopt_encodeFilterOct() output for (0.6, 0, -0.8),
+  // (-0.48, 0.6, -0.64), (0, 0, -1) and (0.36, -0.48, -0.8), through both the
+  // SIMD and the scalar filter
+  for (bool simd : {false, true}) {
+    std::vector<int8_t> low8 = {127, 73,  127, 0, -83, 92,  127, 0,
+                                127, 127, 127, 0, 90,  -99, 127, 0};
+    REQUIRE(tinygltf::detail::ApplyMeshoptFilter(
+        "OCTAHEDRAL", reinterpret_cast<unsigned char *>(low8.data()), 4, 4,
+        simd));
+    REQUIRE(low8 == std::vector<int8_t>({76, 0, -102, 0, -60, 76, -82, 0, 0,
+                                         0, -127, 0, 46, -61, -102, 0}));
+
+    std::vector<int16_t> low16 = {32767,  18724, 32767, 0, -21337, 23623,
+                                  32767,  0,     32767, 32767, 32767, 0,
+                                  23177, -25574, 32767, 0};
+    REQUIRE(tinygltf::detail::ApplyMeshoptFilter(
+        "OCTAHEDRAL", reinterpret_cast<unsigned char *>(low16.data()), 4, 8,
+        simd));
+    REQUIRE(low16 == std::vector<int16_t>({19660, 0, -26214, 0, -15728,
+                                           19660, -20972, 0, 0, 0, -32767, 0,
+                                           11797, -15728, -26214, 0}));
+  }
+
+  // Quaternion: identity, largest component w (index 3), full scale
+  std::vector<int16_t> quat = {0, 0, 0, 32767};
+  REQUIRE(tinygltf::detail::ApplyMeshoptFilter(
+      "QUATERNION", reinterpret_cast<unsigned char *>(quat.data()), 1, 8));
+  REQUIRE(quat == std::vector<int16_t>({0, 0, 0, 32767}));
+
+  // Exponential: mantissa 3, exponent -2
+  std::vector<uint32_t> expo = {(uint32_t(-2) << 24) | 3u, 0u, 0u, 0u};
+  REQUIRE(tinygltf::detail::ApplyMeshoptFilter(
+      "EXPONENTIAL", reinterpret_cast<unsigned char *>(expo.data()), 1, 16));
+  float f;
+  memcpy(&f, &expo[0], 4);
+  REQUIRE(f == 0.75f);
+
+  REQUIRE_FALSE(tinygltf::detail::ApplyMeshoptFilter(
+      "QUATERNION", reinterpret_cast<unsigned char *>(quat.data()), 1, 4));
+
+  // SIMD and scalar filters agree bit for bit on arbitrary input
+  uint32_t rng = 777;
+  std::vector<unsigned char> input(4096);
+  for (unsigned char &b : input) {
+    rng = rng * 1664525u + 1013904223u;
+    b = static_cast<unsigned char>(rng >> 24);
+  }
+  for (const char *filter : {"OCTAHEDRAL", "EXPONENTIAL"}) {
+    for (size_t stride : {4u, 8u}) {
+      size_t count = input.size() / stride - 3;  // leave a scalar remainder
+      std::vector<unsigned char> scalar = input, simd = input;
+      if (std::string(filter) == "EXPONENTIAL") {
+        // Keep exponents small so no lane overflows to inf/NaN
+        for (size_t i = 3; i < input.size(); i += 4) {
+          scalar[i] = simd[i] = static_cast<unsigned char>(input[i] % 16);
+        }
+      }
+      REQUIRE(tinygltf::detail::ApplyMeshoptFilter(filter, scalar.data(),
+                                                   count, stride, false));
+      REQUIRE(tinygltf::detail::ApplyMeshoptFilter(filter, simd.data(), count,
+                                                   stride, true));
+      REQUIRE(scalar == simd);
+    }
+  }
+}
+
+TEST_CASE("meshopt-gltf", "[EXT_meshopt_compression]") {
+  // Four float3 positions, compressed into buffer 0; buffer 1 is the fallback
+  const float positions[12] = {0, 0, 0, 1, 0, 0, 0, 1, 0, 1, 1, 0.5f};
+  std::vector<unsigned char> raw(sizeof(positions));
+  memcpy(raw.data(), positions, sizeof(positions));
+  std::vector<unsigned char> encoded = MeshoptTestEncodeVertices(raw, 12);
+
+  std::string b64 = tinygltf::base64_encode(encoded.data(),
+                                            unsigned(encoded.size()));
+  std::stringstream os;
+  os << "{\"asset\":{\"version\":\"2.0\"},"
+     << "\"extensionsUsed\":[\"EXT_meshopt_compression\"],"
+     << "\"extensionsRequired\":[\"EXT_meshopt_compression\"],"
+     << "\"buffers\":[{\"byteLength\":" << encoded.size()
+     << ",\"uri\":\"data:application/octet-stream;base64," << b64 << "\"},"
+     << "{\"byteLength\":48,\"extensions\":{\"EXT_meshopt_compression\":"
+        "{\"fallback\":true}}}],"
+     << "\"bufferViews\":[{\"buffer\":1,\"byteLength\":48,\"byteStride\":12,"
+     << "\"extensions\":{\"EXT_meshopt_compression\":{\"buffer\":0,"
+     << "\"byteLength\":" << encoded.size()
+     << ",\"byteStride\":12,\"count\":4,\"mode\":\"ATTRIBUTES\"}}}],"
+     << "\"accessors\":[{\"bufferView\":0,\"componentType\":5126,\"count\":4,"
+     << "\"type\":\"VEC3\",\"min\":[0,0,0],\"max\":[1,1,0.5]}],"
+     << "\"meshes\":[{\"primitives\":[{\"attributes\":{\"POSITION\":0}}]}]}";
+
+  tinygltf::TinyGLTF ctx;
+  tinygltf::Model model;
+  std::string err, warn;
+  std::string gltf = os.str();
+  REQUIRE(ctx.LoadASCIIFromString(&model, &err, &warn, gltf.c_str(),
+                                  static_cast<unsigned int>(gltf.size()), ""));
+  REQUIRE(err.empty());
+  REQUIRE(model.buffers[1].data.size() == 48);
+  REQUIRE(memcmp(model.buffers[1].data.data(), positions, 48) == 0);
+
+  // A truncated stream fails the load with a message naming the bufferView
+  std::string bad = gltf;
+  std::string length = "\"byteLength\":" + std::to_string(encoded.size()) +
+                       ",\"byteStride\"";
+  bad.replace(bad.find(length), length.size(),
+              "\"byteLength\":" + std::to_string(encoded.size() - 1) +
+                  ",\"byteStride\"");
+  REQUIRE_FALSE(ctx.LoadASCIIFromString(&model, &err, &warn, bad.c_str(),
+                                        static_cast<unsigned int>(bad.size()),
+                                        ""));
+  REQUIRE(err.find("bufferView[0]") != std::string::npos);
+
+  // Malformed extension fields are rejected before anything is decoded
+  const std::string source = "\"buffer\":0,";
+  const char *malformed[] = {
+      "\"buffer\":0,\"byteOffset\":-4096,",  // negative offset
+      "\"buffer\":0,\"byteOffset\":1.5,",    // not an integer
+      "\"buffer\":0,\"byteOffset\":\"0\",",  // not a number
+      "\"buffer\":-1,",                      // negative buffer
+      "",                                     // missing buffer
+  };
+  for (const char *fields : malformed) {
+    INFO(fields);
+    bad = gltf;
+    bad.replace(bad.find(source), source.size(), fields);
+    err.clear();
+    REQUIRE_FALSE(ctx.LoadASCIIFromString(
+        &model, &err, &warn, bad.c_str(),
+        static_cast<unsigned int>(bad.size()), ""));
+    REQUIRE(err.find("Invalid EXT_meshopt_compression in bufferView[0]") !=
+            std::string::npos);
+  }
+  // A range running past the end of the source buffer
+  bad = gltf;
+  bad.replace(bad.find(length), length.size(),
+              "\"byteOffset\":1,\"byteLength\":" +
+                  std::to_string(encoded.size()) + ",\"byteStride\"");
+  err.clear();
+  REQUIRE_FALSE(ctx.LoadASCIIFromString(&model, &err, &warn, bad.c_str(),
+                                        static_cast<unsigned int>(bad.size()),
+                                        ""));
+  REQUIRE(err.find("Invalid EXT_meshopt_compression") != std::string::npos);
+}
+
+TEST_CASE("accessor-view", "[accessor]") {
+  tinygltf::Model model;
+  tinygltf::Buffer buffer;
+  auto append = [&buffer](const void *p, size_t n) {
+    size_t at = buffer.data.size();
+    buffer.data.resize(at + n);
+    memcpy(buffer.data.data() + at, p, n);
+    return at;
+  };
+
+  // 0: interleaved VEC3 float positions (stride 16) followed by 3 padding bytes
+  const float xyzw[12] = {1, 2, 3, -1, 4, 5, 6, -1, 7, 8, 9, -1};
+  size_t positions = append(xyzw, sizeof(xyzw));
+  // 1: normalized SHORT VEC2, tightly packed
+  const int16_t shorts[4] = {32767, -32768, 0, 16384};
+  size_t normalized = append(shorts, sizeof(shorts));
+  // 2: UNSIGNED_BYTE MAT2, columns padded to 4 bytes
+  const uint8_t mat2[8] = {1, 2, 0xee, 0xee, 3, 4, 0xee, 0xee};
+  size_t matrix = append(mat2, sizeof(mat2));
+  // 3, 4: sparse indices (USHORT) and replacement values (float SCALAR)
+  const uint16_t sparseIndices[2] = {1, 3};
+  size_t indices = append(sparseIndices, sizeof(sparseIndices));
+  const float sparseValues[2] = {10, 30};
+  size_t values = append(sparseValues, sizeof(sparseValues));
+  model.buffers.push_back(buffer);
+
+  auto addView = [&model](size_t offset, size_t length, int stride) {
+    tinygltf::BufferView view;
+    view.buffer = 0;
+    view.byteOffset = offset;
+    view.byteLength = length;
+    view.byteStride = size_t(stride);
+    model.bufferViews.push_back(view);
+    return int(model.bufferViews.size() - 1);
+  };
+  auto addAccessor = [&model](int view, int componentType, int type,
+                              size_t count, bool norm) {
+    tinygltf::Accessor acc;
+    acc.bufferView = view;
+    acc.componentType = componentType;
+    acc.type = type;
+    acc.count = count;
+    acc.normalized = norm;
+    model.accessors.push_back(acc);
+    return int(model.accessors.size() - 1);
+  };
+
+  int pos = addAccessor(addView(positions, sizeof(xyzw), 16),
+                        TINYGLTF_COMPONENT_TYPE_FLOAT, TINYGLTF_TYPE_VEC3, 3,
+                        false);
+  int uv = addAccessor(addView(normalized, sizeof(shorts), 0),
+                       TINYGLTF_COMPONENT_TYPE_SHORT, TINYGLTF_TYPE_VEC2, 2,
+                       true);
+  int mat = addAccessor(addView(matrix, sizeof(mat2), 0),
+                        TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE,
+                        TINYGLTF_TYPE_MAT2, 1, false);
+  int sparse = addAccessor(-1, TINYGLTF_COMPONENT_TYPE_FLOAT,
+                           TINYGLTF_TYPE_SCALAR, 5, false);
+  model.accessors[size_t(sparse)].sparse.isSparse = true;
+  model.accessors[size_t(sparse)].sparse.count = 2;
+  model.accessors[size_t(sparse)].sparse.indices.bufferView =
+      addView(indices, sizeof(sparseIndices), 0);
+  model.accessors[size_t(sparse)].sparse.indices.componentType =
+      TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT;
+  model.accessors[size_t(sparse)].sparse.values.bufferView =
+      addView(values, sizeof(sparseValues), 0);
+
+  std::string err;
+  tinygltf::AccessorView<float> p;
+  REQUIRE(p.Init(model, pos, &err));
+  REQUIRE(p.size() == 3);
+  REQUIRE(p.NumComponents() == 3);
+  REQUIRE(p[1][2] == 6.0f);
+  REQUIRE(std::distance(p.begin(), p.end()) == 3);
+  REQUIRE((*(p.begin() + 2))[0] == 7.0f);
+  std::vector<float> packed(9);
+  p.CopyTo(packed.data());
+  REQUIRE(packed == std::vector<float>({1, 2, 3, 4, 5, 6, 7, 8, 9}));
+
+  // Normalized integers convert for floating point T, not for integral T
+  tinygltf::AccessorView<float> n;
+  REQUIRE(n.Init(model, uv, &err));
+  std::vector<float> nf(4);
+  n.CopyTo(nf.data());
+  REQUIRE(nf == std::vector<float>({1.0f, -1.0f, 0.0f, 16384.0f / 32767.0f}));
+  REQUIRE(n.Get(0, 1) == -1.0f);
+  tinygltf::AccessorView<int32_t> ni;
+  REQUIRE(ni.Init(model, uv, &err));
+  REQUIRE(ni[0][1] == -32768);
+
+  tinygltf::AccessorView<uint32_t> m;
+  REQUIRE(m.Init(model, mat, &err));
+  REQUIRE(m.NumComponents() == 4);
+  std::vector<uint32_t> mu(4);
+  m.CopyTo(mu.data());
+  REQUIRE(mu == std::vector<uint32_t>({1, 2, 3, 4}));
+  REQUIRE(m[0][3] == 4u);
+
+  // Sparse accessor without a bufferView: zeros with two substitutions
+  tinygltf::AccessorView<double> s;
+  REQUIRE(s.Init(model, sparse, &err));
+  REQUIRE(s.IsSparse());
+  std::vector<double> sd(5);
+  s.CopyTo(sd.data());
+  REQUIRE(sd == std::vector<double>({0, 10, 0, 30, 0}));
+  std::vector<double> iterated;
+  for (double v : s) iterated.push_back(v);
+  REQUIRE(iterated == sd);
+  REQUIRE(err.empty());
+
+  // Sparse indices must be strictly increasing and inside the accessor
+  model.accessors[size_t(sparse)].count = 3;
+  REQUIRE_FALSE(s.Init(model, sparse, &err));
+  REQUIRE_FALSE(s.Valid());
+  err.clear();
+  model.accessors[size_t(pos)].count = 4;
+  REQUIRE_FALSE(p.Init(model, pos, &err));
+  REQUIRE(err.find("accessor[0]") != std::string::npos);
+  REQUIRE_FALSE(p.Init(model, 99, &err));
+
+  // A count whose span wraps around to fit in the view is still rejected
+  model.accessors[size_t(pos)].count =
+      (size_t(1) << (sizeof(size_t) * 8 - 4)) + 1;
+  err.clear();
+  REQUIRE_FALSE(p.Init(model, pos, &err));
+  REQUIRE(err.find("runs past the end") != std::string::npos);
+}
+
+TEST_CASE("conversion-kernels", "[kernels]") {
+  using tinygltf::kernels::Isa;
+
+  // Odd sizes leave a scalar tail after the vector loops
+  const size_t count = 1003;
+  uint32_t rng = 99;
+  std::vector<unsigned char> bytes(count * 20);
+  for (unsigned char &b : bytes) {
+    rng = rng * 1664525u + 1013904223u;
+    b = static_cast<unsigned char>(rng >> 24);
+  }
+  // Finite floats for the float3 kernels and FloatToHalf: spans denormal to
+  // overflowing half magnitudes, both signs
+  std::vector<float> floats(count * 5);
+  for (size_t i = 0; i < floats.size(); ++i) {
+    rng = rng * 1664525u + 1013904223u;
+    float mag = std::ldexp(float(rng >> 8) / float(1 << 24),
+                           int(rng % 48) - 30);
+    floats[i] = (rng & 0x80) ? -mag : mag;
+  }
+  const unsigned char *xyz = reinterpret_cast<const unsigned char *>(floats.data());
+
+  struct Results {
+    std::vector<uint32_t> u8, u16;
+    std::vector<float> gathered, norm[4];
+    float min[3], max[3];
+    std::vector<uint16_t> half;
+  };
+  const int normTypes[4] = {TINYGLTF_COMPONENT_TYPE_BYTE,
+                            TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE,
+                            TINYGLTF_COMPONENT_TYPE_SHORT,
+                            TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT};
+  auto run = [&](Results &r) {
+    r.u8.resize(count);
+    tinygltf::kernels::WidenU8ToU32(bytes.data(), count, r.u8.data());
+    r.u16.resize(count);
+    tinygltf::kernels::WidenU16ToU32(
+        reinterpret_cast<const uint16_t *>(bytes.data()), count, r.u16.data());
+    r.gathered.resize(count * 3);
+    tinygltf::kernels::GatherFloat3(xyz, 20, count, r.gathered.data());
+    tinygltf::kernels::BoundsFloat3(xyz, 20, count, r.min, r.max);
+    for (int t = 0; t < 4; ++t) {
+      r.norm[t].resize(count);
+      REQUIRE(tinygltf::kernels::NormalizedToFloat(bytes.data(), normTypes[t],
+                                                   count, r.norm[t].data()));
+    }
+    r.half.resize(floats.size());
+    tinygltf::kernels::FloatToHalf(floats.data(), floats.size(),
+                                   r.half.data());
+  };
+
+  const Isa supported = tinygltf::kernels::SupportedIsa();
+  REQUIRE(tinygltf::kernels::SetIsa(Isa::Scalar) == Isa::Scalar);
+  Results scalar;
+  run(scalar);
+
+  REQUIRE(scalar.u8[5] == bytes[5]);
+  REQUIRE(scalar.norm[1][7] == float(bytes[7]) / 255.0f);
+  REQUIRE(memcmp(&scalar.gathered[3], &floats[5], 12) == 0);
+  REQUIRE(scalar.min[0] <= floats[0]);
+  REQUIRE(scalar.max[2] >= floats[2]);
+
+  for (Isa isa : {Isa::SSE2, Isa::AVX2}) {
+    if (isa > supported) continue;
+    REQUIRE(tinygltf::kernels::SetIsa(isa) == isa);
+    Results simd;
+    run(simd);
+    INFO(tinygltf::kernels::IsaName(isa));
+    REQUIRE(simd.u8 == scalar.u8);
+    REQUIRE(simd.u16 == scalar.u16);
+    REQUIRE(simd.gathered == scalar.gathered);
+    for (int c = 0; c < 3; ++c) {
+      REQUIRE(simd.min[c] == scalar.min[c]);
+      REQUIRE(simd.max[c] == scalar.max[c]);
+    }
+    for (int t = 0; t < 4; ++t) REQUIRE(simd.norm[t] == scalar.norm[t]);
+    REQUIRE(simd.half == scalar.half);
+  }
+  tinygltf::kernels::SetIsa(supported);
+
+  // Half rounding and special values
+  const float in[] = {1.0f,     -2.0f,        65504.0f,    65519.0f,
+                      65520.0f, 5.9604645e-8f, 2.9802322e-8f, 1.0009765625f,
+                      std::numeric_limits<float>::quiet_NaN(),
+                      -std::numeric_limits<float>::infinity()};
+  const uint16_t expected[] = {0x3c00, 0xc000, 0x7bff, 0x7bff, 0x7c00,
+                               0x0001, 0x0000, 0x3c01, 0x7e00, 0xfc00};
+  uint16_t out[10];
+  tinygltf::kernels::FloatToHalf(in, 10, out);
+  for (int i = 0; i < 10; ++i) REQUIRE(out[i] == expected[i]);
+
+  // AccessorView::CopyTo reaches the same results through the kernels
+  tinygltf::Model model;
+  model.buffers.resize(1);
+  model.buffers[0].data = bytes;
+  model.bufferViews.resize(1);
+  model.bufferViews[0].buffer = 0;
+  model.bufferViews[0].byteLength = bytes.size();
+  model.accessors.resize(1);
+  model.accessors[0].bufferView = 0;
+  model.accessors[0].componentType = TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT;
+  model.accessors[0].type = TINYGLTF_TYPE_SCALAR;
+  model.accessors[0].count = count;
+  tinygltf::AccessorView<uint32_t> indices;
+  REQUIRE(indices.Init(model, 0));
+  std::vector<uint32_t> widened(count);
+  indices.CopyTo(widened.data());
+  REQUIRE(widened == scalar.u16);
+}
+
+TEST_CASE("sparse-accessor-cache", "[accessor]") {
+  tinygltf::Model model;
+  tinygltf::TinyGLTF ctx;
+  std::string err, warn;
+  REQUIRE(ctx.LoadBinaryFromFile(
+      &model, &err, &warn,
+      "../models/SparseMorphTargets-issue280/singleBlendshapeCube_sparse.glb"));
+
+  tinygltf::SparseAccessorCache cache;
+  size_t sparseAccessors = 0;
+  for (size_t a = 0; a < model.accessors.size(); ++a) {
+    if (!model.accessors[a].sparse.isSparse) continue;
+    ++sparseAccessors;
+
+    tinygltf::AccessorView<float> searched, dense;
+    REQUIRE(searched.Init(model, int(a), &err));
+    REQUIRE(searched.IsSparse());
+    REQUIRE(dense.Init(model, int(a), &cache, &err));
+    REQUIRE_FALSE(dense.IsSparse());
+    REQUIRE(dense.Data() != nullptr);
+
+    const size_t n = searched.size() * size_t(searched.NumComponents());
+    std::vector<float> expected(n), actual(n);
+    searched.CopyTo(expected.data());
+    dense.CopyTo(actual.data());
+    REQUIRE(actual == expected);
+    for (size_t i = 0; i < searched.size(); ++i) {
+      REQUIRE(dense[i][0] == searched[i][0]);
+    }
+
+    // Later users share the materialized copy
+    const std::vector<unsigned char> *first = cache.Get(model, int(a));
+    REQUIRE(first == cache.Get(model, int(a)));
+    REQUIRE(first->size() == searched.size() * 12);
+  }
+  REQUIRE(sparseAccessors > 0);
+  REQUIRE(cache.size() == sparseAccessors);
+
+  REQUIRE(cache.Get(model, -1, &err) == nullptr);
+  REQUIRE_FALSE(err.empty());
+  cache.Clear();
+  REQUIRE(cache.size() == 0);
+
+  // A count whose dense size overflows size_t is rejected, not allocated
+  tinygltf::Model huge;
+  tinygltf::Buffer buffer;
+  buffer.data.assign(8, 0);
+  huge.buffers.push_back(buffer);
+  tinygltf::BufferView sparseView;
+  sparseView.buffer = 0;
+  sparseView.byteLength = 8;
+  huge.bufferViews.push_back(sparseView);
+  tinygltf::Accessor accessor;
+  accessor.componentType = TINYGLTF_COMPONENT_TYPE_FLOAT;
+  accessor.type = TINYGLTF_TYPE_SCALAR;
+  accessor.count = size_t(1) << (sizeof(size_t) * 8 - 2);
+  accessor.sparse.isSparse = true;
+  accessor.sparse.count = 1;
+  accessor.sparse.indices.bufferView = 0;
+  accessor.sparse.indices.componentType = TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT;
+  accessor.sparse.values.bufferView = 0;
+  accessor.sparse.values.byteOffset = 4;
+  huge.accessors.push_back(accessor);
+  err.clear();
+  REQUIRE(cache.Get(huge, 0, &err) == nullptr);
+  REQUIRE(err.find("accessor[0] is too large") != std::string::npos);
+  REQUIRE(cache.size() == 0);
+}
+
+TEST_CASE("parallel-image-decode", "[image]") {
+  // Same pixels, messages and timings list whatever the thread count
+  tinygltf::ModelVector<tinygltf::Image> reference;
+  for (int threads : {1, 4, 0}) {
+    tinygltf::TinyGLTF ctx;
+    ctx.SetImageDecodeThreads(threads);
+    REQUIRE(ctx.GetImageDecodeThreads() == threads);
+    tinygltf::Model model;
+    std::string err, warn;
+    REQUIRE(ctx.LoadASCIIFromFile(&model, &err, &warn,
+                                  "../models/Cube/Cube.gltf"));
+    REQUIRE(model.images.size() == 2);
+    const std::vector<tinygltf::ImageDecodeTiming> &timings =
+        ctx.GetImageDecodeTimings();
+    REQUIRE(timings.size() == 2);
+    for (size_t i = 0; i < timings.size(); ++i) {
+      REQUIRE(timings[i].image == int(i));
+      REQUIRE(timings[i].ok);
+      REQUIRE(timings[i].encoded_bytes > 0);
+      REQUIRE(timings[i].seconds >= 0.0);
+    }
+    if (reference.empty()) {
+      reference = model.images;
+    } else {
+      REQUIRE(model.images == reference);
+    }
+  }
+
+  // Two undecodable images: only the first failure is reported, as with a
+  // serial load
+  std::string gltf =
+      "{\"asset\":{\"version\":\"2.0\"},\"images\":["
+      "{\"uri\":\"data:image/png;base64,AAAA\"},"
+      "{\"uri\":\"data:image/png;base64,BBBB\"}]}";
+  std::string firstErr;
+  for (int threads : {1, 2}) {
+    tinygltf::TinyGLTF ctx;
+    ctx.SetImageDecodeThreads(threads);
+    tinygltf::Model model;
+    std::string err, warn;
+    REQUIRE_FALSE(ctx.LoadASCIIFromString(
+        &model, &err, &warn, gltf.c_str(),
+        static_cast<unsigned int>(gltf.size()), ""));
+    REQUIRE(err.find("image[0]") != std::string::npos);
+    REQUIRE(err.find("image[1]") == std::string::npos);
+    if (threads == 1) {
+      firstErr = err;
+    } else {
+      REQUIRE(err == firstErr);
+    }
+  }
+
+  // Custom loaders stay on one thread unless a count is set explicitly
+  struct Concurrency {
+    std::atomic<int> active{0};
+    std::atomic<int> peak{0};
+  } seen;
+  auto loader = [](tinygltf::Image *image, const int, std::string *,
+                   std::string *, int, int, const unsigned char *, int,
+                   void *user) {
+    Concurrency *c = static_cast<Concurrency *>(user);
+    int now = ++c->active;
+    int peak = c->peak;
+    while (now > peak && !c->peak.compare_exchange_weak(peak, now)) {
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    --c->active;
+    image->width = image->height = 1;
+    return true;
+  };
+  std::string many = "{\"asset\":{\"version\":\"2.0\"},\"images\":[";
+  for (int i = 0; i < 8; ++i) {
+    many += std::string(i ? "," : "") +
+            "{\"uri\":\"data:image/png;base64,AAAA\"}";
+  }
+  many += "]}";
+  {
+    tinygltf::TinyGLTF ctx;
+    ctx.SetImageLoader(loader, &seen);
+    tinygltf::Model model;
+    std::string err, warn;
+    REQUIRE(ctx.LoadASCIIFromString(&model, &err, &warn, many.c_str(),
+                                    static_cast<unsigned int>(many.size()),
+                                    ""));
+    REQUIRE(seen.peak == 1);
+    ctx.SetImageDecodeThreads(4);
+    REQUIRE(ctx.LoadASCIIFromString(&model, &err, &warn, many.c_str(),
+                                    static_cast<unsigned int>(many.size()),
+                                    ""));
+    REQUIRE(model.images.size() == 8);
+    REQUIRE(seen.peak > 1);
+  }
+
+  // After a failure no further image is decoded: at most the ones already
+  // handed to a worker
+  auto failing = [](tinygltf::Image *, const int, std::string *err,
+                    std::string *, int, int, const unsigned char *, int,
+                    void *user) {
+    ++*static_cast<std::atomic<int> *>(user);
+    if (err) (*err) += "bad image\n";
+    return false;
+  };
+  for (int threads : {1, 4}) {
+    std::atomic<int> calls{0};
+    tinygltf::TinyGLTF ctx;
+    ctx.SetImageLoader(failing, &calls);
+    ctx.SetImageDecodeThreads(threads);
+    tinygltf::Model model;
+    std::string err, warn;
+    REQUIRE_FALSE(ctx.LoadASCIIFromString(
+        &model, &err, &warn, many.c_str(),
+        static_cast<unsigned int>(many.size()), ""));
+    REQUIRE(calls >= 1);
+    REQUIRE(calls <= threads);
+    REQUIRE(err == "bad image\n");
+  }
+}
+
+TEST_CASE("lazy-image-decoding", "[image]") {
+  tinygltf::TinyGLTF ctx;
+  tinygltf::Model eager, model;
+  std::string err, warn;
+  REQUIRE(ctx.LoadASCIIFromFile(&eager, &err, &warn,
+                                "../models/Cube/Cube.gltf"));
+
+  ctx.SetLazyImageDecoding(true);
+  REQUIRE(ctx.LoadASCIIFromFile(&model, &err, &warn,
+                                "../models/Cube/Cube.gltf"));
+  REQUIRE(model.images.size() == 2);
+  REQUIRE(ctx.GetImageDecodeTimings().empty());
+  for (int i = 0; i < 2; ++i) {
+    REQUIRE(tinygltf::IsImageDecodePending(model, i));
+    REQUIRE(model.images[size_t(i)].image.empty());
+    REQUIRE_FALSE(model.images[size_t(i)].encoded.empty());
+  }
+
+  // Decode from several threads at once, including twice the same image
+  std::vector<std::thread> workers;
+  std::atomic<int> failures{0};
+  for (int t = 0; t < 4; ++t) {
+    workers.emplace_back([&model, &failures, t] {
+      if (!tinygltf::DecodeImage(&model, t % 2)) ++failures;
+    });
+  }
+  for (std::thread &w : workers) w.join();
+  REQUIRE(failures == 0);
+  for (int i = 0; i < 2; ++i) {
+    REQUIRE_FALSE(tinygltf::IsImageDecodePending(model, i));
+    REQUIRE(model.images[size_t(i)].encoded.empty());
+    REQUIRE(model.images[size_t(i)].image == eager.images[size_t(i)].image);
+    REQUIRE(model.images[size_t(i)].width == eager.images[size_t(i)].width);
+  }
+  REQUIRE(tinygltf::DecodeImage(&model, 0));  // already decoded
+  REQUIRE_FALSE(tinygltf::DecodeImage(&model, 2, &err));
+
+  // bufferView images are read from the (mapped) buffer only when decoded
+  tinygltf::Model glb;
+  ctx.SetMemoryMapBinary(true);
+  REQUIRE(ctx.LoadBinaryFromFile(&glb, &err, &warn, "../models/box01.glb"));
+  for (size_t i = 0; i < glb.images.size(); ++i) {
+    REQUIRE(glb.images[i].encoded.empty());
+    REQUIRE(glb.images[i].decode_pending == (glb.images[i].bufferView >= 0));
+    REQUIRE(tinygltf::DecodeImage(&glb, int(i), &err, &warn));
+    REQUIRE_FALSE(glb.images[i].decode_pending);
+  }
+
+  // Failures are reported and leave the image pending
+  std::string gltf =
+      "{\"asset\":{\"version\":\"2.0\"},\"images\":["
+      "{\"uri\":\"data:image/png;base64,AAAA\"}]}";
+  tinygltf::Model broken;
+  REQUIRE(ctx.LoadASCIIFromString(&broken, &err, &warn, gltf.c_str(),
+                                  static_cast<unsigned int>(gltf.size()), ""));
+  err.clear();
+  REQUIRE_FALSE(tinygltf::DecodeImage(&broken, 0, &err, &warn));
+  REQUIRE(err.find("image[0]") != std::string::npos);
+  REQUIRE(tinygltf::IsImageDecodePending(broken, 0));
+}
+
+TEST_CASE("data-uri-decode", "[base64]") {
+  // Every tail length round-trips, including bytes needing '+' and '/'.
+  std::vector<unsigned char> bytes;
+  for (int i = 0; i < 70; ++i) {
+    bytes.push_back(static_cast<unsigned char>(i * 37 + 251));
+    std::string b64 = tinygltf::base64_encode(
+        bytes.data(), static_cast<unsigned int>(bytes.size()));
+    std::string decoded = tinygltf::base64_decode(b64);
+    REQUIRE(decoded == std::string(bytes.begin(), bytes.end()));
+
+    std::vector<unsigned char> out;
+    std::string mime_type;
+    REQUIRE(tinygltf::DecodeDataURI(&out, mime_type,
+                                    "data:image/png;base64," + b64,
+                                    bytes.size(), true));
+    REQUIRE(out == bytes);
+    REQUIRE(mime_type == "image/png");
+  }
+
+  // Decoding stops at padding or the first invalid character.
+  REQUIRE(tinygltf::base64_decode("TWFu=TWFu") == "Man");
+  REQUIRE(tinygltf::base64_decode("TWFu TWFu") == "Man");
+  REQUIRE(tinygltf::base64_decode("TQ") == "M");
+  REQUIRE(tinygltf::base64_decode("T").empty());
+
+  // Size mismatches, empty payloads and unknown headers leave `out` alone.
+  std::vector<unsigned char> out(1, 42);
+  std::string mime_type;
+  REQUIRE_FALSE(tinygltf::DecodeDataURI(
+      &out, mime_type, "data:application/octet-stream;base64,TWFu", 4, true));
+  REQUIRE_FALSE(tinygltf::DecodeDataURI(
+      &out, mime_type, "data:application/gltf-buffer;base64,", 0, false));
+  REQUIRE_FALSE(tinygltf::DecodeDataURI(
+      &out, mime_type, "data:image/webp;base64,TWFu", 0, false));
+  REQUIRE(out == std::vector<unsigned char>(1, 42));
+  REQUIRE(mime_type.empty());
+  REQUIRE(tinygltf::DecodeDataURI(
+      &out, mime_type, "data:application/gltf-buffer;base64,TWFu", 3, true));
+  REQUIRE(std::string(out.begin(), out.end()) == "Man");
+}
+
+TEST_CASE("base64-kernels", "[kernels]") {
+  using tinygltf::kernels::Isa;
+
+  uint32_t rng = 7;
+  std::vector<unsigned char> bytes(1000);
+  for (unsigned char &b : bytes) {
+    rng = rng * 1664525u + 1013904223u;
+    b = static_cast<unsigned char>(rng >> 24);
+  }
+
+  // Reference encoding, one character at a time
+  const char *alphabet =
+      "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  auto reference = [alphabet](const unsigned char *p, size_t n) {
+    std::string s;
+    for (size_t i = 0; i < n; i += 3) {
+      uint32_t v = uint32_t(p[i]) << 16;
+      if (i + 1 < n) v |= uint32_t(p[i + 1]) << 8;
+      if (i + 2 < n) v |= p[i + 2];
+      s += alphabet[v >> 18];
+      s += alphabet[(v >> 12) & 63];
+      s += i + 1 < n ? alphabet[(v >> 6) & 63] : '=';
+      s += i + 2 < n ? alphabet[v & 63] : '=';
+    }
+    return s;
+  };
+
+  const Isa supported = tinygltf::kernels::SupportedIsa();
+  for (Isa isa : {Isa::Scalar, Isa::SSE2, Isa::AVX2}) {
+    if (isa > supported) continue;
+    tinygltf::kernels::SetIsa(isa);
+    INFO(tinygltf::kernels::IsaName(isa));
+
+    // Every length around the 12/24-byte blocks, and a long one
+    for (size_t n : {size_t(0), size_t(1), size_t(2), size_t(3), size_t(11),
+                     size_t(12), size_t(13), size_t(16), size_t(27),
+                     size_t(28), size_t(29), size_t(48), size_t(100),
+                     size_t(1000)}) {
+      const std::string expected = reference(bytes.data(), n);
+      std::string encoded(tinygltf::kernels::Base64EncodedSize(n), '\0');
+      if (n) tinygltf::kernels::Base64Encode(bytes.data(), n, &encoded[0]);
+      REQUIRE(encoded == expected);
+
+      size_t digits = 0;
+      const size_t size = tinygltf::kernels::Base64DecodedSize(
+          encoded.data(), encoded.size(), &digits);
+      REQUIRE(size == n);
+      std::vector<unsigned char> decoded(size);
+      tinygltf::kernels::Base64Decode(encoded.data(), digits, decoded.data());
+      REQUIRE(std::equal(decoded.begin(), decoded.end(), bytes.begin()));
+    }
+
+    // The scan stops at the first byte outside the alphabet, wherever it is
+    const std::string text = reference(bytes.data(), 300);
+    for (int c = 0; c < 256; ++c) {
+      if (std::strchr(alphabet, c) && c != 0) continue;
+      for (size_t at : {size_t(0), size_t(5), size_t(17), size_t(40),
+                        size_t(63), size_t(399)}) {
+        std::string broken = text;
+        broken[at] = static_cast<char>(c);
+        size_t digits = 0;
+        tinygltf::kernels::Base64DecodedSize(broken.data(), broken.size(),
+                                             &digits);
+        REQUIRE(digits == at);
+      }
+    }
+  }
+  tinygltf::kernels::SetIsa(supported);
+
+  // base64_encode() and the writer's buffer URIs use the same encoder
+  REQUIRE(tinygltf::base64_encode(bytes.data(), 100) ==
+          reference(bytes.data(), 100));
+}
+
+#ifdef TINYGLTF_ENABLE_STREAMING_PARSE  // built as tester_streaming
+TEST_CASE("streaming-parse", "[parse]") {
+  // The streaming front end and the DOM produce the same model and messages
+  const char *files[] = {
+      "../models/Cube/Cube.gltf",
+      "../models/Cube-texture-ext/Cube-textransform.gltf",
+      "../models/Extensions-issue97/test.gltf",
+      "../models/Extensions-overwrite-issue261/issue-261.gltf",
+      "../models/regression/unassigned-skeleton.gltf",
+      "../models/BoundsChecking/invalid-buffer-index.gltf",
+      "../models/BoundsChecking/invalid-primitive-indices.gltf",
+  };
+  for (const char *file : files) {
+    INFO(file);
+    tinygltf::TinyGLTF ctx;
+    ctx.SetStoreOriginalJSONForExtrasAndExtensions(true);
+    tinygltf::Model streamed, dom;
+    std::string streamedErr, streamedWarn, domErr, domWarn;
+    REQUIRE(ctx.GetStreamingParse());
+    bool streamedOk = ctx.LoadASCIIFromFile(&streamed, &streamedErr,
+                                            &streamedWarn, file);
+    ctx.SetStreamingParse(false);
+    bool domOk = ctx.LoadASCIIFromFile(&dom, &domErr, &domWarn, file);
+    REQUIRE(streamedOk == domOk);
+    REQUIRE(streamedErr == domErr);
+    REQUIRE(streamedWarn == domWarn);
+    if (domOk) REQUIRE(streamed == dom);
+  }
+
+  auto load = [](const std::string &json, std::string *err) {
+    tinygltf::TinyGLTF ctx;
+    tinygltf::Model model;
+    std::string warn;
+    return ctx.LoadASCIIFromString(&model, err, &warn, json.c_str(),
+                                   static_cast<unsigned int>(json.size()), "");
+  };
+
+  // Syntax errors and bad elements are reported while streaming
+  std::string err;
+  REQUIRE_FALSE(load("{\"asset\":{\"version\":\"2.0\"},\"nodes\":[{},", &err));
+  REQUIRE(err.find("parse error") != std::string::npos);
+  err.clear();
+  REQUIRE_FALSE(load("{\"asset\":{\"version\":\"2.0\"},\"nodes\":[{}, 1]}", &err));
+  REQUIRE(err == "`nodes' does not contain an JSON object.");
+
+  // Arrays nested in a streamed section are elements, not new sections
+  err.clear();
+  REQUIRE_FALSE(load("{\"asset\":{\"version\":\"2.0\"},\"nodes\":[[],"
+                     "{\"name\":\"a\",\"extras\":{\"k\":1}}],"
+                     "\"scenes\":[{\"nodes\":[0]}]}",
+                     &err));
+  REQUIRE(err == "`nodes' does not contain an JSON object.");
+  err.clear();
+  REQUIRE_FALSE(load("{\"asset\":{\"version\":\"2.0\"},"
+                     "\"nodes\":[[{\"x\":1}],{\"name\":\"a\"}]}",
+                     &err));
+  REQUIRE(err == "`nodes' does not contain an JSON object.");
+
+  // A section that isn't an array is left to the DOM, as before
+  err.clear();
+  REQUIRE(load("{\"asset\":{\"version\":\"2.0\"},\"nodes\":{\"a\":[1]},"
+               "\"scenes\":[{\"nodes\":[]}],\"scene\":0}",
+               &err));
+  REQUIRE(err.empty());
+}
+#endif
+
+TEST_CASE("attribute-map", "[mesh]") {
+  using tinygltf::AttributeSemantic;
+  REQUIRE(tinygltf::InternAttributeSemantic("POSITION") ==
+          AttributeSemantic::Position);
+  REQUIRE(tinygltf::InternAttributeSemantic("TEXCOORD_3") ==
+          AttributeSemantic::TexCoord3);
+  REQUIRE(tinygltf::InternAttributeSemantic("WEIGHTS_7") ==
+          AttributeSemantic::Weights7);
+  REQUIRE(tinygltf::InternAttributeSemantic("TEXCOORD_8") ==
+          AttributeSemantic::Custom);
+  REQUIRE(tinygltf::InternAttributeSemantic("COLOR_") ==
+          AttributeSemantic::Custom);
+  REQUIRE(tinygltf::InternAttributeSemantic("_POSITION") ==
+          AttributeSemantic::Custom);
+  REQUIRE(tinygltf::InternAttributeSemantic("") == AttributeSemantic::Custom);
+  for (int s = 0; s < int(AttributeSemantic::Custom); ++s) {
+    REQUIRE(tinygltf::InternAttributeSemantic(tinygltf::AttributeSemanticName(
+                AttributeSemantic(s))) == AttributeSemantic(s));
+  }
+
+  // Same contents and iteration order as std::map under inserts and erases
+  const char *names[] = {"TEXCOORD_1", "_BATCHID", "POSITION",  "NORMAL",
+                         "TEXCOORD_0", "COLOR_0",  "TEXCOORD_9", "JOINTS_0",
+                         "WEIGHTS_0",  "TANGENT",  "_A"};
+  tinygltf::AttributeMap attributes;
+  std::map<std::string, int> expected;
+  for (int i = 0; i < 11; ++i) {
+    attributes[names[i]] = i;
+    expected[names[i]] = i;
+  }
+  REQUIRE(attributes.emplace("POSITION", 42).second == false);
+  REQUIRE(attributes.erase("NORMAL") == 1);
+  REQUIRE(attributes.erase("NORMAL") == 0);
+  expected.erase("NORMAL");
+  REQUIRE(attributes.size() == expected.size());
+  auto expected_it = expected.begin();
+  for (const auto &entry : attributes) {
+    REQUIRE(entry.first == expected_it->first);
+    REQUIRE(entry.second == expected_it->second);
+    ++expected_it;
+  }
+  std::map<std::string, int> view = attributes;
+  REQUIRE(view == expected);
+  REQUIRE(attributes.map().size() == expected.size());
+  REQUIRE(tinygltf::AttributeMap(expected) == attributes);
+  for (const auto &entry : expected) {
+    REQUIRE(attributes.count(entry.first) == 1);
+    REQUIRE(attributes.at(entry.first) == entry.second);
+  }
+  REQUIRE(attributes.Get(AttributeSemantic::Position) == 2);
+  REQUIRE(attributes.find(AttributeSemantic::TexCoord0)->second == 4);
+  REQUIRE(attributes.Get(AttributeSemantic::Normal) == -1);
+  REQUIRE(attributes.find(AttributeSemantic::Custom) == attributes.end());
+  REQUIRE(attributes.find("_A")->second == 10);
+  REQUIRE(attributes.count("TEXCOORD_2") == 0);
+#ifndef TINYGLTF_NOEXCEPTION
+  REQUIRE_THROWS(attributes.at("NORMAL"));
+#endif
+
+  // The std::map value type, and indices and names of interned semantics
+  // that survive inserts and erases of other entries
+  static_assert(
+      std::is_same<tinygltf::AttributeMap::value_type,
+                   std::pair<const std::string, int>>::value,
+      "AttributeMap has the value_type of std::map");
+  REQUIRE(attributes.begin()->first == "COLOR_0");
+  int &position = attributes["POSITION"];
+  const std::string *key = &attributes.find("POSITION")->first;
+  for (int i = 0; i < 8; ++i) {
+    attributes["TEXCOORD_" + std::to_string(i)] = 100 + i;
+    attributes["_X" + std::to_string(i)] = 200 + i;
+  }
+  attributes.erase("JOINTS_0");
+  position = 77;
+  REQUIRE(attributes.Get(AttributeSemantic::Position) == 77);
+  REQUIRE(&attributes.find("POSITION")->first == key);
+
+  // Every interned semantic and custom names around them, in name order
+  tinygltf::AttributeMap all;
+  std::map<std::string, int> all_expected;
+  for (int s = 0; s < int(AttributeSemantic::Custom); ++s) {
+    all[AttributeSemantic(s)] = s;
+    all_expected[tinygltf::AttributeSemanticName(AttributeSemantic(s))] = s;
+  }
+  const char *customs[] = {"A", "COLOR_10", "NORMALS", "TEXCOORD_8", "Z",
+                           "_FOO"};
+  for (const char *name : customs) {
+    REQUIRE(all.emplace(name, -1).second);
+    all_expected[name] = -1;
+  }
+  REQUIRE(all.size() == all_expected.size());
+  const std::map<std::string, int> all_view = all;
+  REQUIRE(all_view == all_expected);
+  REQUIRE(all.find("TEXCOORD_8")->second == -1);
+  auto after = all.find("TEXCOORD_7");
+  REQUIRE((++after)->first == "TEXCOORD_8");
+  REQUIRE((++after)->first == "WEIGHTS_0");
+  REQUIRE(tinygltf::InternAttributeSemantic("POSITIO_") ==
+          AttributeSemantic::Custom);
+  REQUIRE(tinygltf::InternAttributeSemantic("TEXCOORD_8") ==
+          AttributeSemantic::Custom);
+
+  // Erasing while iterating
+  for (int i = 0; i < 8; ++i) {
+    REQUIRE(attributes.Get(AttributeSemantic(
+                int(AttributeSemantic::TexCoord0) + i)) == 100 + i);
+  }
+  for (auto it = attributes.begin(); it != attributes.end();) {
+    if ((it->first.compare(0, 9, "TEXCOORD_") == 0 && it->second % 2 == 0) ||
+        it->first == "_X3") {
+      it = attributes.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  REQUIRE(attributes.count("_X3") == 0);
+  REQUIRE(attributes.at("_X4") == 204);
+  for (int i = 0; i < 8; ++i) {
+    const auto it = attributes.find(
+        AttributeSemantic(int(AttributeSemantic::TexCoord0) + i));
+    if (i % 2 == 0) {
+      REQUIRE(it == attributes.end());
+    } else {
+      REQUIRE(it->second == 100 + i);
+    }
+  }
+  REQUIRE(attributes.Get(AttributeSemantic::Weights0) == 8);
+  REQUIRE(attributes.Get(AttributeSemantic::Tangent) == 9);
+  tinygltf::AttributeMap copied = attributes, moved;
+  moved = std::move(copied);
+  REQUIRE(moved == attributes);
+  REQUIRE(moved.Get(AttributeSemantic::TexCoord7) == 107);
+  REQUIRE(moved.find(AttributeSemantic::Position)->second == 77);
+
+  // Loaded primitives and morph targets
+  tinygltf::Model model;
+  tinygltf::TinyGLTF ctx;
+  std::string err, warn;
+  REQUIRE(ctx.LoadASCIIFromFile(&model, &err, &warn,
+                                "../models/Cube/Cube.gltf"));
+  const tinygltf::Primitive &prim = model.meshes[0].primitives[0];
+  REQUIRE(prim.attributes.find(AttributeSemantic::Position) ==
+          prim.attributes.find("POSITION"));
+  REQUIRE(prim.attributes.Get(AttributeSemantic::Normal) ==
+          prim.attributes.at("NORMAL"));
+}
+
+TEST_CASE("value-representation", "[value]") {
+  using tinygltf::Value;
+  REQUIRE(sizeof(Value) <= 16);
+
+  // Reading a type the value does not hold gives an immutable empty one
+  const Value s("text");
+  REQUIRE(s.Get<double>() == 0.0);
+  REQUIRE(s.Get<Value::Object>().empty());
+  REQUIRE(s.Get<Value::Array>().empty());
+  REQUIRE(s.Get<std::string>() == "text");
+  REQUIRE(Value(3).Get<double>() == 3.0);
+  const Value null;
+  REQUIRE(null.Get<std::string>().empty());
+
+#ifdef NDEBUG
+  // The non-const accessor asserts on another type; without asserts it
+  // hands out one scratch T per thread and never changes the stored type
+  Value n, m;
+  Value::Array &a = n.Get<Value::Array>();
+  a.push_back(Value(1));
+  Value::Array &b = m.Get<Value::Array>();
+  REQUIRE(&a == &b);  // the same scratch array, cleared by the second call
+  REQUIRE(a.empty());
+  REQUIRE(n.Type() == tinygltf::NULL_TYPE);
+  REQUIRE(m.Type() == tinygltf::NULL_TYPE);
+  Value t("text");
+  t.Get<double>() = 2.0;
+  t.Get<Value::Object>()["k"] = Value(1);
+  REQUIRE(t.IsString());
+  REQUIRE(t.Get<std::string>() == "text");
+#endif
+  Value r(1.5);
+  r.Get<double>() = 2.5;
+  REQUIRE(r.Get<double>() == 2.5);
+
+  // Flat object: sorted like std::map, small ones indexed inline, with
+  // members that stay put
+  static_assert(std::is_same<Value::Object::value_type,
+                             std::pair<const tinygltf::ValueKey, Value> >::value,
+                "Value::Object members have const keys");
+  REQUIRE(sizeof(Value::Object) <= sizeof(std::map<std::string, Value>));
+  Value::Object o;
+  std::map<std::string, int> expected;
+  const char *keys[] = {"scale", "offset", "texCoord", "rotation", "index"};
+  Value &first = o[keys[0]];
+  first = Value(0);
+  expected[keys[0]] = 0;
+  for (int i = 1; i < 4; ++i) {
+    o[keys[i]] = Value(i);
+    expected[keys[i]] = i;
+  }
+  REQUIRE(o.capacity() == Value::Object::kInlineCapacity);
+  REQUIRE(o.emplace(keys[4], 4).second);
+  expected[keys[4]] = 4;
+  REQUIRE(o.capacity() > Value::Object::kInlineCapacity);
+  REQUIRE(first.Get<int>() == 0);
+  REQUIRE(&first == &o.at("scale"));
+  REQUIRE_FALSE(o.emplace(keys[4], 5).second);
+  REQUIRE(o.erase("offset") == 1);
+  expected.erase("offset");
+  o["offset2"] = Value(9);  // reuses the erased member's slot
+  REQUIRE(o.erase("offset2") == 1);
+  REQUIRE(&first == &o.at("scale"));
+  REQUIRE(o.size() == expected.size());
+  auto it = expected.begin();
+  for (const auto &member : o) {
+    REQUIRE(member.first == it->first);
+    REQUIRE(member.second.Get<int>() == it->second);
+    ++it;
+  }
+  REQUIRE(o.count("index") == 1);
+  REQUIRE(o.find("offset") == o.end());
+  REQUIRE(o.at("scale").Get<int>() == 0);
+  REQUIRE_THROWS(o.at("offset"));
+
+  Value v(o);
+  REQUIRE(v.Keys() == std::vector<std::string>({"index", "rotation", "scale",
+                                                "texCoord"}));
+  REQUIRE(v.Size() == 4);
+  REQUIRE(v.Has("rotation"));
+  REQUIRE(v.Get("texCoord").Get<int>() == 2);
+  Value copy = v;
+  REQUIRE(copy == v);
+  Value moved = std::move(copy);
+  REQUIRE(moved == v);
+  REQUIRE(copy.Type() == tinygltf::NULL_TYPE);
+  Value::Object &movedObject = moved.Get<Value::Object>();
+  Value &scale = movedObject.at("scale");
+  Value::Object stolen(std::move(movedObject));
+  REQUIRE(&scale == &stolen.at("scale"));
+  movedObject = std::move(stolen);
+  moved.Get<Value::Object>()["index"] = Value(7);
+  REQUIRE_FALSE(moved == v);
+
+  // A reference into an extension map survives later inserts
+  tinygltf::Node node;
+  Value &ext = node.extensions["KHR_a"];
+  ext = Value(1);
+  const char *more[] = {"KHR_b", "KHR_c", "KHR_d", "KHR_e"};
+  for (const char *name : more) node.extensions[name] = Value(2);
+  REQUIRE(ext.Get<int>() == 1);
+
+  // Keys parsed by one load are interned
+  {
+    tinygltf::ValueKeyPool pool;
+    tinygltf::ValueKey a = pool.Intern(std::string("KHR_materials_variants"));
+    tinygltf::ValueKey b = pool.Intern(std::string("KHR_materials_variants"));
+    REQUIRE(a.SharesStorage(b));
+    REQUIRE(pool.size() == 1);
+    REQUIRE_FALSE(
+        tinygltf::ValueKey("x").SharesStorage(tinygltf::ValueKey("x")));
+  }
+
+  std::stringstream ss;
+  ss << "{\"asset\":{\"version\":\"2.0\"},\"nodes\":["
+        "{\"extras\":{\"id\":1,\"tag\":\"a\"}},"
+        "{\"extras\":{\"id\":2,\"tag\":\"b\"}}]}";
+  const std::string json = ss.str();
+  tinygltf::Model model;
+  tinygltf::TinyGLTF ctx;
+  std::string err, warn;
+  REQUIRE(ctx.LoadASCIIFromString(&model, &err, &warn, json.c_str(),
+                                  static_cast<unsigned int>(json.size()), ""));
+  const Value::Object &extras0 = model.nodes[0].extras.Get<Value::Object>();
+  const Value::Object &extras = model.nodes[1].extras.Get<Value::Object>();
+  REQUIRE(extras.size() == 2);
+  REQUIRE(extras.begin()->first == "id");
+  REQUIRE(extras0.begin()->first.SharesStorage(extras.begin()->first));
+  REQUIRE(extras.at("tag").Get<std::string>() == "b");
+}
+
+TEST_CASE("streaming-writer", "[write]") {
+  tinygltf::Model model;
+  tinygltf::TinyGLTF ctx;
+  std::string err, warn;
+  REQUIRE(ctx.LoadASCIIFromFile(&model, &err, &warn,
+                                "../models/Cube/Cube.gltf"));
+
+  // Members the document writes in odd places, sizes on both sides of the
+  // base64 block and strings that need escaping.
+  model.buffers[0].data.resize(3 * 16 * 1024 + 2);
+  tinygltf::Buffer empty;
+  empty.name = "tab\there \"quoted\" \xc3\xa9";
+  model.buffers.push_back(empty);
+  model.materials.emplace_back();
+  model.nodes.emplace_back();
+  model.animations.emplace_back();
+  tinygltf::Light light;
+  light.type = "point";
+  model.lights.push_back(light);
+  model.extensionsRequired.push_back("KHR_materials_unlit");
+  tinygltf::Value::Object extras;
+  extras["list"] = tinygltf::Value(tinygltf::Value::Array{
+      tinygltf::Value(1), tinygltf::Value(tinygltf::Value::Object{})});
+  extras["nested"] = tinygltf::Value(tinygltf::Value::Object{
+      {"k", tinygltf::Value(std::string("line\nbreak"))}});
+  model.extras = tinygltf::Value(extras);
+
+  auto payloads = [&](bool binary) {
+    tinygltf::GltfPayloads p;
+    for (size_t i = 0; i < model.buffers.size(); ++i) {
+      tinygltf::SerializeGltfBufferPayload(model.buffers[i],
+                                           binary && i == 0, &p);
+    }
+    for (const tinygltf::Image &image : model.images) {
+      tinygltf::detail::json o;
+      tinygltf::SerializeGltfImage(image, image.uri, o);
+      p.images.push_back(std::move(o));
+    }
+    return p;
+  };
+
+  for (bool binary : {false, true}) {
+    for (int spacing : {-1, 0, 2, 4}) {
+      tinygltf::GltfPayloads dom_payloads = payloads(binary);
+      tinygltf::detail::JsonDocument dom;
+      tinygltf::SerializeGltfDocument(model, dom_payloads, dom);
+      const std::string expected = tinygltf::detail::JsonToString(dom, spacing);
+
+      tinygltf::GltfPayloads streamed_payloads = payloads(binary);
+      std::string streamed;
+      size_t writes = 0;
+      REQUIRE(tinygltf::WriteGltfJson(
+          model, streamed_payloads, spacing,
+          [&](const char *s, size_t n) {
+            streamed.append(s, n);
+            ++writes;
+            return true;
+          }));
+      REQUIRE(streamed == expected);
+      // The embedded buffer alone spans more than one chunk.
+      if (!binary) REQUIRE(writes > 1);
+    }
+  }
+
+  // The stream gets the whole document; a failing sink is reported.
+  // (Images would be embedded on the way.)
+  model.images.clear();
+  std::stringstream os;
+  REQUIRE(ctx.WriteGltfSceneToStream(&model, os, true, false));
+  {
+    tinygltf::GltfPayloads p = payloads(false);
+    tinygltf::detail::JsonDocument dom;
+    tinygltf::SerializeGltfDocument(model, p, dom);
+    REQUIRE(os.str() == tinygltf::detail::JsonToString(dom, 2) + "\n");
+  }
+  tinygltf::GltfPayloads p = payloads(false);
+  REQUIRE_FALSE(tinygltf::WriteGltfJson(
+      model, p, 2, [](const char *, size_t) { return false; }));
+}
@@ -38,18 +38,26 @@
 #define TINY_GLTF_H_
 
 #include <array>
+#include <atomic>  // ValueKey and ModelArena reference counts
 #include <cassert>
 #include <cmath>  // std::fabs
+#include <cstddef>
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
 #include <functional>
+#include <initializer_list>
+#include <iosfwd>
+#include <iterator>
 #include <limits>
 #include <map>
+#include <memory>
 #include <string>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
+
 #ifdef __ANDROID__
 #ifdef TINYGLTF_ANDROID_LOAD_FROM_ASSETS
 #include <android/asset_manager.h>
@@ -245,6 +253,178 @@ bool IsDataURI(const std::string &in);
 bool DecodeDataURI(std::vector<unsigned char> *out, std::string &mime_type,
                    const std::string &in, size_t reqBytes, bool checkSize);
 
+#ifdef TINYGLTF_ENABLE_MODEL_ARENA
+///
+/// Monotonic block allocator for Model storage. Allocations are carved from
+/// large blocks that are only released together, so filling a Model costs a
+/// handful of mallocs and tearing it down none. An arena belongs to the
+/// ModelAllocators that refer to it and is deleted with the last of them.
+/// It must not be allocated from by two threads at once.
+///
+class ModelArena {
+ public:
+  /// ModelAllocator requests of this many bytes or more go to the heap, so
+  /// growing the large top-level arrays doesn't strand their old storage.
+  static const size_t kHeapThreshold = 64 * 1024;
+
+  explicit ModelArena(size_t block_size = size_t(1) << 20)
+      : block_size_(block_size) {}
+  ~ModelArena();
+  ModelArena(const ModelArena &) = delete;
+  ModelArena &operator=(const ModelArena &) = delete;
+
+  void *Allocate(size_t size, size_t alignment) {
+    if (block_ < blocks_.size()) {
+      const size_t offset = (offset_ + alignment - 1) & ~(alignment - 1);
+      if (offset <= blocks_[block_].size &&
+          size <= blocks_[block_].size - offset) {
+        offset_ = offset + size;
+        used_ += size;
+        return blocks_[block_].data + offset;
+      }
+    }
+    return AllocateSlow(size, alignment);
+  }
+
+  /// Rewinds to the first block, keeping all blocks for reuse. Nothing
+  /// allocated from the arena may still be in use.
+  void Reset();
+
+  /// Bytes handed out since construction or the last Reset().
+  size_t BytesUsed() const { return used_; }
+
+  /// Bytes held in blocks.
+  size_t BytesReserved() const { return reserved_; }
+
+  /// Number of ModelAllocators referring to the arena.
+  size_t UseCount() const { return refs_.load(std::memory_order_acquire); }
+
+  void Ref() { refs_.fetch_add(1, std::memory_order_relaxed); }
+  void Unref() {
+    if (refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) delete this;
+  }
+
+  /// Arena that default-constructed ModelAllocators use on this thread.
+  static ModelArena *Current();
+
+  ///
+  /// Makes `arena` current on this thread until the scope ends, so Model
+  /// objects built meanwhile allocate their containers from it.
+  ///
+  class Scope {
+   public:
+    explicit Scope(ModelArena *arena);
+    ~Scope();
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+
+   private:
+    ModelArena *previous_;
+  };
+
+ private:
+  struct Block {
+    unsigned char *data;
+    size_t size;
+  };
+
+  static ModelArena *&CurrentSlot();
+  void *AllocateSlow(size_t size, size_t alignment);
+
+  std::vector<Block> blocks_;
+  size_t block_ = 0;   // block being filled
+  size_t offset_ = 0;  // first free byte in it
+  size_t block_size_;
+  size_t used_ = 0;
+  size_t reserved_ = 0;
+  std::atomic<size_t> refs_{0};
+};
+
+///
+/// Allocator of the Model containers. A default-constructed one draws from
+/// ModelArena::Current(), or from the heap when no arena is current. Copies
+/// of a container allocate like a new one and assigned copies keep the
+/// target's allocator; moving or swapping a container takes its arena along.
+///
+template <typename T>
+class ModelAllocator {
+ public:
+  using value_type = T;
+  using propagate_on_container_copy_assignment = std::false_type;
+  using propagate_on_container_move_assignment = std::true_type;
+  using propagate_on_container_swap = std::true_type;
+
+  ModelAllocator() noexcept : ModelAllocator(ModelArena::Current()) {}
+  explicit ModelAllocator(ModelArena *arena) noexcept : arena_(arena) {
+    if (arena_) arena_->Ref();
+  }
+  ModelAllocator(const ModelAllocator &other) noexcept
+      : ModelAllocator(other.arena_) {}
+  template <typename U>
+  ModelAllocator(const ModelAllocator<U> &other) noexcept
+      : ModelAllocator(other.arena()) {}
+  ModelAllocator &operator=(const ModelAllocator &other) noexcept {
+    if (other.arena_) other.arena_->Ref();
+    if (arena_) arena_->Unref();
+    arena_ = other.arena_;
+    return *this;
+  }
+  ~ModelAllocator() {
+    if (arena_) arena_->Unref();
+  }
+
+  T *allocate(size_t n) {
+    const size_t bytes = n * sizeof(T);
+    if (!arena_ || bytes >= ModelArena::kHeapThreshold) {
+      return static_cast<T *>(::operator new(bytes));
+    }
+    return static_cast<T *>(arena_->Allocate(bytes, alignof(T)));
+  }
+
+  void deallocate(T *p, size_t n) noexcept {
+    if (!arena_ || n * sizeof(T) >= ModelArena::kHeapThreshold) {
+      ::operator delete(p);
+    }
+  }
+
+  ModelAllocator select_on_container_copy_construction() const {
+    return ModelAllocator();
+  }
+
+  ModelArena *arena() const noexcept { return arena_; }
+
+ private:
+  ModelArena *arena_;
+};
+
+template <typename T, typename U>
+bool operator==(const ModelAllocator<T> &a, const ModelAllocator<U> &b) {
+  return a.arena() == b.arena();
+}
+
+template <typename T, typename U>
+bool operator!=(const ModelAllocator<T> &a, const ModelAllocator<U> &b) {
+  return a.arena() != b.arena();
+}
+
+/// Containers of the Model, its elements and Value. They are not
+/// std::vector/std::map here, so code that spells the containers of the
+/// public structs as std::vector<double> etc. does not compile with
+/// TINYGLTF_ENABLE_MODEL_ARENA and has to use ModelVector/ModelMap.
+template <typename T>
+using ModelVector = std::vector<T, ModelAllocator<T>>;
+template <typename K, typename V>
+using ModelMap =
+    std::map<K, V, std::less<K>, ModelAllocator<std::pair<const K, V>>>;
+#else
+/// Containers of the Model, its elements and Value. Arena-backed with
+/// TINYGLTF_ENABLE_MODEL_ARENA.
+template <typename T>
+using ModelVector = std::vector<T>;
+template <typename K, typename V>
+using ModelMap = std::map<K, V>;
+#endif
+
 #ifdef __clang__
 #pragma clang diagnostic push
 // Suppress warning for : static Value null_value
@@ -252,42 +432,218 @@ bool DecodeDataURI(std::vector<unsigned char> *out, std::string &mime_type,
 #pragma clang diagnostic ignored "-Wpadded"
 #endif
 
+///
+/// Key of a Value::Object member: an immutable, reference-counted string,
+/// so copying an object shares its keys instead of copying them. Keys made
+/// while a ValueKeyPool is current (TinyGLTF makes one current for each
+/// load) are interned, and the many "index" or "texCoord" members of a file
+/// share a single string. Reads like a `const std::string &`.
+///
+class ValueKey {
+ public:
+  ValueKey() = default;
+  ValueKey(const std::string &s);
+  ValueKey(std::string &&s);
+  ValueKey(const char *s) : ValueKey(std::string(s)) {}
+  ValueKey(const ValueKey &other) noexcept : node_(other.node_) { Ref(); }
+  ValueKey(ValueKey &&other) noexcept : node_(other.node_) {
+    other.node_ = nullptr;
+  }
+  ValueKey &operator=(const ValueKey &other) noexcept {
+    other.Ref();
+    Unref();
+    node_ = other.node_;
+    return *this;
+  }
+  ValueKey &operator=(ValueKey &&other) noexcept {
+    std::swap(node_, other.node_);
+    return *this;
+  }
+  ~ValueKey() { Unref(); }
+
+  const std::string &str() const { return node_ ? node_->str : Empty(); }
+  operator const std::string &() const { return str(); }
+
+  const char *c_str() const { return str().c_str(); }
+  const char *data() const { return str().data(); }
+  size_t size() const { return str().size(); }
+  size_t length() const { return str().size(); }
+  bool empty() const { return str().empty(); }
+  char operator[](size_t i) const { return str()[i]; }
+  std::string::const_iterator begin() const { return str().begin(); }
+  std::string::const_iterator end() const { return str().end(); }
+  int compare(const std::string &s) const { return str().compare(s); }
+
+  /// True when both keys refer to the same interned string.
+  bool SharesStorage(const ValueKey &other) const {
+    return node_ == other.node_;
+  }
+
+ private:
+  friend class ValueKeyPool;
+
+  struct Node {
+    explicit Node(std::string &&s) : str(std::move(s)) {}
+    std::atomic<unsigned> refs{1};
+    const std::string str;
+  };
+
+  explicit ValueKey(Node *node) noexcept : node_(node) {}  // adopts a ref
+  static const std::string &Empty();
+  void Ref() const {
+    if (node_) node_->refs.fetch_add(1, std::memory_order_relaxed);
+  }
+  void Unref() {
+    if (node_ && node_->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      delete node_;
+    }
+  }
+
+  Node *node_ = nullptr;
+};
+
+#define TINYGLTF_VALUE_KEY_COMPARE(op)                                     \
+  inline bool operator op(const ValueKey &a, const ValueKey &b) {         \
+    return a.str() op b.str();                                            \
+  }                                                                        \
+  inline bool operator op(const ValueKey &a, const std::string &b) {      \
+    return a.str() op b;                                                  \
+  }                                                                        \
+  inline bool operator op(const std::string &a, const ValueKey &b) {      \
+    return a op b.str();                                                  \
+  }                                                                        \
+  inline bool operator op(const ValueKey &a, const char *b) {             \
+    return a.str() op b;                                                  \
+  }                                                                        \
+  inline bool operator op(const char *a, const ValueKey &b) {             \
+    return a op b.str();                                                  \
+  }
+TINYGLTF_VALUE_KEY_COMPARE(==)
+TINYGLTF_VALUE_KEY_COMPARE(!=)
+TINYGLTF_VALUE_KEY_COMPARE(<)
+TINYGLTF_VALUE_KEY_COMPARE(<=)
+TINYGLTF_VALUE_KEY_COMPARE(>)
+TINYGLTF_VALUE_KEY_COMPARE(>=)
+#undef TINYGLTF_VALUE_KEY_COMPARE
+
+inline std::string operator+(const std::string &a, const ValueKey &b) {
+  return a + b.str();
+}
+inline std::string operator+(const ValueKey &a, const std::string &b) {
+  return a.str() + b;
+}
+inline std::string operator+(const char *a, const ValueKey &b) {
+  return a + b.str();
+}
+inline std::string operator+(const ValueKey &a, const char *b) {
+  return a.str() + b;
+}
+
+template <typename CharT, typename Traits>
+std::basic_ostream<CharT, Traits> &operator<<(
+    std::basic_ostream<CharT, Traits> &os, const ValueKey &key) {
+  return os << key.str();
+}
+
+///
+/// Interning table for ValueKeys. While a pool is current on a thread, keys
+/// constructed from strings on that thread are looked up in it and share
+/// storage with equal keys made before. The pool holds a reference to each
+/// of its keys until it is destroyed; the keys themselves outlive it.
+///
+class ValueKeyPool {
+ public:
+  ValueKeyPool() = default;
+  ~ValueKeyPool();
+  ValueKeyPool(const ValueKeyPool &) = delete;
+  ValueKeyPool &operator=(const ValueKeyPool &) = delete;
+
+  /// The pooled key equal to `s`, added if it is not there yet.
+  ValueKey Intern(const std::string &s);
+  ValueKey Intern(std::string &&s);
+
+  /// Number of distinct keys in the pool.
+  size_t size() const { return size_; }
+
+  /// Pool that keys made on this thread are interned in, or nullptr.
+  static ValueKeyPool *Current();
+
+  ///
+  /// Makes `pool` current on this thread until the scope ends.
+  ///
+  class Scope {
+   public:
+    explicit Scope(ValueKeyPool *pool);
+    ~Scope();
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+
+   private:
+    ValueKeyPool *previous_;
+  };
+
+ private:
+  static ValueKeyPool *&CurrentSlot();
+  size_t Probe(const std::string &s) const;
+  template <typename S>
+  ValueKey Insert(S &&s);
+
+  std::vector<ValueKey::Node *> slots_;  // open addressing, power of two
+  size_t size_ = 0;
+};
+
+class ValueObject;
+
 // Simple class to represent JSON object
+//
+// A Value is 16 bytes: the type, bool and int fields, and either the number
+// or a pointer to the string, binary, array or object it holds, so scalars
+// carry no empty containers.
 class Value {
  public:
-  typedef std::vector<Value> Array;
-  typedef std::map<std::string, Value> Object;
+  typedef ModelVector<Value> Array;
+  typedef ValueObject Object;
 
   Value() = default;
 
-  explicit Value(bool b) : type_(BOOL_TYPE) { boolean_value_ = b; }
-  explicit Value(int i) : type_(INT_TYPE) {
-    int_value_ = i;
-    real_value_ = i;
-  }
+  explicit Value(bool b) : type_(BOOL_TYPE), boolean_value_(b) {}
+  explicit Value(int i) : type_(INT_TYPE), int_value_(i) { real_value_ = i; }
   explicit Value(double n) : type_(REAL_TYPE) { real_value_ = n; }
   explicit Value(const std::string &s) : type_(STRING_TYPE) {
-    string_value_ = s;
+    string_value_ = new std::string(s);
+  }
+  explicit Value(std::string &&s) : type_(STRING_TYPE) {
+    string_value_ = new std::string(std::move(s));
+  }
+  explicit Value(const char *s) : type_(STRING_TYPE) {
+    string_value_ = new std::string(s);
   }
-  explicit Value(std::string &&s)
-      : type_(STRING_TYPE), string_value_(std::move(s)) {}
-  explicit Value(const char *s) : type_(STRING_TYPE) { string_value_ = s; }
   explicit Value(const unsigned char *p, size_t n) : type_(BINARY_TYPE) {
-    binary_value_.resize(n);
-    memcpy(binary_value_.data(), p, n);
+    binary_value_ = new std::vector<unsigned char>(p, p + n);
   }
-  explicit Value(std::vector<unsigned char> &&v) noexcept
-      : type_(BINARY_TYPE),
-        binary_value_(std::move(v)) {}
-  explicit Value(const Array &a) : type_(ARRAY_TYPE) { array_value_ = a; }
-  explicit Value(Array &&a) noexcept : type_(ARRAY_TYPE),
-                                       array_value_(std::move(a)) {}
-
-  explicit Value(const Object &o) : type_(OBJECT_TYPE) { object_value_ = o; }
-  explicit Value(Object &&o) noexcept : type_(OBJECT_TYPE),
-                                        object_value_(std::move(o)) {}
+  explicit Value(std::vector<unsigned char> &&v) : type_(BINARY_TYPE) {
+    binary_value_ = new std::vector<unsigned char>(std::move(v));
+  }
+  explicit Value(const Array &a) : type_(ARRAY_TYPE) {
+    array_value_ = new Array(a);
+  }
+  explicit Value(Array &&a) : type_(ARRAY_TYPE) {
+    array_value_ = new Array(std::move(a));
+  }
+  explicit Value(const Object &o);
+  explicit Value(Object &&o);
 
-  DEFAULT_METHODS(Value)
+  Value(const Value &other);
+  Value(Value &&other) noexcept { Take(other); }
+  Value &operator=(const Value &other);
+  Value &operator=(Value &&other) noexcept {
+    if (this != &other) {
+      Release();
+      Take(other);
+    }
+    return *this;
+  }
+  ~Value() { Release(); }
 
   char Type() const { return static_cast<char>(type_); }
 
@@ -311,9 +667,10 @@ class Value {
   double GetNumberAsDouble() const {
     if (type_ == INT_TYPE) {
       return double(int_value_);
-    } else {
+    } else if (type_ == REAL_TYPE) {
       return real_value_;
     }
+    return 0.0;
   }
 
   // Use this function if you want to have number value as int.
@@ -326,7 +683,12 @@ class Value {
     }
   }
 
-  // Accessor
+  // Accessor. For a type the value does not hold, the const accessor
+  // returns an immutable empty (zero) T. Calling the non-const one that way
+  // is a bug and asserts; release builds get a scratch empty T instead.
+  // The scratch T is shared by every such call on the thread and cleared
+  // by the next one, so writes through it are lost. Neither accessor
+  // changes the stored type; assign a Value to do that.
   template <typename T>
   const T &Get() const;
   template <typename T>
@@ -334,84 +696,412 @@ class Value {
 
   // Lookup value from an array
   const Value &Get(size_t idx) const {
-    static Value null_value;
     assert(IsArray());
-    return (idx < array_value_.size())
-               ? array_value_[idx]
-               : null_value;
+    return (IsArray() && idx < array_value_->size()) ? (*array_value_)[idx]
+                                                     : Null();
   }
 
   // Lookup value from a key-value pair
-  const Value &Get(const std::string &key) const {
-    static Value null_value;
-    assert(IsObject());
-    Object::const_iterator it = object_value_.find(key);
-    return (it != object_value_.end()) ? it->second : null_value;
-  }
+  const Value &Get(const std::string &key) const;
 
   size_t ArrayLen() const {
     if (!IsArray()) return 0;
-    return array_value_.size();
+    return array_value_->size();
   }
 
   // Valid only for object type.
-  bool Has(const std::string &key) const {
-    if (!IsObject()) return false;
-    Object::const_iterator it = object_value_.find(key);
-    return (it != object_value_.end()) ? true : false;
-  }
+  bool Has(const std::string &key) const;
 
   // List keys
-  std::vector<std::string> Keys() const {
-    std::vector<std::string> keys;
-    if (!IsObject()) return keys;  // empty
+  std::vector<std::string> Keys() const;
 
-    for (Object::const_iterator it = object_value_.begin();
-         it != object_value_.end(); ++it) {
-      keys.push_back(it->first);
-    }
+  size_t Size() const;
 
-    return keys;
+  bool operator==(const tinygltf::Value &other) const;
+
+ protected:
+  static const Value &Null() {
+#ifdef TINYGLTF_ENABLE_MODEL_ARENA
+    ModelArena::Scope heap(nullptr);  // the static must not pin an arena
+#endif
+    static const Value null_value;
+    return null_value;
   }
 
-  size_t Size() const { return (IsArray() ? ArrayLen() : Keys().size()); }
+  // What the const Get<T>() returns for a type the value does not hold.
+  template <typename T>
+  static const T &Empty();
 
-  bool operator==(const tinygltf::Value &other) const;
+  // What the non-const Get<T>() returns for a type the value does not hold
+  // when asserts are off: an empty T owned by the calling thread, cleared
+  // on every call.
+  template <typename T>
+  static T &Scratch();
 
- protected:
-  int type_ = NULL_TYPE;
+  void Take(Value &other) noexcept {
+    type_ = other.type_;
+    boolean_value_ = other.boolean_value_;
+    int_value_ = other.int_value_;
+    std::memcpy(&real_value_, &other.real_value_, sizeof(real_value_));
+    other.type_ = NULL_TYPE;
+    other.boolean_value_ = false;
+    other.int_value_ = 0;
+    other.real_value_ = 0.0;
+  }
+  void Release() noexcept;
 
-  int int_value_ = 0;
-  double real_value_ = 0.0;
-  std::string string_value_;
-  std::vector<unsigned char> binary_value_;
-  Array array_value_;
-  Object object_value_;
+  unsigned char type_ = NULL_TYPE;
   bool boolean_value_ = false;
+  int int_value_ = 0;
+  union {
+    double real_value_ = 0.0;  // also set for INT_TYPE
+    std::string *string_value_;
+    std::vector<unsigned char> *binary_value_;
+    Array *array_value_;
+    Object *object_value_;
+  };
 };
 
+///
+/// Members of an object Value, iterated in key order like the
+/// std::map<std::string, Value> it replaces, so serialized output is
+/// unchanged. The object itself is a flat array of pointers to its members
+/// sorted by key, with room for kInlineCapacity of them without an
+/// allocation. The (key, value) pairs live in slabs owned by the object
+/// that never move, so as with std::map a reference to a member stays valid
+/// across inserts and erases of other members and across moves of the
+/// object. An empty object is as small as an empty std::map. Keeps the
+/// std::map interface (find, count, at, operator[], insert, emplace, erase,
+/// iteration) for source compatibility.
+///
+class ValueObject
+    : private ModelVector<std::pair<const ValueKey, Value> *>::allocator_type {
+ public:
+  typedef ValueKey key_type;
+  typedef Value mapped_type;
+  typedef std::pair<const ValueKey, Value> value_type;
+  typedef size_t size_type;
+  typedef ModelVector<value_type *>::allocator_type allocator_type;
+
+  // Walks the sorted pointer array
+  template <typename T>
+  class Iterator {
+   public:
+    typedef std::bidirectional_iterator_tag iterator_category;
+    typedef ValueObject::value_type value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef T *pointer;
+    typedef T &reference;
+
+    Iterator() = default;
+    template <typename U, typename = typename std::enable_if<
+                              std::is_convertible<U *, T *>::value>::type>
+    Iterator(const Iterator<U> &other) : slot_(other.slot_) {}
+
+    T &operator*() const { return **slot_; }
+    T *operator->() const { return *slot_; }
+    Iterator &operator++() {
+      ++slot_;
+      return *this;
+    }
+    Iterator operator++(int) { return Iterator(slot_++); }
+    Iterator &operator--() {
+      --slot_;
+      return *this;
+    }
+    Iterator operator--(int) { return Iterator(slot_--); }
+    template <typename U>
+    bool operator==(const Iterator<U> &other) const {
+      return slot_ == other.slot_;
+    }
+    template <typename U>
+    bool operator!=(const Iterator<U> &other) const {
+      return slot_ != other.slot_;
+    }
+
+   private:
+    friend class ValueObject;
+    template <typename>
+    friend class Iterator;
+    explicit Iterator(ValueObject::value_type *const *slot) : slot_(slot) {}
+
+    ValueObject::value_type *const *slot_ = nullptr;
+  };
+  typedef Iterator<value_type> iterator;
+  typedef Iterator<const value_type> const_iterator;
+
+  static const size_t kInlineCapacity = 4;
+
+  ValueObject() {}
+  ValueObject(std::initializer_list<value_type> values);
+  template <typename Compare, typename Alloc>
+  ValueObject(const std::map<std::string, Value, Compare, Alloc> &map) {
+    reserve(map.size());
+    for (const auto &member : map) emplace(member.first, member.second);
+  }
+  ValueObject(const ValueObject &other);
+  ValueObject(ValueObject &&other) noexcept;
+  ValueObject &operator=(const ValueObject &other);
+  ValueObject &operator=(ValueObject &&other) noexcept;
+  ~ValueObject() { Free(); }
+
+  iterator begin() { return iterator(Data()); }
+  iterator end() { return iterator(Data() + size_); }
+  const_iterator begin() const { return const_iterator(Data()); }
+  const_iterator end() const { return const_iterator(Data() + size_); }
+  const_iterator cbegin() const { return begin(); }
+  const_iterator cend() const { return end(); }
+
+  size_type size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  size_type capacity() const { return capacity_; }
+  void clear();
+  void reserve(size_type n);
+  allocator_type get_allocator() const { return *this; }
+
+  iterator find(const std::string &key) {
+    return iterator(Data() + Find(key));
+  }
+  const_iterator find(const std::string &key) const {
+    return const_iterator(Data() + Find(key));
+  }
+  size_type count(const std::string &key) const {
+    return Find(key) != size_ ? 1 : 0;
+  }
+
+  /// Like std::map::at(), throws std::out_of_range when `key` is absent
+  /// (asserts when exceptions are disabled).
+  Value &at(const std::string &key);
+  const Value &at(const std::string &key) const;
+
+  Value &operator[](const std::string &key) {
+    return emplace(key).first->second;
+  }
+  Value &operator[](std::string &&key) {
+    return emplace(std::move(key)).first->second;
+  }
+  Value &operator[](const char *key) { return emplace(key).first->second; }
+  Value &operator[](const ValueKey &key) { return emplace(key).first->second; }
+
+  std::pair<iterator, bool> insert(const value_type &value) {
+    return emplace(value.first, value.second);
+  }
+  std::pair<iterator, bool> insert(value_type &&value) {
+    return emplace(value.first, std::move(value.second));
+  }
+  template <typename K, typename... Args>
+  std::pair<iterator, bool> emplace(K &&key, Args &&...args) {
+    const size_t pos = LowerBound(key);
+    if (pos < size_ && Data()[pos]->first == key) {
+      return std::make_pair(iterator(Data() + pos), false);
+    }
+    value_type *member = ::new (Allocate())
+        value_type(ValueKey(std::forward<K>(key)),
+                   Value(std::forward<Args>(args)...));
+    return std::make_pair(InsertAt(pos, member), true);
+  }
+
+  size_type erase(const std::string &key);
+  iterator erase(const_iterator pos);
+
+  bool operator==(const ValueObject &other) const;
+  bool operator!=(const ValueObject &other) const {
+    return !(*this == other);
+  }
+
+ private:
+  // A member's storage; on the free list once its member is erased
+  union Slot {
+    Slot *next_free;
+    typename std::aligned_storage<sizeof(value_type),
+                                  alignof(value_type)>::type storage;
+  };
+  // Header of a block of slots, followed by the slots themselves. The
+  // newest slab also holds the object's free list.
+  struct Slab {
+    Slab *next;
+    uint32_t capacity;
+    uint32_t used;
+    Slot *free;
+  };
+  static const size_t kHeaderSlots = (sizeof(Slab) + sizeof(Slot) - 1) /
+                                     sizeof(Slot);
+  typedef typename std::allocator_traits<allocator_type>::template rebind_alloc<
+      Slot>
+      SlotAllocator;
+  typedef std::allocator_traits<allocator_type> AllocTraits;
+
+  static Slot *Slots(Slab *slab) {
+    return reinterpret_cast<Slot *>(slab) + kHeaderSlots;
+  }
+  allocator_type &Alloc() { return *this; }
+  bool IsInline() const { return capacity_ == kInlineCapacity; }
+  value_type **Data() { return IsInline() ? inline_ : heap_; }
+  value_type *const *Data() const { return IsInline() ? inline_ : heap_; }
+  size_t LowerBound(const std::string &key) const;
+  size_t Find(const std::string &key) const;
+  void *Allocate();
+  void AddSlab(size_t capacity);
+  iterator InsertAt(size_t pos, value_type *member);
+  void Grow(size_t capacity);
+  void Free() noexcept;
+  void Steal(ValueObject &other) noexcept;
+
+  union {  // members sorted by key, inline up to kInlineCapacity
+    value_type *inline_[kInlineCapacity];
+    value_type **heap_;
+  };
+  uint32_t size_ = 0;
+  uint32_t capacity_ = kInlineCapacity;
+  Slab *slabs_ = nullptr;  // newest first
+};
+
+inline Value::Value(const Object &o) : type_(OBJECT_TYPE) {
+  object_value_ = new Object(o);
+}
+inline Value::Value(Object &&o) : type_(OBJECT_TYPE) {
+  object_value_ = new Object(std::move(o));
+}
+
+inline Value::Value(const Value &other)
+    : type_(other.type_),
+      boolean_value_(other.boolean_value_),
+      int_value_(other.int_value_) {
+  switch (type_) {
+    case STRING_TYPE:
+      string_value_ = new std::string(*other.string_value_);
+      break;
+    case BINARY_TYPE:
+      binary_value_ = new std::vector<unsigned char>(*other.binary_value_);
+      break;
+    case ARRAY_TYPE:
+      array_value_ = new Array(*other.array_value_);
+      break;
+    case OBJECT_TYPE:
+      object_value_ = new Object(*other.object_value_);
+      break;
+    default:
+      real_value_ = other.real_value_;
+      break;
+  }
+}
+
+inline Value &Value::operator=(const Value &other) {
+  if (this != &other) *this = Value(other);
+  return *this;
+}
+
+inline void Value::Release() noexcept {
+  switch (type_) {
+    case STRING_TYPE:
+      delete string_value_;
+      break;
+    case BINARY_TYPE:
+      delete binary_value_;
+      break;
+    case ARRAY_TYPE:
+      delete array_value_;
+      break;
+    case OBJECT_TYPE:
+      delete object_value_;
+      break;
+    default:
+      break;
+  }
+  type_ = NULL_TYPE;
+  real_value_ = 0.0;
+}
+
+inline const Value &Value::Get(const std::string &key) const {
+  assert(IsObject());
+  if (!IsObject()) return Null();
+  Object::const_iterator it = object_value_->find(key);
+  return (it != object_value_->end()) ? it->second : Null();
+}
+
+inline bool Value::Has(const std::string &key) const {
+  if (!IsObject()) return false;
+  return object_value_->find(key) != object_value_->end();
+}
+
+inline std::vector<std::string> Value::Keys() const {
+  std::vector<std::string> keys;
+  if (!IsObject()) return keys;  // empty
+  keys.reserve(object_value_->size());
+  for (const auto &member : *object_value_) keys.push_back(member.first);
+  return keys;
+}
+
+inline size_t Value::Size() const {
+  return IsArray() ? array_value_->size()
+                   : (IsObject() ? object_value_->size() : 0);
+}
+
+template <typename T>
+inline const T &Value::Empty() {
+#ifdef TINYGLTF_ENABLE_MODEL_ARENA
+  ModelArena::Scope heap(nullptr);  // the static must not pin an arena
+#endif
+  static const T empty{};
+  return empty;
+}
+
+template <typename T>
+inline T &Value::Scratch() {
+#ifdef TINYGLTF_ENABLE_MODEL_ARENA
+  ModelArena::Scope heap(nullptr);  // the static must not pin an arena
+#endif
+  static thread_local T scratch{};
+  scratch = T();
+  return scratch;
+}
+
 #ifdef __clang__
 #pragma clang diagnostic pop
 #endif
 
-#define TINYGLTF_VALUE_GET(ctype, var)            \
-  template <>                                     \
-  inline const ctype &Value::Get<ctype>() const { \
-    return var;                                   \
-  }                                               \
-  template <>                                     \
-  inline ctype &Value::Get<ctype>() {             \
-    return var;                                   \
-  }
-TINYGLTF_VALUE_GET(bool, boolean_value_)
-TINYGLTF_VALUE_GET(double, real_value_)
-TINYGLTF_VALUE_GET(int, int_value_)
-TINYGLTF_VALUE_GET(std::string, string_value_)
-TINYGLTF_VALUE_GET(std::vector<unsigned char>, binary_value_)
-TINYGLTF_VALUE_GET(Value::Array, array_value_)
-TINYGLTF_VALUE_GET(Value::Object, object_value_)
+#define TINYGLTF_VALUE_GET(ctype, type, var)                               \
+  template <>                                                              \
+  inline const ctype &Value::Get<ctype>() const {                          \
+    return type_ == type ? *var : Empty<ctype>();                          \
+  }                                                                        \
+  template <>                                                              \
+  inline ctype &Value::Get<ctype>() {                                      \
+    assert(type_ == type && "non-const Get<T>() on another type");         \
+    return type_ == type ? *var : Scratch<ctype>();                        \
+  }
+TINYGLTF_VALUE_GET(std::string, STRING_TYPE, string_value_)
+TINYGLTF_VALUE_GET(std::vector<unsigned char>, BINARY_TYPE, binary_value_)
+TINYGLTF_VALUE_GET(Value::Array, ARRAY_TYPE, array_value_)
+TINYGLTF_VALUE_GET(Value::Object, OBJECT_TYPE, object_value_)
 #undef TINYGLTF_VALUE_GET
 
+template <>
+inline const bool &Value::Get<bool>() const {
+  return boolean_value_;
+}
+template <>
+inline bool &Value::Get<bool>() {
+  return boolean_value_;
+}
+template <>
+inline const int &Value::Get<int>() const {
+  return int_value_;
+}
+template <>
+inline int &Value::Get<int>() {
+  return int_value_;
+}
+template <>
+inline const double &Value::Get<double>() const {
+  return IsNumber() ? real_value_ : Empty<double>();
+}
+template <>
+inline double &Value::Get<double>() {
+  assert(IsNumber() && "non-const Get<double>() on a Value of another type");
+  return IsNumber() ? real_value_ : Scratch<double>();
+}
+
 #ifdef __clang__
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wc++98-compat"
@@ -427,8 +1117,8 @@ struct Parameter {
   bool bool_value = false;
   bool has_number_value = false;
   std::string string_value;
-  std::vector<double> number_array;
-  std::map<std::string, double> json_double_value;
+  ModelVector<double> number_array;
+  ModelMap<std::string, double> json_double_value;
   double number_value = 0.0;
 
   // context sensitive methods. depending the type of the Parameter you are
@@ -512,8 +1202,8 @@ struct Parameter {
 #pragma clang diagnostic ignored "-Wpadded"
 #endif
 
-typedef std::map<std::string, Parameter> ParameterMap;
-typedef std::map<std::string, Value> ExtensionMap;
+typedef ModelMap<std::string, Parameter> ParameterMap;
+typedef Value::Object ExtensionMap;
 
 struct AnimationChannel {
   int sampler{-1};          // required
@@ -556,8 +1246,8 @@ struct AnimationSampler {
 
 struct Animation {
   std::string name;
-  std::vector<AnimationChannel> channels;
-  std::vector<AnimationSampler> samplers;
+  ModelVector<AnimationChannel> channels;
+  ModelVector<AnimationSampler> samplers;
   Value extras;
   ExtensionMap extensions;
 
@@ -574,7 +1264,7 @@ struct Skin {
   std::string name;
   int inverseBindMatrices{-1};  // required here but not in the spec
   int skeleton{-1};             // The index of the node used as a skeleton root
-  std::vector<int> joints;      // Indices of skeleton nodes
+  ModelVector<int> joints;      // Indices of skeleton nodes
 
   Value extras;
   ExtensionMap extensions;
@@ -646,6 +1336,12 @@ struct Image {
   // parsing).
   bool as_is{false};
 
+  // Lazy decoding (TinyGLTF::SetLazyImageDecoding): true until DecodeImage()
+  // fills `image`. `encoded` holds the compressed bytes of a `uri` image;
+  // `bufferView` images are decoded straight from their buffer.
+  bool decode_pending{false};
+  std::vector<unsigned char> encoded;
+
   Image() = default;
   DEFAULT_METHODS(Image)
 
@@ -728,7 +1424,7 @@ struct OcclusionTextureInfo {
 
 // pbrMetallicRoughness class defined in glTF 2.0 spec.
 struct PbrMetallicRoughness {
-  std::vector<double> baseColorFactor{1.0, 1.0, 1.0, 1.0};  // len = 4. default [1,1,1,1]
+  ModelVector<double> baseColorFactor{1.0, 1.0, 1.0, 1.0};  // len = 4. default [1,1,1,1]
   TextureInfo baseColorTexture;
   double metallicFactor{1.0};   // default 1
   double roughnessFactor{1.0};  // default 1
@@ -753,11 +1449,11 @@ struct PbrMetallicRoughness {
 struct Material {
   std::string name;
 
-  std::vector<double> emissiveFactor{0.0, 0.0, 0.0};  // length 3. default [0, 0, 0]
+  ModelVector<double> emissiveFactor{0.0, 0.0, 0.0};  // length 3. default [0, 0, 0]
   std::string alphaMode{"OPAQUE"}; // default "OPAQUE"
   double alphaCutoff{0.5};        // default 0.5
   bool doubleSided{false};        // default false
-  std::vector<int> lods;          // level of detail materials (MSFT_lod)
+  ModelVector<int> lods;          // level of detail materials (MSFT_lod)
 
   PbrMetallicRoughness pbrMetallicRoughness;
 
@@ -822,9 +1518,9 @@ struct Accessor {
   std::string extras_json_string;
   std::string extensions_json_string;
 
-  std::vector<double>
+  ModelVector<double>
       minValues;  // optional. integer value is promoted to double
-  std::vector<double>
+  ModelVector<double>
       maxValues;  // optional. integer value is promoted to double
 
   struct Sparse {
@@ -952,16 +1648,326 @@ struct Camera {
   std::string extensions_json_string;
 };
 
+///
+/// Standard vertex attribute semantics, interned so a primitive can look
+/// them up without comparing strings. Sets (TEXCOORD_n, COLOR_n, JOINTS_n,
+/// WEIGHTS_n) are interned for n < 8; other names, such as TEXCOORD_8 or
+/// application-specific "_FOO" semantics, are `Custom` and found by name.
+///
+enum class AttributeSemantic : unsigned char {
+  Position, Normal, Tangent,
+  TexCoord0, TexCoord1, TexCoord2, TexCoord3,
+  TexCoord4, TexCoord5, TexCoord6, TexCoord7,
+  Color0, Color1, Color2, Color3, Color4, Color5, Color6, Color7,
+  Joints0, Joints1, Joints2, Joints3, Joints4, Joints5, Joints6, Joints7,
+  Weights0, Weights1, Weights2, Weights3,
+  Weights4, Weights5, Weights6, Weights7,
+  Custom
+};
+
+/// Interned semantic of attribute `name`, or AttributeSemantic::Custom.
+AttributeSemantic InternAttributeSemantic(const std::string &name);
+
+/// Attribute name of `semantic` ("POSITION", "TEXCOORD_0", ...); an empty
+/// string for AttributeSemantic::Custom.
+const char *AttributeSemanticName(AttributeSemantic semantic);
+
+///
+/// Attribute name to accessor index table of a primitive or morph target,
+/// with the interface of the std::map<std::string, int> it replaces. The
+/// accessor indices of the interned semantics live in a fixed array indexed
+/// by AttributeSemantic, so find(AttributeSemantic), Get() and find() of a
+/// standard name neither compare strings nor allocate; the few custom names
+/// ("_FOO", "TEXCOORD_8") are kept in a small vector sorted by name.
+///
+/// Iteration visits the entries in name order, as the map did. Iterators
+/// refer to an Entry whose `first` and `second` are references to the name
+/// and the accessor index; the Entry itself lives in the iterator, so bind
+/// it with `const auto &` or `auto &` in a range for, not past the
+/// iterator. Indices of interned semantics stay put until the map is
+/// destroyed; inserting or erasing a custom name invalidates the iterators
+/// and references of the other custom names, so erase while iterating with
+/// `it = erase(it)`. map() and the std::map conversion build a map on
+/// demand.
+///
+/// \code
+/// auto it = prim.attributes.find(tinygltf::AttributeSemantic::Position);
+/// int normals = prim.attributes.Get(tinygltf::AttributeSemantic::Normal);
+/// \endcode
+///
+class AttributeMap {
+ public:
+  typedef ModelMap<std::string, int> map_type;
+  typedef std::string key_type;
+  typedef int mapped_type;
+  typedef std::pair<const std::string, int> value_type;
+  typedef size_t size_type;
+  typedef ModelVector<std::pair<std::string, int>>::allocator_type
+      allocator_type;
+
+  /// What an iterator refers to: the name and the accessor index of one
+  /// attribute.
+  template <typename Index>
+  struct Entry {
+    const std::string &first;
+    Index &second;
+  };
+
+  template <typename Index>
+  class Iterator {
+    typedef typename std::conditional<std::is_const<Index>::value,
+                                      const AttributeMap, AttributeMap>::type
+        Map;
+
+   public:
+    typedef std::input_iterator_tag iterator_category;
+    typedef AttributeMap::value_type value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const Entry<Index> &reference;
+    typedef const Entry<Index> *pointer;
+
+    Iterator() = default;
+    Iterator(const Iterator &other)
+        : map_(other.map_), rank_(other.rank_), custom_(other.custom_) {}
+    Iterator &operator=(const Iterator &other) {
+      map_ = other.map_;
+      rank_ = other.rank_;
+      custom_ = other.custom_;
+      return *this;
+    }
+    /// A const_iterator from an iterator.
+    template <typename Other,
+              typename std::enable_if<
+                  std::is_same<const Other, Index>::value &&
+                      !std::is_same<Other, Index>::value,
+                  int>::type = 0>
+    Iterator(const Iterator<Other> &other)
+        : map_(other.map_), rank_(other.rank_), custom_(other.custom_) {}
+
+    reference operator*() const {
+      const std::string *name;
+      Index *index;
+      if (OnSemantic()) {
+        const AttributeSemantic semantic = SemanticAt(rank_);
+        name = &Key(semantic);
+        index = &map_->indices_[size_t(semantic)];
+      } else {
+        name = &map_->custom_[custom_].first;
+        index = &map_->custom_[custom_].second;
+      }
+      return *::new (entry_) Entry<Index>{*name, *index};
+    }
+    pointer operator->() const { return &**this; }
+
+    Iterator &operator++() {
+      if (custom_ == kUnresolved) {
+        custom_ = map_->CustomLowerBound(Key(SemanticAt(rank_)));
+      }
+      if (OnSemantic()) {
+        rank_ = map_->NextRank(rank_ + 1);
+      } else {
+        ++custom_;
+      }
+      return *this;
+    }
+    Iterator operator++(int) {
+      Iterator old(*this);
+      ++*this;
+      return old;
+    }
+
+    friend bool operator==(const Iterator &a, const Iterator &b) {
+      const bool semantic = a.OnSemantic();
+      if (semantic != b.OnSemantic()) return false;
+      return semantic ? a.rank_ == b.rank_ : a.custom_ == b.custom_;
+    }
+    friend bool operator!=(const Iterator &a, const Iterator &b) {
+      return !(a == b);
+    }
+
+   private:
+    friend class AttributeMap;
+    template <typename>
+    friend class Iterator;
+
+    Iterator(Map *map, size_t rank, size_t custom)
+        : map_(map),
+          rank_(static_cast<unsigned char>(rank)),
+          custom_(static_cast<uint32_t>(custom)) {}
+
+    // Whether the entry is the interned semantic at rank_ rather than the
+    // custom name at custom_. Both are the next in name order of their kind.
+    bool OnSemantic() const {
+      if (rank_ == kSemanticCount) return false;
+      if (custom_ == kUnresolved || custom_ == map_->custom_.size()) {
+        return true;
+      }
+      return Key(SemanticAt(rank_)) < map_->custom_[custom_].first;
+    }
+
+    Map *map_{nullptr};
+    unsigned char rank_{kSemanticCount};  // position in name order
+    // Index into custom_, or kUnresolved for an iterator to an interned
+    // semantic made by find(), whose place among the custom names is only
+    // looked up when it is incremented.
+    uint32_t custom_{0};
+    alignas(Entry<Index>) mutable unsigned char entry_[sizeof(Entry<Index>)];
+  };
+
+  typedef Iterator<int> iterator;
+  typedef Iterator<const int> const_iterator;
+
+  AttributeMap() = default;
+  AttributeMap(std::initializer_list<value_type> values) { insert(values); }
+  template <typename Compare, typename Alloc>
+  AttributeMap(const std::map<std::string, int, Compare, Alloc> &map) {
+    insert(map.begin(), map.end());
+  }
+
+  template <typename Compare, typename Alloc>
+  operator std::map<std::string, int, Compare, Alloc>() const {
+    std::map<std::string, int, Compare, Alloc> map;
+    for (const auto &entry : *this) {
+      map.emplace_hint(map.end(), entry.first, entry.second);
+    }
+    return map;
+  }
+
+  /// The entries as a map, built on each call.
+  map_type map() const { return *this; }
+
+  iterator begin() { return iterator(this, NextRank(0), 0); }
+  iterator end() { return iterator(this, kSemanticCount, custom_.size()); }
+  const_iterator begin() const {
+    return const_iterator(this, NextRank(0), 0);
+  }
+  const_iterator end() const {
+    return const_iterator(this, kSemanticCount, custom_.size());
+  }
+  const_iterator cbegin() const { return begin(); }
+  const_iterator cend() const { return end(); }
+
+  size_type size() const {
+    size_type n = custom_.size();
+    for (uint64_t bits = present_; bits != 0; bits &= bits - 1) ++n;
+    return n;
+  }
+  bool empty() const { return present_ == 0 && custom_.empty(); }
+  allocator_type get_allocator() const { return custom_.get_allocator(); }
+
+  iterator find(AttributeSemantic semantic) {
+    if (!Has(semantic)) return end();
+    return iterator(this, RankOf(semantic), kUnresolved);
+  }
+  const_iterator find(AttributeSemantic semantic) const {
+    return const_cast<AttributeMap *>(this)->find(semantic);
+  }
+  iterator find(const std::string &name);
+  const_iterator find(const std::string &name) const {
+    return const_cast<AttributeMap *>(this)->find(name);
+  }
+  size_type count(const std::string &name) const {
+    return find(name) != end() ? 1 : 0;
+  }
+
+  /// Accessor index of `semantic`, or -1 when the attribute is absent.
+  int Get(AttributeSemantic semantic) const {
+    return Has(semantic) ? indices_[size_t(semantic)] : -1;
+  }
+
+  /// Like std::map::at(), throws std::out_of_range when `name` is absent
+  /// (asserts when exceptions are disabled).
+  int &at(const std::string &name);
+  const int &at(const std::string &name) const {
+    return const_cast<AttributeMap *>(this)->at(name);
+  }
+
+  int &operator[](const std::string &name);
+  int &operator[](AttributeSemantic semantic) {
+    assert(semantic != AttributeSemantic::Custom);
+    present_ |= uint64_t(1) << size_t(semantic);
+    return indices_[size_t(semantic)];
+  }
+
+  std::pair<iterator, bool> insert(const value_type &value);
+  template <typename InputIt>
+  void insert(InputIt first, InputIt last) {
+    for (; first != last; ++first) {
+      insert(value_type(first->first, first->second));
+    }
+  }
+  void insert(std::initializer_list<value_type> values) {
+    insert(values.begin(), values.end());
+  }
+  template <typename... Args>
+  std::pair<iterator, bool> emplace(Args &&... args) {
+    return insert(value_type(std::forward<Args>(args)...));
+  }
+
+  iterator erase(const_iterator pos);
+  iterator erase(iterator pos) { return erase(const_iterator(pos)); }
+  size_type erase(const std::string &name) {
+    iterator it = find(name);
+    if (it == end()) return 0;
+    erase(it);
+    return 1;
+  }
+  void clear() {
+    present_ = 0;
+    std::fill(indices_, indices_ + kSemanticCount, 0);
+    custom_.clear();
+  }
+  void swap(AttributeMap &other) {
+    std::swap(present_, other.present_);
+    std::swap_ranges(indices_, indices_ + kSemanticCount, other.indices_);
+    custom_.swap(other.custom_);
+  }
+
+  bool operator==(const AttributeMap &other) const {
+    return present_ == other.present_ &&
+           std::equal(indices_, indices_ + kSemanticCount, other.indices_) &&
+           custom_ == other.custom_;
+  }
+  bool operator!=(const AttributeMap &other) const {
+    return !(*this == other);
+  }
+
+ private:
+  static const unsigned char kSemanticCount =
+      static_cast<unsigned char>(AttributeSemantic::Custom);
+  static const uint32_t kUnresolved = 0xffffffffu;
+
+  // The interned semantics in name order ("COLOR_0" first, "WEIGHTS_7"
+  // last), the position of one in it, and its name.
+  static AttributeSemantic SemanticAt(size_t rank);
+  static size_t RankOf(AttributeSemantic semantic);
+  static const std::string &Key(AttributeSemantic semantic);
+
+  bool Has(AttributeSemantic semantic) const {
+    return semantic != AttributeSemantic::Custom &&
+           ((present_ >> size_t(semantic)) & 1) != 0;
+  }
+  // Rank of the first semantic present at or after `rank`.
+  size_t NextRank(size_t rank) const;
+  // Position of the first custom name not less than `name`.
+  size_t CustomLowerBound(const std::string &name) const;
+  // Iterator to the custom name at `custom`.
+  iterator CustomAt(size_t custom);
+
+  uint64_t present_{0};  // bit n: AttributeSemantic(n) is present
+  int indices_[kSemanticCount] = {};  // 0 when absent
+  ModelVector<std::pair<std::string, int>> custom_;  // sorted by name
+};
+
 struct Primitive {
-  std::map<std::string, int> attributes;  // (required) A dictionary object of
-                                          // integer, where each integer
-                                          // is the index of the accessor
-                                          // containing an attribute.
+  AttributeMap attributes;  // (required) A dictionary object of integer,
+                            // where each integer is the index of the
+                            // accessor containing an attribute.
   int material{-1};  // The index of the material to apply to this primitive
                      // when rendering.
   int indices{-1};   // The index of the accessor that contains the indices.
   int mode{-1};      // one of TINYGLTF_MODE_***
-  std::vector<std::map<std::string, int> > targets;  // array of morph targets,
+  ModelVector<AttributeMap> targets;  // array of morph targets,
   // where each target is a dict with attributes in ["POSITION, "NORMAL",
   // "TANGENT"] pointing
   // to their corresponding accessors
@@ -979,8 +1985,8 @@ struct Primitive {
 
 struct Mesh {
   std::string name;
-  std::vector<Primitive> primitives;
-  std::vector<double> weights;  // weights to be applied to the Morph Targets
+  ModelVector<Primitive> primitives;
+  ModelVector<double> weights;  // weights to be applied to the Morph Targets
   ExtensionMap extensions;
   Value extras;
 
@@ -1008,13 +2014,13 @@ class Node {
   int mesh{-1};
   int light{-1};    // light source index (KHR_lights_punctual)
   int emitter{-1};  // audio emitter index (KHR_audio)
-  std::vector<int> lods; // level of detail nodes (MSFT_lod)
-  std::vector<int> children;
-  std::vector<double> rotation;     // length must be 0 or 4
-  std::vector<double> scale;        // length must be 0 or 3
-  std::vector<double> translation;  // length must be 0 or 3
-  std::vector<double> matrix;       // length must be 0 or 16
-  std::vector<double> weights;  // The weights of the instantiated Morph Target
+  ModelVector<int> lods; // level of detail nodes (MSFT_lod)
+  ModelVector<int> children;
+  ModelVector<double> rotation;     // length must be 0 or 4
+  ModelVector<double> scale;        // length must be 0 or 3
+  ModelVector<double> translation;  // length must be 0 or 3
+  ModelVector<double> matrix;       // length must be 0 or 16
+  ModelVector<double> weights;  // The weights of the instantiated Morph Target
 
   ExtensionMap extensions;
   Value extras;
@@ -1027,6 +2033,13 @@ class Node {
 struct Buffer {
   std::string name;
   std::vector<unsigned char> data;
+  // Set instead of `data` for the GLB BIN chunk when the file was loaded with
+  // TinyGLTF::SetMemoryMapBinary(true): a read-only view into the mapped file.
+  // `mapped_file` owns the mapping, so the view stays valid for as long as
+  // any copy of this Buffer (or its Model) is alive.
+  const unsigned char *mapped_data = nullptr;
+  size_t mapped_size = 0;
+  std::shared_ptr<const void> mapped_file;
   std::string
       uri;  // considered as required here but not in the spec (need to clarify)
             // uri is not decoded(e.g. whitespace may be represented as %20)
@@ -1040,6 +2053,12 @@ struct Buffer {
   Buffer() = default;
   DEFAULT_METHODS(Buffer)
   bool operator==(const Buffer &) const;
+
+  // Buffer contents, whether owned (`data`) or mapped (`mapped_data`).
+  const unsigned char *Data() const {
+    return mapped_data ? mapped_data : data.data();
+  }
+  size_t Size() const { return mapped_data ? mapped_size : data.size(); }
 };
 
 struct Asset {
@@ -1061,8 +2080,8 @@ struct Asset {
 
 struct Scene {
   std::string name;
-  std::vector<int> nodes;
-  std::vector<int> audioEmitters;  // KHR_audio global emitters
+  ModelVector<int> nodes;
+  ModelVector<int> audioEmitters;  // KHR_audio global emitters
 
   ExtensionMap extensions;
   Value extras;
@@ -1094,7 +2113,7 @@ struct SpotLight {
 
 struct Light {
   std::string name;
-  std::vector<double> color;
+  ModelVector<double> color;
   double intensity{1.0};
   std::string type;
   double range{0.0};  // 0.0 = infinite
@@ -1166,74 +2185,753 @@ struct AudioEmitter {
 
   bool operator==(const AudioEmitter &) const;
 
-  ExtensionMap extensions;
-  Value extras;
+  ExtensionMap extensions;
+  Value extras;
+
+  // Filled when SetStoreOriginalJSONForExtrasAndExtensions is enabled.
+  std::string extras_json_string;
+  std::string extensions_json_string;
+};
+
+struct AudioSource {
+  std::string name;
+  std::string uri;
+  int bufferView{-1};  // (required if no uri)
+  std::string
+      mimeType;  // (required if no uri) The audio's MIME type. Required if
+                 // bufferView is defined. Unless specified by another
+                 // extension, the only supported mimeType is audio/mpeg.
+
+  AudioSource() = default;
+  DEFAULT_METHODS(AudioSource)
+
+  bool operator==(const AudioSource &) const;
+
+  Value extras;
+  ExtensionMap extensions;
+
+  // Filled when SetStoreOriginalJSONForExtrasAndExtensions is enabled.
+  std::string extras_json_string;
+  std::string extensions_json_string;
+};
+
+struct LazyImageDecoder;
+
+class Model {
+ public:
+  Model() = default;
+  DEFAULT_METHODS(Model)
+
+  bool operator==(const Model &) const;
+
+  ModelVector<Accessor> accessors;
+  ModelVector<Animation> animations;
+  ModelVector<Buffer> buffers;
+  ModelVector<BufferView> bufferViews;
+  ModelVector<Material> materials;
+  ModelVector<Mesh> meshes;
+  ModelVector<Node> nodes;
+  ModelVector<Texture> textures;
+  ModelVector<Image> images;
+  ModelVector<Skin> skins;
+  ModelVector<Sampler> samplers;
+  ModelVector<Camera> cameras;
+  ModelVector<Scene> scenes;
+  ModelVector<Light> lights;
+  ModelVector<AudioEmitter> audioEmitters;
+  ModelVector<AudioSource> audioSources;
+
+  int defaultScene{-1};
+  ModelVector<std::string> extensionsUsed;
+  ModelVector<std::string> extensionsRequired;
+
+  Asset asset;
+
+  Value extras;
+  ExtensionMap extensions;
+
+  // Filled when SetStoreOriginalJSONForExtrasAndExtensions is enabled.
+  std::string extras_json_string;
+  std::string extensions_json_string;
+
+  // Set by a load with lazy image decoding; used by DecodeImage().
+  std::shared_ptr<LazyImageDecoder> image_decoder;
+};
+
+///
+/// Decodes `model->images[image]` when it was loaded with lazy image decoding
+/// and is still pending, using the image loader and options of that load.
+/// Safe to call concurrently for the same or different images of a model
+/// that is not otherwise being modified. Returns true when the image is
+/// decoded or had nothing to decode; on failure returns false with messages
+/// in `err`/`warn` and leaves the image pending.
+///
+bool DecodeImage(Model *model, int image, std::string *err = nullptr,
+                 std::string *warn = nullptr);
+
+///
+/// True while `model.images[image]` holds only compressed data (lazy image
+/// decoding). Safe to call concurrently with DecodeImage().
+///
+bool IsImageDecodePending(const Model &model, int image);
+
+///
+/// Returns true when `accessor` is a valid encoding for vertex attribute
+/// `semantic` (e.g. "POSITION", "TEXCOORD_0") in glTF 2.0, or in
+/// KHR_mesh_quantization when `quantized` is set. Application-specific
+/// semantics ("_FOO") are always accepted.
+///
+bool IsValidAttributeEncoding(const std::string &semantic,
+                              const Accessor &accessor, bool quantized);
+
+///
+/// Bulk conversion kernels behind AccessorView::CopyTo(), also usable
+/// directly by loaders. On x86-64 each call dispatches at runtime to an SSE2
+/// or AVX2 implementation (define TINYGLTF_NO_KERNEL_SIMD to build only the
+/// scalar code). Every path produces bit-identical results.
+///
+namespace kernels {
+
+enum class Isa { Scalar, SSE2, AVX2 };
+
+/// Best instruction set supported by both the build and the running CPU.
+Isa SupportedIsa();
+
+/// Instruction set the kernels currently dispatch to.
+Isa ActiveIsa();
+
+///
+/// Limits dispatch to `isa` or below, e.g. to compare paths in benchmarks.
+/// Returns the instruction set now in use. Not thread-safe against
+/// concurrent kernel calls.
+///
+Isa SetIsa(Isa isa);
+
+const char *IsaName(Isa isa);
+
+/// Zero-extends `count` 8-bit indices to 32 bits.
+void WidenU8ToU32(const uint8_t *src, size_t count, uint32_t *dst);
+
+/// Zero-extends `count` 16-bit indices to 32 bits.
+void WidenU16ToU32(const uint16_t *src, size_t count, uint32_t *dst);
+
+/// Copies `count` float3 elements, `stride` (>= 12) bytes apart, into a
+/// tightly packed array.
+void GatherFloat3(const unsigned char *src, size_t stride, size_t count,
+                  float *dst);
+
+///
+/// Component-wise min/max of `count` float3 elements `stride` (>= 12) bytes
+/// apart. With `count == 0`, `min` is +inf and `max` is -inf.
+///
+void BoundsFloat3(const unsigned char *src, size_t stride, size_t count,
+                  float min[3], float max[3]);
+
+///
+/// Converts `count` tightly packed normalized components of `componentType`
+/// (BYTE, UNSIGNED_BYTE, SHORT or UNSIGNED_SHORT) to float with the glTF 2.0
+/// rules. Returns false for any other component type.
+///
+bool NormalizedToFloat(const void *src, int componentType, size_t count,
+                       float *dst);
+
+/// Converts to IEEE 754 half precision, rounding to nearest even.
+void FloatToHalf(const float *src, size_t count, uint16_t *dst);
+
+///
+/// Counts the leading base64 digits of `src` into `digits` and returns the
+/// number of bytes they decode to. Decoding stops at '=' padding or at the
+/// first character outside the standard alphabet.
+///
+size_t Base64DecodedSize(const char *src, size_t len, size_t *digits);
+
+/// Decodes `digits` base64 digits, as counted by Base64DecodedSize(), to `dst`.
+void Base64Decode(const char *src, size_t digits, unsigned char *dst);
+
+/// Length of the padded base64 encoding of `count` bytes.
+size_t Base64EncodedSize(size_t count);
+
+/// Encodes `count` bytes as Base64EncodedSize(count) characters at `dst`.
+void Base64Encode(const unsigned char *src, size_t count, char *dst);
+
+}  // namespace kernels
+
+namespace detail {
+
+// Reads one stored component of type Src as Dst. Integer components read
+// into a floating point Dst follow the glTF normalization rules when
+// Normalized is set; every other combination is a plain conversion.
+template <typename Src, typename Dst, bool Normalized,
+          bool = Normalized && std::is_integral<Src>::value &&
+                 std::is_floating_point<Dst>::value>
+struct AccessorComponentReader {
+  static Dst Read(const unsigned char *p) {
+    Src v;
+    std::memcpy(&v, p, sizeof(Src));
+    return static_cast<Dst>(v);
+  }
+};
+
+template <typename Src, typename Dst, bool Normalized>
+struct AccessorComponentReader<Src, Dst, Normalized, true> {
+  static Dst Read(const unsigned char *p) {
+    Src v;
+    std::memcpy(&v, p, sizeof(Src));
+    Dst f = static_cast<Dst>(v) /
+            static_cast<Dst>((std::numeric_limits<Src>::max)());
+    return f < Dst(-1) ? Dst(-1) : f;
+  }
+};
+
+// Bytes between matrix columns: columns of 1- and 2-byte components start on
+// 4-byte boundaries (glTF 2.0, "Data Alignment").
+inline size_t AccessorColumnSize(size_t componentSize, int rows, int cols) {
+  size_t column = componentSize * size_t(rows);
+  return cols == 1 ? column : (column + 3) & ~size_t(3);
+}
+
+// Kernel-backed fast paths for the layouts that dominate load time (index
+// widening, float3 gathers, normalized attributes). Run() returns false when
+// the layout has no kernel and the generic loop must be used.
+template <typename Src, typename Dst, bool Normalized, int Rows, int Cols>
+struct AccessorBulkCopy {
+  static bool Run(const unsigned char *, size_t, size_t, Dst *) {
+    return false;
+  }
+};
+
+template <>
+struct AccessorBulkCopy<uint8_t, uint32_t, false, 1, 1> {
+  static bool Run(const unsigned char *src, size_t stride, size_t count,
+                  uint32_t *dst) {
+    if (stride != 1) return false;
+    kernels::WidenU8ToU32(src, count, dst);
+    return true;
+  }
+};
+
+template <>
+struct AccessorBulkCopy<uint16_t, uint32_t, false, 1, 1> {
+  static bool Run(const unsigned char *src, size_t stride, size_t count,
+                  uint32_t *dst) {
+    if (stride != 2 || reinterpret_cast<uintptr_t>(src) % 2) return false;
+    kernels::WidenU16ToU32(reinterpret_cast<const uint16_t *>(src), count,
+                           dst);
+    return true;
+  }
+};
+
+template <>
+struct AccessorBulkCopy<float, float, false, 3, 1> {
+  static bool Run(const unsigned char *src, size_t stride, size_t count,
+                  float *dst) {
+    if (stride < 12) return false;
+    kernels::GatherFloat3(src, stride, count, dst);
+    return true;
+  }
+};
+
+template <typename Src, int ComponentType, int Rows>
+struct AccessorBulkNormalized {
+  static bool Run(const unsigned char *src, size_t stride, size_t count,
+                  float *dst) {
+    if (stride != sizeof(Src) * Rows) return false;
+    return kernels::NormalizedToFloat(src, ComponentType, count * Rows, dst);
+  }
+};
+
+template <int Rows>
+struct AccessorBulkCopy<int8_t, float, true, Rows, 1>
+    : AccessorBulkNormalized<int8_t, TINYGLTF_COMPONENT_TYPE_BYTE, Rows> {};
+template <int Rows>
+struct AccessorBulkCopy<uint8_t, float, true, Rows, 1>
+    : AccessorBulkNormalized<uint8_t, TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE,
+                             Rows> {};
+template <int Rows>
+struct AccessorBulkCopy<int16_t, float, true, Rows, 1>
+    : AccessorBulkNormalized<int16_t, TINYGLTF_COMPONENT_TYPE_SHORT, Rows> {};
+template <int Rows>
+struct AccessorBulkCopy<uint16_t, float, true, Rows, 1>
+    : AccessorBulkNormalized<uint16_t, TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT,
+                             Rows> {};
+
+// Converts `count` Rows x Cols elements, `stride` bytes apart, into tightly
+// packed Dst components.
+template <typename Src, typename Dst, bool Normalized, int Rows, int Cols>
+void CopyAccessorElements(const unsigned char *src, size_t stride,
+                          size_t count, Dst *dst) {
+  if (std::is_same<Src, Dst>::value && Cols == 1 &&
+      stride == sizeof(Src) * Rows) {
+    if (count) std::memcpy(dst, src, count * stride);
+    return;
+  }
+  if (AccessorBulkCopy<Src, Dst, Normalized, Rows, Cols>::Run(src, stride,
+                                                                count, dst)) {
+    return;
+  }
+  const size_t column = AccessorColumnSize(sizeof(Src), Rows, Cols);
+  for (size_t i = 0; i < count; ++i, src += stride) {
+    for (int c = 0; c < Cols; ++c) {
+      const unsigned char *p = src + size_t(c) * column;
+      for (int r = 0; r < Rows; ++r, p += sizeof(Src)) {
+        *dst++ = AccessorComponentReader<Src, Dst, Normalized>::Read(p);
+      }
+    }
+  }
+}
+
+template <typename Dst>
+struct AccessorKernels {
+  typedef void (*CopyFn)(const unsigned char *, size_t, size_t, Dst *);
+  typedef Dst (*ReadFn)(const unsigned char *);
+
+  template <typename Src, bool Normalized>
+  static CopyFn SelectCopy(int type) {
+    switch (type) {
+      case TINYGLTF_TYPE_SCALAR:
+        return &CopyAccessorElements<Src, Dst, Normalized, 1, 1>;
+      case TINYGLTF_TYPE_VEC2:
+        return &CopyAccessorElements<Src, Dst, Normalized, 2, 1>;
+      case TINYGLTF_TYPE_VEC3:
+        return &CopyAccessorElements<Src, Dst, Normalized, 3, 1>;
+      case TINYGLTF_TYPE_VEC4:
+        return &CopyAccessorElements<Src, Dst, Normalized, 4, 1>;
+      case TINYGLTF_TYPE_MAT2:
+        return &CopyAccessorElements<Src, Dst, Normalized, 2, 2>;
+      case TINYGLTF_TYPE_MAT3:
+        return &CopyAccessorElements<Src, Dst, Normalized, 3, 3>;
+      case TINYGLTF_TYPE_MAT4:
+        return &CopyAccessorElements<Src, Dst, Normalized, 4, 4>;
+      default:
+        return nullptr;
+    }
+  }
+
+  template <typename Src>
+  static bool Select(int type, bool normalized, CopyFn *copy, ReadFn *read) {
+    if (normalized && std::is_integral<Src>::value && sizeof(Src) < 4) {
+      *copy = SelectCopy<Src, true>(type);
+      *read = &AccessorComponentReader<Src, Dst, true>::Read;
+    } else {
+      *copy = SelectCopy<Src, false>(type);
+      *read = &AccessorComponentReader<Src, Dst, false>::Read;
+    }
+    return *copy != nullptr;
+  }
+
+  // Picks the converters for one (componentType, type, normalized) triple;
+  // returns false when either is not a glTF accessor encoding.
+  static bool Select(int componentType, int type, bool normalized,
+                     CopyFn *copy, ReadFn *read) {
+    switch (componentType) {
+      case TINYGLTF_COMPONENT_TYPE_BYTE:
+        return Select<int8_t>(type, normalized, copy, read);
+      case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+        return Select<uint8_t>(type, normalized, copy, read);
+      case TINYGLTF_COMPONENT_TYPE_SHORT:
+        return Select<int16_t>(type, normalized, copy, read);
+      case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+        return Select<uint16_t>(type, normalized, copy, read);
+      case TINYGLTF_COMPONENT_TYPE_INT:
+        return Select<int32_t>(type, normalized, copy, read);
+      case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
+        return Select<uint32_t>(type, normalized, copy, read);
+      case TINYGLTF_COMPONENT_TYPE_FLOAT:
+        return Select<float>(type, normalized, copy, read);
+      case TINYGLTF_COMPONENT_TYPE_DOUBLE:
+        return Select<double>(type, normalized, copy, read);
+      default:
+        return false;
+    }
+  }
+};
+
+}  // namespace detail
+
+class SparseAccessorCache;
+
+///
+/// Typed, read-only view of an accessor that converts its components to `T`
+/// on access, without copying the buffer. Handles byteStride, matrix column
+/// padding, normalized integers (applied when `T` is a floating point type)
+/// and sparse accessors. The converters for the accessor's
+/// (componentType, type) pair are chosen once in Init(), so element access
+/// and CopyTo() do not switch per element.
+///
+/// The view points into `model`'s buffers and is invalidated with them.
+///
+/// \code
+/// tinygltf::AccessorView<float> positions;
+/// if (positions.Init(model, prim.attributes.at("POSITION"), &err)) {
+///   std::vector<float> xyz(positions.size() * 3);
+///   positions.CopyTo(xyz.data());
+///   float y1 = positions[1][1];
+/// }
+/// \endcode
+///
+template <typename T>
+class AccessorView {
+ public:
+  /// One element (vector or matrix); components in glTF (column-major) order.
+  class Element {
+   public:
+    Element(const AccessorView *view, size_t index)
+        : view_(view), index_(index) {}
+    T operator[](int component) const { return view_->Get(index_, component); }
+    int size() const { return view_->NumComponents(); }
+    size_t index() const { return index_; }
+    /// First component; handy for SCALAR accessors such as indices.
+    operator T() const { return view_->Get(index_, 0); }
+
+   private:
+    const AccessorView *view_;
+    size_t index_;
+  };
+
+  class const_iterator {
+   public:
+    typedef std::random_access_iterator_tag iterator_category;
+    typedef Element value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const Element *pointer;
+    typedef Element reference;
+
+    const_iterator() = default;
+    const_iterator(const AccessorView *view, size_t index)
+        : view_(view), index_(index) {}
+
+    Element operator*() const { return Element(view_, index_); }
+    Element operator[](difference_type n) const {
+      return Element(view_, size_t(difference_type(index_) + n));
+    }
+    const_iterator &operator++() {
+      ++index_;
+      return *this;
+    }
+    const_iterator operator++(int) {
+      const_iterator it = *this;
+      ++index_;
+      return it;
+    }
+    const_iterator &operator--() {
+      --index_;
+      return *this;
+    }
+    const_iterator operator--(int) {
+      const_iterator it = *this;
+      --index_;
+      return it;
+    }
+    const_iterator &operator+=(difference_type n) {
+      index_ = size_t(difference_type(index_) + n);
+      return *this;
+    }
+    const_iterator &operator-=(difference_type n) { return *this += -n; }
+    const_iterator operator+(difference_type n) const {
+      return const_iterator(*this) += n;
+    }
+    const_iterator operator-(difference_type n) const {
+      return const_iterator(*this) += -n;
+    }
+    difference_type operator-(const const_iterator &o) const {
+      return difference_type(index_) - difference_type(o.index_);
+    }
+    bool operator==(const const_iterator &o) const { return index_ == o.index_; }
+    bool operator!=(const const_iterator &o) const { return index_ != o.index_; }
+    bool operator<(const const_iterator &o) const { return index_ < o.index_; }
+    bool operator>(const const_iterator &o) const { return index_ > o.index_; }
+    bool operator<=(const const_iterator &o) const { return index_ <= o.index_; }
+    bool operator>=(const const_iterator &o) const { return index_ >= o.index_; }
+
+   private:
+    const AccessorView *view_{nullptr};
+    size_t index_{0};
+  };
+
+  ///
+  /// Binds the view to `model.accessors[accessor]`. Returns false with a
+  /// message in `err` when the accessor is out of range, uses an unknown
+  /// componentType/type, runs past its bufferView or buffer, or has sparse
+  /// indices that are out of range or not strictly increasing.
+  ///
+  bool Init(const Model &model, int accessor, std::string *err = nullptr);
+
+  ///
+  /// As above, but a sparse accessor reads from its dense copy in `cache`
+  /// (built on first use), so element access needs no index search and
+  /// Data() includes the sparse substitutions.
+  ///
+  bool Init(const Model &model, int accessor, SparseAccessorCache *cache,
+            std::string *err = nullptr);
+
+  bool Valid() const { return copy_ != nullptr; }
+  size_t size() const { return count_; }
+  int NumComponents() const { return rows_ * cols_; }
+  bool IsSparse() const { return sparseCount_ != 0; }
+  /// Stored componentType, e.g. to take a float-only fast path on Data().
+  int ComponentType() const { return componentType_; }
+
+  /// Stored (unconverted) data and its stride, for consumers that upload the
+  /// accessor as-is. Null when the accessor has no bufferView. Sparse
+  /// substitutions are not applied to this data.
+  const unsigned char *Data() const { return data_; }
+  size_t ByteStride() const { return stride_; }
+
+  /// Component `component` of element `i`, converted to T. No bounds checks.
+  T Get(size_t i, int component = 0) const {
+    const unsigned char *p = data_ ? data_ + i * stride_ : nullptr;
+    size_t k;
+    if (sparseCount_ && FindSparse(i, &k)) {
+      p = sparseValues_ + k * elementSize_;
+    }
+    if (!p) return T(0);
+    const int col = component / rows_, row = component % rows_;
+    return read_(p + size_t(col) * columnSize_ +
+                 size_t(row) * componentSize_);
+  }
+
+  Element operator[](size_t i) const { return Element(this, i); }
+  const_iterator begin() const { return const_iterator(this, 0); }
+  const_iterator end() const { return const_iterator(this, count_); }
+
+  ///
+  /// Writes all `size() * NumComponents()` components to `out`, tightly
+  /// packed, with sparse substitutions applied.
+  ///
+  void CopyTo(T *out) const {
+    const size_t n = size_t(NumComponents());
+    if (data_) {
+      copy_(data_, stride_, count_, out);
+    } else {
+      for (size_t i = 0; i < count_ * n; ++i) out[i] = T(0);
+    }
+    for (size_t k = 0; k < sparseCount_; ++k) {
+      copy_(sparseValues_ + k * elementSize_, elementSize_, 1,
+            out + SparseIndex(k) * n);
+    }
+  }
+
+ private:
+  size_t SparseIndex(size_t k) const {
+    return size_t(sparseIndexRead_(sparseIndices_ + k * sparseIndexSize_));
+  }
+
+  // Sparse indices are strictly increasing (checked in Init).
+  bool FindSparse(size_t i, size_t *k) const {
+    size_t lo = 0, hi = sparseCount_;
+    while (lo < hi) {
+      size_t mid = lo + (hi - lo) / 2;
+      size_t v = SparseIndex(mid);
+      if (v == i) {
+        *k = mid;
+        return true;
+      }
+      if (v < i) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    return false;
+  }
 
-  // Filled when SetStoreOriginalJSONForExtrasAndExtensions is enabled.
-  std::string extras_json_string;
-  std::string extensions_json_string;
+  typename detail::AccessorKernels<T>::CopyFn copy_{nullptr};
+  typename detail::AccessorKernels<T>::ReadFn read_{nullptr};
+  const unsigned char *data_{nullptr};
+  size_t count_{0};
+  size_t stride_{0};
+  size_t componentSize_{0};
+  size_t columnSize_{0};
+  size_t elementSize_{0};
+  int componentType_{-1};
+  int rows_{1};
+  int cols_{1};
+
+  const unsigned char *sparseIndices_{nullptr};
+  const unsigned char *sparseValues_{nullptr};
+  size_t sparseCount_{0};
+  size_t sparseIndexSize_{0};
+  uint32_t (*sparseIndexRead_)(const unsigned char *){nullptr};
+
+  friend class SparseAccessorCache;
 };
 
-struct AudioSource {
-  std::string name;
-  std::string uri;
-  int bufferView{-1};  // (required if no uri)
-  std::string
-      mimeType;  // (required if no uri) The audio's MIME type. Required if
-                 // bufferView is defined. Unless specified by another
-                 // extension, the only supported mimeType is audio/mpeg.
-
-  AudioSource() = default;
-  DEFAULT_METHODS(AudioSource)
-
-  bool operator==(const AudioSource &) const;
+namespace detail {
 
-  Value extras;
-  ExtensionMap extensions;
+// Returns the `length` bytes at `byteOffset` into bufferView `index`, or null
+// when they do not fit in the view or its buffer.
+inline const unsigned char *AccessorBytes(const Model &model, int index,
+                                          size_t byteOffset, size_t length) {
+  if (index < 0 || size_t(index) >= model.bufferViews.size()) return nullptr;
+  const BufferView &view = model.bufferViews[size_t(index)];
+  if (view.buffer < 0 || size_t(view.buffer) >= model.buffers.size())
+    return nullptr;
+  const Buffer &buffer = model.buffers[size_t(view.buffer)];
+  // Subtractions only, so huge offsets or lengths cannot wrap around
+  if (length > view.byteLength || byteOffset > view.byteLength - length ||
+      view.byteLength > buffer.Size() ||
+      view.byteOffset > buffer.Size() - view.byteLength)
+    return nullptr;
+  return buffer.Data() + view.byteOffset + byteOffset;
+}
 
-  // Filled when SetStoreOriginalJSONForExtrasAndExtensions is enabled.
-  std::string extras_json_string;
-  std::string extensions_json_string;
-};
+}  // namespace detail
 
-class Model {
- public:
-  Model() = default;
-  DEFAULT_METHODS(Model)
+template <typename T>
+bool AccessorView<T>::Init(const Model &model, int accessor,
+                           std::string *err) {
+  *this = AccessorView();
+  if (accessor < 0 || size_t(accessor) >= model.accessors.size()) {
+    if (err) (*err) += "Invalid accessor index.\n";
+    return false;
+  }
+  const Accessor &acc = model.accessors[size_t(accessor)];
+  const std::string name = "accessor[" + std::to_string(accessor) + "]";
+
+  typename detail::AccessorKernels<T>::CopyFn copy = nullptr;
+  typename detail::AccessorKernels<T>::ReadFn read = nullptr;
+  const int numComponents = GetNumComponentsInType(uint32_t(acc.type));
+  const int componentSize =
+      GetComponentSizeInBytes(uint32_t(acc.componentType));
+  if (numComponents <= 0 || componentSize <= 0 ||
+      !detail::AccessorKernels<T>::Select(acc.componentType, acc.type,
+                                          acc.normalized, &copy, &read)) {
+    if (err) (*err) += name + " has an unsupported componentType or type.\n";
+    return false;
+  }
 
-  bool operator==(const Model &) const;
+  rows_ = acc.type == TINYGLTF_TYPE_MAT2   ? 2
+          : acc.type == TINYGLTF_TYPE_MAT3 ? 3
+          : acc.type == TINYGLTF_TYPE_MAT4 ? 4
+                                           : numComponents;
+  cols_ = numComponents / rows_;
+  componentType_ = acc.componentType;
+  componentSize_ = size_t(componentSize);
+  columnSize_ = detail::AccessorColumnSize(componentSize_, rows_, cols_);
+  elementSize_ = columnSize_ * size_t(cols_);
+  count_ = acc.count;
+
+  if (acc.bufferView >= 0) {
+    if (size_t(acc.bufferView) >= model.bufferViews.size()) {
+      if (err) (*err) += name + " has an invalid bufferView.\n";
+      return false;
+    }
+    const BufferView &view = model.bufferViews[size_t(acc.bufferView)];
+    stride_ = view.byteStride ? view.byteStride : elementSize_;
+    // The last element must end inside the view: checked as
+    // count - 1 <= (byteLength - byteOffset - elementSize) / stride so that
+    // a huge count cannot wrap the span around.
+    bool fits = acc.byteOffset <= view.byteLength;
+    if (fits && count_ > 0) {
+      const size_t available = view.byteLength - acc.byteOffset;
+      fits = elementSize_ <= available &&
+             count_ - 1 <= (available - elementSize_) / stride_;
+    }
+    size_t span = count_ == 0 ? 0 : (count_ - 1) * stride_ + elementSize_;
+    data_ = fits ? detail::AccessorBytes(model, acc.bufferView,
+                                         acc.byteOffset, span)
+                 : nullptr;
+    if (!data_) {
+      if (err) (*err) += name + " runs past the end of its bufferView.\n";
+      return false;
+    }
+  }
 
-  std::vector<Accessor> accessors;
-  std::vector<Animation> animations;
-  std::vector<Buffer> buffers;
-  std::vector<BufferView> bufferViews;
-  std::vector<Material> materials;
-  std::vector<Mesh> meshes;
-  std::vector<Node> nodes;
-  std::vector<Texture> textures;
-  std::vector<Image> images;
-  std::vector<Skin> skins;
-  std::vector<Sampler> samplers;
-  std::vector<Camera> cameras;
-  std::vector<Scene> scenes;
-  std::vector<Light> lights;
-  std::vector<AudioEmitter> audioEmitters;
-  std::vector<AudioSource> audioSources;
+  if (acc.sparse.isSparse && acc.sparse.count > 0) {
+    const size_t sparseCount = size_t(acc.sparse.count);
+    switch (acc.sparse.indices.componentType) {
+      case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+        sparseIndexRead_ =
+            &detail::AccessorComponentReader<uint8_t, uint32_t, false>::Read;
+        sparseIndexSize_ = 1;
+        break;
+      case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+        sparseIndexRead_ =
+            &detail::AccessorComponentReader<uint16_t, uint32_t, false>::Read;
+        sparseIndexSize_ = 2;
+        break;
+      case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
+        sparseIndexRead_ =
+            &detail::AccessorComponentReader<uint32_t, uint32_t, false>::Read;
+        sparseIndexSize_ = 4;
+        break;
+      default:
+        if (err) (*err) += name + " has an invalid sparse index type.\n";
+        *this = AccessorView();
+        return false;
+    }
+    sparseIndices_ = detail::AccessorBytes(
+        model, acc.sparse.indices.bufferView,
+        size_t(acc.sparse.indices.byteOffset), sparseCount * sparseIndexSize_);
+    sparseValues_ = detail::AccessorBytes(
+        model, acc.sparse.values.bufferView,
+        size_t(acc.sparse.values.byteOffset), sparseCount * elementSize_);
+    if (!sparseIndices_ || !sparseValues_) {
+      if (err) (*err) += name + " has sparse data past its bufferView.\n";
+      *this = AccessorView();
+      return false;
+    }
+    sparseCount_ = sparseCount;
+    for (size_t k = 0; k < sparseCount_; ++k) {
+      size_t index = SparseIndex(k);
+      if (index >= count_ || (k > 0 && index <= SparseIndex(k - 1))) {
+        if (err)
+          (*err) += name +
+                    " has sparse indices that are out of range or not "
+                    "strictly increasing.\n";
+        *this = AccessorView();
+        return false;
+      }
+    }
+  }
 
-  int defaultScene{-1};
-  std::vector<std::string> extensionsUsed;
-  std::vector<std::string> extensionsRequired;
+  copy_ = copy;
+  read_ = read;
+  return true;
+}
 
-  Asset asset;
+///
+/// Dense copies of sparse accessors, keyed by accessor index. Each accessor
+/// is materialized (base data or zeros, then the sparse values scattered in)
+/// the first time it is requested and shared by every later user, e.g. all
+/// primitives referencing the same morph target. Data keeps the stored
+/// componentType with tightly packed elements. Not thread-safe; Clear() it
+/// when the model's accessors or buffers change.
+///
+class SparseAccessorCache {
+ public:
+  ///
+  /// Dense data for `model.accessors[accessor]`, or nullptr with a message
+  /// in `err` when the accessor is invalid. Non-sparse accessors are
+  /// materialized too, so callers need not special-case them.
+  ///
+  const std::vector<unsigned char> *Get(const Model &model, int accessor,
+                                        std::string *err = nullptr);
 
-  Value extras;
-  ExtensionMap extensions;
+  void Clear() { dense_.clear(); }
+  size_t size() const { return dense_.size(); }
 
-  // Filled when SetStoreOriginalJSONForExtrasAndExtensions is enabled.
-  std::string extras_json_string;
-  std::string extensions_json_string;
+ private:
+  std::map<int, std::vector<unsigned char>> dense_;
 };
 
+template <typename T>
+bool AccessorView<T>::Init(const Model &model, int accessor,
+                           SparseAccessorCache *cache, std::string *err) {
+  if (!Init(model, accessor, err)) return false;
+  if (!cache || !IsSparse()) return true;
+  const std::vector<unsigned char> *dense = cache->Get(model, accessor, err);
+  if (!dense) {
+    *this = AccessorView();
+    return false;
+  }
+  data_ = dense->empty() ? nullptr : dense->data();
+  stride_ = elementSize_;
+  sparseCount_ = 0;
+  sparseIndices_ = sparseValues_ = nullptr;
+  return true;
+}
+
 enum SectionCheck {
   NO_REQUIRE = 0x00,
   REQUIRE_VERSION = 0x01,
@@ -1385,6 +3083,17 @@ bool WriteImageData(const std::string *basepath, const std::string *filename,
                     std::string *out_uri, void *);
 #endif
 
+///
+/// Decode statistics for one image of the last load, see
+/// TinyGLTF::GetImageDecodeTimings().
+///
+struct ImageDecodeTiming {
+  int image{-1};            // index into Model::images
+  size_t encoded_bytes{0};  // size of the encoded (PNG, JPEG, ...) data
+  double seconds{0.0};      // time spent in the LoadImageData callback
+  bool ok{false};           // callback result
+};
+
 ///
 /// glTF Parser/Serializer context.
 ///
@@ -1554,6 +3263,89 @@ class TinyGLTF {
 
   size_t GetMaxExternalFileSize() const { return max_external_file_size_; }
 
+  ///
+  /// Memory-map the file in LoadBinaryFromFile() and let the buffer backed by
+  /// the GLB BIN chunk reference the mapping (Buffer::mapped_data) instead of
+  /// copying it into Buffer::data. Read buffers through Buffer::Data() and
+  /// Buffer::Size() when this is enabled.
+  /// Only effective with the built-in FS callbacks; falls back to reading the
+  /// file when it can't be mapped.
+  ///
+  void SetMemoryMapBinary(bool onoff) { memory_map_binary_ = onoff; }
+
+  bool GetMemoryMapBinary() const { return memory_map_binary_; }
+
+  ///
+  /// Number of threads decoding images during load. 0 (default) uses one
+  /// per hardware thread with the built-in stb_image loader, and a single
+  /// thread with a SetImageLoader() callback, which must be thread-safe
+  /// before setting a larger count. Results, error and warning messages are
+  /// the same as with one thread.
+  ///
+  void SetImageDecodeThreads(int threads) {
+    image_decode_threads_ = threads < 0 ? 0 : threads;
+  }
+
+  int GetImageDecodeThreads() const { return image_decode_threads_; }
+
+  ///
+  /// Per-image decode times of the last load, in image order. Images with
+  /// nothing to decode (e.g. external files that were not loaded) are not
+  /// listed.
+  ///
+  const std::vector<ImageDecodeTiming> &GetImageDecodeTimings() const {
+    return image_decode_timings_;
+  }
+
+  ///
+  /// Keep images compressed during load and decode each one on demand with
+  /// DecodeImage(model, idx). `uri` images keep their file or data URI bytes
+  /// in Image::encoded, `bufferView` images are read from their buffer (the
+  /// mapped file with SetMemoryMapBinary()) when decoded. The loader
+  /// callback and its options are captured at load time. Decode images
+  /// before saving the model if they are to be embedded.
+  ///
+  void SetLazyImageDecoding(bool onoff) { lazy_image_decoding_ = onoff; }
+
+  bool GetLazyImageDecoding() const { return lazy_image_decoding_; }
+
+  ///
+  /// Parse .gltf JSON with a streaming (SAX) front end (default true). The
+  /// elements of the top-level buffers, bufferViews, accessors, nodes,
+  /// scenes, materials, textures, animations, skins, samplers and cameras
+  /// arrays are parsed into the Model as soon as each one is read, instead
+  /// of after a DOM of the whole file has been built. Only takes effect
+  /// when compiled with TINYGLTF_ENABLE_STREAMING_PARSE (nlohmann json);
+  /// otherwise the DOM is always built.
+  ///
+  void SetStreamingParse(bool onoff) { streaming_parse_ = onoff; }
+
+  bool GetStreamingParse() const { return streaming_parse_; }
+
+  ///
+  /// Allocate the containers of loaded models from a ModelArena (default
+  /// true). Only takes effect when compiled with TINYGLTF_ENABLE_MODEL_ARENA.
+  /// A load then clears the model first, and when nothing else still uses
+  /// the arena of the previous load, rewinds and refills it, so loading
+  /// repeatedly into the same Model reuses its storage.
+  ///
+  void SetModelArena(bool onoff) { model_arena_ = onoff; }
+
+  bool GetModelArena() const { return model_arena_; }
+
+  ///
+  /// Fail the load when a vertex attribute uses a type or component type that
+  /// is invalid even with KHR_mesh_quantization (default false: report it as
+  /// a warning, so files that loaded before the check was added still load).
+  ///
+  void SetStrictAttributeEncoding(bool onoff) {
+    strict_attribute_encoding_ = onoff;
+  }
+
+  bool GetStrictAttributeEncoding() const {
+    return strict_attribute_encoding_;
+  }
+
  private:
   ///
   /// Loads glTF asset from string(memory).
@@ -1567,6 +3359,7 @@ class TinyGLTF {
 
   const unsigned char *bin_data_ = nullptr;
   size_t bin_size_ = 0;
+  std::shared_ptr<const void> bin_owner_;  // set while loading a mapped GLB
   bool is_binary_ = false;
 
   ParseStrictness strictness_ = ParseStrictness::Strict;
@@ -1580,6 +3373,18 @@ class TinyGLTF {
 
   bool images_as_is_ = false; /// Default false (decode/decompress images)
 
+  bool memory_map_binary_ = false;  /// Default false (copy the BIN chunk)
+
+  int image_decode_threads_ = 0;  /// Default 0 (automatic)
+  bool lazy_image_decoding_ = false;  /// Default false (decode during load)
+  bool streaming_parse_ = true;  /// Default true (when compiled in)
+  bool model_arena_ = true;      /// Default true (when compiled in)
+  bool strict_attribute_encoding_ = false;  /// Default false (warn)
+#ifdef TINYGLTF_ENABLE_MODEL_ARENA
+  ModelAllocator<char> arena_{nullptr};  // arena of the last load
+#endif
+  std::vector<ImageDecodeTiming> image_decode_timings_;
+
   size_t max_external_file_size_{
       size_t((std::numeric_limits<int32_t>::max)())};  // Default 2GB
 
@@ -1646,8 +3451,61 @@ class TinyGLTF {
 
 #include <cstdio>
 #include <fstream>
+
+#if !defined(_WIN32) && !defined(TINYGLTF_ANDROID_LOAD_FROM_ASSETS)
+#include <fcntl.h>     // open
+#include <sys/mman.h>  // mmap, for SetMemoryMapBinary()
+#include <unistd.h>    // close
+#endif
 #endif
 #include <sstream>
+#include <stdexcept>  // AttributeMap::at
+
+#include <chrono>  // image decode timings
+
+#ifndef TINYGLTF_NO_THREADS
+#include <atomic>
+#include <mutex>
+#include <thread>
+#endif
+
+// Called with the byte count wherever a load copies buffer or image payload
+// from one buffer into another (on top of decoding it). Empty unless defined
+// before the implementation; benchmark/load_bench.cc counts with it.
+#ifndef TINYGLTF_COUNT_COPY
+#define TINYGLTF_COUNT_COPY(n) ((void)0)
+#endif
+
+// SSE4.1 paths for the EXT_meshopt_compression decoder, chosen at runtime.
+#if !defined(TINYGLTF_NO_MESHOPT_SIMD) && \
+    (defined(__x86_64__) || defined(_M_X64)) && \
+    (defined(__GNUC__) || defined(_MSC_VER))
+#define TINYGLTF_MESHOPT_SSE41 1
+#include <smmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>  // __cpuid
+#define TINYGLTF_TARGET_SSE41
+#else
+#define TINYGLTF_TARGET_SSE41 __attribute__((target("sse4.1")))
+#endif
+#endif
+
+// SSE2/AVX2 paths for tinygltf::kernels, chosen at runtime.
+#if !defined(TINYGLTF_NO_KERNEL_SIMD) && \
+    (defined(__x86_64__) || defined(_M_X64)) && \
+    (defined(__GNUC__) || defined(_MSC_VER))
+#define TINYGLTF_KERNELS_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>  // __cpuidex, _xgetbv
+#define TINYGLTF_TARGET_AVX2
+#define TINYGLTF_TARGET_SSSE3
+#else
+#include <cpuid.h>
+#define TINYGLTF_TARGET_AVX2 __attribute__((target("avx2,f16c")))
+#define TINYGLTF_TARGET_SSSE3 __attribute__((target("ssse3")))
+#endif
+#endif
 
 #ifdef __clang__
 // Disable some warnings for external files.
@@ -1910,6 +3768,349 @@ struct LoadImageDataOption {
   bool as_is{false};
 };
 
+///
+/// Image loader state captured by a load with lazy image decoding, shared by
+/// copies of the model. Image::decode_pending is only read or written with
+/// the lock of its stripe held.
+///
+struct LazyImageDecoder {
+  LoadImageDataFunction load;
+  void *user_data{nullptr};  // the user loader's pointer
+  bool user_loader{false};
+  LoadImageDataOption option;
+#ifndef TINYGLTF_NO_THREADS
+  std::mutex locks[32];
+
+  std::mutex &Lock(int image) { return locks[size_t(image) % 32]; }
+#endif
+};
+
+#ifdef TINYGLTF_ENABLE_MODEL_ARENA
+ModelArena::~ModelArena() {
+  for (const Block &block : blocks_) ::operator delete(block.data);
+}
+
+void ModelArena::Reset() {
+  block_ = 0;
+  offset_ = 0;
+  used_ = 0;
+}
+
+void *ModelArena::AllocateSlow(size_t size, size_t alignment) {
+  // Move on to the next kept block that fits (after a Reset()), or add one
+  const size_t needed = size + alignment;
+  size_t next = blocks_.empty() ? 0 : block_ + 1;
+  while (next < blocks_.size() && blocks_[next].size < needed) ++next;
+  if (next == blocks_.size()) {
+    Block block;
+    block.size = (std::max)(block_size_, needed);
+    block.data = static_cast<unsigned char *>(::operator new(block.size));
+    blocks_.push_back(block);
+    reserved_ += block.size;
+  }
+  block_ = next;
+  offset_ = 0;
+  return Allocate(size, alignment);
+}
+
+ModelArena *&ModelArena::CurrentSlot() {
+  static thread_local ModelArena *current = nullptr;
+  return current;
+}
+
+ModelArena *ModelArena::Current() { return CurrentSlot(); }
+
+ModelArena::Scope::Scope(ModelArena *arena) : previous_(CurrentSlot()) {
+  CurrentSlot() = arena;
+}
+
+ModelArena::Scope::~Scope() { CurrentSlot() = previous_; }
+#endif
+
+const std::string &ValueKey::Empty() {
+  static const std::string empty;
+  return empty;
+}
+
+ValueKey::ValueKey(const std::string &s) {
+  if (ValueKeyPool *pool = ValueKeyPool::Current()) {
+    *this = pool->Intern(s);
+  } else {
+    node_ = new Node(std::string(s));
+  }
+}
+
+ValueKey::ValueKey(std::string &&s) {
+  if (ValueKeyPool *pool = ValueKeyPool::Current()) {
+    *this = pool->Intern(std::move(s));
+  } else {
+    node_ = new Node(std::move(s));
+  }
+}
+
+ValueKeyPool::~ValueKeyPool() {
+  for (ValueKey::Node *node : slots_) {
+    ValueKey release(node);  // drops the pool's reference
+  }
+}
+
+ValueKey ValueKeyPool::Intern(const std::string &s) { return Insert(s); }
+
+ValueKey ValueKeyPool::Intern(std::string &&s) { return Insert(std::move(s)); }
+
+size_t ValueKeyPool::Probe(const std::string &s) const {
+  const size_t mask = slots_.size() - 1;
+  size_t i = std::hash<std::string>()(s) & mask;
+  while (slots_[i] && slots_[i]->str != s) i = (i + 1) & mask;
+  return i;
+}
+
+template <typename S>
+ValueKey ValueKeyPool::Insert(S &&s) {
+  // Linear probing at a load factor of at most 3/4
+  if ((size_ + 1) * 4 > slots_.size() * 3) {
+    std::vector<ValueKey::Node *> slots(std::max<size_t>(16, slots_.size() * 2),
+                                        nullptr);
+    slots.swap(slots_);
+    for (ValueKey::Node *node : slots) {
+      if (node) slots_[Probe(node->str)] = node;
+    }
+  }
+  const size_t i = Probe(s);
+  if (!slots_[i]) {
+    slots_[i] = new ValueKey::Node(std::string(std::forward<S>(s)));
+    ++size_;
+  }
+  ValueKey key(slots_[i]);
+  key.Ref();
+  return key;
+}
+
+ValueKeyPool *&ValueKeyPool::CurrentSlot() {
+  static thread_local ValueKeyPool *current = nullptr;
+  return current;
+}
+
+ValueKeyPool *ValueKeyPool::Current() { return CurrentSlot(); }
+
+ValueKeyPool::Scope::Scope(ValueKeyPool *pool) : previous_(CurrentSlot()) {
+  CurrentSlot() = pool;
+}
+
+ValueKeyPool::Scope::~Scope() { CurrentSlot() = previous_; }
+const size_t ValueObject::kInlineCapacity;
+
+ValueObject::ValueObject(std::initializer_list<value_type> values) {
+  reserve(values.size());
+  for (const value_type &value : values) insert(value);
+}
+
+ValueObject::ValueObject(const ValueObject &other)
+    : allocator_type(
+          AllocTraits::select_on_container_copy_construction(other)) {
+  reserve(other.size_);
+  value_type **data = Data();
+  for (; size_ < other.size_; ++size_) {
+    data[size_] = ::new (Allocate()) value_type(*other.Data()[size_]);
+  }
+}
+
+ValueObject::ValueObject(ValueObject &&other) noexcept
+    : allocator_type(other) {
+  Steal(other);
+}
+
+ValueObject &ValueObject::operator=(const ValueObject &other) {
+  if (this != &other) {
+    clear();
+    reserve(other.size_);
+    value_type **data = Data();
+    for (; size_ < other.size_; ++size_) {
+      data[size_] = ::new (Allocate()) value_type(*other.Data()[size_]);
+    }
+  }
+  return *this;
+}
+
+ValueObject &ValueObject::operator=(ValueObject &&other) noexcept {
+  if (this != &other) {
+    Free();
+    Alloc() = other.Alloc();
+    Steal(other);
+  }
+  return *this;
+}
+
+// Takes over the members, which stay where they are, and the index
+void ValueObject::Steal(ValueObject &other) noexcept {
+  if (other.IsInline()) {
+    std::copy(other.inline_, other.inline_ + other.size_, inline_);
+  } else {
+    heap_ = other.heap_;
+  }
+  size_ = other.size_;
+  capacity_ = other.capacity_;
+  slabs_ = other.slabs_;
+  other.size_ = 0;
+  other.capacity_ = kInlineCapacity;
+  other.slabs_ = nullptr;
+}
+
+void ValueObject::clear() {
+  value_type **data = Data();
+  for (size_t i = 0; i < size_; ++i) data[i]->~value_type();
+  size_ = 0;
+  for (Slab *slab = slabs_; slab; slab = slab->next) {
+    slab->used = 0;
+    slab->free = nullptr;
+  }
+}
+
+void ValueObject::Free() noexcept {
+  value_type **data = Data();
+  for (size_t i = 0; i < size_; ++i) data[i]->~value_type();
+  size_ = 0;
+  SlotAllocator slots(Alloc());
+  while (slabs_) {
+    Slab *next = slabs_->next;
+    std::allocator_traits<SlotAllocator>::deallocate(
+        slots, reinterpret_cast<Slot *>(slabs_),
+        kHeaderSlots + slabs_->capacity);
+    slabs_ = next;
+  }
+  if (!IsInline()) {
+    AllocTraits::deallocate(Alloc(), heap_, capacity_);
+    capacity_ = kInlineCapacity;
+  }
+}
+
+void ValueObject::reserve(size_type n) {
+  assert(n <= (std::numeric_limits<uint32_t>::max)());
+  if (n > capacity_) Grow(n);
+  // Room for n members in the slabs, counting free slots
+  size_t room = 0;
+  for (Slab *slab = slabs_; slab; slab = slab->next) {
+    room += slab->capacity - slab->used;
+  }
+  if (slabs_) {
+    for (Slot *slot = slabs_->free; slot; slot = slot->next_free) ++room;
+  }
+  if (size_ + room < n) AddSlab(n - size_ - room);
+}
+
+void ValueObject::AddSlab(size_t capacity) {
+  SlotAllocator slots(Alloc());
+  Slab *slab = reinterpret_cast<Slab *>(
+      std::allocator_traits<SlotAllocator>::allocate(slots,
+                                                     kHeaderSlots + capacity));
+  slab->next = slabs_;
+  slab->capacity = uint32_t(capacity);
+  slab->used = 0;
+  slab->free = slabs_ ? slabs_->free : nullptr;
+  if (slabs_) slabs_->free = nullptr;
+  slabs_ = slab;
+}
+
+void *ValueObject::Allocate() {
+  if (slabs_ && slabs_->free) {
+    Slot *slot = slabs_->free;
+    slabs_->free = slot->next_free;
+    return slot;
+  }
+  for (Slab *slab = slabs_; slab; slab = slab->next) {
+    if (slab->used < slab->capacity) return &Slots(slab)[slab->used++];
+  }
+  // Slabs double, like the capacity of a vector
+  AddSlab(std::max<size_t>(kInlineCapacity, size_));
+  return &Slots(slabs_)[slabs_->used++];
+}
+
+void ValueObject::Grow(size_t capacity) {
+  value_type **data = AllocTraits::allocate(Alloc(), capacity);
+  std::copy(Data(), Data() + size_, data);
+  if (!IsInline()) AllocTraits::deallocate(Alloc(), heap_, capacity_);
+  heap_ = data;
+  capacity_ = uint32_t(capacity);
+}
+
+size_t ValueObject::LowerBound(const std::string &key) const {
+  value_type *const *data = Data();
+  size_t lo = 0, hi = size_;
+  while (lo < hi) {
+    const size_t mid = lo + (hi - lo) / 2;
+    if (data[mid]->first.str() < key) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+size_t ValueObject::Find(const std::string &key) const {
+  const size_t pos = LowerBound(key);
+  return (pos < size_ && Data()[pos]->first.str() == key) ? pos : size_;
+}
+
+Value &ValueObject::at(const std::string &key) {
+  return const_cast<Value &>(static_cast<const ValueObject &>(*this).at(key));
+}
+
+const Value &ValueObject::at(const std::string &key) const {
+  const size_t pos = Find(key);
+#if (defined(__cpp_exceptions) || defined(__EXCEPTIONS) || \
+     defined(_CPPUNWIND)) &&                               \
+    !defined(TINYGLTF_NOEXCEPTION)
+  if (pos == size_) throw std::out_of_range("Value::Object::at: " + key);
+#else
+  assert(pos != size_);
+#endif
+  return Data()[pos]->second;
+}
+
+ValueObject::iterator ValueObject::InsertAt(size_t pos, value_type *member) {
+  if (size_ == capacity_) Grow(size_t(capacity_) * 2);
+  // Members parsed from JSON usually arrive in key order, so this is
+  // mostly an append.
+  value_type **data = Data();
+  std::copy_backward(data + pos, data + size_, data + size_ + 1);
+  data[pos] = member;
+  ++size_;
+  return iterator(data + pos);
+}
+
+ValueObject::size_type ValueObject::erase(const std::string &key) {
+  const size_t pos = Find(key);
+  if (pos == size_) return 0;
+  erase(const_iterator(Data() + pos));
+  return 1;
+}
+
+ValueObject::iterator ValueObject::erase(const_iterator pos) {
+  value_type **data = Data();
+  const size_t index = size_t(pos.slot_ - data);
+  value_type *member = data[index];
+  member->~value_type();
+  Slot *slot = reinterpret_cast<Slot *>(member);
+  slot->next_free = slabs_->free;
+  slabs_->free = slot;
+  std::copy(data + index + 1, data + size_, data + index);
+  --size_;
+  return iterator(data + index);
+}
+
+bool ValueObject::operator==(const ValueObject &other) const {
+  if (size_ != other.size_) return false;
+  for (size_t i = 0; i < size_; ++i) {
+    const value_type &a = *Data()[i];
+    const value_type &b = *other.Data()[i];
+    if (!a.first.SharesStorage(b.first) && a.first != b.first) return false;
+    if (!(a.second == b.second)) return false;
+  }
+  return true;
+}
+
+
 // Equals function for Value, for recursivity
 static bool Equals(const tinygltf::Value &one, const tinygltf::Value &other) {
   if (one.Type() != other.Type()) return false;
@@ -1923,18 +4124,10 @@ static bool Equals(const tinygltf::Value &one, const tinygltf::Value &other) {
       return TINYGLTF_DOUBLE_EQUAL(one.Get<double>(), other.Get<double>());
     case INT_TYPE:
       return one.Get<int>() == other.Get<int>();
-    case OBJECT_TYPE: {
-      auto oneObj = one.Get<tinygltf::Value::Object>();
-      auto otherObj = other.Get<tinygltf::Value::Object>();
-      if (oneObj.size() != otherObj.size()) return false;
-      for (auto &it : oneObj) {
-        auto otherIt = otherObj.find(it.first);
-        if (otherIt == otherObj.end()) return false;
-
-        if (!Equals(it.second, otherIt->second)) return false;
-      }
-      return true;
-    }
+    case OBJECT_TYPE:
+      // Members are sorted by key, so equal objects line up.
+      return one.Get<tinygltf::Value::Object>() ==
+             other.Get<tinygltf::Value::Object>();
     case ARRAY_TYPE: {
       if (one.Size() != other.Size()) return false;
       for (size_t i = 0; i < one.Size(); ++i)
@@ -1954,8 +4147,8 @@ static bool Equals(const tinygltf::Value &one, const tinygltf::Value &other) {
 }
 
 // Equals function for std::vector<double> using TINYGLTF_DOUBLE_EPSILON
-static bool Equals(const std::vector<double> &one,
-                   const std::vector<double> &other) {
+static bool Equals(const ModelVector<double> &one,
+                   const ModelVector<double> &other) {
   if (one.size() != other.size()) return false;
   for (int i = 0; i < int(one.size()); ++i) {
     if (!TINYGLTF_DOUBLE_EQUAL(one[size_t(i)], other[size_t(i)])) return false;
@@ -1997,7 +4190,10 @@ bool Asset::operator==(const Asset &other) const {
          this->minVersion == other.minVersion && this->version == other.version;
 }
 bool Buffer::operator==(const Buffer &other) const {
-  return this->data == other.data && this->extensions == other.extensions &&
+  return this->Size() == other.Size() &&
+         (this->Size() == 0 ||
+          memcmp(this->Data(), other.Data(), this->Size()) == 0) &&
+         this->extensions == other.extensions &&
          this->extras == other.extras && this->name == other.name &&
          this->uri == other.uri;
 }
@@ -2109,31 +4305,216 @@ bool Parameter::operator==(const Parameter &other) const {
       this->has_number_value != other.has_number_value)
     return false;
 
-  if (!TINYGLTF_DOUBLE_EQUAL(this->number_value, other.number_value))
-    return false;
+  if (!TINYGLTF_DOUBLE_EQUAL(this->number_value, other.number_value))
+    return false;
+
+  if (this->json_double_value.size() != other.json_double_value.size())
+    return false;
+  for (auto &it : this->json_double_value) {
+    auto otherIt = other.json_double_value.find(it.first);
+    if (otherIt == other.json_double_value.end()) return false;
+
+    if (!TINYGLTF_DOUBLE_EQUAL(it.second, otherIt->second)) return false;
+  }
+
+  if (!Equals(this->number_array, other.number_array)) return false;
+
+  if (this->string_value != other.string_value) return false;
+
+  return true;
+}
+bool PerspectiveCamera::operator==(const PerspectiveCamera &other) const {
+  return TINYGLTF_DOUBLE_EQUAL(this->aspectRatio, other.aspectRatio) &&
+         this->extensions == other.extensions && this->extras == other.extras &&
+         TINYGLTF_DOUBLE_EQUAL(this->yfov, other.yfov) &&
+         TINYGLTF_DOUBLE_EQUAL(this->zfar, other.zfar) &&
+         TINYGLTF_DOUBLE_EQUAL(this->znear, other.znear);
+}
+AttributeSemantic InternAttributeSemantic(const std::string &name) {
+  // The length and the first character tell which name it can be, and the
+  // last digit which member of a set; one compare with that name confirms.
+  const size_t n = name.size();
+  if (n < 6) return AttributeSemantic::Custom;
+  const char digit = name[n - 1];
+  const bool set = digit >= '0' && digit <= '7';
+  int candidate;
+  switch (name[0]) {
+    case 'P':
+      candidate = n == 8 ? int(AttributeSemantic::Position) : -1;
+      break;
+    case 'N':
+      candidate = n == 6 ? int(AttributeSemantic::Normal) : -1;
+      break;
+    case 'T':
+      candidate = n == 7 ? int(AttributeSemantic::Tangent)
+                  : n == 10 && set
+                      ? int(AttributeSemantic::TexCoord0) + (digit - '0')
+                      : -1;
+      break;
+    case 'C':
+      candidate =
+          n == 7 && set ? int(AttributeSemantic::Color0) + (digit - '0') : -1;
+      break;
+    case 'J':
+      candidate =
+          n == 8 && set ? int(AttributeSemantic::Joints0) + (digit - '0') : -1;
+      break;
+    case 'W':
+      candidate = n == 9 && set
+                      ? int(AttributeSemantic::Weights0) + (digit - '0')
+                      : -1;
+      break;
+    default:
+      candidate = -1;
+  }
+  if (candidate < 0 ||
+      std::memcmp(name.data(), AttributeSemanticName(
+                                   AttributeSemantic(candidate)),
+                  n) != 0) {
+    return AttributeSemantic::Custom;
+  }
+  return AttributeSemantic(candidate);
+}
+
+const char *AttributeSemanticName(AttributeSemantic semantic) {
+  static const char *const kNames[] = {
+      "POSITION",   "NORMAL",     "TANGENT",    "TEXCOORD_0", "TEXCOORD_1",
+      "TEXCOORD_2", "TEXCOORD_3", "TEXCOORD_4", "TEXCOORD_5", "TEXCOORD_6",
+      "TEXCOORD_7", "COLOR_0",    "COLOR_1",    "COLOR_2",    "COLOR_3",
+      "COLOR_4",    "COLOR_5",    "COLOR_6",    "COLOR_7",    "JOINTS_0",
+      "JOINTS_1",   "JOINTS_2",   "JOINTS_3",   "JOINTS_4",   "JOINTS_5",
+      "JOINTS_6",   "JOINTS_7",   "WEIGHTS_0",  "WEIGHTS_1",  "WEIGHTS_2",
+      "WEIGHTS_3",  "WEIGHTS_4",  "WEIGHTS_5",  "WEIGHTS_6",  "WEIGHTS_7",
+      ""};
+  static_assert(sizeof(kNames) / sizeof(kNames[0]) ==
+                    size_t(AttributeSemantic::Custom) + 1,
+                "one name per AttributeSemantic");
+  return kNames[size_t(semantic)];
+}
+
+AttributeSemantic AttributeMap::SemanticAt(size_t rank) {
+  static const unsigned char kByName[] = {
+      11, 12, 13, 14, 15, 16, 17, 18,  // COLOR_n
+      19, 20, 21, 22, 23, 24, 25, 26,  // JOINTS_n
+      1,  0,  2,                       // NORMAL, POSITION, TANGENT
+      3,  4,  5,  6,  7,  8,  9,  10,  // TEXCOORD_n
+      27, 28, 29, 30, 31, 32, 33, 34};  // WEIGHTS_n
+  static_assert(sizeof(kByName) == kSemanticCount,
+                "every AttributeSemantic has a place in name order");
+  return AttributeSemantic(kByName[rank]);
+}
+
+size_t AttributeMap::RankOf(AttributeSemantic semantic) {
+  static const unsigned char kRanks[] = {
+      17, 16, 18,                      // POSITION, NORMAL, TANGENT
+      19, 20, 21, 22, 23, 24, 25, 26,  // TEXCOORD_n
+      0,  1,  2,  3,  4,  5,  6,  7,   // COLOR_n
+      8,  9,  10, 11, 12, 13, 14, 15,  // JOINTS_n
+      27, 28, 29, 30, 31, 32, 33, 34};  // WEIGHTS_n
+  static_assert(sizeof(kRanks) == kSemanticCount,
+                "every AttributeSemantic has a place in name order");
+  return kRanks[size_t(semantic)];
+}
+
+const std::string &AttributeMap::Key(AttributeSemantic semantic) {
+  // Never destroyed, so maps can be iterated by static destructors too
+  static const std::string *const kKeys = [] {
+    std::string *keys = new std::string[kSemanticCount];
+    for (size_t i = 0; i < kSemanticCount; ++i) {
+      keys[i] = AttributeSemanticName(AttributeSemantic(i));
+    }
+    return keys;
+  }();
+  return kKeys[size_t(semantic)];
+}
+
+size_t AttributeMap::NextRank(size_t rank) const {
+  while (rank < kSemanticCount && !Has(SemanticAt(rank))) ++rank;
+  return rank;
+}
 
-  if (this->json_double_value.size() != other.json_double_value.size())
-    return false;
-  for (auto &it : this->json_double_value) {
-    auto otherIt = other.json_double_value.find(it.first);
-    if (otherIt == other.json_double_value.end()) return false;
+size_t AttributeMap::CustomLowerBound(const std::string &name) const {
+  return size_t(std::lower_bound(custom_.begin(), custom_.end(), name,
+                                 [](const std::pair<std::string, int> &entry,
+                                    const std::string &key) {
+                                   return entry.first < key;
+                                 }) -
+                custom_.begin());
+}
 
-    if (!TINYGLTF_DOUBLE_EQUAL(it.second, otherIt->second)) return false;
+AttributeMap::iterator AttributeMap::CustomAt(size_t custom) {
+  // The next interned semantic in name order is the first one after the name
+  size_t rank = NextRank(0);
+  while (rank < kSemanticCount &&
+         Key(SemanticAt(rank)) < custom_[custom].first) {
+    rank = NextRank(rank + 1);
   }
+  return iterator(this, rank, custom);
+}
 
-  if (!Equals(this->number_array, other.number_array)) return false;
+AttributeMap::iterator AttributeMap::find(const std::string &name) {
+  const AttributeSemantic semantic = InternAttributeSemantic(name);
+  if (semantic != AttributeSemantic::Custom) return find(semantic);
+  const size_t custom = CustomLowerBound(name);
+  if (custom == custom_.size() || custom_[custom].first != name) return end();
+  return CustomAt(custom);
+}
 
-  if (this->string_value != other.string_value) return false;
+int &AttributeMap::at(const std::string &name) {
+  iterator it = find(name);
+#if (defined(__cpp_exceptions) || defined(__EXCEPTIONS) || \
+     defined(_CPPUNWIND)) &&                               \
+    !defined(TINYGLTF_NOEXCEPTION)
+  if (it == end()) throw std::out_of_range("AttributeMap::at: " + name);
+#else
+  assert(it != end());
+#endif
+  return it->second;
+}
 
-  return true;
+int &AttributeMap::operator[](const std::string &name) {
+  const AttributeSemantic semantic = InternAttributeSemantic(name);
+  if (semantic != AttributeSemantic::Custom) return (*this)[semantic];
+  const size_t custom = CustomLowerBound(name);
+  if (custom == custom_.size() || custom_[custom].first != name) {
+    custom_.insert(custom_.begin() + std::ptrdiff_t(custom),
+                   std::make_pair(name, 0));
+  }
+  return custom_[custom].second;
 }
-bool PerspectiveCamera::operator==(const PerspectiveCamera &other) const {
-  return TINYGLTF_DOUBLE_EQUAL(this->aspectRatio, other.aspectRatio) &&
-         this->extensions == other.extensions && this->extras == other.extras &&
-         TINYGLTF_DOUBLE_EQUAL(this->yfov, other.yfov) &&
-         TINYGLTF_DOUBLE_EQUAL(this->zfar, other.zfar) &&
-         TINYGLTF_DOUBLE_EQUAL(this->znear, other.znear);
+
+std::pair<AttributeMap::iterator, bool> AttributeMap::insert(
+    const value_type &value) {
+  const AttributeSemantic semantic = InternAttributeSemantic(value.first);
+  if (semantic != AttributeSemantic::Custom) {
+    const bool inserted = !Has(semantic);
+    if (inserted) (*this)[semantic] = value.second;
+    return std::make_pair(find(semantic), inserted);
+  }
+  const size_t custom = CustomLowerBound(value.first);
+  const bool inserted =
+      custom == custom_.size() || custom_[custom].first != value.first;
+  if (inserted) {
+    custom_.insert(custom_.begin() + std::ptrdiff_t(custom),
+                   std::make_pair(value.first, value.second));
+  }
+  return std::make_pair(CustomAt(custom), inserted);
+}
+
+AttributeMap::iterator AttributeMap::erase(const_iterator pos) {
+  if (!pos.OnSemantic()) {
+    custom_.erase(custom_.begin() + std::ptrdiff_t(pos.custom_));
+    return iterator(this, pos.rank_, pos.custom_);
+  }
+  const AttributeSemantic semantic = SemanticAt(pos.rank_);
+  const size_t custom = pos.custom_ == kUnresolved
+                            ? CustomLowerBound(Key(semantic))
+                            : pos.custom_;
+  present_ &= ~(uint64_t(1) << size_t(semantic));
+  indices_[size_t(semantic)] = 0;
+  return iterator(this, NextRank(pos.rank_ + 1u), custom);
 }
+
 bool Primitive::operator==(const Primitive &other) const {
   return this->attributes == other.attributes && this->extras == other.extras &&
          this->indices == other.indices && this->material == other.material &&
@@ -2302,103 +4683,28 @@ std::string base64_decode(std::string const &s);
 #pragma clang diagnostic ignored "-Wconversion"
 #endif
 
-static inline bool is_base64(unsigned char c) {
-  return (isalnum(c) || (c == '+') || (c == '/'));
-}
+// Altered from the original: both directions run on the table-driven
+// (and, on x86-64, SIMD) kernels::Base64Encode/Base64Decode, which write
+// straight into caller-provided storage.
 
 std::string base64_encode(unsigned char const *bytes_to_encode,
                           unsigned int in_len) {
-  std::string ret;
-  int i = 0;
-  int j = 0;
-  unsigned char char_array_3[3];
-  unsigned char char_array_4[4];
-
-  const char *base64_chars =
-      "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
-      "abcdefghijklmnopqrstuvwxyz"
-      "0123456789+/";
-
-  while (in_len--) {
-    char_array_3[i++] = *(bytes_to_encode++);
-    if (i == 3) {
-      char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
-      char_array_4[1] =
-          ((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4);
-      char_array_4[2] =
-          ((char_array_3[1] & 0x0f) << 2) + ((char_array_3[2] & 0xc0) >> 6);
-      char_array_4[3] = char_array_3[2] & 0x3f;
-
-      for (i = 0; (i < 4); i++) ret += base64_chars[char_array_4[i]];
-      i = 0;
-    }
+  std::string ret(kernels::Base64EncodedSize(in_len), '\0');
+  if (in_len) {
+    kernels::Base64Encode(bytes_to_encode, in_len, &ret[0]);
   }
-
-  if (i) {
-    for (j = i; j < 3; j++) char_array_3[j] = '\0';
-
-    char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
-    char_array_4[1] =
-        ((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4);
-    char_array_4[2] =
-        ((char_array_3[1] & 0x0f) << 2) + ((char_array_3[2] & 0xc0) >> 6);
-
-    for (j = 0; (j < i + 1); j++) ret += base64_chars[char_array_4[j]];
-
-    while ((i++ < 3)) ret += '=';
-  }
-
   return ret;
 }
 
 std::string base64_decode(std::string const &encoded_string) {
-  int in_len = static_cast<int>(encoded_string.size());
-  int i = 0;
-  int j = 0;
-  int in_ = 0;
-  unsigned char char_array_4[4], char_array_3[3];
-  std::string ret;
-
-  const std::string base64_chars =
-      "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
-      "abcdefghijklmnopqrstuvwxyz"
-      "0123456789+/";
-
-  while (in_len-- && (encoded_string[in_] != '=') &&
-         is_base64(encoded_string[in_])) {
-    char_array_4[i++] = encoded_string[in_];
-    in_++;
-    if (i == 4) {
-      for (i = 0; i < 4; i++)
-        char_array_4[i] =
-            static_cast<unsigned char>(base64_chars.find(char_array_4[i]));
-
-      char_array_3[0] =
-          (char_array_4[0] << 2) + ((char_array_4[1] & 0x30) >> 4);
-      char_array_3[1] =
-          ((char_array_4[1] & 0xf) << 4) + ((char_array_4[2] & 0x3c) >> 2);
-      char_array_3[2] = ((char_array_4[2] & 0x3) << 6) + char_array_4[3];
-
-      for (i = 0; (i < 3); i++) ret += char_array_3[i];
-      i = 0;
-    }
-  }
-
-  if (i) {
-    for (j = i; j < 4; j++) char_array_4[j] = 0;
-
-    for (j = 0; j < 4; j++)
-      char_array_4[j] =
-          static_cast<unsigned char>(base64_chars.find(char_array_4[j]));
-
-    char_array_3[0] = (char_array_4[0] << 2) + ((char_array_4[1] & 0x30) >> 4);
-    char_array_3[1] =
-        ((char_array_4[1] & 0xf) << 4) + ((char_array_4[2] & 0x3c) >> 2);
-    char_array_3[2] = ((char_array_4[2] & 0x3) << 6) + char_array_4[3];
-
-    for (j = 0; (j < i - 1); j++) ret += char_array_3[j];
+  size_t digits = 0;
+  size_t size = kernels::Base64DecodedSize(encoded_string.data(),
+                                           encoded_string.size(), &digits);
+  std::string ret(size, '\0');
+  if (size) {
+    kernels::Base64Decode(encoded_string.data(), digits,
+                          reinterpret_cast<unsigned char *>(&ret[0]));
   }
-
   return ret;
 }
 #ifdef __clang__
@@ -2633,8 +4939,8 @@ bool LoadImageData(Image *image, const int image_idx, std::string *err,
       // set all image properties to invalid, and report success.
       image->width = image->height = image->component = -1;
       image->bits = image->pixel_type = -1;
-      image->image.resize(static_cast<size_t>(size));
-      std::copy(bytes, bytes + size, image->image.begin());
+      image->image.assign(bytes, bytes + size);
+      TINYGLTF_COUNT_COPY(size_t(size));
       return true;
     }
   }
@@ -2724,13 +5030,15 @@ bool LoadImageData(Image *image, const int image_idx, std::string *err,
 
   if (option.as_is) {
     // Store the original image data
-    image->image.resize(static_cast<size_t>(size));
-    std::copy(bytes, bytes + size, image->image.begin());
+    image->image.assign(bytes, bytes + size);
+    TINYGLTF_COUNT_COPY(size_t(size));
   }
   else {
-    // Store the decoded image data
-    image->image.resize(static_cast<size_t>(w * h * comp) * size_t(bits / 8));
-    std::copy(data, data + w * h * comp * (bits / 8), image->image.begin());
+    // Store the decoded image data. assign() allocates and copies in one
+    // pass; resize() would zero-fill the pixels before overwriting them.
+    image->image.assign(
+        data, data + static_cast<size_t>(w * h * comp) * size_t(bits / 8));
+    TINYGLTF_COUNT_COPY(image->image.size());
   }
 
   stbi_image_free(data);
@@ -3259,6 +5567,109 @@ bool WriteWholeFile(std::string *err, const std::string &filepath,
   return true;
 }
 
+namespace detail {
+
+// Read-only mapping of a whole file, unmapped when the last reference to it
+// goes away. Backs Buffer::mapped_data for SetMemoryMapBinary().
+struct MappedFile {
+  const unsigned char *data = nullptr;
+  size_t size = 0;
+#ifdef _WIN32
+  HANDLE mapping = nullptr;
+#endif
+
+  MappedFile() = default;
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  ~MappedFile() {
+#ifdef _WIN32
+    if (data) UnmapViewOfFile(data);
+    if (mapping) CloseHandle(mapping);
+#elif !defined(TINYGLTF_ANDROID_LOAD_FROM_ASSETS)
+    if (data) munmap(const_cast<unsigned char *>(data), size);
+#endif
+  }
+};
+
+// Returns nullptr (and appends to `err`) when the file can't be mapped; the
+// caller then reads it the usual way.
+static std::shared_ptr<MappedFile> MapWholeFile(const std::string &filepath,
+                                                std::string *err) {
+  std::shared_ptr<MappedFile> mapped = std::make_shared<MappedFile>();
+#if defined(TINYGLTF_ANDROID_LOAD_FROM_ASSETS)
+  (void)filepath;
+  if (err) {
+    (*err) += "Memory mapping is not supported for Android assets.\n";
+  }
+  return nullptr;
+#elif defined(_WIN32)
+  HANDLE file = CreateFileW(UTF8ToWchar(filepath).c_str(), GENERIC_READ,
+                            FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    if (err) {
+      (*err) += "File open error : " + filepath + "\n";
+    }
+    return nullptr;
+  }
+  LARGE_INTEGER file_size;
+  if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart <= 0) {
+    CloseHandle(file);
+    if (err) {
+      (*err) += "File is empty or its size can't be read : " + filepath + "\n";
+    }
+    return nullptr;
+  }
+  // The mapping keeps its own reference to the file.
+  mapped->mapping =
+      CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  CloseHandle(file);
+  if (mapped->mapping) {
+    mapped->data = static_cast<const unsigned char *>(
+        MapViewOfFile(mapped->mapping, FILE_MAP_READ, 0, 0, 0));
+  }
+  if (!mapped->data) {
+    if (err) {
+      (*err) += "Failed to map file : " + filepath + "\n";
+    }
+    return nullptr;
+  }
+  mapped->size = static_cast<size_t>(file_size.QuadPart);
+  return mapped;
+#else
+  int fd = open(filepath.c_str(), O_RDONLY);
+  if (fd < 0) {
+    if (err) {
+      (*err) += "File open error : " + filepath + "\n";
+    }
+    return nullptr;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0) {
+    close(fd);
+    if (err) {
+      (*err) += "File is empty or not a regular file : " + filepath + "\n";
+    }
+    return nullptr;
+  }
+  void *p = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ,
+                 MAP_PRIVATE, fd, 0);
+  close(fd);  // the mapping stays valid without the descriptor
+  if (p == MAP_FAILED) {
+    if (err) {
+      (*err) += "Failed to map file : " + filepath + "\n";
+    }
+    return nullptr;
+  }
+  mapped->data = static_cast<const unsigned char *>(p);
+  mapped->size = static_cast<size_t>(st.st_size);
+  return mapped;
+#endif
+}
+
+}  // namespace detail
+
 #endif  // TINYGLTF_NO_FS
 
 static std::string MimeToExt(const std::string &mimeType) {
@@ -3318,125 +5729,1136 @@ static bool UpdateImageObject(const Image &image, std::string &baseDir,
     }
   }
 
-  // Use the original uri if the image was not written.
-  if (!imageWritten) {
-    *out_uri = image.uri;
-  }
+  // Use the original uri if the image was not written.
+  if (!imageWritten) {
+    *out_uri = image.uri;
+  }
+
+  return true;
+}
+
+bool IsDataURI(const std::string &in) {
+  std::string header = "data:application/octet-stream;base64,";
+  if (in.find(header) == 0) {
+    return true;
+  }
+
+  header = "data:image/jpeg;base64,";
+  if (in.find(header) == 0) {
+    return true;
+  }
+
+  header = "data:image/png;base64,";
+  if (in.find(header) == 0) {
+    return true;
+  }
+
+  header = "data:image/bmp;base64,";
+  if (in.find(header) == 0) {
+    return true;
+  }
+
+  header = "data:image/gif;base64,";
+  if (in.find(header) == 0) {
+    return true;
+  }
+
+  header = "data:text/plain;base64,";
+  if (in.find(header) == 0) {
+    return true;
+  }
+
+  header = "data:application/gltf-buffer;base64,";
+  if (in.find(header) == 0) {
+    return true;
+  }
+
+  return false;
+}
+
+bool DecodeDataURI(std::vector<unsigned char> *out, std::string &mime_type,
+                   const std::string &in, size_t reqBytes, bool checkSize) {
+  // Only image and text payloads report their mime type.
+  static const struct {
+    const char *header;
+    const char *mime_type;
+  } kDataTypes[] = {
+      {"data:application/octet-stream;base64,", nullptr},
+      {"data:image/jpeg;base64,", "image/jpeg"},
+      {"data:image/png;base64,", "image/png"},
+      {"data:image/bmp;base64,", "image/bmp"},
+      {"data:image/gif;base64,", "image/gif"},
+      {"data:text/plain;base64,", "text/plain"},
+      {"data:application/gltf-buffer;base64,", nullptr},
+  };
+
+  for (const auto &type : kDataTypes) {
+    const size_t header_len = strlen(type.header);
+    if (in.compare(0, header_len, type.header) != 0) {
+      continue;
+    }
+    if (type.mime_type) {
+      mime_type = type.mime_type;
+    }
+
+    // Size the output first and decode straight into it.
+    const char *payload = in.data() + header_len;
+    size_t digits = 0;
+    size_t size = kernels::Base64DecodedSize(payload, in.size() - header_len,
+                                             &digits);
+    // TODO(syoyo): Allow empty buffer? #229
+    if (size == 0 || (checkSize && size != reqBytes)) {
+      return false;
+    }
+    out->resize(size);
+    kernels::Base64Decode(payload, digits, out->data());
+    return true;
+  }
+
+  return false;
+}
+
+bool DecodeImage(Model *model, int image, std::string *err,
+                 std::string *warn) {
+  if (!model || image < 0 || size_t(image) >= model->images.size()) {
+    if (err) (*err) += "Invalid image index.\n";
+    return false;
+  }
+  LazyImageDecoder *decoder = model->image_decoder.get();
+  if (!decoder) return true;
+#ifndef TINYGLTF_NO_THREADS
+  std::lock_guard<std::mutex> lock(decoder->Lock(image));
+#endif
+  Image &img = model->images[size_t(image)];
+  if (!img.decode_pending) return true;
+
+  const unsigned char *bytes = img.encoded.data();
+  size_t size = img.encoded.size();
+  int req_width = 0, req_height = 0;
+  if (img.bufferView >= 0) {
+    // Validated during load
+    const BufferView &view = model->bufferViews[size_t(img.bufferView)];
+    bytes = model->buffers[size_t(view.buffer)].Data() + view.byteOffset;
+    size = view.byteLength;
+    req_width = img.width;
+    req_height = img.height;
+  }
+  if (!decoder->load) {
+    if (err) (*err) += "No LoadImageData callback specified.\n";
+    return false;
+  }
+  if (!decoder->load(&img, image, err, warn, req_width, req_height, bytes,
+                     static_cast<int>(size),
+                     decoder->user_loader
+                         ? decoder->user_data
+                         : reinterpret_cast<void *>(&decoder->option))) {
+    return false;
+  }
+  std::vector<unsigned char>().swap(img.encoded);
+  img.decode_pending = false;
+  return true;
+}
+
+bool IsImageDecodePending(const Model &model, int image) {
+  if (!model.image_decoder || image < 0 ||
+      size_t(image) >= model.images.size()) {
+    return false;
+  }
+#ifndef TINYGLTF_NO_THREADS
+  std::lock_guard<std::mutex> lock(model.image_decoder->Lock(image));
+#endif
+  return model.images[size_t(image)].decode_pending;
+}
+
+bool IsValidAttributeEncoding(const std::string &semantic,
+                              const Accessor &accessor, bool quantized) {
+  const int ct = accessor.componentType;
+  const bool n = accessor.normalized;
+  const bool isFloat = ct == TINYGLTF_COMPONENT_TYPE_FLOAT;
+  const bool anyInt = ct == TINYGLTF_COMPONENT_TYPE_BYTE ||
+                      ct == TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE ||
+                      ct == TINYGLTF_COMPONENT_TYPE_SHORT ||
+                      ct == TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT;
+  const bool signedNorm = n && (ct == TINYGLTF_COMPONENT_TYPE_BYTE ||
+                                ct == TINYGLTF_COMPONENT_TYPE_SHORT);
+  const bool unsignedNorm =
+      n && (ct == TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE ||
+            ct == TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT);
+
+  if (semantic == "POSITION") {
+    return accessor.type == TINYGLTF_TYPE_VEC3 &&
+           (isFloat || (quantized && anyInt));
+  }
+  if (semantic == "NORMAL") {
+    return accessor.type == TINYGLTF_TYPE_VEC3 &&
+           (isFloat || (quantized && signedNorm));
+  }
+  if (semantic == "TANGENT") {
+    return accessor.type == TINYGLTF_TYPE_VEC4 &&
+           (isFloat || (quantized && signedNorm));
+  }
+  if (semantic.compare(0, 9, "TEXCOORD_") == 0) {
+    return accessor.type == TINYGLTF_TYPE_VEC2 &&
+           (isFloat || unsignedNorm || (quantized && anyInt));
+  }
+  // COLOR_n, JOINTS_n, WEIGHTS_n and custom semantics are not affected by
+  // quantization and are not checked here.
+  return true;
+}
+
+namespace detail {
+
+static kernels::Isa DetectKernelIsa() {
+#ifdef TINYGLTF_KERNELS_X86
+  // SSE2 is part of x86-64. AVX2 also needs F16C (FloatToHalf) and the OS
+  // saving YMM state.
+  unsigned int leaf1[4] = {0, 0, 0, 0}, leaf7[4] = {0, 0, 0, 0};
+  unsigned long long xcr0 = 0;
+#ifdef _MSC_VER
+  int info[4];
+  __cpuid(info, 0);
+  const int maxLeaf = info[0];
+  __cpuid(info, 1);
+  for (int i = 0; i < 4; ++i) leaf1[i] = unsigned(info[i]);
+  if (maxLeaf >= 7) {
+    __cpuidex(info, 7, 0);
+    for (int i = 0; i < 4; ++i) leaf7[i] = unsigned(info[i]);
+  }
+  const bool osxsave = (leaf1[2] & (1u << 27)) != 0;
+  if (osxsave) xcr0 = _xgetbv(0);
+#else
+  __get_cpuid(1, &leaf1[0], &leaf1[1], &leaf1[2], &leaf1[3]);
+  __get_cpuid_count(7, 0, &leaf7[0], &leaf7[1], &leaf7[2], &leaf7[3]);
+  const bool osxsave = (leaf1[2] & (1u << 27)) != 0;
+  if (osxsave) {
+    unsigned int lo, hi;
+    __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    xcr0 = (static_cast<unsigned long long>(hi) << 32) | lo;
+  }
+#endif
+  const bool avx = (leaf1[2] & (1u << 28)) != 0;
+  const bool f16c = (leaf1[2] & (1u << 29)) != 0;
+  const bool avx2 = (leaf7[1] & (1u << 5)) != 0;
+  if (osxsave && avx && f16c && avx2 && (xcr0 & 6) == 6) {
+    return kernels::Isa::AVX2;
+  }
+  return kernels::Isa::SSE2;
+#else
+  return kernels::Isa::Scalar;
+#endif
+}
+
+static kernels::Isa &KernelIsaSlot() {
+  static kernels::Isa isa = kernels::SupportedIsa();
+  return isa;
+}
+
+// Scalar kernels; also the tails of the vector paths.
+
+static void WidenU8Scalar(const uint8_t *src, size_t count, uint32_t *dst) {
+  for (size_t i = 0; i < count; ++i) dst[i] = src[i];
+}
+
+static void WidenU16Scalar(const uint16_t *src, size_t count, uint32_t *dst) {
+  for (size_t i = 0; i < count; ++i) dst[i] = src[i];
+}
+
+static void GatherFloat3Scalar(const unsigned char *src, size_t stride,
+                               size_t count, float *dst) {
+  for (size_t i = 0; i < count; ++i) {
+    std::memcpy(dst + 3 * i, src + i * stride, 12);
+  }
+}
+
+// `min`/`max` are running values; the vector paths fold their tails in here.
+static void BoundsFloat3Scalar(const unsigned char *src, size_t stride,
+                               size_t count, float min[3], float max[3]) {
+  for (size_t i = 0; i < count; ++i) {
+    float v[3];
+    std::memcpy(v, src + i * stride, 12);
+    for (int c = 0; c < 3; ++c) {
+      // Same operand order as minps/maxps, so NaNs propagate identically
+      min[c] = v[c] < min[c] ? v[c] : min[c];
+      max[c] = v[c] > max[c] ? v[c] : max[c];
+    }
+  }
+}
+
+template <typename T>
+static void NormalizedToFloatScalar(const T *src, size_t count, float *dst) {
+  const float scale = static_cast<float>((std::numeric_limits<T>::max)());
+  for (size_t i = 0; i < count; ++i) {
+    float f = static_cast<float>(src[i]) / scale;
+    dst[i] = f < -1.0f ? -1.0f : f;
+  }
+}
+
+static uint16_t FloatToHalfScalar(float value) {
+  uint32_t f;
+  std::memcpy(&f, &value, 4);
+  const uint32_t sign = f & 0x80000000u;
+  f ^= sign;
+
+  uint32_t h;
+  if (f >= 0x47800000u) {
+    // Overflow to inf; NaNs stay quiet NaNs with the top payload bits, as
+    // vcvtps2ph does
+    h = f > 0x7f800000u ? 0x7e00u | ((f >> 13) & 0x3ffu) : 0x7c00u;
+  } else if (f < 0x38800000u) {
+    // Half subnormal or zero: let the FPU round by adding a magic number
+    const uint32_t magicBits = 126u << 23;
+    float magic, r;
+    std::memcpy(&magic, &magicBits, 4);
+    std::memcpy(&r, &f, 4);
+    r += magic;
+    std::memcpy(&h, &r, 4);
+    h -= magicBits;
+  } else {
+    // Rebias the exponent and round the mantissa to nearest even
+    const uint32_t odd = (f >> 13) & 1u;
+    f += (uint32_t(15 - 127) << 23) + 0xfffu + odd;
+    h = f >> 13;
+  }
+  return static_cast<uint16_t>(h | (sign >> 16));
+}
+
+static void FloatToHalfScalar(const float *src, size_t count, uint16_t *dst) {
+  for (size_t i = 0; i < count; ++i) dst[i] = FloatToHalfScalar(src[i]);
+}
+
+static const char kBase64Alphabet[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+// Digit value of every byte, 0xff outside the alphabet.
+struct Base64DigitTable {
+  unsigned char value[256];
+
+  Base64DigitTable() {
+    std::memset(value, 0xff, sizeof(value));
+    for (unsigned char i = 0; i < 64; ++i) {
+      value[static_cast<unsigned char>(kBase64Alphabet[i])] = i;
+    }
+  }
+};
+
+static const unsigned char *Base64Digits() {
+  static const Base64DigitTable table;
+  return table.value;
+}
+
+// Returns the end of the run of base64 digits starting at `i`.
+static size_t Base64ScanScalar(const char *src, size_t len, size_t i) {
+  const unsigned char *digits = Base64Digits();
+  while (i < len && digits[static_cast<unsigned char>(src[i])] != 0xff) ++i;
+  return i;
+}
+
+static void Base64DecodeScalar(const char *src, size_t count,
+                               unsigned char *dst) {
+  const unsigned char *digits = Base64Digits();
+  auto digit = [src, digits](size_t i) {
+    return static_cast<uint32_t>(digits[static_cast<unsigned char>(src[i])]);
+  };
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    uint32_t v = (digit(i) << 18) | (digit(i + 1) << 12) |
+                 (digit(i + 2) << 6) | digit(i + 3);
+    dst[0] = static_cast<unsigned char>(v >> 16);
+    dst[1] = static_cast<unsigned char>(v >> 8);
+    dst[2] = static_cast<unsigned char>(v);
+    dst += 3;
+  }
+  // A single trailing digit carries no whole byte and is dropped.
+  const size_t rest = count - i;
+  if (rest >= 2) {
+    uint32_t v = (digit(i) << 18) | (digit(i + 1) << 12) |
+                 (rest == 3 ? digit(i + 2) << 6 : 0);
+    dst[0] = static_cast<unsigned char>(v >> 16);
+    if (rest == 3) dst[1] = static_cast<unsigned char>(v >> 8);
+  }
+}
+
+static void Base64EncodeScalar(const unsigned char *src, size_t count,
+                               char *dst) {
+  size_t i = 0;
+  for (; i + 3 <= count; i += 3) {
+    uint32_t v = (uint32_t(src[i]) << 16) | (uint32_t(src[i + 1]) << 8) |
+                 src[i + 2];
+    dst[0] = kBase64Alphabet[v >> 18];
+    dst[1] = kBase64Alphabet[(v >> 12) & 63];
+    dst[2] = kBase64Alphabet[(v >> 6) & 63];
+    dst[3] = kBase64Alphabet[v & 63];
+    dst += 4;
+  }
+  const size_t rest = count - i;
+  if (rest) {
+    uint32_t v = (uint32_t(src[i]) << 16) |
+                 (rest == 2 ? uint32_t(src[i + 1]) << 8 : 0);
+    dst[0] = kBase64Alphabet[v >> 18];
+    dst[1] = kBase64Alphabet[(v >> 12) & 63];
+    dst[2] = rest == 2 ? kBase64Alphabet[(v >> 6) & 63] : '=';
+    dst[3] = '=';
+  }
+}
+
+#ifdef TINYGLTF_KERNELS_X86
+
+static void WidenU8Sse2(const uint8_t *src, size_t count, uint32_t *dst) {
+  const __m128i zero = _mm_setzero_si128();
+  size_t i = 0;
+  for (; i + 16 <= count; i += 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+    __m128i lo = _mm_unpacklo_epi8(v, zero);
+    __m128i hi = _mm_unpackhi_epi8(v, zero);
+    __m128i *out = reinterpret_cast<__m128i *>(dst + i);
+    _mm_storeu_si128(out + 0, _mm_unpacklo_epi16(lo, zero));
+    _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(lo, zero));
+    _mm_storeu_si128(out + 2, _mm_unpacklo_epi16(hi, zero));
+    _mm_storeu_si128(out + 3, _mm_unpackhi_epi16(hi, zero));
+  }
+  WidenU8Scalar(src + i, count - i, dst + i);
+}
+
+static void WidenU16Sse2(const uint16_t *src, size_t count, uint32_t *dst) {
+  const __m128i zero = _mm_setzero_si128();
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+    __m128i *out = reinterpret_cast<__m128i *>(dst + i);
+    _mm_storeu_si128(out + 0, _mm_unpacklo_epi16(v, zero));
+    _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(v, zero));
+  }
+  WidenU16Scalar(src + i, count - i, dst + i);
+}
+
+// Every element but the last is read and written 16 bytes wide: the extra 4
+// bytes belong to the next element in both arrays (stride >= 12), and the
+// next iteration overwrites what was stored past this one.
+static void GatherFloat3Sse2(const unsigned char *src, size_t stride,
+                             size_t count, float *dst) {
+  if (count == 0) return;
+  size_t i = 0;
+  for (; i + 1 < count; ++i) {
+    _mm_storeu_ps(dst + 3 * i, _mm_loadu_ps(reinterpret_cast<const float *>(
+                                   src + i * stride)));
+  }
+  GatherFloat3Scalar(src + i * stride, stride, 1, dst + 3 * i);
+}
+
+static void BoundsFloat3Sse2(const unsigned char *src, size_t stride,
+                             size_t count, float min[3], float max[3]) {
+  // The 4th lane reads into the next element and is never stored.
+  __m128 lo = _mm_setr_ps(min[0], min[1], min[2], 0.0f);
+  __m128 hi = _mm_setr_ps(max[0], max[1], max[2], 0.0f);
+  size_t i = 0;
+  for (; i + 1 < count; ++i) {
+    __m128 v = _mm_loadu_ps(reinterpret_cast<const float *>(src + i * stride));
+    lo = _mm_min_ps(v, lo);
+    hi = _mm_max_ps(v, hi);
+  }
+  float l[4], h[4];
+  _mm_storeu_ps(l, lo);
+  _mm_storeu_ps(h, hi);
+  for (int c = 0; c < 3; ++c) {
+    min[c] = l[c];
+    max[c] = h[c];
+  }
+  BoundsFloat3Scalar(src + i * stride, stride, count - i, min, max);
+}
+
+static void NormalizedU8Sse2(const uint8_t *src, size_t count, float *dst) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128 scale = _mm_set1_ps(255.0f);
+  size_t i = 0;
+  for (; i + 16 <= count; i += 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+    __m128i lo = _mm_unpacklo_epi8(v, zero);
+    __m128i hi = _mm_unpackhi_epi8(v, zero);
+    const __m128i parts[4] = {
+        _mm_unpacklo_epi16(lo, zero), _mm_unpackhi_epi16(lo, zero),
+        _mm_unpacklo_epi16(hi, zero), _mm_unpackhi_epi16(hi, zero)};
+    for (int k = 0; k < 4; ++k) {
+      _mm_storeu_ps(dst + i + 4 * k,
+                    _mm_div_ps(_mm_cvtepi32_ps(parts[k]), scale));
+    }
+  }
+  NormalizedToFloatScalar(src + i, count - i, dst + i);
+}
+
+static void NormalizedI8Sse2(const int8_t *src, size_t count, float *dst) {
+  const __m128 scale = _mm_set1_ps(127.0f);
+  const __m128 minusOne = _mm_set1_ps(-1.0f);
+  size_t i = 0;
+  for (; i + 16 <= count; i += 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+    // Sign-extend by placing each byte in the high half and shifting down
+    __m128i lo = _mm_srai_epi16(_mm_unpacklo_epi8(v, v), 8);
+    __m128i hi = _mm_srai_epi16(_mm_unpackhi_epi8(v, v), 8);
+    const __m128i parts[4] = {
+        _mm_srai_epi32(_mm_unpacklo_epi16(lo, lo), 16),
+        _mm_srai_epi32(_mm_unpackhi_epi16(lo, lo), 16),
+        _mm_srai_epi32(_mm_unpacklo_epi16(hi, hi), 16),
+        _mm_srai_epi32(_mm_unpackhi_epi16(hi, hi), 16)};
+    for (int k = 0; k < 4; ++k) {
+      __m128 f = _mm_div_ps(_mm_cvtepi32_ps(parts[k]), scale);
+      _mm_storeu_ps(dst + i + 4 * k, _mm_max_ps(f, minusOne));
+    }
+  }
+  NormalizedToFloatScalar(src + i, count - i, dst + i);
+}
+
+static void NormalizedU16Sse2(const uint16_t *src, size_t count, float *dst) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128 scale = _mm_set1_ps(65535.0f);
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+    _mm_storeu_ps(dst + i, _mm_div_ps(_mm_cvtepi32_ps(
+                                          _mm_unpacklo_epi16(v, zero)),
+                                      scale));
+    _mm_storeu_ps(dst + i + 4, _mm_div_ps(_mm_cvtepi32_ps(
+                                              _mm_unpackhi_epi16(v, zero)),
+                                          scale));
+  }
+  NormalizedToFloatScalar(src + i, count - i, dst + i);
+}
+
+static void NormalizedI16Sse2(const int16_t *src, size_t count, float *dst) {
+  const __m128 scale = _mm_set1_ps(32767.0f);
+  const __m128 minusOne = _mm_set1_ps(-1.0f);
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+    __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+    __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+    _mm_storeu_ps(dst + i,
+                  _mm_max_ps(_mm_div_ps(_mm_cvtepi32_ps(lo), scale), minusOne));
+    _mm_storeu_ps(dst + i + 4,
+                  _mm_max_ps(_mm_div_ps(_mm_cvtepi32_ps(hi), scale), minusOne));
+  }
+  NormalizedToFloatScalar(src + i, count - i, dst + i);
+}
+
+TINYGLTF_TARGET_AVX2
+static void WidenU8Avx2(const uint8_t *src, size_t count, uint32_t *dst) {
+  size_t i = 0;
+  for (; i + 32 <= count; i += 32) {
+    for (int k = 0; k < 4; ++k) {
+      __m128i v =
+          _mm_loadl_epi64(reinterpret_cast<const __m128i *>(src + i + 8 * k));
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i + 8 * k),
+                          _mm256_cvtepu8_epi32(v));
+    }
+  }
+  WidenU8Scalar(src + i, count - i, dst + i);
+}
+
+TINYGLTF_TARGET_AVX2
+static void WidenU16Avx2(const uint16_t *src, size_t count, uint32_t *dst) {
+  size_t i = 0;
+  for (; i + 16 <= count; i += 16) {
+    for (int k = 0; k < 2; ++k) {
+      __m128i v =
+          _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i + 8 * k));
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i + 8 * k),
+                          _mm256_cvtepu16_epi32(v));
+    }
+  }
+  WidenU16Scalar(src + i, count - i, dst + i);
+}
+
+// Two elements per 256-bit register; see BoundsFloat3Sse2 for the 4th lanes.
+TINYGLTF_TARGET_AVX2
+static void BoundsFloat3Avx2(const unsigned char *src, size_t stride,
+                             size_t count, float min[3], float max[3]) {
+  __m256 lo = _mm256_setr_ps(min[0], min[1], min[2], 0.0f, min[0], min[1],
+                             min[2], 0.0f);
+  __m256 hi = _mm256_setr_ps(max[0], max[1], max[2], 0.0f, max[0], max[1],
+                             max[2], 0.0f);
+  size_t i = 0;
+  for (; i + 2 < count; i += 2) {
+    __m256 v = _mm256_insertf128_ps(
+        _mm256_castps128_ps256(
+            _mm_loadu_ps(reinterpret_cast<const float *>(src + i * stride))),
+        _mm_loadu_ps(reinterpret_cast<const float *>(src + (i + 1) * stride)),
+        1);
+    lo = _mm256_min_ps(v, lo);
+    hi = _mm256_max_ps(v, hi);
+  }
+  __m128 l = _mm_min_ps(_mm256_extractf128_ps(lo, 1), _mm256_castps256_ps128(lo));
+  __m128 h = _mm_max_ps(_mm256_extractf128_ps(hi, 1), _mm256_castps256_ps128(hi));
+  float ls[4], hs[4];
+  _mm_storeu_ps(ls, l);
+  _mm_storeu_ps(hs, h);
+  for (int c = 0; c < 3; ++c) {
+    min[c] = ls[c];
+    max[c] = hs[c];
+  }
+  BoundsFloat3Sse2(src + i * stride, stride, count - i, min, max);
+}
+
+// Widened integers in `v` (8 lanes) to normalized floats.
+TINYGLTF_TARGET_AVX2
+static inline void StoreNormalizedAvx2(float *dst, __m256i v, float scale,
+                                       bool isSigned) {
+  __m256 f = _mm256_div_ps(_mm256_cvtepi32_ps(v), _mm256_set1_ps(scale));
+  if (isSigned) f = _mm256_max_ps(f, _mm256_set1_ps(-1.0f));
+  _mm256_storeu_ps(dst, f);
+}
+
+TINYGLTF_TARGET_AVX2
+static void NormalizedToFloatAvx2(const void *src, int componentType,
+                                  size_t count, float *dst) {
+  const unsigned char *p = static_cast<const unsigned char *>(src);
+  size_t i = 0;
+  switch (componentType) {
+    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+      for (; i + 8 <= count; i += 8) {
+        __m128i v = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(p + i));
+        StoreNormalizedAvx2(dst + i, _mm256_cvtepu8_epi32(v), 255.0f, false);
+      }
+      NormalizedToFloatScalar(p + i, count - i, dst + i);
+      break;
+    case TINYGLTF_COMPONENT_TYPE_BYTE:
+      for (; i + 8 <= count; i += 8) {
+        __m128i v = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(p + i));
+        StoreNormalizedAvx2(dst + i, _mm256_cvtepi8_epi32(v), 127.0f, true);
+      }
+      NormalizedToFloatScalar(reinterpret_cast<const int8_t *>(p) + i,
+                              count - i, dst + i);
+      break;
+    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+      for (; i + 8 <= count; i += 8) {
+        __m128i v =
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 2 * i));
+        StoreNormalizedAvx2(dst + i, _mm256_cvtepu16_epi32(v), 65535.0f,
+                            false);
+      }
+      NormalizedToFloatScalar(reinterpret_cast<const uint16_t *>(p) + i,
+                              count - i, dst + i);
+      break;
+    default:  // TINYGLTF_COMPONENT_TYPE_SHORT
+      for (; i + 8 <= count; i += 8) {
+        __m128i v =
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 2 * i));
+        StoreNormalizedAvx2(dst + i, _mm256_cvtepi16_epi32(v), 32767.0f,
+                            true);
+      }
+      NormalizedToFloatScalar(reinterpret_cast<const int16_t *>(p) + i,
+                              count - i, dst + i);
+      break;
+  }
+}
+
+TINYGLTF_TARGET_AVX2
+static void FloatToHalfAvx2(const float *src, size_t count, uint16_t *dst) {
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(src + i),
+                                _MM_FROUND_TO_NEAREST_INT);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), h);
+  }
+  FloatToHalfScalar(src + i, count - i, dst + i);
+}
+
+// Base64 with pshufb lookups (W. Mula, D. Lemire, "Faster Base64 Encoding
+// and Decoding Using AVX2 Instructions", 2018). SSSE3 is not part of the
+// SSE2 baseline, so the SSE2 tier checks for it separately.
+
+static bool KernelHasSsse3() {
+#ifdef _MSC_VER
+  static const bool supported = [] {
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 9)) != 0;
+  }();
+#else
+  static const bool supported = __builtin_cpu_supports("ssse3") != 0;
+#endif
+  return supported;
+}
+
+// Digit values of 16 characters. Lanes of `invalid` are non-zero for
+// characters outside the alphabet, whose values are garbage.
+TINYGLTF_TARGET_SSSE3
+static inline __m128i Base64ValuesSsse3(__m128i in, __m128i *invalid) {
+  const __m128i lutLo =
+      _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                    0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+  const __m128i lutHi =
+      _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10,
+                    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+  const __m128i lutRoll =
+      _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+  const __m128i nibble = _mm_set1_epi8(0x0f);
+  const __m128i hi = _mm_and_si128(_mm_srli_epi32(in, 4), nibble);
+  const __m128i lo = _mm_and_si128(in, nibble);
+  *invalid = _mm_and_si128(_mm_shuffle_epi8(lutLo, lo),
+                           _mm_shuffle_epi8(lutHi, hi));
+  const __m128i slash = _mm_cmpeq_epi8(in, _mm_set1_epi8('/'));
+  return _mm_add_epi8(in, _mm_shuffle_epi8(lutRoll, _mm_add_epi8(slash, hi)));
+}
+
+TINYGLTF_TARGET_SSSE3
+static size_t Base64ScanSsse3(const char *src, size_t len) {
+  size_t i = 0;
+  for (; i + 16 <= len; i += 16) {
+    __m128i invalid;
+    Base64ValuesSsse3(
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i)), &invalid);
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(invalid, _mm_setzero_si128())) !=
+        0xffff) {
+      break;
+    }
+  }
+  return i;
+}
+
+// Decodes whole blocks of 16 valid digits; returns the digits consumed. Each
+// 12-byte block is stored as 16 bytes, so the loop stops short of the end.
+TINYGLTF_TARGET_SSSE3
+static size_t Base64DecodeSsse3(const char *src, size_t count,
+                                unsigned char *dst) {
+  size_t i = 0;
+  for (; i + 24 <= count; i += 16, dst += 12) {
+    __m128i invalid;
+    __m128i v = Base64ValuesSsse3(
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i)), &invalid);
+    // Pack 4 x 6 bits into 3 bytes per 32-bit lane, then drop the 4th bytes
+    v = _mm_maddubs_epi16(v, _mm_set1_epi32(0x01400140));
+    v = _mm_madd_epi16(v, _mm_set1_epi32(0x00011000));
+    v = _mm_shuffle_epi8(v, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13,
+                                          12, -1, -1, -1, -1));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst), v);
+  }
+  return i;
+}
+
+// Splits 12 bytes (in the low 3/4 of `in`) into 16 6-bit indices.
+TINYGLTF_TARGET_SSSE3
+static inline __m128i Base64IndicesSsse3(__m128i in) {
+  in = _mm_shuffle_epi8(
+      in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+  const __m128i ac = _mm_mulhi_epu16(
+      _mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00)), _mm_set1_epi32(0x04000040));
+  const __m128i bd = _mm_mullo_epi16(
+      _mm_and_si128(in, _mm_set1_epi32(0x003f03f0)), _mm_set1_epi32(0x01000010));
+  return _mm_or_si128(ac, bd);
+}
+
+TINYGLTF_TARGET_SSSE3
+static inline __m128i Base64CharsSsse3(__m128i indices) {
+  // Offset to add per range: A-Z, a-z, 0-9 (10 entries), '+', '/'
+  const __m128i offsets = _mm_setr_epi8(65, 71, -4, -4, -4, -4, -4, -4, -4,
+                                        -4, -4, -4, -19, -16, 0, 0);
+  __m128i range = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+  range = _mm_sub_epi8(range, _mm_cmpgt_epi8(indices, _mm_set1_epi8(25)));
+  return _mm_add_epi8(indices, _mm_shuffle_epi8(offsets, range));
+}
+
+// Encodes whole 12-byte blocks (reading 16) and returns the bytes consumed.
+TINYGLTF_TARGET_SSSE3
+static size_t Base64EncodeSsse3(const unsigned char *src, size_t count,
+                                char *dst) {
+  size_t i = 0;
+  for (; i + 16 <= count; i += 12, dst += 16) {
+    __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst),
+                     Base64CharsSsse3(Base64IndicesSsse3(in)));
+  }
+  return i;
+}
+
+// The AVX2 versions run the same steps on two 128-bit lanes.
+
+TINYGLTF_TARGET_AVX2
+static inline __m256i Base64ValuesAvx2(__m256i in, __m256i *invalid) {
+  const __m256i lutLo = _mm256_setr_epi8(
+      0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1a,
+      0x1b, 0x1b, 0x1b, 0x1a, 0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+      0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+  const __m256i lutHi = _mm256_setr_epi8(
+      0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10,
+      0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+      0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+  const __m256i lutRoll = _mm256_setr_epi8(
+      0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0, 0, 16, 19, 4,
+      -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+  const __m256i nibble = _mm256_set1_epi8(0x0f);
+  const __m256i hi = _mm256_and_si256(_mm256_srli_epi32(in, 4), nibble);
+  const __m256i lo = _mm256_and_si256(in, nibble);
+  *invalid = _mm256_and_si256(_mm256_shuffle_epi8(lutLo, lo),
+                              _mm256_shuffle_epi8(lutHi, hi));
+  const __m256i slash = _mm256_cmpeq_epi8(in, _mm256_set1_epi8('/'));
+  return _mm256_add_epi8(
+      in, _mm256_shuffle_epi8(lutRoll, _mm256_add_epi8(slash, hi)));
+}
+
+TINYGLTF_TARGET_AVX2
+static size_t Base64ScanAvx2(const char *src, size_t len) {
+  size_t i = 0;
+  for (; i + 32 <= len; i += 32) {
+    __m256i invalid;
+    Base64ValuesAvx2(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i)),
+        &invalid);
+    if (!_mm256_testz_si256(invalid, invalid)) break;
+  }
+  return i;
+}
+
+TINYGLTF_TARGET_AVX2
+static size_t Base64DecodeAvx2(const char *src, size_t count,
+                               unsigned char *dst) {
+  size_t i = 0;
+  for (; i + 44 <= count; i += 32, dst += 24) {
+    __m256i invalid;
+    __m256i v = Base64ValuesAvx2(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i)),
+        &invalid);
+    v = _mm256_maddubs_epi16(v, _mm256_set1_epi32(0x01400140));
+    v = _mm256_madd_epi16(v, _mm256_set1_epi32(0x00011000));
+    v = _mm256_shuffle_epi8(
+        v, _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1,
+                            -1, 2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1,
+                            -1, -1));
+    // Close the gap between the lanes' 12-byte halves
+    v = _mm256_permutevar8x32_epi32(v, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 0, 0));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst), v);
+  }
+  return i;
+}
+
+TINYGLTF_TARGET_AVX2
+static size_t Base64EncodeAvx2(const unsigned char *src, size_t count,
+                               char *dst) {
+  const __m256i split = _mm256_setr_epi8(
+      1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10, 1, 0, 2, 1, 4, 3, 5,
+      4, 7, 6, 8, 7, 10, 9, 11, 10);
+  const __m256i offsets = _mm256_setr_epi8(
+      65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -19, -16, 0, 0, 65, 71,
+      -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, -19, -16, 0, 0);
+  size_t i = 0;
+  for (; i + 28 <= count; i += 24, dst += 32) {
+    const __m128i *p = reinterpret_cast<const __m128i *>(src + i);
+    __m256i in = _mm256_inserti128_si256(
+        _mm256_castsi128_si256(_mm_loadu_si128(p)),
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i + 12)), 1);
+    in = _mm256_shuffle_epi8(in, split);
+    const __m256i ac =
+        _mm256_mulhi_epu16(_mm256_and_si256(in, _mm256_set1_epi32(0x0fc0fc00)),
+                           _mm256_set1_epi32(0x04000040));
+    const __m256i bd =
+        _mm256_mullo_epi16(_mm256_and_si256(in, _mm256_set1_epi32(0x003f03f0)),
+                           _mm256_set1_epi32(0x01000010));
+    const __m256i indices = _mm256_or_si256(ac, bd);
+    __m256i range = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+    range = _mm256_sub_epi8(
+        range, _mm256_cmpgt_epi8(indices, _mm256_set1_epi8(25)));
+    _mm256_storeu_si256(
+        reinterpret_cast<__m256i *>(dst),
+        _mm256_add_epi8(indices, _mm256_shuffle_epi8(offsets, range)));
+  }
+  return i;
+}
+
+#endif  // TINYGLTF_KERNELS_X86
+
+}  // namespace detail
+
+namespace detail {
+
+// Scatters `count` elements of Size bytes; the fixed size lets the compiler
+// emit one or two vector moves per element.
+template <size_t Size>
+static void ScatterElements(const uint32_t *indices, size_t count,
+                            const unsigned char *values, unsigned char *dst) {
+  for (size_t k = 0; k < count; ++k) {
+    std::memcpy(dst + size_t(indices[k]) * Size, values + k * Size, Size);
+  }
+}
+
+static void ScatterElements(const uint32_t *indices, size_t count,
+                            const unsigned char *values, size_t size,
+                            unsigned char *dst) {
+  switch (size) {
+    case 4:
+      return ScatterElements<4>(indices, count, values, dst);
+    case 8:
+      return ScatterElements<8>(indices, count, values, dst);
+    case 12:
+      return ScatterElements<12>(indices, count, values, dst);
+    case 16:
+      return ScatterElements<16>(indices, count, values, dst);
+    default:
+      for (size_t k = 0; k < count; ++k) {
+        std::memcpy(dst + size_t(indices[k]) * size, values + k * size, size);
+      }
+  }
+}
+
+}  // namespace detail
+
+const std::vector<unsigned char> *SparseAccessorCache::Get(const Model &model,
+                                                           int accessor,
+                                                           std::string *err) {
+  std::map<int, std::vector<unsigned char>>::const_iterator it =
+      dense_.find(accessor);
+  if (it != dense_.end()) return &it->second;
+
+  // Validates the accessor, including its sparse indices
+  AccessorView<unsigned char> view;
+  if (!view.Init(model, accessor, err)) return nullptr;
+
+  const size_t elementSize = view.elementSize_;
+  if (view.count_ > (std::numeric_limits<size_t>::max)() / elementSize) {
+    if (err) {
+      (*err) += "accessor[" + std::to_string(accessor) +
+                "] is too large to materialize.\n";
+    }
+    return nullptr;
+  }
+  std::vector<unsigned char> dense(view.count_ * elementSize);
+  if (view.data_ && view.stride_ == elementSize) {
+    if (!dense.empty()) std::memcpy(dense.data(), view.data_, dense.size());
+  } else if (view.data_) {
+    for (size_t i = 0; i < view.count_; ++i) {
+      std::memcpy(&dense[i * elementSize], view.data_ + i * view.stride_,
+                  elementSize);
+    }
+  }  // else: no bufferView, the base is zeros
+
+  // Widen the sparse indices in chunks with the SIMD kernels, then scatter
+  const size_t kChunk = 4096;
+  uint32_t indices[kChunk];
+  for (size_t k = 0; k < view.sparseCount_; k += kChunk) {
+    const size_t n = std::min(kChunk, view.sparseCount_ - k);
+    const unsigned char *src = view.sparseIndices_ + k * view.sparseIndexSize_;
+    switch (view.sparseIndexSize_) {
+      case 1:
+        kernels::WidenU8ToU32(src, n, indices);
+        break;
+      case 2:
+        if (reinterpret_cast<uintptr_t>(src) % 2 == 0) {
+          kernels::WidenU16ToU32(reinterpret_cast<const uint16_t *>(src), n,
+                                 indices);
+        } else {
+          for (size_t j = 0; j < n; ++j) {
+            uint16_t v;
+            std::memcpy(&v, src + 2 * j, 2);
+            indices[j] = v;
+          }
+        }
+        break;
+      default:
+        std::memcpy(indices, src, n * 4);
+        break;
+    }
+    detail::ScatterElements(indices, n, view.sparseValues_ + k * elementSize,
+                            elementSize, dense.data());
+  }
+
+  return &(dense_[accessor] = std::move(dense));
+}
 
-  return true;
+namespace kernels {
+
+Isa SupportedIsa() {
+  static const Isa isa = detail::DetectKernelIsa();
+  return isa;
 }
 
-bool IsDataURI(const std::string &in) {
-  std::string header = "data:application/octet-stream;base64,";
-  if (in.find(header) == 0) {
-    return true;
-  }
+Isa ActiveIsa() { return detail::KernelIsaSlot(); }
 
-  header = "data:image/jpeg;base64,";
-  if (in.find(header) == 0) {
-    return true;
-  }
+Isa SetIsa(Isa isa) {
+  const Isa supported = SupportedIsa();
+  detail::KernelIsaSlot() = isa < supported ? isa : supported;
+  return detail::KernelIsaSlot();
+}
 
-  header = "data:image/png;base64,";
-  if (in.find(header) == 0) {
-    return true;
+const char *IsaName(Isa isa) {
+  switch (isa) {
+    case Isa::SSE2:
+      return "sse2";
+    case Isa::AVX2:
+      return "avx2";
+    default:
+      return "scalar";
   }
+}
 
-  header = "data:image/bmp;base64,";
-  if (in.find(header) == 0) {
-    return true;
+void WidenU8ToU32(const uint8_t *src, size_t count, uint32_t *dst) {
+#ifdef TINYGLTF_KERNELS_X86
+  switch (ActiveIsa()) {
+    case Isa::AVX2:
+      return detail::WidenU8Avx2(src, count, dst);
+    case Isa::SSE2:
+      return detail::WidenU8Sse2(src, count, dst);
+    default:
+      break;
   }
+#endif
+  detail::WidenU8Scalar(src, count, dst);
+}
 
-  header = "data:image/gif;base64,";
-  if (in.find(header) == 0) {
-    return true;
+void WidenU16ToU32(const uint16_t *src, size_t count, uint32_t *dst) {
+#ifdef TINYGLTF_KERNELS_X86
+  switch (ActiveIsa()) {
+    case Isa::AVX2:
+      return detail::WidenU16Avx2(src, count, dst);
+    case Isa::SSE2:
+      return detail::WidenU16Sse2(src, count, dst);
+    default:
+      break;
   }
+#endif
+  detail::WidenU16Scalar(src, count, dst);
+}
 
-  header = "data:text/plain;base64,";
-  if (in.find(header) == 0) {
-    return true;
+void GatherFloat3(const unsigned char *src, size_t stride, size_t count,
+                  float *dst) {
+  if (stride == 12) {
+    if (count) std::memcpy(dst, src, count * 12);
+    return;
   }
-
-  header = "data:application/gltf-buffer;base64,";
-  if (in.find(header) == 0) {
-    return true;
+#ifdef TINYGLTF_KERNELS_X86
+  // 12-byte elements don't fill a 256-bit register, so AVX2 uses SSE2 too.
+  if (ActiveIsa() != Isa::Scalar) {
+    return detail::GatherFloat3Sse2(src, stride, count, dst);
   }
-
-  return false;
+#endif
+  detail::GatherFloat3Scalar(src, stride, count, dst);
 }
 
-bool DecodeDataURI(std::vector<unsigned char> *out, std::string &mime_type,
-                   const std::string &in, size_t reqBytes, bool checkSize) {
-  std::string header = "data:application/octet-stream;base64,";
-  std::string data;
-  if (in.find(header) == 0) {
-    data = base64_decode(in.substr(header.size()));  // cut mime string.
+void BoundsFloat3(const unsigned char *src, size_t stride, size_t count,
+                  float min[3], float max[3]) {
+  for (int c = 0; c < 3; ++c) {
+    min[c] = std::numeric_limits<float>::infinity();
+    max[c] = -std::numeric_limits<float>::infinity();
   }
-
-  if (data.empty()) {
-    header = "data:image/jpeg;base64,";
-    if (in.find(header) == 0) {
-      mime_type = "image/jpeg";
-      data = base64_decode(in.substr(header.size()));  // cut mime string.
-    }
+#ifdef TINYGLTF_KERNELS_X86
+  switch (ActiveIsa()) {
+    case Isa::AVX2:
+      return detail::BoundsFloat3Avx2(src, stride, count, min, max);
+    case Isa::SSE2:
+      return detail::BoundsFloat3Sse2(src, stride, count, min, max);
+    default:
+      break;
   }
+#endif
+  detail::BoundsFloat3Scalar(src, stride, count, min, max);
+}
 
-  if (data.empty()) {
-    header = "data:image/png;base64,";
-    if (in.find(header) == 0) {
-      mime_type = "image/png";
-      data = base64_decode(in.substr(header.size()));  // cut mime string.
-    }
+bool NormalizedToFloat(const void *src, int componentType, size_t count,
+                       float *dst) {
+  switch (componentType) {
+    case TINYGLTF_COMPONENT_TYPE_BYTE:
+    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+    case TINYGLTF_COMPONENT_TYPE_SHORT:
+    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+      break;
+    default:
+      return false;
   }
-
-  if (data.empty()) {
-    header = "data:image/bmp;base64,";
-    if (in.find(header) == 0) {
-      mime_type = "image/bmp";
-      data = base64_decode(in.substr(header.size()));  // cut mime string.
-    }
+#ifdef TINYGLTF_KERNELS_X86
+  if (ActiveIsa() == Isa::AVX2) {
+    detail::NormalizedToFloatAvx2(src, componentType, count, dst);
+    return true;
   }
-
-  if (data.empty()) {
-    header = "data:image/gif;base64,";
-    if (in.find(header) == 0) {
-      mime_type = "image/gif";
-      data = base64_decode(in.substr(header.size()));  // cut mime string.
+  if (ActiveIsa() == Isa::SSE2) {
+    switch (componentType) {
+      case TINYGLTF_COMPONENT_TYPE_BYTE:
+        detail::NormalizedI8Sse2(static_cast<const int8_t *>(src), count, dst);
+        break;
+      case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+        detail::NormalizedU8Sse2(static_cast<const uint8_t *>(src), count,
+                                 dst);
+        break;
+      case TINYGLTF_COMPONENT_TYPE_SHORT:
+        detail::NormalizedI16Sse2(static_cast<const int16_t *>(src), count,
+                                  dst);
+        break;
+      default:
+        detail::NormalizedU16Sse2(static_cast<const uint16_t *>(src), count,
+                                  dst);
+        break;
     }
+    return true;
+  }
+#endif
+  switch (componentType) {
+    case TINYGLTF_COMPONENT_TYPE_BYTE:
+      detail::NormalizedToFloatScalar(static_cast<const int8_t *>(src), count,
+                                      dst);
+      break;
+    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+      detail::NormalizedToFloatScalar(static_cast<const uint8_t *>(src), count,
+                                      dst);
+      break;
+    case TINYGLTF_COMPONENT_TYPE_SHORT:
+      detail::NormalizedToFloatScalar(static_cast<const int16_t *>(src), count,
+                                      dst);
+      break;
+    default:
+      detail::NormalizedToFloatScalar(static_cast<const uint16_t *>(src),
+                                      count, dst);
+      break;
   }
+  return true;
+}
 
-  if (data.empty()) {
-    header = "data:text/plain;base64,";
-    if (in.find(header) == 0) {
-      mime_type = "text/plain";
-      data = base64_decode(in.substr(header.size()));
-    }
+void FloatToHalf(const float *src, size_t count, uint16_t *dst) {
+#ifdef TINYGLTF_KERNELS_X86
+  // SSE2 has no half conversion; the AVX2 tier includes F16C.
+  if (ActiveIsa() == Isa::AVX2) {
+    return detail::FloatToHalfAvx2(src, count, dst);
   }
+#endif
+  detail::FloatToHalfScalar(src, count, dst);
+}
 
-  if (data.empty()) {
-    header = "data:application/gltf-buffer;base64,";
-    if (in.find(header) == 0) {
-      data = base64_decode(in.substr(header.size()));
-    }
+size_t Base64DecodedSize(const char *src, size_t len, size_t *digits) {
+  size_t n = 0;
+#ifdef TINYGLTF_KERNELS_X86
+  if (ActiveIsa() == Isa::AVX2) {
+    n = detail::Base64ScanAvx2(src, len);
+  } else if (ActiveIsa() == Isa::SSE2 && detail::KernelHasSsse3()) {
+    n = detail::Base64ScanSsse3(src, len);
   }
+#endif
+  n = detail::Base64ScanScalar(src, len, n);
+  (*digits) = n;
+  return n / 4 * 3 + (n % 4 ? n % 4 - 1 : 0);
+}
 
-  // TODO(syoyo): Allow empty buffer? #229
-  if (data.empty()) {
-    return false;
+void Base64Decode(const char *src, size_t digits, unsigned char *dst) {
+  size_t i = 0;
+#ifdef TINYGLTF_KERNELS_X86
+  if (ActiveIsa() == Isa::AVX2) {
+    i = detail::Base64DecodeAvx2(src, digits, dst);
+  } else if (ActiveIsa() == Isa::SSE2 && detail::KernelHasSsse3()) {
+    i = detail::Base64DecodeSsse3(src, digits, dst);
   }
+#endif
+  detail::Base64DecodeScalar(src + i, digits - i, dst + i / 4 * 3);
+}
 
-  if (checkSize) {
-    if (data.size() != reqBytes) {
-      return false;
-    }
-    out->resize(reqBytes);
-  } else {
-    out->resize(data.size());
+size_t Base64EncodedSize(size_t count) { return (count + 2) / 3 * 4; }
+
+void Base64Encode(const unsigned char *src, size_t count, char *dst) {
+  size_t i = 0;
+#ifdef TINYGLTF_KERNELS_X86
+  if (ActiveIsa() == Isa::AVX2) {
+    i = detail::Base64EncodeAvx2(src, count, dst);
+  } else if (ActiveIsa() == Isa::SSE2 && detail::KernelHasSsse3()) {
+    i = detail::Base64EncodeSsse3(src, count, dst);
   }
-  std::copy(data.begin(), data.end(), out->begin());
-  return true;
+#endif
+  detail::Base64EncodeScalar(src + i, count - i, dst + i / 3 * 4);
 }
 
+}  // namespace kernels
+
 namespace detail {
 bool GetInt(const detail::json &o, int &val) {
 #ifdef TINYGLTF_USE_RAPIDJSON
@@ -3659,6 +7081,136 @@ std::string JsonToString(const detail::json &o, int spacing = -1) {
 #endif
 }
 
+/// Receives the output of JsonStreamWriter; returns false on a write error.
+typedef std::function<bool(const char *, size_t)> JsonSink;
+
+#ifndef TINYGLTF_USE_RAPIDJSON
+///
+/// Writes a JSON document into a JsonSink in chunks, formatted exactly as
+/// json::dump(indent) formats the same document. Containers are opened and
+/// closed one at a time and complete values are dumped as they are added, so
+/// the whole document never has to exist as a DOM or a string.
+///
+class JsonStreamWriter {
+ public:
+  JsonStreamWriter(const JsonSink &sink, int indent)
+      : sink_(sink), indent_(indent) {
+    buffer_.reserve(kChunkSize);
+  }
+
+  void BeginObject() { Open('{'); }
+  void EndObject() { Close('}'); }
+  void BeginArray() { Open('['); }
+  void EndArray() { Close(']'); }
+
+  /// Starts an object member; its value is written next.
+  void Key(const std::string &key) {
+    Next();
+    const std::string quoted = json(key).dump();
+    Append(quoted.data(), quoted.size());
+    Append(indent_ < 0 ? ":" : ": ", indent_ < 0 ? 1 : 2);
+    after_key_ = true;
+  }
+
+  /// Writes a complete value.
+  void Value(const json &value) {
+    Next();
+    const std::string s = value.dump(indent_);
+    if (indent_ < 0 || open_.empty()) {
+      Append(s.data(), s.size());
+      return;
+    }
+    // Nested lines of the dump are shifted to the current depth; strings in
+    // JSON text never contain a raw newline.
+    size_t begin = 0;
+    for (size_t nl; (nl = s.find('\n', begin)) != std::string::npos;
+         begin = nl + 1) {
+      Append(s.data() + begin, nl + 1 - begin);
+      Indent(open_.size());
+    }
+    Append(s.data() + begin, s.size() - begin);
+  }
+
+  /// Writes a string value whose characters are added with Append() between
+  /// BeginString() and EndString(); they are written without escaping.
+  void BeginString() {
+    Next();
+    Append("\"", 1);
+  }
+  void EndString() { Append("\"", 1); }
+
+  void Append(const char *s, size_t n) {
+    std::memcpy(Append(n), s, n);
+  }
+
+  /// Returns space for `n` characters at the end of the output.
+  char *Append(size_t n) {
+    if (buffer_.size() + n > kChunkSize) Drain();
+    const size_t offset = buffer_.size();
+    buffer_.resize(offset + n);
+    return &buffer_[offset];
+  }
+
+  /// Passes buffered output to the sink; returns false if any write failed.
+  bool Flush() {
+    Drain();
+    return ok_;
+  }
+
+ private:
+  static const size_t kChunkSize = 64 * 1024;
+
+  // Separates a value from the previous one in the enclosing container.
+  void Next() {
+    if (after_key_) {
+      after_key_ = false;
+      return;
+    }
+    if (open_.empty()) return;
+    if (!open_.back()) Append(",", 1);
+    open_.back() = false;
+    if (indent_ >= 0) {
+      Append("\n", 1);
+      Indent(open_.size());
+    }
+  }
+
+  void Open(char c) {
+    Next();
+    Append(&c, 1);
+    open_.push_back(true);
+  }
+
+  void Close(char c) {
+    const bool empty = open_.back();
+    open_.pop_back();
+    if (!empty && indent_ >= 0) {
+      Append("\n", 1);
+      Indent(open_.size());
+    }
+    Append(&c, 1);
+  }
+
+  void Indent(size_t depth) {
+    const size_t n = depth * size_t(indent_);
+    std::memset(Append(n), ' ', n);
+  }
+
+  void Drain() {
+    if (ok_ && !buffer_.empty()) ok_ = sink_(buffer_.data(), buffer_.size());
+    buffer_.clear();
+  }
+
+  JsonSink sink_;
+  int indent_;
+  std::string buffer_;
+  // Per open container, whether nothing has been written into it yet.
+  std::vector<bool> open_;
+  bool after_key_ = false;
+  bool ok_ = true;
+};
+#endif
+
 }  // namespace detail
 
 static bool ParseJsonAsValue(Value *ret, const detail::json &o) {
@@ -3668,6 +7220,7 @@ static bool ParseJsonAsValue(Value *ret, const detail::json &o) {
   switch (o.GetType()) {
     case Type::kObjectType: {
       Value::Object value_object;
+      value_object.reserve(o.MemberCount());
       for (auto it = o.MemberBegin(); it != o.MemberEnd(); ++it) {
         Value entry;
         ParseJsonAsValue(&entry, it->value);
@@ -3713,6 +7266,7 @@ static bool ParseJsonAsValue(Value *ret, const detail::json &o) {
   switch (o.type()) {
     case detail::json::value_t::object: {
       Value::Object value_object;
+      value_object.reserve(o.size());
       for (auto it = o.begin(); it != o.end(); it++) {
         Value entry;
         ParseJsonAsValue(&entry, it.value());
@@ -3948,7 +7502,7 @@ static bool ParseNumberProperty(double *ret, std::string *err,
   return true;
 }
 
-static bool ParseNumberArrayProperty(std::vector<double> *ret, std::string *err,
+static bool ParseNumberArrayProperty(ModelVector<double> *ret, std::string *err,
                                      const detail::json &o,
                                      const std::string &property, bool required,
                                      const std::string &parent_node = "") {
@@ -4002,7 +7556,7 @@ static bool ParseNumberArrayProperty(std::vector<double> *ret, std::string *err,
   return true;
 }
 
-static bool ParseIntegerArrayProperty(std::vector<int> *ret, std::string *err,
+static bool ParseIntegerArrayProperty(ModelVector<int> *ret, std::string *err,
                                       const detail::json &o,
                                       const std::string &property,
                                       bool required,
@@ -4093,7 +7647,7 @@ static bool ParseStringProperty(
   return true;
 }
 
-static bool ParseStringIntegerProperty(std::map<std::string, int> *ret,
+static bool ParseStringIntegerProperty(AttributeMap *ret,
                                        std::string *err, const detail::json &o,
                                        const std::string &property,
                                        bool required,
@@ -4147,7 +7701,7 @@ static bool ParseStringIntegerProperty(std::map<std::string, int> *ret,
   return true;
 }
 
-static bool ParseJSONProperty(std::map<std::string, double> *ret,
+static bool ParseJSONProperty(ModelMap<std::string, double> *ret,
                               std::string *err, const detail::json &o,
                               const std::string &property, bool required) {
   detail::json_const_iterator it;
@@ -4289,13 +7843,15 @@ static bool ParseAsset(Asset *asset, std::string *err, const detail::json &o,
   return true;
 }
 
+// Parses image metadata. For `uri` images the encoded bytes (data URI or
+// external file) are returned in `encoded` for decoding; `bufferView` images
+// are decoded from their buffer by the caller.
 static bool ParseImage(Image *image, const int image_idx, std::string *err,
                        std::string *warn, const detail::json &o,
                        bool store_original_json_for_extras_and_extensions,
                        const std::string &basedir, const size_t max_file_size,
                        FsCallbacks *fs, const URICallbacks *uri_cb,
-                       const LoadImageDataFunction& LoadImageData = nullptr,
-                       void *load_image_user_data = nullptr) {
+                       std::vector<unsigned char> *encoded) {
   // A glTF image must either reference a bufferView or an image uri
 
   // schema says oneOf [`bufferView`, `uri`]
@@ -4374,6 +7930,7 @@ static bool ParseImage(Image *image, const int image_idx, std::string *err,
   std::vector<unsigned char> img;
 
   if (IsDataURI(uri)) {
+    TINYGLTF_COUNT_COPY(uri.size());  // out of the JSON document
     if (!DecodeDataURI(&img, image->mimeType, uri, 0, false)) {
       if (err) {
         (*err) += "Failed to decode 'uri' for image[" +
@@ -4425,15 +7982,8 @@ static bool ParseImage(Image *image, const int image_idx, std::string *err,
 #endif
   }
 
-  if (LoadImageData == nullptr) {
-    if (err) {
-      (*err) += "No LoadImageData callback specified.\n";
-    }
-    return false;
-  }
-
-  return LoadImageData(image, image_idx, err, warn, 0, 0, &img.at(0),
-                       static_cast<int>(img.size()), load_image_user_data);
+  encoded->swap(img);
+  return true;
 }
 
 static bool ParseTexture(Texture *texture, std::string *err,
@@ -4455,69 +8005,978 @@ static bool ParseTexture(Texture *texture, std::string *err,
 
   ParseStringProperty(&texture->name, err, o, "name", false);
 
-  return true;
+  return true;
+}
+
+static bool ParseTextureInfo(
+    TextureInfo *texinfo, std::string *err, const detail::json &o,
+    bool store_original_json_for_extras_and_extensions) {
+  if (texinfo == nullptr) {
+    return false;
+  }
+
+  if (!ParseIntegerProperty(&texinfo->index, err, o, "index",
+                            /* required */ true, "TextureInfo")) {
+    return false;
+  }
+
+  ParseIntegerProperty(&texinfo->texCoord, err, o, "texCoord", false);
+
+  ParseExtrasAndExtensions(texinfo, err, o,
+                           store_original_json_for_extras_and_extensions);
+
+  return true;
+}
+
+static bool ParseNormalTextureInfo(
+    NormalTextureInfo *texinfo, std::string *err, const detail::json &o,
+    bool store_original_json_for_extras_and_extensions) {
+  if (texinfo == nullptr) {
+    return false;
+  }
+
+  if (!ParseIntegerProperty(&texinfo->index, err, o, "index",
+                            /* required */ true, "NormalTextureInfo")) {
+    return false;
+  }
+
+  ParseIntegerProperty(&texinfo->texCoord, err, o, "texCoord", false);
+  ParseNumberProperty(&texinfo->scale, err, o, "scale", false);
+
+  ParseExtrasAndExtensions(texinfo, err, o,
+                           store_original_json_for_extras_and_extensions);
+
+  return true;
+}
+
+static bool ParseOcclusionTextureInfo(
+    OcclusionTextureInfo *texinfo, std::string *err, const detail::json &o,
+    bool store_original_json_for_extras_and_extensions) {
+  if (texinfo == nullptr) {
+    return false;
+  }
+
+  if (!ParseIntegerProperty(&texinfo->index, err, o, "index",
+                            /* required */ true, "NormalTextureInfo")) {
+    return false;
+  }
+
+  ParseIntegerProperty(&texinfo->texCoord, err, o, "texCoord", false);
+  ParseNumberProperty(&texinfo->strength, err, o, "strength", false);
+
+  ParseExtrasAndExtensions(texinfo, err, o,
+                           store_original_json_for_extras_and_extensions);
+
+  return true;
+}
+
+namespace detail {
+
+// EXT_meshopt_compression decoders. The bitstreams are those of meshoptimizer
+// (vertex codec v0, index codec v0/v1, index sequence v0/v1); the filters are
+// applied in place after decoding. The SSE4.1 paths produce bit-identical
+// output and are picked at runtime.
+
+static const size_t kMeshoptVertexBlockSizeBytes = 8192;
+static const size_t kMeshoptVertexBlockMaxSize = 256;
+static const size_t kMeshoptByteGroupSize = 16;
+static const size_t kMeshoptByteGroupDecodeLimit = 24;
+static const size_t kMeshoptTailMaxSize = 32;
+
+static size_t MeshoptVertexBlockSize(size_t vertex_size) {
+  size_t result = (kMeshoptVertexBlockSizeBytes / vertex_size) &
+                  ~(kMeshoptByteGroupSize - 1);
+  return (result < kMeshoptVertexBlockMaxSize) ? result
+                                               : kMeshoptVertexBlockMaxSize;
+}
+
+static inline unsigned char MeshoptUnzigzag8(unsigned char v) {
+  return static_cast<unsigned char>(-(v & 1) ^ (v >> 1));
+}
+
+static const unsigned char *MeshoptDecodeBytesGroup(const unsigned char *data,
+                                                    unsigned char *buffer,
+                                                    int bitslog2) {
+  if (bitslog2 == 0) {
+    memset(buffer, 0, kMeshoptByteGroupSize);
+    return data;
+  }
+  if (bitslog2 == 3) {
+    memcpy(buffer, data, kMeshoptByteGroupSize);
+    return data + kMeshoptByteGroupSize;
+  }
+
+  // 2 or 4 bits per value, most significant first; the all-ones value means
+  // "read a full byte from the tail of the group".
+  const int bits = bitslog2 == 1 ? 2 : 4;
+  const unsigned int sentinel = (1u << bits) - 1;
+  const unsigned char *rest = data + kMeshoptByteGroupSize * size_t(bits) / 8;
+  for (size_t i = 0; i < kMeshoptByteGroupSize; ++i) {
+    size_t bit = i * size_t(bits);
+    unsigned int enc = (data[bit / 8] >> (8 - bits - int(bit % 8))) & sentinel;
+    buffer[i] = enc == sentinel ? *rest++ : static_cast<unsigned char>(enc);
+  }
+  return rest;
+}
+
+static const unsigned char *MeshoptDecodeBytes(const unsigned char *data,
+                                               const unsigned char *data_end,
+                                               unsigned char *buffer,
+                                               size_t buffer_size) {
+  const unsigned char *header = data;
+  // Two header bits per group, rounded up to whole bytes
+  size_t header_size = (buffer_size / kMeshoptByteGroupSize + 3) / 4;
+  if (size_t(data_end - data) < header_size) return nullptr;
+  data += header_size;
+
+  for (size_t i = 0; i < buffer_size; i += kMeshoptByteGroupSize) {
+    if (size_t(data_end - data) < kMeshoptByteGroupDecodeLimit) return nullptr;
+    size_t header_offset = i / kMeshoptByteGroupSize;
+    int bitslog2 = (header[header_offset / 4] >> ((header_offset % 4) * 2)) & 3;
+    data = MeshoptDecodeBytesGroup(data, buffer + i, bitslog2);
+  }
+  return data;
+}
+
+static const unsigned char *MeshoptDecodeVertexBlock(
+    const unsigned char *data, const unsigned char *data_end,
+    unsigned char *vertex_data, size_t vertex_count, size_t vertex_size,
+    unsigned char last_vertex[256]) {
+  unsigned char buffer[kMeshoptVertexBlockMaxSize];
+  unsigned char transposed[kMeshoptVertexBlockSizeBytes];
+  size_t vertex_count_aligned =
+      (vertex_count + kMeshoptByteGroupSize - 1) & ~(kMeshoptByteGroupSize - 1);
+
+  for (size_t k = 0; k < vertex_size; ++k) {
+    data = MeshoptDecodeBytes(data, data_end, buffer, vertex_count_aligned);
+    if (!data) return nullptr;
+
+    // Each byte channel is delta coded against the previous vertex
+    unsigned char p = last_vertex[k];
+    for (size_t i = 0; i < vertex_count; ++i) {
+      unsigned char v = static_cast<unsigned char>(MeshoptUnzigzag8(buffer[i]) + p);
+      transposed[i * vertex_size + k] = v;
+      p = v;
+    }
+  }
+
+  memcpy(vertex_data, transposed, vertex_count * vertex_size);
+  memcpy(last_vertex, &transposed[vertex_size * (vertex_count - 1)],
+         vertex_size);
+  return data;
+}
+
+#ifdef TINYGLTF_MESHOPT_SSE41
+// Lane shuffles for the 2/4-bit groups: for an 8-bit mask of lanes holding the
+// sentinel, where each lane's byte sits in the group tail (0x80 = keep lane).
+struct MeshoptShuffleTables {
+  unsigned char shuffle[256][8];
+  unsigned char count[256];
+
+  MeshoptShuffleTables() {
+    for (int mask = 0; mask < 256; ++mask) {
+      unsigned char n = 0;
+      for (int lane = 0; lane < 8; ++lane) {
+        shuffle[mask][lane] = (mask & (1 << lane)) ? n++ : 0x80;
+      }
+      count[mask] = n;
+    }
+  }
+};
+
+static const MeshoptShuffleTables &MeshoptTables() {
+  static const MeshoptShuffleTables tables;
+  return tables;
+}
+
+static bool MeshoptHasSse41() {
+#ifdef _MSC_VER
+  static const bool supported = [] {
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 19)) != 0;
+  }();
+#else
+  static const bool supported = __builtin_cpu_supports("sse4.1") != 0;
+#endif
+  return supported;
+}
+
+TINYGLTF_TARGET_SSE41
+static const unsigned char *MeshoptDecodeBytesGroupSse(
+    const unsigned char *data, unsigned char *buffer, int bitslog2) {
+  if (bitslog2 == 0) {
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(buffer), _mm_setzero_si128());
+    return data;
+  }
+  if (bitslog2 == 3) {
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(buffer),
+                     _mm_loadu_si128(reinterpret_cast<const __m128i *>(data)));
+    return data + 16;
+  }
+
+  // Spread the packed selectors to one byte per lane, first value in the top bits
+  __m128i sel;
+  size_t header_bytes;
+  if (bitslog2 == 1) {
+    int packed;
+    memcpy(&packed, data, 4);
+    __m128i sel2 = _mm_cvtsi32_si128(packed);
+    __m128i sel22 = _mm_unpacklo_epi8(_mm_srli_epi16(sel2, 4), sel2);
+    __m128i sel2222 = _mm_unpacklo_epi8(_mm_srli_epi16(sel22, 2), sel22);
+    sel = _mm_and_si128(sel2222, _mm_set1_epi8(3));
+    header_bytes = 4;
+  } else {
+    __m128i sel4 = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(data));
+    __m128i sel44 = _mm_unpacklo_epi8(_mm_srli_epi16(sel4, 4), sel4);
+    sel = _mm_and_si128(sel44, _mm_set1_epi8(15));
+    header_bytes = 8;
+  }
+  __m128i rest =
+      _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + header_bytes));
+  __m128i sentinel = bitslog2 == 1 ? _mm_set1_epi8(3) : _mm_set1_epi8(15);
+  __m128i mask = _mm_cmpeq_epi8(sel, sentinel);
+  int mask16 = _mm_movemask_epi8(mask);
+  unsigned char mask0 = static_cast<unsigned char>(mask16 & 255);
+  unsigned char mask1 = static_cast<unsigned char>(mask16 >> 8);
+
+  const MeshoptShuffleTables &tables = MeshoptTables();
+  __m128i sm0 = _mm_loadl_epi64(
+      reinterpret_cast<const __m128i *>(tables.shuffle[mask0]));
+  __m128i sm1 = _mm_loadl_epi64(
+      reinterpret_cast<const __m128i *>(tables.shuffle[mask1]));
+  // The upper lanes read after the bytes consumed by the lower ones
+  sm1 = _mm_add_epi8(sm1, _mm_set1_epi8(static_cast<char>(tables.count[mask0])));
+  __m128i shuf = _mm_unpacklo_epi64(sm0, sm1);
+
+  __m128i result = _mm_or_si128(_mm_shuffle_epi8(rest, shuf),
+                                _mm_andnot_si128(mask, sel));
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(buffer), result);
+  return data + header_bytes + tables.count[mask0] + tables.count[mask1];
+}
+
+TINYGLTF_TARGET_SSE41
+static const unsigned char *MeshoptDecodeBytesSse(const unsigned char *data,
+                                                  const unsigned char *data_end,
+                                                  unsigned char *buffer,
+                                                  size_t buffer_size) {
+  const unsigned char *header = data;
+  size_t header_size = (buffer_size / kMeshoptByteGroupSize + 3) / 4;
+  if (size_t(data_end - data) < header_size) return nullptr;
+  data += header_size;
+
+  for (size_t i = 0; i < buffer_size; i += kMeshoptByteGroupSize) {
+    // Also guarantees the 16-byte tail load in the group decoder stays in bounds
+    if (size_t(data_end - data) < kMeshoptByteGroupDecodeLimit) return nullptr;
+    size_t header_offset = i / kMeshoptByteGroupSize;
+    int bitslog2 = (header[header_offset / 4] >> ((header_offset % 4) * 2)) & 3;
+    data = MeshoptDecodeBytesGroupSse(data, buffer + i, bitslog2);
+  }
+  return data;
+}
+
+// Decodes four byte channels at a time: the channels are transposed into one
+// 32-bit lane per vertex, then the deltas are summed across 4 vertices per
+// register with byte-wise adds.
+TINYGLTF_TARGET_SSE41
+static const unsigned char *MeshoptDecodeVertexBlockSse(
+    const unsigned char *data, const unsigned char *data_end,
+    unsigned char *vertex_data, size_t vertex_count, size_t vertex_size,
+    unsigned char last_vertex[256]) {
+  unsigned char buffer[kMeshoptVertexBlockMaxSize * 4];
+  unsigned char transposed[kMeshoptVertexBlockSizeBytes];
+  size_t vertex_count_aligned =
+      (vertex_count + kMeshoptByteGroupSize - 1) & ~(kMeshoptByteGroupSize - 1);
+
+  const __m128i one = _mm_set1_epi8(1);
+  const __m128i low7 = _mm_set1_epi8(127);
+  for (size_t k = 0; k < vertex_size; k += 4) {
+    for (size_t j = 0; j < 4; ++j) {
+      data = MeshoptDecodeBytesSse(data, data_end,
+                                   buffer + j * vertex_count_aligned,
+                                   vertex_count_aligned);
+      if (!data) return nullptr;
+    }
+
+    int last;
+    memcpy(&last, last_vertex + k, 4);
+    __m128i p = _mm_set1_epi32(last);
+
+    // vertex_count_aligned * vertex_size fits `transposed`, so the padding
+    // lanes of the last 16 vertices can be stored without a check
+    for (size_t i = 0; i < vertex_count; i += 16) {
+      __m128i r0 = _mm_loadu_si128(
+          reinterpret_cast<const __m128i *>(buffer + i));
+      __m128i r1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(
+          buffer + i + vertex_count_aligned));
+      __m128i r2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(
+          buffer + i + vertex_count_aligned * 2));
+      __m128i r3 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(
+          buffer + i + vertex_count_aligned * 3));
+
+      __m128i t0 = _mm_unpacklo_epi8(r0, r1);
+      __m128i t1 = _mm_unpackhi_epi8(r0, r1);
+      __m128i t2 = _mm_unpacklo_epi8(r2, r3);
+      __m128i t3 = _mm_unpackhi_epi8(r2, r3);
+      __m128i x[4] = {_mm_unpacklo_epi16(t0, t2), _mm_unpackhi_epi16(t0, t2),
+                      _mm_unpacklo_epi16(t1, t3), _mm_unpackhi_epi16(t1, t3)};
+
+      for (int g = 0; g < 4; ++g) {
+        __m128i v = x[g];
+        v = _mm_xor_si128(_mm_and_si128(_mm_srli_epi16(v, 1), low7),
+                          _mm_sub_epi8(_mm_setzero_si128(), _mm_and_si128(v, one)));
+        v = _mm_add_epi8(v, _mm_slli_si128(v, 4));
+        v = _mm_add_epi8(v, _mm_slli_si128(v, 8));
+        v = _mm_add_epi8(v, p);
+        p = _mm_shuffle_epi32(v, 0xff);
+
+        unsigned char *out = transposed + (i + size_t(g) * 4) * vertex_size + k;
+        int lanes[4] = {_mm_cvtsi128_si32(v), _mm_extract_epi32(v, 1),
+                        _mm_extract_epi32(v, 2), _mm_extract_epi32(v, 3)};
+        for (int l = 0; l < 4; ++l) {
+          memcpy(out + size_t(l) * vertex_size, &lanes[l], 4);
+        }
+      }
+    }
+  }
+
+  memcpy(vertex_data, transposed, vertex_count * vertex_size);
+  memcpy(last_vertex, &transposed[vertex_size * (vertex_count - 1)],
+         vertex_size);
+  return data;
 }
+#endif  // TINYGLTF_MESHOPT_SSE41
 
-static bool ParseTextureInfo(
-    TextureInfo *texinfo, std::string *err, const detail::json &o,
-    bool store_original_json_for_extras_and_extensions) {
-  if (texinfo == nullptr) {
+// Returns false if the stream is malformed. `allow_simd` is for tests.
+static bool DecodeMeshoptVertexBuffer(unsigned char *destination,
+                                      size_t vertex_count, size_t vertex_size,
+                                      const unsigned char *buffer,
+                                      size_t buffer_size,
+                                      bool allow_simd = true) {
+  if (vertex_size == 0 || vertex_size > 256 || vertex_size % 4 != 0) {
     return false;
   }
+  const unsigned char *data = buffer;
+  const unsigned char *data_end = buffer + buffer_size;
+  if (buffer_size < 1 + vertex_size) return false;
+  // 0xa0 | version; glTF only allows version 0
+  if (*data++ != 0xa0) return false;
 
-  if (!ParseIntegerProperty(&texinfo->index, err, o, "index",
-                            /* required */ true, "TextureInfo")) {
-    return false;
+  // The first vertex is stored at the very end of the stream
+  unsigned char last_vertex[256];
+  memcpy(last_vertex, data_end - vertex_size, vertex_size);
+
+  const unsigned char *(*decode_block)(const unsigned char *,
+                                       const unsigned char *, unsigned char *,
+                                       size_t, size_t, unsigned char[256]) =
+      MeshoptDecodeVertexBlock;
+#ifdef TINYGLTF_MESHOPT_SSE41
+  if (allow_simd && MeshoptHasSse41()) {
+    decode_block = MeshoptDecodeVertexBlockSse;
   }
+#else
+  (void)allow_simd;
+#endif
 
-  ParseIntegerProperty(&texinfo->texCoord, err, o, "texCoord", false);
+  size_t vertex_block_size = MeshoptVertexBlockSize(vertex_size);
+  for (size_t offset = 0; offset < vertex_count;) {
+    size_t block_size = (std::min)(vertex_block_size, vertex_count - offset);
+    data = decode_block(data, data_end, destination + offset * vertex_size,
+                        block_size, vertex_size, last_vertex);
+    if (!data) return false;
+    offset += block_size;
+  }
 
-  ParseExtrasAndExtensions(texinfo, err, o,
-                           store_original_json_for_extras_and_extensions);
+  size_t tail_size =
+      vertex_size < kMeshoptTailMaxSize ? kMeshoptTailMaxSize : vertex_size;
+  return size_t(data_end - data) == tail_size;
+}
 
-  return true;
+static unsigned int MeshoptDecodeVByte(const unsigned char *&data) {
+  unsigned char lead = *data++;
+  if (lead < 128) return lead;
+
+  // Up to 5 bytes, 7 bits each, least significant group first
+  unsigned int result = lead & 127;
+  unsigned int shift = 7;
+  for (int i = 0; i < 4; ++i) {
+    unsigned char group = *data++;
+    result |= static_cast<unsigned int>(group & 127) << shift;
+    shift += 7;
+    if (group < 128) break;
+  }
+  return result;
 }
 
-static bool ParseNormalTextureInfo(
-    NormalTextureInfo *texinfo, std::string *err, const detail::json &o,
-    bool store_original_json_for_extras_and_extensions) {
-  if (texinfo == nullptr) {
-    return false;
+static unsigned int MeshoptDecodeIndex(const unsigned char *&data,
+                                       unsigned int last) {
+  unsigned int v = MeshoptDecodeVByte(data);
+  unsigned int d = (v >> 1) ^ static_cast<unsigned int>(-static_cast<int>(v & 1));
+  return last + d;
+}
+
+static void MeshoptWriteTriangle(unsigned char *destination, size_t offset,
+                                 size_t index_size, unsigned int a,
+                                 unsigned int b, unsigned int c) {
+  if (index_size == 2) {
+    unsigned short t[3] = {static_cast<unsigned short>(a),
+                           static_cast<unsigned short>(b),
+                           static_cast<unsigned short>(c)};
+    memcpy(destination + offset * 2, t, sizeof(t));
+  } else {
+    unsigned int t[3] = {a, b, c};
+    memcpy(destination + offset * 4, t, sizeof(t));
   }
+}
 
-  if (!ParseIntegerProperty(&texinfo->index, err, o, "index",
-                            /* required */ true, "NormalTextureInfo")) {
+// TRIANGLES mode: triangle list coded against a 16-entry edge FIFO and vertex
+// FIFO.
+static bool DecodeMeshoptIndexBuffer(unsigned char *destination,
+                                     size_t index_count, size_t index_size,
+                                     const unsigned char *buffer,
+                                     size_t buffer_size) {
+  if (index_count % 3 != 0 || (index_size != 2 && index_size != 4)) {
     return false;
   }
+  // Header, one code byte per triangle and the 16-byte codeaux table
+  if (buffer_size < 1 + index_count / 3 + 16) return false;
+  if ((buffer[0] & 0xf0) != 0xe0) return false;
+  int version = buffer[0] & 0x0f;
+  if (version > 1) return false;
+
+  unsigned int edgefifo[16][2];
+  unsigned int vertexfifo[16];
+  memset(edgefifo, -1, sizeof(edgefifo));
+  memset(vertexfifo, -1, sizeof(vertexfifo));
+  size_t edgefifooffset = 0;
+  size_t vertexfifooffset = 0;
+  unsigned int next = 0;
+  unsigned int last = 0;
+  int fecmax = version >= 1 ? 13 : 15;
+
+  const unsigned char *code = buffer + 1;
+  const unsigned char *data = code + index_count / 3;
+  const unsigned char *data_safe_end = buffer + buffer_size - 16;
+  const unsigned char *codeaux_table = data_safe_end;
+
+  auto pushEdge = [&](unsigned int a, unsigned int b) {
+    edgefifo[edgefifooffset][0] = a;
+    edgefifo[edgefifooffset][1] = b;
+    edgefifooffset = (edgefifooffset + 1) & 15;
+  };
+  auto pushVertex = [&](unsigned int v, bool advance) {
+    vertexfifo[vertexfifooffset] = v;
+    vertexfifooffset = (vertexfifooffset + (advance ? 1 : 0)) & 15;
+  };
 
-  ParseIntegerProperty(&texinfo->texCoord, err, o, "texCoord", false);
-  ParseNumberProperty(&texinfo->scale, err, o, "scale", false);
-
-  ParseExtrasAndExtensions(texinfo, err, o,
-                           store_original_json_for_extras_and_extensions);
+  for (size_t i = 0; i < index_count; i += 3) {
+    // A triangle reads at most 16 data bytes (codeaux + three 5-byte
+    // indices), which the codeaux table after data_safe_end covers
+    if (data > data_safe_end) return false;
+
+    unsigned char codetri = *code++;
+    if (codetri < 0xf0) {
+      // Reuse an edge from the FIFO, third vertex new, cached or explicit
+      int fe = codetri >> 4;
+      unsigned int a = edgefifo[(edgefifooffset - 1 - size_t(fe)) & 15][0];
+      unsigned int b = edgefifo[(edgefifooffset - 1 - size_t(fe)) & 15][1];
+      int fec = codetri & 15;
+      if (fec < fecmax) {
+        unsigned int c =
+            fec == 0 ? next : vertexfifo[(vertexfifooffset - 1 - size_t(fec)) & 15];
+        bool fec0 = fec == 0;
+        next += fec0 ? 1 : 0;
+        MeshoptWriteTriangle(destination, i, index_size, a, b, c);
+        pushVertex(c, fec0);
+        pushEdge(c, b);
+        pushEdge(a, c);
+      } else {
+        // fec 13/14 encode last -1/+1 (version 1), 15 an explicit index
+        unsigned int c = (fec != 15)
+                             ? last + static_cast<unsigned int>(fec - (fec ^ 3))
+                             : MeshoptDecodeIndex(data, last);
+        last = c;
+        MeshoptWriteTriangle(destination, i, index_size, a, b, c);
+        pushVertex(c, true);
+        pushEdge(c, b);
+        pushEdge(a, c);
+      }
+    } else if (codetri < 0xfe) {
+      // No shared edge; the second and third vertex come from the codeaux table
+      unsigned char codeaux = codeaux_table[codetri & 15];
+      int feb = codeaux >> 4;
+      int fec = codeaux & 15;
+      unsigned int a = next++;
+      unsigned int b =
+          feb == 0 ? next : vertexfifo[(vertexfifooffset - size_t(feb)) & 15];
+      bool feb0 = feb == 0;
+      next += feb0 ? 1 : 0;
+      unsigned int c =
+          fec == 0 ? next : vertexfifo[(vertexfifooffset - size_t(fec)) & 15];
+      bool fec0 = fec == 0;
+      next += fec0 ? 1 : 0;
+      MeshoptWriteTriangle(destination, i, index_size, a, b, c);
+      pushVertex(a, true);
+      pushVertex(b, feb0);
+      pushVertex(c, fec0);
+      pushEdge(b, a);
+      pushEdge(c, b);
+      pushEdge(a, c);
+    } else {
+      // Full codeaux byte in the data stream
+      unsigned char codeaux = *data++;
+      int fea = codetri == 0xfe ? 0 : 15;
+      int feb = codeaux >> 4;
+      int fec = codeaux & 15;
+      if (codeaux == 0) next = 0;  // reset marker
+
+      unsigned int a = (fea == 0) ? next++ : 0;
+      unsigned int b = (feb == 0)
+                           ? next++
+                           : vertexfifo[(vertexfifooffset - size_t(feb)) & 15];
+      unsigned int c = (fec == 0)
+                           ? next++
+                           : vertexfifo[(vertexfifooffset - size_t(fec)) & 15];
+      if (fea == 15) last = a = MeshoptDecodeIndex(data, last);
+      if (feb == 15) last = b = MeshoptDecodeIndex(data, last);
+      if (fec == 15) last = c = MeshoptDecodeIndex(data, last);
+
+      MeshoptWriteTriangle(destination, i, index_size, a, b, c);
+      pushVertex(a, true);
+      pushVertex(b, feb == 0 || feb == 15);
+      pushVertex(c, fec == 0 || fec == 15);
+      pushEdge(b, a);
+      pushEdge(c, b);
+      pushEdge(a, c);
+    }
+  }
+
+  // All data consumed, stopping exactly at the codeaux table
+  return data == data_safe_end;
+}
+
+// INDICES mode: arbitrary index sequence, delta coded against one of two
+// baselines.
+static bool DecodeMeshoptIndexSequence(unsigned char *destination,
+                                       size_t index_count, size_t index_size,
+                                       const unsigned char *buffer,
+                                       size_t buffer_size) {
+  if (index_size != 2 && index_size != 4) return false;
+  // Header, at least one byte per index and a 4-byte tail
+  if (buffer_size < 1 + index_count + 4) return false;
+  if ((buffer[0] & 0xf0) != 0xd0) return false;
+  int version = buffer[0] & 0x0f;
+  if (version > 1) return false;
+
+  const unsigned char *data = buffer + 1;
+  const unsigned char *data_safe_end = buffer + buffer_size - 4;
+  unsigned int last[2] = {0, 0};
+  for (size_t i = 0; i < index_count; ++i) {
+    // An index reads at most 5 bytes; the 4-byte tail covers the overrun
+    if (data >= data_safe_end) return false;
+
+    unsigned int v = MeshoptDecodeVByte(data);
+    unsigned int current = v & 1;
+    v >>= 1;
+    unsigned int d =
+        (v >> 1) ^ static_cast<unsigned int>(-static_cast<int>(v & 1));
+    unsigned int index = last[current] + d;
+    last[current] = index;
+
+    if (index_size == 2) {
+      unsigned short s = static_cast<unsigned short>(index);
+      memcpy(destination + i * 2, &s, 2);
+    } else {
+      memcpy(destination + i * 4, &index, 4);
+    }
+  }
+  return data == data_safe_end;
+}
 
-  return true;
+static inline int MeshoptRound(float v) {
+  return static_cast<int>(v + (v >= 0.f ? 0.5f : -0.5f));
 }
 
-static bool ParseOcclusionTextureInfo(
-    OcclusionTextureInfo *texinfo, std::string *err, const detail::json &o,
-    bool store_original_json_for_extras_and_extensions) {
-  if (texinfo == nullptr) {
+// OCTAHEDRAL: x/y hold octahedral coordinates and z the encoding of 1.0;
+// the 4th component passes through.
+template <typename T>
+static void MeshoptOctFilter(T *data, size_t count, size_t begin = 0) {
+  const float max = float((1 << (sizeof(T) * 8 - 1)) - 1);
+  for (size_t i = begin; i < count; ++i) {
+    float x = float(data[i * 4 + 0]);
+    float y = float(data[i * 4 + 1]);
+    float z = float(data[i * 4 + 2]) - std::fabs(x) - std::fabs(y);
+
+    // Fold back the lower hemisphere
+    float t = (z < 0.f) ? z : 0.f;
+    x += (x >= 0.f) ? t : -t;
+    y += (y >= 0.f) ? t : -t;
+
+    float l = std::sqrt(x * x + y * y + z * z);
+    float s = max / l;
+    data[i * 4 + 0] = static_cast<T>(MeshoptRound(x * s));
+    data[i * 4 + 1] = static_cast<T>(MeshoptRound(y * s));
+    data[i * 4 + 2] = static_cast<T>(MeshoptRound(z * s));
+  }
+}
+
+// QUATERNION: three smallest components plus the index of the largest and a
+// shared scale in the 4th component.
+static void MeshoptQuatFilter(short *data, size_t count) {
+  const float scale = 1.f / std::sqrt(2.f);
+  for (size_t i = 0; i < count; ++i) {
+    int sf = data[i * 4 + 3] | 3;
+    float ss = scale / float(sf);
+
+    float x = float(data[i * 4 + 0]) * ss;
+    float y = float(data[i * 4 + 1]) * ss;
+    float z = float(data[i * 4 + 2]) * ss;
+    // Clamped against rounding so w never becomes NaN
+    float ww = 1.f - x * x - y * y - z * z;
+    float w = std::sqrt(ww >= 0.f ? ww : 0.f);
+
+    int xf = MeshoptRound(x * 32767.f);
+    int yf = MeshoptRound(y * 32767.f);
+    int zf = MeshoptRound(z * 32767.f);
+    int wf = static_cast<int>(w * 32767.f + 0.5f);
+
+    int qc = data[i * 4 + 3] & 3;
+    data[i * 4 + ((qc + 1) & 3)] = static_cast<short>(xf);
+    data[i * 4 + ((qc + 2) & 3)] = static_cast<short>(yf);
+    data[i * 4 + ((qc + 3) & 3)] = static_cast<short>(zf);
+    data[i * 4 + ((qc + 0) & 3)] = static_cast<short>(wf);
+  }
+}
+
+// EXPONENTIAL: each 32-bit value is a 24-bit signed mantissa and an 8-bit
+// signed exponent, turned into a float.
+static void MeshoptExpFilter(unsigned int *data, size_t count,
+                             size_t begin = 0) {
+  for (size_t i = begin; i < count; ++i) {
+    unsigned int v = data[i];
+    int m = static_cast<int>(v << 8) >> 8;
+    int e = static_cast<int>(v) >> 24;
+
+    // ldexp(float(m), e) without the libm call
+    float f;
+    unsigned int bits = static_cast<unsigned int>(e + 127) << 23;
+    memcpy(&f, &bits, 4);
+    f *= float(m);
+    memcpy(&data[i], &f, 4);
+  }
+}
+
+#ifdef TINYGLTF_MESHOPT_SSE41
+TINYGLTF_TARGET_SSE41
+static __m128 MeshoptOctNormalizeSse(__m128 &x, __m128 &y, __m128 zin,
+                                     float max) {
+  const __m128 sign = _mm_set1_ps(-0.f);
+  __m128 z = _mm_sub_ps(_mm_sub_ps(zin, _mm_andnot_ps(sign, x)),
+                        _mm_andnot_ps(sign, y));
+  __m128 t = _mm_min_ps(z, _mm_setzero_ps());
+  // x += (x >= 0) ? t : -t, i.e. add t with the sign of x
+  x = _mm_add_ps(x, _mm_xor_ps(t, _mm_and_ps(_mm_cmplt_ps(x, _mm_setzero_ps()), sign)));
+  y = _mm_add_ps(y, _mm_xor_ps(t, _mm_and_ps(_mm_cmplt_ps(y, _mm_setzero_ps()), sign)));
+
+  __m128 l = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)),
+                                    _mm_mul_ps(z, z)));
+  __m128 s = _mm_div_ps(_mm_set1_ps(max), l);
+  x = _mm_mul_ps(x, s);
+  y = _mm_mul_ps(y, s);
+  return _mm_mul_ps(z, s);
+}
+
+// Matches MeshoptRound: add +-0.5 by sign, then truncate
+TINYGLTF_TARGET_SSE41
+static __m128i MeshoptRoundSse(__m128 v) {
+  const __m128 half = _mm_set1_ps(0.5f);
+  __m128 bias = _mm_or_ps(half, _mm_and_ps(_mm_cmplt_ps(v, _mm_setzero_ps()),
+                                           _mm_set1_ps(-0.f)));
+  return _mm_cvttps_epi32(_mm_add_ps(v, bias));
+}
+
+TINYGLTF_TARGET_SSE41
+static void MeshoptOctFilterSse(signed char *data, size_t count) {
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m128i n4 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i * 4));
+    // Sign-extend bytes 0..2 of each 32-bit lane
+    __m128 x = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_slli_epi32(n4, 24), 24));
+    __m128 y = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_slli_epi32(n4, 16), 24));
+    __m128 z = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_slli_epi32(n4, 8), 24));
+    z = MeshoptOctNormalizeSse(x, y, z, 127.f);
+
+    const __m128i byte = _mm_set1_epi32(0xff);
+    __m128i res = _mm_and_si128(n4, _mm_set1_epi32(static_cast<int>(0xff000000u)));
+    res = _mm_or_si128(res, _mm_and_si128(MeshoptRoundSse(x), byte));
+    res = _mm_or_si128(res, _mm_slli_epi32(_mm_and_si128(MeshoptRoundSse(y), byte), 8));
+    res = _mm_or_si128(res, _mm_slli_epi32(_mm_and_si128(MeshoptRoundSse(z), byte), 16));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(data + i * 4), res);
+  }
+  MeshoptOctFilter(data, count, i);
+}
+
+TINYGLTF_TARGET_SSE41
+static void MeshoptOctFilterSse(short *data, size_t count) {
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m128 n4_0 = _mm_castsi128_ps(
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i * 4)));
+    __m128 n4_1 = _mm_castsi128_ps(
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i * 4 + 8)));
+    // 32-bit lanes of xy and zw pairs for the four vertices
+    __m128i xy = _mm_castps_si128(_mm_shuffle_ps(n4_0, n4_1, _MM_SHUFFLE(2, 0, 2, 0)));
+    __m128i zw = _mm_castps_si128(_mm_shuffle_ps(n4_0, n4_1, _MM_SHUFFLE(3, 1, 3, 1)));
+
+    __m128 x = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_slli_epi32(xy, 16), 16));
+    __m128 y = _mm_cvtepi32_ps(_mm_srai_epi32(xy, 16));
+    __m128 z = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_slli_epi32(zw, 16), 16));
+    z = MeshoptOctNormalizeSse(x, y, z, 32767.f);
+
+    const __m128i word = _mm_set1_epi32(0xffff);
+    __m128i rxy = _mm_or_si128(_mm_and_si128(MeshoptRoundSse(x), word),
+                               _mm_slli_epi32(MeshoptRoundSse(y), 16));
+    __m128i rzw = _mm_or_si128(_mm_and_si128(MeshoptRoundSse(z), word),
+                               _mm_andnot_si128(word, zw));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(data + i * 4),
+                     _mm_unpacklo_epi32(rxy, rzw));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(data + i * 4 + 8),
+                     _mm_unpackhi_epi32(rxy, rzw));
+  }
+  MeshoptOctFilter(data, count, i);
+}
+
+TINYGLTF_TARGET_SSE41
+static void MeshoptExpFilterSse(unsigned int *data, size_t count) {
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+    __m128i m = _mm_srai_epi32(_mm_slli_epi32(v, 8), 8);
+    __m128i e = _mm_srai_epi32(v, 24);
+    __m128 scale = _mm_castsi128_ps(
+        _mm_slli_epi32(_mm_add_epi32(e, _mm_set1_epi32(127)), 23));
+    __m128 r = _mm_mul_ps(scale, _mm_cvtepi32_ps(m));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(data + i), _mm_castps_si128(r));
+  }
+  MeshoptExpFilter(data, count, i);
+}
+#endif  // TINYGLTF_MESHOPT_SSE41
+
+// Applies `filter` in place to `count` elements of `stride` bytes. `data` is
+// aligned for the element types (it points into a std::vector).
+static bool ApplyMeshoptFilter(const std::string &filter, unsigned char *data,
+                               size_t count, size_t stride,
+                               bool allow_simd = true) {
+  bool simd = false;
+#ifdef TINYGLTF_MESHOPT_SSE41
+  simd = allow_simd && MeshoptHasSse41();
+#else
+  (void)allow_simd;
+#endif
+  if (filter.empty() || filter == "NONE") {
+    return true;
+  } else if (filter == "OCTAHEDRAL") {
+    if (stride == 4) {
+      signed char *p = reinterpret_cast<signed char *>(data);
+#ifdef TINYGLTF_MESHOPT_SSE41
+      if (simd) {
+        MeshoptOctFilterSse(p, count);
+        return true;
+      }
+#endif
+      MeshoptOctFilter(p, count);
+      return true;
+    } else if (stride == 8) {
+      short *p = reinterpret_cast<short *>(data);
+#ifdef TINYGLTF_MESHOPT_SSE41
+      if (simd) {
+        MeshoptOctFilterSse(p, count);
+        return true;
+      }
+#endif
+      MeshoptOctFilter(p, count);
+      return true;
+    }
     return false;
+  } else if (filter == "QUATERNION") {
+    if (stride != 8) return false;
+    MeshoptQuatFilter(reinterpret_cast<short *>(data), count);
+    return true;
+  } else if (filter == "EXPONENTIAL") {
+    if (stride % 4 != 0) return false;
+    unsigned int *p = reinterpret_cast<unsigned int *>(data);
+#ifdef TINYGLTF_MESHOPT_SSE41
+    if (simd) {
+      MeshoptExpFilterSse(p, count * stride / 4);
+      return true;
+    }
+#endif
+    MeshoptExpFilter(p, count * stride / 4);
+    return true;
   }
+  return false;
+}
 
-  if (!ParseIntegerProperty(&texinfo->index, err, o, "index",
-                            /* required */ true, "NormalTextureInfo")) {
-    return false;
+// One EXT_meshopt_compression bufferView: where the compressed bytes are and
+// how to decode them into the (fallback) buffer the bufferView points at.
+struct MeshoptView {
+  int bufferView{-1};
+  int source{-1};  // buffer holding the compressed stream
+  size_t byteOffset{0};
+  size_t byteLength{0};
+  size_t byteStride{0};
+  size_t count{0};
+  std::string mode;
+  std::string filter;
+};
+
+static bool DecodeMeshoptView(const MeshoptView &mv, const Buffer &source,
+                              unsigned char *destination, std::string *err) {
+  const unsigned char *src = source.Data() + mv.byteOffset;
+  bool ok = false;
+  if (mv.mode == "ATTRIBUTES") {
+    ok = DecodeMeshoptVertexBuffer(destination, mv.count, mv.byteStride, src,
+                                   mv.byteLength) &&
+         ApplyMeshoptFilter(mv.filter, destination, mv.count, mv.byteStride);
+  } else if (mv.mode == "TRIANGLES") {
+    ok = DecodeMeshoptIndexBuffer(destination, mv.count, mv.byteStride, src,
+                                  mv.byteLength);
+  } else if (mv.mode == "INDICES") {
+    ok = DecodeMeshoptIndexSequence(destination, mv.count, mv.byteStride, src,
+                                    mv.byteLength);
+  }
+  if (!ok && err) {
+    (*err) += "Failed to decode EXT_meshopt_compression bufferView[" +
+              std::to_string(mv.bufferView) + "] (mode " + mv.mode +
+              ", filter " + (mv.filter.empty() ? "NONE" : mv.filter) + ").\n";
+  }
+  return ok;
+}
+
+// Runs fn(0) .. fn(count - 1) on up to `workers` threads (0: one per
+// hardware thread), handing out indices in order. Serial when threads are
+// disabled or only one worker is useful.
+static void ParallelFor(size_t count, size_t workers,
+                        const std::function<void(size_t)> &fn) {
+#ifndef TINYGLTF_NO_THREADS
+  if (workers == 0) {
+    workers = size_t((std::max)(1u, std::thread::hardware_concurrency()));
+  }
+  workers = (std::min)(workers, count);
+  if (workers > 1) {
+    std::atomic<size_t> next{0};
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < workers; t++) {
+      threads.emplace_back([&] {
+        for (size_t k = next++; k < count; k = next++) fn(k);
+      });
+    }
+    for (std::thread &t : threads) t.join();
+    return;
   }
+#else
+  (void)workers;
+#endif
+  for (size_t k = 0; k < count; k++) fn(k);
+}
 
-  ParseIntegerProperty(&texinfo->texCoord, err, o, "texCoord", false);
-  ParseNumberProperty(&texinfo->strength, err, o, "strength", false);
+}  // namespace detail
 
-  ParseExtrasAndExtensions(texinfo, err, o,
-                           store_original_json_for_extras_and_extensions);
+// Decodes every EXT_meshopt_compression bufferView into the buffer it points
+// at (usually a `fallback` buffer without data), in parallel across views.
+static bool DecodeMeshoptBufferViews(Model *model, std::string *err) {
+  std::vector<detail::MeshoptView> views;
+  for (size_t i = 0; i < model->bufferViews.size(); i++) {
+    const BufferView &view = model->bufferViews[i];
+    auto it = view.extensions.find("EXT_meshopt_compression");
+    if (it == view.extensions.end() || !it->second.IsObject()) continue;
+    const Value &ext = it->second;
+
+    // Each field must be a non-negative integer; only byteOffset may be
+    // left out (it defaults to 0).
+    auto readSize = [&ext](const char *name, bool required, size_t *out) {
+      const Value &v = ext.Get(name);
+      if (!v.IsNumber()) return !required && !ext.Has(name);
+      const double d = v.GetNumberAsDouble();
+      if (!(d >= 0.0) || d != std::floor(d) || d >= 9007199254740992.0) {
+        return false;
+      }
+      (*out) = size_t(d);
+      return true;
+    };
+
+    detail::MeshoptView mv;
+    mv.bufferView = int(i);
+    size_t source = 0;
+    bool valid = readSize("buffer", true, &source) &&
+                 readSize("byteOffset", false, &mv.byteOffset) &&
+                 readSize("byteLength", true, &mv.byteLength) &&
+                 readSize("byteStride", true, &mv.byteStride) &&
+                 readSize("count", true, &mv.count);
+    if (ext.Get("mode").IsString()) mv.mode = ext.Get("mode").Get<std::string>();
+    if (ext.Get("filter").IsString()) {
+      mv.filter = ext.Get("filter").Get<std::string>();
+    }
+
+    // Ranges are checked without additions or products that could wrap
+    valid = valid && source < model->buffers.size() && view.buffer >= 0 &&
+            size_t(view.buffer) < model->buffers.size() && mv.byteStride > 0;
+    if (valid) {
+      mv.source = int(source);
+      const size_t sourceSize = model->buffers[source].Size();
+      const size_t targetSize = model->buffers[size_t(view.buffer)].Size();
+      valid = mv.byteLength <= sourceSize &&
+              mv.byteOffset <= sourceSize - mv.byteLength &&
+              mv.count <= view.byteLength / mv.byteStride &&
+              view.byteLength <= targetSize &&
+              view.byteOffset <= targetSize - view.byteLength;
+    }
+    if (!valid) {
+      if (err) {
+        (*err) += "Invalid EXT_meshopt_compression in bufferView[" +
+                  std::to_string(i) + "].\n";
+      }
+      return false;
+    }
+    views.push_back(mv);
+  }
+  if (views.empty()) return true;
+
+  // Decoded bytes are written in place, so mapped (read-only) targets are
+  // copied into owned storage first.
+  for (const detail::MeshoptView &mv : views) {
+    Buffer &target = model->buffers[size_t(model->bufferViews[size_t(mv.bufferView)].buffer)];
+    if (target.mapped_data) {
+      target.data.assign(target.mapped_data,
+                         target.mapped_data + target.mapped_size);
+      TINYGLTF_COUNT_COPY(target.mapped_size);
+      target.mapped_data = nullptr;
+      target.mapped_size = 0;
+      target.mapped_file.reset();
+    }
+  }
+
+  std::vector<std::string> errors(views.size());
+  std::vector<char> results(views.size(), 0);
+  auto decodeOne = [&](size_t k) {
+    const detail::MeshoptView &mv = views[k];
+    const BufferView &view = model->bufferViews[size_t(mv.bufferView)];
+    Buffer &target = model->buffers[size_t(view.buffer)];
+    results[k] = detail::DecodeMeshoptView(
+        mv, model->buffers[size_t(mv.source)],
+        target.data.data() + view.byteOffset, &errors[k]);
+  };
 
-  return true;
+  detail::ParallelFor(views.size(), 0, decodeOne);
+
+  bool ok = true;
+  for (size_t k = 0; k < views.size(); k++) {
+    if (!results[k]) {
+      ok = false;
+      if (err) (*err) += errors[k];
+    }
+  }
+  return ok;
 }
 
 static bool ParseBuffer(Buffer *buffer, std::string *err, const detail::json &o,
@@ -4526,7 +8985,8 @@ static bool ParseBuffer(Buffer *buffer, std::string *err, const detail::json &o,
                         const std::string &basedir,
                         const size_t max_buffer_size, bool is_binary = false,
                         const unsigned char *bin_data = nullptr,
-                        size_t bin_size = 0) {
+                        size_t bin_size = 0,
+                        const std::shared_ptr<const void> &bin_owner = nullptr) {
   size_t byteLength;
   if (!ParseUnsignedProperty(&byteLength, err, o, "byteLength", true,
                              "Buffer")) {
@@ -4536,6 +8996,27 @@ static bool ParseBuffer(Buffer *buffer, std::string *err, const detail::json &o,
   // In glTF 2.0, uri is not mandatory anymore
   buffer->uri.clear();
   ParseStringProperty(&buffer->uri, err, o, "uri", false, "Buffer");
+  if (IsDataURI(buffer->uri)) TINYGLTF_COUNT_COPY(buffer->uri.size());
+
+  // An EXT_meshopt_compression fallback buffer has no data of its own; it
+  // receives the decoded bufferViews once all of them are parsed.
+  if (buffer->uri.empty()) {
+    detail::json_const_iterator extensions, meshopt;
+    if (detail::FindMember(o, "extensions", extensions) &&
+        detail::FindMember(detail::GetValue(extensions),
+                           "EXT_meshopt_compression", meshopt)) {
+      bool isFallback = false;
+      if (ParseBooleanProperty(&isFallback, nullptr, detail::GetValue(meshopt),
+                               "fallback", false) &&
+          isFallback) {
+        buffer->data.assign(byteLength, 0);
+        ParseStringProperty(&buffer->name, err, o, "name", false);
+        ParseExtrasAndExtensions(buffer, err, o,
+                                 store_original_json_for_extras_and_extensions);
+        return true;
+      }
+    }
+  }
 
   // having an empty uri for a non embedded image should not be valid
   if (!is_binary && buffer->uri.empty()) {
@@ -4603,9 +9084,16 @@ static bool ParseBuffer(Buffer *buffer, std::string *err, const detail::json &o,
         return false;
       }
 
-      // Read buffer data
-      buffer->data.resize(static_cast<size_t>(byteLength));
-      memcpy(&(buffer->data.at(0)), bin_data, static_cast<size_t>(byteLength));
+      if (bin_owner) {
+        // Reference the BIN chunk in place; `bin_owner` keeps it mapped.
+        buffer->mapped_data = bin_data;
+        buffer->mapped_size = static_cast<size_t>(byteLength);
+        buffer->mapped_file = bin_owner;
+      } else {
+        // Read buffer data
+        buffer->data.assign(bin_data, bin_data + byteLength);
+        TINYGLTF_COUNT_COPY(static_cast<size_t>(byteLength));
+      }
     }
 
   } else {
@@ -4966,7 +9454,7 @@ static bool ParseDracoExtension(Primitive *primitive, Model *model,
   auto attributesValue = dracoExtensionValue.Get("attributes");
   if (!attributesValue.IsObject()) return false;
 
-  auto attributesObject = attributesValue.Get<Value::Object>();
+  const auto &attributesObject = attributesValue.Get<Value::Object>();
   int bufferView = bufferViewValue.Get<int>();
 
   BufferView &view = model->bufferViews[bufferView];
@@ -4976,7 +9464,7 @@ static bool ParseDracoExtension(Primitive *primitive, Model *model,
   view.dracoDecoded = true;
 
   const char *bufferViewData =
-      reinterpret_cast<const char *>(buffer.data.data() + view.byteOffset);
+      reinterpret_cast<const char *>(buffer.Data() + view.byteOffset);
   size_t bufferViewSize = view.byteLength;
 
   // decode draco
@@ -5112,7 +9600,7 @@ static bool ParsePrimitive(Primitive *primitive, Model *model,
     for (detail::json_const_array_iterator i =
              detail::ArrayBegin(detail::GetValue(targetsObject));
          i != targetsObjectEnd; ++i) {
-      std::map<std::string, int> targetAttribues;
+      AttributeMap targetAttribues;
 
       const detail::json &dict = *i;
       if (detail::IsObject(dict)) {
@@ -5304,7 +9792,7 @@ static bool ParsePbrMetallicRoughness(
     return false;
   }
 
-  std::vector<double> baseColorFactor;
+  ModelVector<double> baseColorFactor;
   if (ParseNumberArrayProperty(&baseColorFactor, err, o, "baseColorFactor",
                                /* required */ false)) {
     if (baseColorFactor.size() != 4) {
@@ -5647,7 +10135,7 @@ static bool ParseSkin(Skin *skin, std::string *err, const detail::json &o,
                       bool store_original_json_for_extras_and_extensions) {
   ParseStringProperty(&skin->name, err, o, "name", false, "Skin");
 
-  std::vector<int> joints;
+  ModelVector<int> joints;
   if (!ParseIntegerArrayProperty(&joints, err, o, "joints", false, "Skin")) {
     return false;
   }
@@ -5974,6 +10462,142 @@ bool ForEachInArray(const detail::json &_v, const char *member, Callback &&cb) {
   return true;
 };
 
+#if defined(TINYGLTF_ENABLE_STREAMING_PARSE) && !defined(TINYGLTF_USE_RAPIDJSON)
+// SAX front end for LoadFromString(). Each element of a top-level array
+// named in `sections` is passed to `emit` as soon as it is complete and
+// then dropped, so at most one of them is held as JSON at a time. The rest
+// of the document is built as a DOM as usual, with the streamed arrays left
+// in it empty.
+class StreamingJsonParser : public nlohmann::json_sax<json> {
+ public:
+  using EmitFunction = std::function<bool(size_t section, const json &)>;
+
+  StreamingJsonParser(const char *const *sections, size_t count,
+                      EmitFunction emit)
+      : sections_(sections), count_(count), emit_(std::move(emit)) {}
+
+  // Returns false with `error` set on a JSON syntax error, or with `error`
+  // empty when `emit` failed.
+  bool Parse(const char *str, size_t length, json *root, std::string *error) {
+    const bool ok = json::sax_parse(str, str + length, this);
+    if (ok) {
+      (*root) = std::move(root_);
+    } else if (error) {
+      (*error) = error_;
+    }
+    return ok;
+  }
+
+  bool null() override { return Put(json(nullptr)); }
+  bool boolean(bool val) override { return Put(json(val)); }
+  bool number_integer(number_integer_t val) override { return Put(json(val)); }
+  bool number_unsigned(number_unsigned_t val) override {
+    return Put(json(val));
+  }
+  bool number_float(number_float_t val, const string_t &) override {
+    return Put(json(val));
+  }
+  bool string(string_t &val) override { return Put(json(std::move(val))); }
+  bool binary(binary_t &val) override { return Put(json::binary(val)); }
+
+  bool start_object(std::size_t) override {
+    stack_.push_back(Place(json::object()));
+    return true;
+  }
+
+  bool key(string_t &val) override {
+    slot_ = &(*stack_.back())[val];
+    if (stack_.size() == 1) {
+      // A member of the root: is it a streamed array?
+      pending_ = count_;
+      for (size_t i = 0; i < count_; ++i) {
+        if (val == sections_[i]) pending_ = i;
+      }
+    }
+    return true;
+  }
+
+  bool end_object() override {
+    stack_.pop_back();
+    return Done();
+  }
+
+  bool start_array(std::size_t) override {
+    // Only the value of a root member can open a streamed section; an
+    // array nested in a streamed element is an ordinary element.
+    if (stack_.size() == 1 && section_ == count_ && pending_ < count_) {
+      (*slot_) = json::array();
+      section_ = pending_;
+      pending_ = count_;
+      return true;
+    }
+    stack_.push_back(Place(json::array()));
+    return true;
+  }
+
+  bool end_array() override {
+    if (Streaming()) {
+      section_ = count_;
+      return true;
+    }
+    stack_.pop_back();
+    return Done();
+  }
+
+  bool parse_error(std::size_t, const std::string &,
+                   const nlohmann::detail::exception &ex) override {
+    error_ = ex.what();
+    return false;
+  }
+
+ private:
+  // True between the elements of a streamed array
+  bool Streaming() const { return section_ < count_ && stack_.size() == 1; }
+
+  json *Place(json &&value) {
+    if (stack_.empty()) {
+      root_ = std::move(value);
+      return &root_;
+    }
+    if (Streaming()) {
+      element_ = std::move(value);
+      return &element_;
+    }
+    json &parent = *stack_.back();
+    if (parent.is_array()) {
+      parent.push_back(std::move(value));
+      return &parent.back();
+    }
+    (*slot_) = std::move(value);
+    return slot_;
+  }
+
+  bool Put(json &&value) {
+    Place(std::move(value));
+    return Done();
+  }
+
+  // Hands a completed streamed element to `emit_`
+  bool Done() {
+    if (!Streaming()) return true;
+    const bool ok = emit_(section_, element_);
+    element_ = json();
+    return ok;
+  }
+
+  const char *const *sections_;
+  size_t count_;
+  EmitFunction emit_;
+  json root_;
+  json element_;
+  std::vector<json *> stack_;  // open objects and arrays
+  json *slot_ = nullptr;       // member named by the last key
+  size_t pending_ = 0;         // streamed array named by the last root key
+  size_t section_ = count_;    // streamed array being read, count_ if none
+  std::string error_;
+};
+#endif
+
 }  // end of namespace detail
 
 bool TinyGLTF::LoadFromString(Model *model, std::string *err, std::string *warn,
@@ -5988,22 +10612,207 @@ bool TinyGLTF::LoadFromString(Model *model, std::string *err, std::string *warn,
     return false;
   }
 
-  detail::JsonDocument v;
+#ifdef TINYGLTF_ENABLE_MODEL_ARENA
+  // Everything built below allocates from the arena. Dropping the previous
+  // contents first lets the arena they used be rewound instead of growing.
+  if (model_arena_) {
+    (*model) = Model();
+    ModelArena *arena = arena_.arena();
+    if (arena && arena->UseCount() == 1) {
+      arena->Reset();
+    } else {
+      arena_ = ModelAllocator<char>(new ModelArena());
+    }
+  }
+  ModelArena::Scope arena_scope(model_arena_ ? arena_.arena()
+                                             : ModelArena::Current());
+#endif
+
+  // Object keys of the extras and extensions parsed by this load share their
+  // storage.
+  ValueKeyPool key_pool;
+  ValueKeyPool::Scope key_scope(&key_pool);
+
+  // Parsers for one element of each top-level array whose elements don't
+  // depend on other sections. They run on the DOM in the numbered steps
+  // below, or while the JSON is read with the streaming front end.
+  auto isObject = [&](const detail::json &o, const char *section) {
+    if (detail::IsObject(o)) return true;
+    if (err) {
+      (*err) +=
+          std::string("`") + section + "' does not contain an JSON object.";
+    }
+    return false;
+  };
+
+  auto parseBuffer = [&](Model *m, const detail::json &o) {
+    if (!isObject(o, "buffers")) return false;
+    Buffer buffer;
+    if (!ParseBuffer(&buffer, err, o,
+                     store_original_json_for_extras_and_extensions_, &fs,
+                     &uri_cb, base_dir, max_external_file_size_, is_binary_,
+                     bin_data_, bin_size_, bin_owner_)) {
+      return false;
+    }
+    m->buffers.emplace_back(std::move(buffer));
+    return true;
+  };
+
+  auto parseBufferView = [&](Model *m, const detail::json &o) {
+    if (!isObject(o, "bufferViews")) return false;
+    BufferView bufferView;
+    if (!ParseBufferView(&bufferView, err, o,
+                         store_original_json_for_extras_and_extensions_)) {
+      return false;
+    }
+    m->bufferViews.emplace_back(std::move(bufferView));
+    return true;
+  };
+
+  auto parseAccessor = [&](Model *m, const detail::json &o) {
+    if (!isObject(o, "accessors")) return false;
+    Accessor accessor;
+    if (!ParseAccessor(&accessor, err, o,
+                       store_original_json_for_extras_and_extensions_)) {
+      return false;
+    }
+    m->accessors.emplace_back(std::move(accessor));
+    return true;
+  };
+
+  auto parseNode = [&](Model *m, const detail::json &o) {
+    if (!isObject(o, "nodes")) return false;
+    Node node;
+    if (!ParseNode(&node, err, o,
+                   store_original_json_for_extras_and_extensions_)) {
+      return false;
+    }
+    m->nodes.emplace_back(std::move(node));
+    return true;
+  };
+
+  auto parseScene = [&](Model *m, const detail::json &o) {
+    if (!isObject(o, "scenes")) return false;
+    Scene scene;
+    if (!ParseScene(&scene, err, o,
+                    store_original_json_for_extras_and_extensions_)) {
+      return false;
+    }
+    m->scenes.emplace_back(std::move(scene));
+    return true;
+  };
+
+  auto parseMaterial = [&](Model *m, const detail::json &o) {
+    if (!isObject(o, "materials")) return false;
+    Material material;
+    ParseStringProperty(&material.name, err, o, "name", false);
+
+    if (!ParseMaterial(&material, err, warn, o,
+                       store_original_json_for_extras_and_extensions_,
+                       strictness_)) {
+      return false;
+    }
+    m->materials.emplace_back(std::move(material));
+    return true;
+  };
+
+  auto parseTexture = [&](Model *m, const detail::json &o) {
+    if (!isObject(o, "textures")) return false;
+    Texture texture;
+    if (!ParseTexture(&texture, err, o,
+                      store_original_json_for_extras_and_extensions_,
+                      base_dir)) {
+      return false;
+    }
+    m->textures.emplace_back(std::move(texture));
+    return true;
+  };
+
+  auto parseAnimation = [&](Model *m, const detail::json &o) {
+    if (!isObject(o, "animations")) return false;
+    Animation animation;
+    if (!ParseAnimation(&animation, err, o,
+                        store_original_json_for_extras_and_extensions_)) {
+      return false;
+    }
+    m->animations.emplace_back(std::move(animation));
+    return true;
+  };
+
+  auto parseSkin = [&](Model *m, const detail::json &o) {
+    if (!isObject(o, "skins")) return false;
+    Skin skin;
+    if (!ParseSkin(&skin, err, o,
+                   store_original_json_for_extras_and_extensions_)) {
+      return false;
+    }
+    m->skins.emplace_back(std::move(skin));
+    return true;
+  };
+
+  auto parseSampler = [&](Model *m, const detail::json &o) {
+    if (!isObject(o, "samplers")) return false;
+    Sampler sampler;
+    if (!ParseSampler(&sampler, err, o,
+                      store_original_json_for_extras_and_extensions_)) {
+      return false;
+    }
+    m->samplers.emplace_back(std::move(sampler));
+    return true;
+  };
+
+  auto parseCamera = [&](Model *m, const detail::json &o) {
+    if (!isObject(o, "cameras")) return false;
+    Camera camera;
+    if (!ParseCamera(&camera, err, o,
+                     store_original_json_for_extras_and_extensions_)) {
+      return false;
+    }
+    m->cameras.emplace_back(std::move(camera));
+    return true;
+  };
 
+  detail::JsonDocument v;
+  Model streamed;  // sections filled by the streaming front end
+
+#if defined(TINYGLTF_ENABLE_STREAMING_PARSE) && !defined(TINYGLTF_USE_RAPIDJSON)
+  if (streaming_parse_) {
+    static const char *const kSections[] = {
+        "buffers", "bufferViews", "accessors", "nodes",
+        "scenes",  "materials",   "textures",  "animations",
+        "skins",   "samplers",    "cameras"};
+    const std::function<bool(Model *, const detail::json &)> parsers[] = {
+        parseBuffer, parseBufferView, parseAccessor, parseNode,
+        parseScene,  parseMaterial,   parseTexture,  parseAnimation,
+        parseSkin,   parseSampler,    parseCamera};
+    detail::StreamingJsonParser parser(
+        kSections, sizeof(kSections) / sizeof(kSections[0]),
+        [&](size_t section, const detail::json &o) {
+          return parsers[section](&streamed, o);
+        });
+    std::string parseErr;
+    if (!parser.Parse(json_str, json_str_length, &v, &parseErr)) {
+      if (err && !parseErr.empty()) {
+        (*err) = parseErr;
+      }
+      return false;
+    }
+  } else
+#endif
+  {
 #if (defined(__cpp_exceptions) || defined(__EXCEPTIONS) || \
      defined(_CPPUNWIND)) &&                               \
     !defined(TINYGLTF_NOEXCEPTION)
-  try {
-    detail::JsonParse(v, json_str, json_str_length, true);
+    try {
+      detail::JsonParse(v, json_str, json_str_length, true);
 
-  } catch (const std::exception &e) {
-    if (err) {
-      (*err) = e.what();
+    } catch (const std::exception &e) {
+      if (err) {
+        (*err) = e.what();
+      }
+      return false;
     }
-    return false;
-  }
 #else
-  {
     detail::JsonParse(v, json_str, json_str_length);
 
     if (!detail::IsObject(v)) {
@@ -6013,8 +10822,8 @@ bool TinyGLTF::LoadFromString(Model *model, std::string *err, std::string *warn,
       }
       return false;
     }
-  }
 #endif
+  }
 
   if (!detail::IsObject(v)) {
     // root is not an object.
@@ -6106,8 +10915,20 @@ bool TinyGLTF::LoadFromString(Model *model, std::string *err, std::string *warn,
     }
   }
 
-  // Reset the model
+  // Reset the model, keeping what was parsed while streaming. The streamed
+  // arrays are empty in `v`, so their steps below add nothing.
   (*model) = Model();
+  model->buffers.swap(streamed.buffers);
+  model->bufferViews.swap(streamed.bufferViews);
+  model->accessors.swap(streamed.accessors);
+  model->nodes.swap(streamed.nodes);
+  model->scenes.swap(streamed.scenes);
+  model->materials.swap(streamed.materials);
+  model->textures.swap(streamed.textures);
+  model->animations.swap(streamed.animations);
+  model->skins.swap(streamed.skins);
+  model->samplers.swap(streamed.samplers);
+  model->cameras.swap(streamed.cameras);
 
   // 1. Parse Asset
   {
@@ -6145,22 +10966,7 @@ bool TinyGLTF::LoadFromString(Model *model, std::string *err, std::string *warn,
   // 3. Parse Buffer
   {
     bool success = ForEachInArray(v, "buffers", [&](const detail::json &o) {
-      if (!detail::IsObject(o)) {
-        if (err) {
-          (*err) += "`buffers' does not contain an JSON object.";
-        }
-        return false;
-      }
-      Buffer buffer;
-      if (!ParseBuffer(&buffer, err, o,
-                       store_original_json_for_extras_and_extensions_, &fs,
-                       &uri_cb, base_dir, max_external_file_size_, is_binary_,
-                       bin_data_, bin_size_)) {
-        return false;
-      }
-
-      model->buffers.emplace_back(std::move(buffer));
-      return true;
+      return parseBuffer(model, o);
     });
 
     if (!success) {
@@ -6170,20 +10976,7 @@ bool TinyGLTF::LoadFromString(Model *model, std::string *err, std::string *warn,
   // 4. Parse BufferView
   {
     bool success = ForEachInArray(v, "bufferViews", [&](const detail::json &o) {
-      if (!detail::IsObject(o)) {
-        if (err) {
-          (*err) += "`bufferViews' does not contain an JSON object.";
-        }
-        return false;
-      }
-      BufferView bufferView;
-      if (!ParseBufferView(&bufferView, err, o,
-                           store_original_json_for_extras_and_extensions_)) {
-        return false;
-      }
-
-      model->bufferViews.emplace_back(std::move(bufferView));
-      return true;
+      return parseBufferView(model, o);
     });
 
     if (!success) {
@@ -6191,23 +10984,15 @@ bool TinyGLTF::LoadFromString(Model *model, std::string *err, std::string *warn,
     }
   }
 
-  // 5. Parse Accessor
-  {
-    bool success = ForEachInArray(v, "accessors", [&](const detail::json &o) {
-      if (!detail::IsObject(o)) {
-        if (err) {
-          (*err) += "`accessors' does not contain an JSON object.";
-        }
-        return false;
-      }
-      Accessor accessor;
-      if (!ParseAccessor(&accessor, err, o,
-                         store_original_json_for_extras_and_extensions_)) {
-        return false;
-      }
-
-      model->accessors.emplace_back(std::move(accessor));
-      return true;
+  // 4.1 Decode EXT_meshopt_compression bufferViews
+  if (!DecodeMeshoptBufferViews(model, err)) {
+    return false;
+  }
+
+  // 5. Parse Accessor
+  {
+    bool success = ForEachInArray(v, "accessors", [&](const detail::json &o) {
+      return parseAccessor(model, o);
     });
 
     if (!success) {
@@ -6302,23 +11087,53 @@ bool TinyGLTF::LoadFromString(Model *model, std::string *err, std::string *warn,
     }
   }
 
-  // 7. Parse Node
+  // Check vertex attribute encodings. Integer positions, normals and UVs are
+  // only valid with KHR_mesh_quantization; files that use them without
+  // declaring it still load, with a warning. Other invalid encodings are
+  // warnings too unless SetStrictAttributeEncoding() is on.
   {
-    bool success = ForEachInArray(v, "nodes", [&](const detail::json &o) {
-      if (!detail::IsObject(o)) {
-        if (err) {
-          (*err) += "`nodes' does not contain an JSON object.";
+    const bool quantized =
+        std::find(model->extensionsUsed.begin(), model->extensionsUsed.end(),
+                  "KHR_mesh_quantization") != model->extensionsUsed.end();
+    for (size_t m = 0; m < model->meshes.size(); m++) {
+      for (const auto &primitive : model->meshes[m].primitives) {
+        for (const auto &attribute : primitive.attributes) {
+          if (attribute.second < 0 ||
+              size_t(attribute.second) >= model->accessors.size()) {
+            continue;
+          }
+          const Accessor &accessor = model->accessors[size_t(attribute.second)];
+          if (IsValidAttributeEncoding(attribute.first, accessor, quantized)) {
+            continue;
+          }
+          std::string msg = "mesh[" + std::to_string(m) + "] attribute " +
+                            attribute.first + " (accessor[" +
+                            std::to_string(attribute.second) +
+                            "]) has an invalid type or component type";
+          if (!quantized &&
+              IsValidAttributeEncoding(attribute.first, accessor, true)) {
+            if (warn) {
+              (*warn) += msg + " unless KHR_mesh_quantization is used.\n";
+            }
+          } else if (!strict_attribute_encoding_) {
+            if (warn) {
+              (*warn) += msg + ".\n";
+            }
+          } else {
+            if (err) {
+              (*err) += msg + ".\n";
+            }
+            return false;
+          }
         }
-        return false;
-      }
-      Node node;
-      if (!ParseNode(&node, err, o,
-                     store_original_json_for_extras_and_extensions_)) {
-        return false;
       }
+    }
+  }
 
-      model->nodes.emplace_back(std::move(node));
-      return true;
+  // 7. Parse Node
+  {
+    bool success = ForEachInArray(v, "nodes", [&](const detail::json &o) {
+      return parseNode(model, o);
     });
 
     if (!success) {
@@ -6329,21 +11144,7 @@ bool TinyGLTF::LoadFromString(Model *model, std::string *err, std::string *warn,
   // 8. Parse scenes.
   {
     bool success = ForEachInArray(v, "scenes", [&](const detail::json &o) {
-      if (!detail::IsObject(o)) {
-        if (err) {
-          (*err) += "`scenes' does not contain an JSON object.";
-        }
-        return false;
-      }
-
-      Scene scene;
-      if (!ParseScene(&scene, err, o,
-                      store_original_json_for_extras_and_extensions_)) {
-        return false;
-      }
-
-      model->scenes.emplace_back(std::move(scene));
-      return true;
+      return parseScene(model, o);
     });
 
     if (!success) {
@@ -6364,23 +11165,7 @@ bool TinyGLTF::LoadFromString(Model *model, std::string *err, std::string *warn,
   // 10. Parse Material
   {
     bool success = ForEachInArray(v, "materials", [&](const detail::json &o) {
-      if (!detail::IsObject(o)) {
-        if (err) {
-          (*err) += "`materials' does not contain an JSON object.";
-        }
-        return false;
-      }
-      Material material;
-      ParseStringProperty(&material.name, err, o, "name", false);
-
-      if (!ParseMaterial(&material, err, warn, o,
-                         store_original_json_for_extras_and_extensions_,
-                         strictness_)) {
-        return false;
-      }
-
-      model->materials.emplace_back(std::move(material));
-      return true;
+      return parseMaterial(model, o);
     });
 
     if (!success) {
@@ -6402,100 +11187,148 @@ bool TinyGLTF::LoadFromString(Model *model, std::string *err, std::string *warn,
     load_image_user_data = reinterpret_cast<void *>(&load_image_option);
   }
 
+  // Images are parsed and their encoded bytes collected in order, then
+  // decoded in parallel. Messages are kept per image and appended in image
+  // order, stopping at the first failure, so err/warn match a serial load.
   {
-    int idx = 0;
-    bool success = ForEachInArray(v, "images", [&](const detail::json &o) {
+    struct PendingImage {
+      std::vector<unsigned char> encoded;  // data URI or external file
+      const unsigned char *bytes{nullptr};
+      size_t size{0};
+      int req_width{0};
+      int req_height{0};
+      std::string err, warn;
+      bool ok{true};
+      double seconds{0.0};
+    };
+    std::vector<PendingImage> pending;
+    model->image_decoder.reset();
+
+    ForEachInArray(v, "images", [&](const detail::json &o) {
+      const int idx = int(pending.size());
+      pending.emplace_back();
+      PendingImage &p = pending.back();
+      p.ok = false;  // until parsed
       if (!detail::IsObject(o)) {
-        if (err) {
-          (*err) += "image[" + std::to_string(idx) + "] is not a JSON object.";
-        }
+        p.err += "image[" + std::to_string(idx) + "] is not a JSON object.";
         return false;
       }
       Image image;
-      if (!ParseImage(&image, idx, err, warn, o,
+      if (!ParseImage(&image, idx, &p.err, &p.warn, o,
                       store_original_json_for_extras_and_extensions_, base_dir,
-                      max_external_file_size_, &fs, &uri_cb,
-                      this->LoadImageData, load_image_user_data)) {
+                      max_external_file_size_, &fs, &uri_cb, &p.encoded)) {
         return false;
       }
+      p.bytes = p.encoded.empty() ? nullptr : p.encoded.data();
+      p.size = p.encoded.size();
 
       if (image.bufferView != -1) {
         // Load image from the buffer view.
         if (size_t(image.bufferView) >= model->bufferViews.size()) {
-          if (err) {
-            std::stringstream ss;
-            ss << "image[" << idx << "] bufferView \"" << image.bufferView
-               << "\" not found in the scene." << std::endl;
-            (*err) += ss.str();
-          }
+          std::stringstream ss;
+          ss << "image[" << idx << "] bufferView \"" << image.bufferView
+             << "\" not found in the scene." << std::endl;
+          p.err += ss.str();
           return false;
         }
 
         const BufferView &bufferView =
             model->bufferViews[size_t(image.bufferView)];
         if (size_t(bufferView.buffer) >= model->buffers.size()) {
-          if (err) {
-            std::stringstream ss;
-            ss << "image[" << idx << "] buffer \"" << bufferView.buffer
-               << "\" not found in the scene." << std::endl;
-            (*err) += ss.str();
-          }
+          std::stringstream ss;
+          ss << "image[" << idx << "] buffer \"" << bufferView.buffer
+             << "\" not found in the scene." << std::endl;
+          p.err += ss.str();
           return false;
         }
         const Buffer &buffer = model->buffers[size_t(bufferView.buffer)];
-        if (bufferView.byteOffset >= buffer.data.size()) {
-          if (err) {
-            std::stringstream ss;
-            ss << "image[" << idx << "] bufferView \"" << image.bufferView
-               << "\" indexed out of bounds of its buffer." << std::endl;
-            (*err) += ss.str();
-          }
-          return false;
-        }
-
-        if (LoadImageData == nullptr) {
-          if (err) {
-            (*err) += "No LoadImageData callback specified.\n";
-          }
-          return false;
-        }
-        bool ret = LoadImageData(
-            &image, idx, err, warn, image.width, image.height,
-            &buffer.data[bufferView.byteOffset],
-            static_cast<int>(bufferView.byteLength), load_image_user_data);
-        if (!ret) {
+        if (bufferView.byteOffset >= buffer.Size()) {
+          std::stringstream ss;
+          ss << "image[" << idx << "] bufferView \"" << image.bufferView
+             << "\" indexed out of bounds of its buffer." << std::endl;
+          p.err += ss.str();
           return false;
         }
+        p.bytes = buffer.Data() + bufferView.byteOffset;
+        p.size = bufferView.byteLength;
+        p.req_width = image.width;
+        p.req_height = image.height;
       }
 
+      p.ok = true;
       model->images.emplace_back(std::move(image));
-      ++idx;
       return true;
     });
 
-    if (!success) {
-      return false;
+    if (lazy_image_decoding_) {
+      // Keep the compressed bytes; DecodeImage() decodes on demand
+      std::shared_ptr<LazyImageDecoder> decoder =
+          std::make_shared<LazyImageDecoder>();
+      decoder->load = LoadImageData;
+      decoder->user_data = load_image_user_data_;
+      decoder->user_loader = user_image_loader_;
+      decoder->option = load_image_option;
+      for (size_t k = 0; k < model->images.size(); ++k) {
+        PendingImage &p = pending[k];
+        if (!p.bytes) continue;
+        Image &image = model->images[k];
+        image.encoded.swap(p.encoded);
+        image.decode_pending = true;
+        p.bytes = nullptr;  // no decode timing
+      }
+      model->image_decoder = decoder;
+    }
+
+    // A custom loader is only run concurrently when asked to
+    size_t workers = size_t(image_decode_threads_);
+    if (workers == 0 && user_image_loader_) workers = 1;
+
+    // Indices are handed out in order, so once an image has failed no image
+    // after it is started, as the serial loop would stop there; the ones
+    // already running finish, but are not reported.
+    std::atomic<bool> failed{false};
+    detail::ParallelFor(model->images.size(), workers, [&](size_t k) {
+      PendingImage &p = pending[k];
+      if (!p.bytes || failed) return;
+      if (LoadImageData == nullptr) {
+        p.err += "No LoadImageData callback specified.\n";
+        p.ok = false;
+        failed = true;
+        return;
+      }
+      auto start = std::chrono::steady_clock::now();
+      p.ok = LoadImageData(&model->images[k], int(k), &p.err, &p.warn,
+                           p.req_width, p.req_height, p.bytes,
+                           static_cast<int>(p.size), load_image_user_data);
+      p.seconds = std::chrono::duration<double>(
+                      std::chrono::steady_clock::now() - start)
+                      .count();
+      if (!p.ok) failed = true;
+    });
+
+    image_decode_timings_.clear();
+    for (size_t k = 0; k < pending.size(); ++k) {
+      const PendingImage &p = pending[k];
+      if (err) (*err) += p.err;
+      if (warn) (*warn) += p.warn;
+      if (p.bytes && LoadImageData) {
+        ImageDecodeTiming timing;
+        timing.image = int(k);
+        timing.encoded_bytes = p.size;
+        timing.seconds = p.seconds;
+        timing.ok = p.ok;
+        image_decode_timings_.push_back(timing);
+      }
+      if (!p.ok) {
+        return false;
+      }
     }
   }
 
   // 12. Parse Texture
   {
     bool success = ForEachInArray(v, "textures", [&](const detail::json &o) {
-      if (!detail::IsObject(o)) {
-        if (err) {
-          (*err) += "`textures' does not contain an JSON object.";
-        }
-        return false;
-      }
-      Texture texture;
-      if (!ParseTexture(&texture, err, o,
-                        store_original_json_for_extras_and_extensions_,
-                        base_dir)) {
-        return false;
-      }
-
-      model->textures.emplace_back(std::move(texture));
-      return true;
+      return parseTexture(model, o);
     });
 
     if (!success) {
@@ -6506,20 +11339,7 @@ bool TinyGLTF::LoadFromString(Model *model, std::string *err, std::string *warn,
   // 13. Parse Animation
   {
     bool success = ForEachInArray(v, "animations", [&](const detail::json &o) {
-      if (!detail::IsObject(o)) {
-        if (err) {
-          (*err) += "`animations' does not contain an JSON object.";
-        }
-        return false;
-      }
-      Animation animation;
-      if (!ParseAnimation(&animation, err, o,
-                          store_original_json_for_extras_and_extensions_)) {
-        return false;
-      }
-
-      model->animations.emplace_back(std::move(animation));
-      return true;
+      return parseAnimation(model, o);
     });
 
     if (!success) {
@@ -6530,20 +11350,7 @@ bool TinyGLTF::LoadFromString(Model *model, std::string *err, std::string *warn,
   // 14. Parse Skin
   {
     bool success = ForEachInArray(v, "skins", [&](const detail::json &o) {
-      if (!detail::IsObject(o)) {
-        if (err) {
-          (*err) += "`skins' does not contain an JSON object.";
-        }
-        return false;
-      }
-      Skin skin;
-      if (!ParseSkin(&skin, err, o,
-                     store_original_json_for_extras_and_extensions_)) {
-        return false;
-      }
-
-      model->skins.emplace_back(std::move(skin));
-      return true;
+      return parseSkin(model, o);
     });
 
     if (!success) {
@@ -6554,20 +11361,7 @@ bool TinyGLTF::LoadFromString(Model *model, std::string *err, std::string *warn,
   // 15. Parse Sampler
   {
     bool success = ForEachInArray(v, "samplers", [&](const detail::json &o) {
-      if (!detail::IsObject(o)) {
-        if (err) {
-          (*err) += "`samplers' does not contain an JSON object.";
-        }
-        return false;
-      }
-      Sampler sampler;
-      if (!ParseSampler(&sampler, err, o,
-                        store_original_json_for_extras_and_extensions_)) {
-        return false;
-      }
-
-      model->samplers.emplace_back(std::move(sampler));
-      return true;
+      return parseSampler(model, o);
     });
 
     if (!success) {
@@ -6578,20 +11372,7 @@ bool TinyGLTF::LoadFromString(Model *model, std::string *err, std::string *warn,
   // 16. Parse Camera
   {
     bool success = ForEachInArray(v, "cameras", [&](const detail::json &o) {
-      if (!detail::IsObject(o)) {
-        if (err) {
-          (*err) += "`cameras' does not contain an JSON object.";
-        }
-        return false;
-      }
-      Camera camera;
-      if (!ParseCamera(&camera, err, o,
-                       store_original_json_for_extras_and_extensions_)) {
-        return false;
-      }
-
-      model->cameras.emplace_back(std::move(camera));
-      return true;
+      return parseCamera(model, o);
     });
 
     if (!success) {
@@ -6940,6 +11721,29 @@ bool TinyGLTF::LoadBinaryFromFile(Model *model, std::string *err,
     return false;
   }
 
+#ifndef TINYGLTF_NO_FS
+  // Mapping bypasses the FS callbacks, so only do it when they are the
+  // built-in ones.
+  typedef bool (*ReadWholeFilePtr)(std::vector<unsigned char> *, std::string *,
+                                   const std::string &, void *);
+  const ReadWholeFilePtr *read_fn = fs.ReadWholeFile.target<ReadWholeFilePtr>();
+  if (memory_map_binary_ && read_fn && *read_fn == &tinygltf::ReadWholeFile) {
+    std::string maperr;
+    std::shared_ptr<detail::MappedFile> mapped =
+        detail::MapWholeFile(filename, &maperr);
+    if (mapped && mapped->size <= (std::numeric_limits<unsigned int>::max)()) {
+      bin_owner_ = mapped;
+      bool ret = LoadBinaryFromMemory(
+          model, err, warn, mapped->data,
+          static_cast<unsigned int>(mapped->size), GetBaseDir(filename),
+          check_sections);
+      bin_owner_.reset();
+      return ret;
+    }
+    // Otherwise fall back to reading the file.
+  }
+#endif
+
   std::vector<unsigned char> data;
   std::string fileerr;
   bool fileread = fs.ReadWholeFile(&data, &fileerr, filename, fs.user_data);
@@ -7058,7 +11862,7 @@ void SerializeNumberProperty(const std::string &key, size_t number,
 
 template <typename T>
 static void SerializeNumberArrayProperty(const std::string &key,
-                                         const std::vector<T> &value,
+                                         const ModelVector<T> &value,
                                          detail::json &obj) {
   if (value.empty()) return;
 
@@ -7078,7 +11882,7 @@ static void SerializeStringProperty(const std::string &key,
 }
 
 static void SerializeStringArrayProperty(const std::string &key,
-                                         const std::vector<std::string> &value,
+                                         const ModelVector<std::string> &value,
                                          detail::json &obj) {
   detail::json ary;
   detail::JsonReserveArray(ary, value.size());
@@ -7109,7 +11913,6 @@ static bool ValueToJson(const Value &value, detail::json *ret) {
       obj.Reserve(static_cast<rapidjson::SizeType>(value.ArrayLen()),
                   detail::GetAllocator());
       for (unsigned int i = 0; i < value.ArrayLen(); ++i) {
-        Value elementValue = value.Get(int(i));
         detail::json elementJson;
         if (ValueToJson(value.Get(int(i)), &elementJson))
           obj.PushBack(std::move(elementJson), detail::GetAllocator());
@@ -7123,7 +11926,7 @@ static bool ValueToJson(const Value &value, detail::json *ret) {
       break;
     case OBJECT_TYPE: {
       obj.SetObject();
-      Value::Object objMap = value.Get<Value::Object>();
+      const Value::Object &objMap = value.Get<Value::Object>();
       for (auto &it : objMap) {
         detail::json elementJson;
         if (ValueToJson(it.second, &elementJson)) {
@@ -7153,7 +11956,6 @@ static bool ValueToJson(const Value &value, detail::json *ret) {
       break;
     case ARRAY_TYPE: {
       for (size_t i = 0; i < value.ArrayLen(); ++i) {
-        Value elementValue = value.Get(i);
         detail::json elementJson;
         if (ValueToJson(value.Get(i), &elementJson))
           obj.push_back(elementJson);
@@ -7166,10 +11968,12 @@ static bool ValueToJson(const Value &value, detail::json *ret) {
       return false;
       break;
     case OBJECT_TYPE: {
-      Value::Object objMap = value.Get<Value::Object>();
+      const Value::Object &objMap = value.Get<Value::Object>();
       for (auto &it : objMap) {
         detail::json elementJson;
-        if (ValueToJson(it.second, &elementJson)) obj[it.first] = elementJson;
+        if (ValueToJson(it.second, &elementJson)) {
+          obj[it.first.str()] = std::move(elementJson);
+        }
       }
       break;
     }
@@ -7190,21 +11994,22 @@ static void SerializeValue(const std::string &key, const Value &value,
   }
 }
 
-static void SerializeGltfBufferData(const std::vector<unsigned char> &data,
+static const char kBufferDataUriHeader[] =
+    "data:application/octet-stream;base64,";
+
+static void SerializeGltfBufferData(const unsigned char *data, size_t size,
                                     detail::json &o) {
-  std::string header = "data:application/octet-stream;base64,";
-  if (data.size() > 0) {
-    std::string encodedData =
-        base64_encode(&data[0], static_cast<unsigned int>(data.size()));
-    SerializeStringProperty("uri", header + encodedData, o);
-  } else {
-    // Issue #229
-    // size 0 is allowed. Just emit mime header.
-    SerializeStringProperty("uri", header, o);
+  // Issue #229: size 0 is allowed, the uri is then just the mime header.
+  const size_t header_len = sizeof(kBufferDataUriHeader) - 1;
+  std::string uri(header_len + kernels::Base64EncodedSize(size), '\0');
+  std::memcpy(&uri[0], kBufferDataUriHeader, header_len);
+  if (size > 0) {
+    kernels::Base64Encode(data, size, &uri[header_len]);
   }
+  SerializeStringProperty("uri", uri, o);
 }
 
-static bool SerializeGltfBufferData(const std::vector<unsigned char> &data,
+static bool SerializeGltfBufferData(const unsigned char *data, size_t size,
                                     const std::string &binFilename) {
 #ifndef TINYGLTF_NO_FS
 #ifdef _WIN32
@@ -7226,9 +12031,9 @@ static bool SerializeGltfBufferData(const std::vector<unsigned char> &data,
   std::ofstream output(binFilename.c_str(), std::ofstream::binary);
   if (!output.is_open()) return false;
 #endif
-  if (data.size() > 0) {
-    output.write(reinterpret_cast<const char *>(&data[0]),
-                 std::streamsize(data.size()));
+  if (size > 0) {
+    output.write(reinterpret_cast<const char *>(data),
+                 std::streamsize(size));
   } else {
     // Issue #229
     // size 0 will be still valid buffer data.
@@ -7326,7 +12131,7 @@ static void SerializeGltfAccessor(const Accessor &accessor, detail::json &o) {
     // Issue #301. Serialize as integer.
     // Assume int value is within [-2**31-1, 2**31-1]
     {
-      std::vector<int> values;
+      ModelVector<int> values;
       std::transform(accessor.minValues.begin(), accessor.minValues.end(),
                      std::back_inserter(values),
                      [](double v) { return static_cast<int>(v); });
@@ -7335,7 +12140,7 @@ static void SerializeGltfAccessor(const Accessor &accessor, detail::json &o) {
     }
 
     {
-      std::vector<int> values;
+      ModelVector<int> values;
       std::transform(accessor.maxValues.begin(), accessor.maxValues.end(),
                      std::back_inserter(values),
                      [](double v) { return static_cast<int>(v); });
@@ -7490,10 +12295,10 @@ static void SerializeGltfAsset(const Asset &asset, detail::json &o) {
   SerializeExtrasAndExtensions(asset, o);
 }
 
-static void SerializeGltfBufferBin(const Buffer &buffer, detail::json &o,
-                                   std::vector<unsigned char> &binBuffer) {
-  SerializeNumberProperty("byteLength", buffer.data.size(), o);
-  binBuffer = buffer.data;
+// Everything but the uri, for a buffer whose data is written separately:
+// into the GLB BIN chunk or as a data URI streamed into the output.
+static void SerializeGltfBufferInfo(const Buffer &buffer, detail::json &o) {
+  SerializeNumberProperty("byteLength", buffer.Size(), o);
 
   if (buffer.name.size()) SerializeStringProperty("name", buffer.name, o);
 
@@ -7501,8 +12306,8 @@ static void SerializeGltfBufferBin(const Buffer &buffer, detail::json &o,
 }
 
 static void SerializeGltfBuffer(const Buffer &buffer, detail::json &o) {
-  SerializeNumberProperty("byteLength", buffer.data.size(), o);
-  SerializeGltfBufferData(buffer.data, o);
+  SerializeNumberProperty("byteLength", buffer.Size(), o);
+  SerializeGltfBufferData(buffer.Data(), buffer.Size(), o);
 
   if (buffer.name.size()) SerializeStringProperty("name", buffer.name, o);
 
@@ -7512,8 +12317,9 @@ static void SerializeGltfBuffer(const Buffer &buffer, detail::json &o) {
 static bool SerializeGltfBuffer(const Buffer &buffer, detail::json &o,
                                 const std::string &binFilename,
                                 const std::string &binUri) {
-  if (!SerializeGltfBufferData(buffer.data, binFilename)) return false;
-  SerializeNumberProperty("byteLength", buffer.data.size(), o);
+  if (!SerializeGltfBufferData(buffer.Data(), buffer.Size(), binFilename))
+    return false;
+  SerializeNumberProperty("byteLength", buffer.Size(), o);
   SerializeStringProperty("uri", binUri, o);
 
   if (buffer.name.size()) SerializeStringProperty("name", buffer.name, o);
@@ -7608,7 +12414,7 @@ static void SerializeGltfOcclusionTextureInfo(
 
 static void SerializeGltfPbrMetallicRoughness(const PbrMetallicRoughness &pbr,
                                               detail::json &o) {
-  std::vector<double> default_baseColorFactor = {1.0, 1.0, 1.0, 1.0};
+  ModelVector<double> default_baseColorFactor = {1.0, 1.0, 1.0, 1.0};
   if (!Equals(pbr.baseColorFactor, default_baseColorFactor)) {
     SerializeNumberArrayProperty<double>("baseColorFactor", pbr.baseColorFactor,
                                          o);
@@ -7673,7 +12479,7 @@ static void SerializeGltfMaterial(const Material &material, detail::json &o) {
     detail::JsonAddMember(o, "emissiveTexture", std::move(texinfo));
   }
 
-  std::vector<double> default_emissiveFactor = {0.0, 0.0, 0.0};
+  ModelVector<double> default_emissiveFactor = {0.0, 0.0, 0.0};
   if (!Equals(material.emissiveFactor, default_emissiveFactor)) {
     SerializeNumberArrayProperty<double>("emissiveFactor",
                                          material.emissiveFactor, o);
@@ -7772,9 +12578,9 @@ static void SerializeGltfMesh(const Mesh &mesh, detail::json &o) {
       detail::JsonReserveArray(targets, gltfPrimitive.targets.size());
       for (unsigned int k = 0; k < gltfPrimitive.targets.size(); ++k) {
         detail::json targetAttributes;
-        std::map<std::string, int> targetData = gltfPrimitive.targets[k];
-        for (std::map<std::string, int>::iterator attrIt = targetData.begin();
-             attrIt != targetData.end(); ++attrIt) {
+        const AttributeMap &targetData = gltfPrimitive.targets[k];
+        for (auto attrIt = targetData.begin(); attrIt != targetData.end();
+             ++attrIt) {
           SerializeNumberProperty<int>(attrIt->first, attrIt->second,
                                        targetAttributes);
         }
@@ -8147,53 +12953,120 @@ static void SerializeGltfTexture(const Texture &texture, detail::json &o) {
   SerializeExtrasAndExtensions(texture, o);
 }
 
-///
-/// Serialize all properties except buffers and images.
-///
-static void SerializeGltfModel(const Model *model, detail::json &o) {
-  // ACCESSORS
-  if (model->accessors.size()) {
-    detail::json accessors;
-    detail::JsonReserveArray(accessors, model->accessors.size());
-    for (unsigned int i = 0; i < model->accessors.size(); ++i) {
-      detail::json accessor;
-      SerializeGltfAccessor(model->accessors[i], accessor);
-      detail::JsonPushBack(accessors, std::move(accessor));
-    }
-    detail::JsonAddMember(o, "accessors", std::move(accessors));
-  }
+// A top-level array of the model: its key, its length and how to serialize
+// one element. Elements for which `serialize` returns false are left out,
+// but the array itself is written whenever the model has elements.
+struct GltfArrayProperty {
+  const char *key;
+  size_t (*size)(const Model &);
+  bool (*serialize)(const Model &, size_t, detail::json &);
+};
 
-  // ANIMATIONS
-  if (model->animations.size()) {
-    detail::json animations;
-    detail::JsonReserveArray(animations, model->animations.size());
-    for (unsigned int i = 0; i < model->animations.size(); ++i) {
-      if (model->animations[i].channels.size()) {
-        detail::json animation;
-        SerializeGltfAnimation(model->animations[i], animation);
-        detail::JsonPushBack(animations, std::move(animation));
-      }
-    }
+// `material`, `node` and `scene` have no required parameters, so their JSON
+// may be null(unmodified) when all parameters have the default value.
+// null is not allowed thus we create an empty JSON object (Issue 294, 457,
+// 464).
+static void SetObjectIfNull(detail::json &o) {
+  if (detail::JsonIsNull(o)) {
+    detail::JsonSetObject(o);
+  }
+}
+
+static const GltfArrayProperty kGltfArrayProperties[] = {
+    {"accessors", [](const Model &m) { return m.accessors.size(); },
+     [](const Model &m, size_t i, detail::json &o) {
+       SerializeGltfAccessor(m.accessors[i], o);
+       return true;
+     }},
+    {"animations", [](const Model &m) { return m.animations.size(); },
+     [](const Model &m, size_t i, detail::json &o) {
+       if (m.animations[i].channels.empty()) return false;
+       SerializeGltfAnimation(m.animations[i], o);
+       return true;
+     }},
+    {"bufferViews", [](const Model &m) { return m.bufferViews.size(); },
+     [](const Model &m, size_t i, detail::json &o) {
+       SerializeGltfBufferView(m.bufferViews[i], o);
+       return true;
+     }},
+    {"materials", [](const Model &m) { return m.materials.size(); },
+     [](const Model &m, size_t i, detail::json &o) {
+       SerializeGltfMaterial(m.materials[i], o);
+       SetObjectIfNull(o);
+       return true;
+     }},
+    {"meshes", [](const Model &m) { return m.meshes.size(); },
+     [](const Model &m, size_t i, detail::json &o) {
+       SerializeGltfMesh(m.meshes[i], o);
+       return true;
+     }},
+    {"nodes", [](const Model &m) { return m.nodes.size(); },
+     [](const Model &m, size_t i, detail::json &o) {
+       SerializeGltfNode(m.nodes[i], o);
+       SetObjectIfNull(o);
+       return true;
+     }},
+    {"scenes", [](const Model &m) { return m.scenes.size(); },
+     [](const Model &m, size_t i, detail::json &o) {
+       SerializeGltfScene(m.scenes[i], o);
+       SetObjectIfNull(o);
+       return true;
+     }},
+    {"skins", [](const Model &m) { return m.skins.size(); },
+     [](const Model &m, size_t i, detail::json &o) {
+       SerializeGltfSkin(m.skins[i], o);
+       return true;
+     }},
+    {"textures", [](const Model &m) { return m.textures.size(); },
+     [](const Model &m, size_t i, detail::json &o) {
+       SerializeGltfTexture(m.textures[i], o);
+       return true;
+     }},
+    {"samplers", [](const Model &m) { return m.samplers.size(); },
+     [](const Model &m, size_t i, detail::json &o) {
+       SerializeGltfSampler(m.samplers[i], o);
+       return true;
+     }},
+    {"cameras", [](const Model &m) { return m.cameras.size(); },
+     [](const Model &m, size_t i, detail::json &o) {
+       SerializeGltfCamera(m.cameras[i], o);
+       return true;
+     }},
+};
 
-    detail::JsonAddMember(o, "animations", std::move(animations));
+static void SerializeGltfArrayProperty(const Model &model, const char *key,
+                                       detail::json &o) {
+  for (const GltfArrayProperty &property : kGltfArrayProperties) {
+    if (std::strcmp(property.key, key) != 0) continue;
+    const size_t size = property.size(model);
+    if (!size) return;
+    detail::json elements;
+    detail::JsonReserveArray(elements, size);
+    for (size_t i = 0; i < size; ++i) {
+      detail::json element;
+      if (property.serialize(model, i, element)) {
+        detail::JsonPushBack(elements, std::move(element));
+      }
+    }
+    detail::JsonAddMember(o, key, std::move(elements));
+    return;
   }
+}
+
+/// Serializes all properties except buffers and images. Without `arrays`
+/// the kGltfArrayProperties are left out as well, for writers that emit
+/// them element by element.
+static void SerializeGltfModel(const Model *model, detail::json &o,
+                               bool arrays = true) {
+  if (arrays) SerializeGltfArrayProperty(*model, "accessors", o);
+  if (arrays) SerializeGltfArrayProperty(*model, "animations", o);
 
   // ASSET
   detail::json asset;
   SerializeGltfAsset(model->asset, asset);
   detail::JsonAddMember(o, "asset", std::move(asset));
 
-  // BUFFERVIEWS
-  if (model->bufferViews.size()) {
-    detail::json bufferViews;
-    detail::JsonReserveArray(bufferViews, model->bufferViews.size());
-    for (unsigned int i = 0; i < model->bufferViews.size(); ++i) {
-      detail::json bufferView;
-      SerializeGltfBufferView(model->bufferViews[i], bufferView);
-      detail::JsonPushBack(bufferViews, std::move(bufferView));
-    }
-    detail::JsonAddMember(o, "bufferViews", std::move(bufferViews));
-  }
+  if (arrays) SerializeGltfArrayProperty(*model, "bufferViews", o);
 
   // Extensions required
   if (model->extensionsRequired.size()) {
@@ -8201,60 +13074,10 @@ static void SerializeGltfModel(const Model *model, detail::json &o) {
                                  model->extensionsRequired, o);
   }
 
-  // MATERIALS
-  if (model->materials.size()) {
-    detail::json materials;
-    detail::JsonReserveArray(materials, model->materials.size());
-    for (unsigned int i = 0; i < model->materials.size(); ++i) {
-      detail::json material;
-      SerializeGltfMaterial(model->materials[i], material);
-
-      if (detail::JsonIsNull(material)) {
-        // Issue 294.
-        // `material` does not have any required parameters
-        // so the result may be null(unmodified) when all material parameters
-        // have default value.
-        //
-        // null is not allowed thus we create an empty JSON object.
-        detail::JsonSetObject(material);
-      }
-      detail::JsonPushBack(materials, std::move(material));
-    }
-    detail::JsonAddMember(o, "materials", std::move(materials));
-  }
-
-  // MESHES
-  if (model->meshes.size()) {
-    detail::json meshes;
-    detail::JsonReserveArray(meshes, model->meshes.size());
-    for (unsigned int i = 0; i < model->meshes.size(); ++i) {
-      detail::json mesh;
-      SerializeGltfMesh(model->meshes[i], mesh);
-      detail::JsonPushBack(meshes, std::move(mesh));
-    }
-    detail::JsonAddMember(o, "meshes", std::move(meshes));
-  }
-
-  // NODES
-  if (model->nodes.size()) {
-    detail::json nodes;
-    detail::JsonReserveArray(nodes, model->nodes.size());
-    for (unsigned int i = 0; i < model->nodes.size(); ++i) {
-      detail::json node;
-      SerializeGltfNode(model->nodes[i], node);
-
-      if (detail::JsonIsNull(node)) {
-        // Issue 457.
-        // `node` does not have any required parameters,
-        // so the result may be null(unmodified) when all node parameters
-        // have default value.
-        //
-        // null is not allowed thus we create an empty JSON object.
-        detail::JsonSetObject(node);
-      }
-      detail::JsonPushBack(nodes, std::move(node));
-    }
-    detail::JsonAddMember(o, "nodes", std::move(nodes));
+  if (arrays) {
+    SerializeGltfArrayProperty(*model, "materials", o);
+    SerializeGltfArrayProperty(*model, "meshes", o);
+    SerializeGltfArrayProperty(*model, "nodes", o);
   }
 
   // SCENE
@@ -8262,73 +13085,12 @@ static void SerializeGltfModel(const Model *model, detail::json &o) {
     SerializeNumberProperty<int>("scene", model->defaultScene, o);
   }
 
-  // SCENES
-  if (model->scenes.size()) {
-    detail::json scenes;
-    detail::JsonReserveArray(scenes, model->scenes.size());
-    for (unsigned int i = 0; i < model->scenes.size(); ++i) {
-      detail::json currentScene;
-      SerializeGltfScene(model->scenes[i], currentScene);
-      if (detail::JsonIsNull(currentScene)) {
-        // Issue 464.
-        // `scene` does not have any required parameters,
-        // so the result may be null(unmodified) when all scene parameters
-        // have default value.
-        //
-        // null is not allowed thus we create an empty JSON object.
-        detail::JsonSetObject(currentScene);
-      }
-      detail::JsonPushBack(scenes, std::move(currentScene));
-    }
-    detail::JsonAddMember(o, "scenes", std::move(scenes));
-  }
-
-  // SKINS
-  if (model->skins.size()) {
-    detail::json skins;
-    detail::JsonReserveArray(skins, model->skins.size());
-    for (unsigned int i = 0; i < model->skins.size(); ++i) {
-      detail::json skin;
-      SerializeGltfSkin(model->skins[i], skin);
-      detail::JsonPushBack(skins, std::move(skin));
-    }
-    detail::JsonAddMember(o, "skins", std::move(skins));
-  }
-
-  // TEXTURES
-  if (model->textures.size()) {
-    detail::json textures;
-    detail::JsonReserveArray(textures, model->textures.size());
-    for (unsigned int i = 0; i < model->textures.size(); ++i) {
-      detail::json texture;
-      SerializeGltfTexture(model->textures[i], texture);
-      detail::JsonPushBack(textures, std::move(texture));
-    }
-    detail::JsonAddMember(o, "textures", std::move(textures));
-  }
-
-  // SAMPLERS
-  if (model->samplers.size()) {
-    detail::json samplers;
-    detail::JsonReserveArray(samplers, model->samplers.size());
-    for (unsigned int i = 0; i < model->samplers.size(); ++i) {
-      detail::json sampler;
-      SerializeGltfSampler(model->samplers[i], sampler);
-      detail::JsonPushBack(samplers, std::move(sampler));
-    }
-    detail::JsonAddMember(o, "samplers", std::move(samplers));
-  }
-
-  // CAMERAS
-  if (model->cameras.size()) {
-    detail::json cameras;
-    detail::JsonReserveArray(cameras, model->cameras.size());
-    for (unsigned int i = 0; i < model->cameras.size(); ++i) {
-      detail::json camera;
-      SerializeGltfCamera(model->cameras[i], camera);
-      detail::JsonPushBack(cameras, std::move(camera));
-    }
-    detail::JsonAddMember(o, "cameras", std::move(cameras));
+  if (arrays) {
+    SerializeGltfArrayProperty(*model, "scenes", o);
+    SerializeGltfArrayProperty(*model, "skins", o);
+    SerializeGltfArrayProperty(*model, "textures", o);
+    SerializeGltfArrayProperty(*model, "samplers", o);
+    SerializeGltfArrayProperty(*model, "cameras", o);
   }
 
   // EXTRAS & EXTENSIONS
@@ -8452,13 +13214,204 @@ static void SerializeGltfModel(const Model *model, detail::json &o) {
   }
 }
 
-static bool WriteGltfStream(std::ostream &stream, const std::string &content) {
-  stream << content << std::endl;
-  return stream.good();
+// The buffers and images of a model, serialized before the document is
+// written since that may fail or write files. The data of the buffers in
+// `embedded` (null for the others) goes into the document as data URIs, and
+// `bin` is the buffer stored in the GLB BIN chunk.
+struct GltfPayloads {
+  std::vector<detail::json> buffers;
+  std::vector<const Buffer *> embedded;
+  std::vector<detail::json> images;
+  const Buffer *bin = nullptr;
+};
+
+// Adds a buffer whose data is stored in the BIN chunk when `bin` is set and
+// embedded as a data URI otherwise.
+static void SerializeGltfBufferPayload(const Buffer &buffer, bool bin,
+                                       GltfPayloads *payloads) {
+  detail::json o;
+  SerializeGltfBufferInfo(buffer, o);
+  payloads->buffers.push_back(std::move(o));
+  payloads->embedded.push_back(bin ? nullptr : &buffer);
+  if (bin) payloads->bin = &buffer;
+}
+
+/// Builds the complete glTF JSON of `model`, taking the JSON of `payloads`.
+/// WriteGltfJson() writes the same text without building it.
+void SerializeGltfDocument(const Model &model, GltfPayloads &payloads,
+                           detail::json &o) {
+  SerializeGltfModel(&model, o);
+
+  // BUFFERS
+  if (payloads.buffers.size()) {
+    detail::json buffers;
+    detail::JsonReserveArray(buffers, payloads.buffers.size());
+    for (size_t i = 0; i < payloads.buffers.size(); ++i) {
+      if (payloads.embedded[i]) {
+        detail::json buffer;
+        SerializeGltfBuffer(*payloads.embedded[i], buffer);
+        detail::JsonPushBack(buffers, std::move(buffer));
+      } else {
+        detail::JsonPushBack(buffers, std::move(payloads.buffers[i]));
+      }
+    }
+    detail::JsonAddMember(o, "buffers", std::move(buffers));
+  }
+
+  // IMAGES
+  if (payloads.images.size()) {
+    detail::json images;
+    detail::JsonReserveArray(images, payloads.images.size());
+    for (size_t i = 0; i < payloads.images.size(); ++i) {
+      detail::JsonPushBack(images, std::move(payloads.images[i]));
+    }
+    detail::JsonAddMember(o, "images", std::move(images));
+  }
 }
 
-static bool WriteGltfFile(const std::string &output,
-                          const std::string &content) {
+#ifndef TINYGLTF_USE_RAPIDJSON
+static void WriteGltfBufferDataUri(const Buffer &buffer,
+                                   detail::JsonStreamWriter &writer) {
+  writer.BeginString();
+  writer.Append(kBufferDataUriHeader, sizeof(kBufferDataUriHeader) - 1);
+  // Blocks of whole 3 byte groups encode the same as the buffer at once.
+  const size_t kBlockSize = 3 * 16 * 1024;
+  for (size_t offset = 0; offset < buffer.Size(); offset += kBlockSize) {
+    const size_t n = (std::min)(kBlockSize, buffer.Size() - offset);
+    kernels::Base64Encode(buffer.Data() + offset, n,
+                          writer.Append(kernels::Base64EncodedSize(n)));
+  }
+  writer.EndString();
+}
+
+static void WriteGltfBuffer(const detail::json &o, const Buffer *embedded,
+                            detail::JsonStreamWriter &writer) {
+  if (!embedded) {
+    writer.Value(o);
+    return;
+  }
+  writer.BeginObject();
+  bool uri = false;
+  for (auto it = o.begin(); it != o.end(); ++it) {
+    if (!uri && it.key() > "uri") {
+      writer.Key("uri");
+      WriteGltfBufferDataUri(*embedded, writer);
+      uri = true;
+    }
+    writer.Key(it.key());
+    writer.Value(it.value());
+  }
+  if (!uri) {
+    writer.Key("uri");
+    WriteGltfBufferDataUri(*embedded, writer);
+  }
+  writer.EndObject();
+}
+#endif
+
+/// Writes the glTF JSON of `model` into `sink`, formatted as JsonToString()
+/// with `spacing` formats the document of SerializeGltfDocument(). Returns
+/// false when the sink fails.
+static bool WriteGltfJson(const Model &model, GltfPayloads &payloads,
+                          int spacing, const detail::JsonSink &sink) {
+#ifdef TINYGLTF_USE_RAPIDJSON
+  // RapidJSON writes members in the order the DOM was built in.
+  detail::json o;
+  SerializeGltfDocument(model, payloads, o);
+  const std::string content = detail::JsonToString(o, spacing);
+  return sink(content.data(), content.size());
+#else
+  // Members of a json object are sorted by key, so the top-level arrays are
+  // merged into the members of the small document that is left without
+  // them, and written one element at a time.
+  detail::json root;
+  SerializeGltfModel(&model, root, /* arrays */ false);
+
+  struct Section {
+    const char *key;
+    const GltfArrayProperty *property;
+    const std::vector<detail::json> *payload;
+  };
+  std::vector<Section> sections;
+  for (const GltfArrayProperty &property : kGltfArrayProperties) {
+    if (property.size(model)) {
+      sections.push_back({property.key, &property, nullptr});
+    }
+  }
+  if (payloads.buffers.size()) {
+    sections.push_back({"buffers", nullptr, &payloads.buffers});
+  }
+  if (payloads.images.size()) {
+    sections.push_back({"images", nullptr, &payloads.images});
+  }
+  std::sort(sections.begin(), sections.end(),
+            [](const Section &a, const Section &b) {
+              return std::strcmp(a.key, b.key) < 0;
+            });
+
+  detail::JsonStreamWriter writer(sink, spacing);
+  writer.BeginObject();
+  auto member = root.begin();
+  for (const Section &section : sections) {
+    for (; member != root.end() && member.key() < section.key; ++member) {
+      writer.Key(member.key());
+      writer.Value(member.value());
+    }
+    writer.Key(section.key);
+    if (section.property) {
+      // Like the unreserved json array of the DOM, an array that got no
+      // elements is null.
+      bool empty = true;
+      const size_t size = section.property->size(model);
+      for (size_t i = 0; i < size; ++i) {
+        detail::json element;
+        if (!section.property->serialize(model, i, element)) continue;
+        if (empty) writer.BeginArray();
+        empty = false;
+        writer.Value(element);
+      }
+      if (empty) {
+        writer.Value(detail::json());
+      } else {
+        writer.EndArray();
+      }
+      continue;
+    }
+    writer.BeginArray();
+    if (section.payload == &payloads.buffers) {
+      for (size_t i = 0; i < payloads.buffers.size(); ++i) {
+        WriteGltfBuffer(payloads.buffers[i], payloads.embedded[i], writer);
+      }
+    } else {
+      for (const detail::json &image : payloads.images) {
+        writer.Value(image);
+      }
+    }
+    writer.EndArray();
+  }
+  for (; member != root.end(); ++member) {
+    writer.Key(member.key());
+    writer.Value(member.value());
+  }
+  writer.EndObject();
+  return writer.Flush();
+#endif
+}
+
+static bool WriteGltfStream(std::ostream &stream, const Model &model,
+                            GltfPayloads &payloads, bool prettyPrint) {
+  const bool written = WriteGltfJson(
+      model, payloads, prettyPrint ? 2 : -1,
+      [&stream](const char *s, size_t n) {
+        stream.write(s, std::streamsize(n));
+        return stream.good();
+      });
+  stream << std::endl;
+  return written && stream.good();
+}
+
+static bool WriteGltfFile(const std::string &output, const Model &model,
+                          GltfPayloads &payloads, bool prettyPrint) {
 #ifndef TINYGLTF_NO_FS
 #ifdef _WIN32
 #if defined(_MSC_VER)
@@ -8478,20 +13431,29 @@ static bool WriteGltfFile(const std::string &output,
   std::ofstream gltfFile(output.c_str());
   if (!gltfFile.is_open()) return false;
 #endif
-  return WriteGltfStream(gltfFile, content);
+  return WriteGltfStream(gltfFile, model, payloads, prettyPrint);
 #else
     return false;
 #endif
 }
 
-static bool WriteBinaryGltfStream(std::ostream &stream,
-                                  const std::string &content,
-                                  const std::vector<unsigned char> &binBuffer) {
+static bool WriteBinaryGltfStream(std::ostream &stream, const Model &model,
+                                  GltfPayloads &payloads) {
+  // The JSON chunk is preceded by its length, so it is written into memory
+  // first; the BIN chunk is written straight from the buffer.
+  std::string content;
+  WriteGltfJson(model, payloads, -1, [&content](const char *s, size_t n) {
+    content.append(s, n);
+    return true;
+  });
+  const unsigned char *bin = payloads.bin ? payloads.bin->Data() : nullptr;
+
   const std::string header = "glTF";
   const int version = 2;
 
   const uint32_t content_size = uint32_t(content.size());
-  const uint32_t binBuffer_size = uint32_t(binBuffer.size());
+  const uint32_t binBuffer_size =
+      payloads.bin ? uint32_t(payloads.bin->Size()) : 0;
   // determine number of padding bytes required to ensure 4 byte alignment
   const uint32_t content_padding_size =
       content_size % 4 == 0 ? 0 : 4 - content_size % 4;
@@ -8522,16 +13484,16 @@ static bool WriteBinaryGltfStream(std::ostream &stream,
     const std::string padding = std::string(size_t(content_padding_size), ' ');
     stream.write(padding.c_str(), std::streamsize(padding.size()));
   }
-  if (binBuffer.size() > 0) {
+  if (binBuffer_size > 0) {
     // BIN chunk info, then BIN data
-    const uint32_t bin_length = uint32_t(binBuffer.size()) + bin_padding_size;
+    const uint32_t bin_length = binBuffer_size + bin_padding_size;
     const uint32_t bin_format = 0x004e4942;
     stream.write(reinterpret_cast<const char *>(&bin_length),
                  sizeof(bin_length));
     stream.write(reinterpret_cast<const char *>(&bin_format),
                  sizeof(bin_format));
-    stream.write(reinterpret_cast<const char *>(binBuffer.data()),
-                 std::streamsize(binBuffer.size()));
+    stream.write(reinterpret_cast<const char *>(bin),
+                 std::streamsize(binBuffer_size));
     // Chunksize must be multiplies of 4, so pad with zeroes
     if (bin_padding_size > 0) {
       const std::vector<unsigned char> padding =
@@ -8545,9 +13507,8 @@ static bool WriteBinaryGltfStream(std::ostream &stream,
   return stream.good();
 }
 
-static bool WriteBinaryGltfFile(const std::string &output,
-                                const std::string &content,
-                                const std::vector<unsigned char> &binBuffer) {
+static bool WriteBinaryGltfFile(const std::string &output, const Model &model,
+                                GltfPayloads &payloads) {
 #ifndef TINYGLTF_NO_FS
 #ifdef _WIN32
 #if defined(_MSC_VER)
@@ -8564,7 +13525,7 @@ static bool WriteBinaryGltfFile(const std::string &output,
 #else
   std::ofstream gltfFile(output.c_str(), std::ios::binary);
 #endif
-  return WriteBinaryGltfStream(gltfFile, content, binBuffer);
+  return WriteBinaryGltfStream(gltfFile, model, payloads);
 #else
     return false;
 #endif
@@ -8573,57 +13534,40 @@ static bool WriteBinaryGltfFile(const std::string &output,
 bool TinyGLTF::WriteGltfSceneToStream(const Model *model, std::ostream &stream,
                                       bool prettyPrint = true,
                                       bool writeBinary = false) {
+#ifdef TINYGLTF_USE_RAPIDJSON
+  // Owns the allocator of the json values built for the payloads.
   detail::JsonDocument output;
-
-  /// Serialize all properties except buffers and images.
-  SerializeGltfModel(model, output);
+#endif
+  GltfPayloads payloads;
 
   // BUFFERS
-  std::vector<unsigned char> binBuffer;
-  if (model->buffers.size()) {
-    detail::json buffers;
-    detail::JsonReserveArray(buffers, model->buffers.size());
-    for (unsigned int i = 0; i < model->buffers.size(); ++i) {
-      detail::json buffer;
-      if (writeBinary && i == 0 && model->buffers[i].uri.empty()) {
-        SerializeGltfBufferBin(model->buffers[i], buffer, binBuffer);
-      } else {
-        SerializeGltfBuffer(model->buffers[i], buffer);
-      }
-      detail::JsonPushBack(buffers, std::move(buffer));
-    }
-    detail::JsonAddMember(output, "buffers", std::move(buffers));
+  for (unsigned int i = 0; i < model->buffers.size(); ++i) {
+    const bool bin = writeBinary && i == 0 && model->buffers[i].uri.empty();
+    SerializeGltfBufferPayload(model->buffers[i], bin, &payloads);
   }
 
   // IMAGES
-  if (model->images.size()) {
-    detail::json images;
-    detail::JsonReserveArray(images, model->images.size());
-    for (unsigned int i = 0; i < model->images.size(); ++i) {
-      detail::json image;
-
-      std::string dummystring;
-      // UpdateImageObject need baseDir but only uses it if embeddedImages is
-      // enabled, since we won't write separate images when writing to a stream
-      // we
-      std::string uri;
-      if (!UpdateImageObject(model->images[i], dummystring, int(i), true,
-                             &fs, &uri_cb, this->WriteImageData,
-                             this->write_image_user_data_, &uri)) {
-        return false;
-      }
-      SerializeGltfImage(model->images[i], uri, image);
-      detail::JsonPushBack(images, std::move(image));
+  for (unsigned int i = 0; i < model->images.size(); ++i) {
+    detail::json image;
+
+    std::string dummystring;
+    // UpdateImageObject need baseDir but only uses it if embeddedImages is
+    // enabled, since we won't write separate images when writing to a stream
+    // we
+    std::string uri;
+    if (!UpdateImageObject(model->images[i], dummystring, int(i), true, &fs,
+                           &uri_cb, this->WriteImageData,
+                           this->write_image_user_data_, &uri)) {
+      return false;
     }
-    detail::JsonAddMember(output, "images", std::move(images));
+    SerializeGltfImage(model->images[i], uri, image);
+    payloads.images.push_back(std::move(image));
   }
 
   if (writeBinary) {
-    return WriteBinaryGltfStream(stream, detail::JsonToString(output),
-                                 binBuffer);
+    return WriteBinaryGltfStream(stream, *model, payloads);
   } else {
-    return WriteGltfStream(stream,
-                           detail::JsonToString(output, prettyPrint ? 2 : -1));
+    return WriteGltfStream(stream, *model, payloads, prettyPrint);
   }
 }
 
@@ -8633,7 +13577,10 @@ bool TinyGLTF::WriteGltfSceneToFile(const Model *model,
                                     bool embedBuffers = false,
                                     bool prettyPrint = true,
                                     bool writeBinary = false) {
+#ifdef TINYGLTF_USE_RAPIDJSON
+  // Owns the allocator of the json values built for the payloads.
   detail::JsonDocument output;
+#endif
   std::string defaultBinFilename = GetBaseFilename(filename);
   std::string defaultBinFileExt = ".bin";
   std::string::size_type pos =
@@ -8646,92 +13593,79 @@ bool TinyGLTF::WriteGltfSceneToFile(const Model *model,
   if (baseDir.empty()) {
     baseDir = "./";
   }
-  /// Serialize all properties except buffers and images.
-  SerializeGltfModel(model, output);
+  GltfPayloads payloads;
 
   // BUFFERS
   std::vector<std::string> usedFilenames;
-  std::vector<unsigned char> binBuffer;
-  if (model->buffers.size()) {
-    detail::json buffers;
-    detail::JsonReserveArray(buffers, model->buffers.size());
-    for (unsigned int i = 0; i < model->buffers.size(); ++i) {
+  for (unsigned int i = 0; i < model->buffers.size(); ++i) {
+    if (writeBinary && i == 0 && model->buffers[i].uri.empty()) {
+      SerializeGltfBufferPayload(model->buffers[i], true, &payloads);
+    } else if (embedBuffers) {
+      SerializeGltfBufferPayload(model->buffers[i], false, &payloads);
+    } else {
       detail::json buffer;
-      if (writeBinary && i == 0 && model->buffers[i].uri.empty()) {
-        SerializeGltfBufferBin(model->buffers[i], buffer, binBuffer);
-      } else if (embedBuffers) {
-        SerializeGltfBuffer(model->buffers[i], buffer);
+      std::string binSavePath;
+      std::string binFilename;
+      std::string binUri;
+      if (!model->buffers[i].uri.empty() &&
+          !IsDataURI(model->buffers[i].uri)) {
+        binUri = model->buffers[i].uri;
+        if (!uri_cb.decode(binUri, &binFilename, uri_cb.user_data)) {
+          return false;
+        }
       } else {
-        std::string binSavePath;
-        std::string binFilename;
-        std::string binUri;
-        if (!model->buffers[i].uri.empty() &&
-            !IsDataURI(model->buffers[i].uri)) {
-          binUri = model->buffers[i].uri;
-          if (!uri_cb.decode(binUri, &binFilename, uri_cb.user_data)) {
-            return false;
-          }
-        } else {
-          binFilename = defaultBinFilename + defaultBinFileExt;
-          bool inUse = true;
-          int numUsed = 0;
-          while (inUse) {
-            inUse = false;
-            for (const std::string &usedName : usedFilenames) {
-              if (binFilename.compare(usedName) != 0) continue;
-              inUse = true;
-              binFilename = defaultBinFilename + std::to_string(numUsed++) +
-                            defaultBinFileExt;
-              break;
-            }
+        binFilename = defaultBinFilename + defaultBinFileExt;
+        bool inUse = true;
+        int numUsed = 0;
+        while (inUse) {
+          inUse = false;
+          for (const std::string &usedName : usedFilenames) {
+            if (binFilename.compare(usedName) != 0) continue;
+            inUse = true;
+            binFilename = defaultBinFilename + std::to_string(numUsed++) +
+                          defaultBinFileExt;
+            break;
           }
+        }
 
-          if (uri_cb.encode) {
-            if (!uri_cb.encode(binFilename, "buffer", &binUri,
-                               uri_cb.user_data)) {
-              return false;
-            }
-          } else {
-            binUri = binFilename;
+        if (uri_cb.encode) {
+          if (!uri_cb.encode(binFilename, "buffer", &binUri,
+                             uri_cb.user_data)) {
+            return false;
           }
+        } else {
+          binUri = binFilename;
         }
-        usedFilenames.push_back(binFilename);
-        binSavePath = JoinPath(baseDir, binFilename);
-        if (!SerializeGltfBuffer(model->buffers[i], buffer, binSavePath,
-                                 binUri)) {
-          return false;
-        }
       }
-      detail::JsonPushBack(buffers, std::move(buffer));
+      usedFilenames.push_back(binFilename);
+      binSavePath = JoinPath(baseDir, binFilename);
+      if (!SerializeGltfBuffer(model->buffers[i], buffer, binSavePath,
+                               binUri)) {
+        return false;
+      }
+      payloads.buffers.push_back(std::move(buffer));
+      payloads.embedded.push_back(nullptr);
     }
-    detail::JsonAddMember(output, "buffers", std::move(buffers));
   }
 
   // IMAGES
-  if (model->images.size()) {
-    detail::json images;
-    detail::JsonReserveArray(images, model->images.size());
-    for (unsigned int i = 0; i < model->images.size(); ++i) {
-      detail::json image;
-
-      std::string uri;
-      if (!UpdateImageObject(model->images[i], baseDir, int(i), embedImages,
-                             &fs, &uri_cb, this->WriteImageData,
-                             this->write_image_user_data_, &uri)) {
-        return false;
-      }
-      SerializeGltfImage(model->images[i], uri, image);
-      detail::JsonPushBack(images, std::move(image));
+  for (unsigned int i = 0; i < model->images.size(); ++i) {
+    detail::json image;
+
+    std::string uri;
+    if (!UpdateImageObject(model->images[i], baseDir, int(i), embedImages,
+                           &fs, &uri_cb, this->WriteImageData,
+                           this->write_image_user_data_, &uri)) {
+      return false;
     }
-    detail::JsonAddMember(output, "images", std::move(images));
+    SerializeGltfImage(model->images[i], uri, image);
+    payloads.images.push_back(std::move(image));
   }
 
   if (writeBinary) {
-    return WriteBinaryGltfFile(filename, detail::JsonToString(output),
-                               binBuffer);
+    return WriteBinaryGltfFile(filename, *model, payloads);
   } else {
-    return WriteGltfFile(filename,
-                         detail::JsonToString(output, (prettyPrint ? 2 : -1)));
+    return WriteGltfFile(filename, *model, payloads, prettyPrint);
   }
 }
 